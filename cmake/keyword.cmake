@@ -94,6 +94,7 @@ function(getNanairoKeywords nanairo_keyword_list)
       eyePathLightSampler "EyePathLightSampler"
           uniformLightSampler "UniformLightSampler"
           powerWeightedLightSampler "PowerWeightedLightSampler"
+      enableWavefront "EnableWavefront"
       # Probabilistic PPM
       numOfPhotons "NumOfPhotons"
       photonSearchRadius "PhotonSearchRadius"
@@ -105,6 +106,21 @@ function(getNanairoKeywords nanairo_keyword_list)
           agglomerativeTreeletRestructuringBvh "AgglomerativeTreeletRestructuringBvh"
               treeletSize "TreeletSize"
               optimizationLoopCount "OptimizationLoopCount"
+          binnedSahBvh "BinnedSahBvh"
+              numOfBins "NumOfBins"
+          plocBvh "PlocBvh"
+              searchRadius "SearchRadius"
+          spatialSplitBvh "SpatialSplitBvh"
+              duplicationLimit "DuplicationLimit"
+          bvhTraversal "Traversal"
+              orderedTraversal "OrderedTraversal"
+              stacklessTraversal "StacklessTraversal"
+          bvhNodeFormat "NodeFormat"
+              fullNode "FullNode"
+              quantized16Node "Quantized16Node"
+              quantized8Node "Quantized8Node"
+          bvhMaxLeafSize "MaxLeafSize"
+          bvhNodeWidth "NodeWidth"
 
       # Texture
       textureModel "TextureModel"
@@ -158,8 +174,14 @@ function(getNanairoKeywords nanairo_keyword_list)
       shapeType "ShapeType"
           planeObject "PlaneObject"
           meshObject "MeshObject"
+          sphereObject "SphereObject"
+          diskObject "DiskObject"
       objectFilePath "ObjectFilePath"
       smoothing "Smoothing"
+      meshCompression "MeshCompression"
+          uncompressedMesh "UncompressedMesh"
+          quantized16Mesh "Quantized16Mesh"
+          quantized32Mesh "Quantized32Mesh"
       surfaceIndex "SurfaceIndex"
       isEmissiveObject "IsEmissiveObject"
       emitterIndex "EmitterIndex"
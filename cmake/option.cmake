@@ -56,9 +56,9 @@ function(initCommandOptions)
   set(option_description "Set the floating point type of the computation in rendering.")
   setStringOption(NANAIRO_FLOATING_POINT_TYPE "double" ${option_description})
  
-  set(option_description "Set the max number of objects that a BVH node can contain.")
-  setStringOption(NANAIRO_MAX_NUM_OF_OBJECTS 8 ${option_description})
-
+  set(option_description "Store and intersect the BVH traversal data in single precision.")
+  setBooleanOption(NANAIRO_SINGLE_PRECISION_TRAVERSAL OFF ${option_description})
+ 
   set(option_description "Set max FPS")
   setStringOption(NANAIRO_MAX_FPS 50 ${option_description})
 
@@ -77,6 +77,9 @@ function(initCommandOptions)
   set(option_description "Use an efficient memory manager for NanairoCore.")
   setBooleanOption(NANAIRO_USES_EFFICIENT_MEMORY_MANAGER ON ${option_description})
 
+  set(option_description "Place the shapes of BVH objects contiguously in the leaf order.")
+  setBooleanOption(NANAIRO_CONTIGUOUS_OBJECT_LAYOUT ON ${option_description})
+
   set(option_description "The size of a memory pool per thread.")
   math(EXPR __memory_size__ "1 * 1024 * 1024")
   setStringOption(NANAIRO_MEMORY_POOL_SIZE ${__memory_size__} ${option_description})
@@ -102,5 +105,8 @@ function(initCommandOptions)
   set(option_description "Set the heuristic parameter of the MIS weight calculation (1: balance heuristic, 2: power heuristic).")
   setStringOption(NANAIRO_MIS_HEURISTIC_BETA 2 ${option_description})
 
+  set(option_description "Count the BVH traversal of each ray and output the heatmaps of the counts.")
+  setBooleanOption(NANAIRO_TRAVERSAL_STATISTICS OFF ${option_description})
+
   validateOptions()
 endfunction(initCommandOptions)
@@ -18,6 +18,7 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/DataStructure/traversal_statistics.hpp"
 #include "NanairoCore/Sampling/sample_statistics.hpp"
 
 namespace nanairo {
@@ -60,6 +61,7 @@ inline
 void Film::clear() noexcept
 {
   sample_statistics_.clear();
+  traversal_statistics_.clear();
 }
 
 /*!
@@ -97,6 +99,22 @@ const SampleStatistics& Film::sampleStatistics() const noexcept
   return sample_statistics_;
 }
 
+/*!
+  */
+inline
+TraversalStatistics& Film::traversalStatistics() noexcept
+{
+  return traversal_statistics_;
+}
+
+/*!
+  */
+inline
+const TraversalStatistics& Film::traversalStatistics() const noexcept
+{
+  return traversal_statistics_;
+}
+
 /*!
   \details
   No detailed.
@@ -27,7 +27,8 @@ namespace nanairo {
   No detailed.
   */
 Film::Film(System& system, const SettingNodeBase* settings) noexcept :
-    sample_statistics_{system}
+    sample_statistics_{system},
+    traversal_statistics_{system}
 {
   initialize(system, settings);
 }
@@ -13,6 +13,7 @@
 // Nanairo 
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/DataStructure/traversal_statistics.hpp"
 #include "NanairoCore/Sampling/sample_statistics.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
@@ -56,6 +57,12 @@ class Film
   //! Return the sample statistics
   const SampleStatistics& sampleStatistics() const noexcept;
 
+  //! Return the traversal statistics
+  TraversalStatistics& traversalStatistics() noexcept;
+
+  //! Return the traversal statistics
+  const TraversalStatistics& traversalStatistics() const noexcept;
+
   //! Return the image width
   uint widthResolution() const noexcept;
 
@@ -65,6 +72,7 @@ class Film
 
 
   SampleStatistics sample_statistics_;
+  TraversalStatistics traversal_statistics_;
 };
 
 //! \} Core 
@@ -29,6 +29,7 @@ namespace nanairo {
 inline
 IntersectionInfo::IntersectionInfo() noexcept :
     object_{nullptr},
+    instanced_object_{nullptr},
     ray_distance_{0.0},
     is_back_face_{kFalse}
 {
@@ -42,6 +43,7 @@ inline
 IntersectionInfo::IntersectionInfo(const Object* object,
                                    const ShapePoint& point) noexcept :
     object_{object},
+    instanced_object_{nullptr},
     point_{point},
     ray_distance_{0.0},
     is_back_face_{kFalse}
@@ -65,6 +67,17 @@ Vector3 IntersectionInfo::frontNormal() const noexcept
   return n;
 }
 
+/*!
+  \details
+  The object is recorded in the intersection test of an instance,
+  so the hit attributes are computed without traversing the BVH again.
+  */
+inline
+const Object* IntersectionInfo::instancedObject() const noexcept
+{
+  return instanced_object_;
+}
+
 /*!
   \details
   No detailed.
@@ -143,6 +156,16 @@ void IntersectionInfo::setBitangent(const Vector3& bitangent) noexcept
   point_.setBitangent(bitangent);
 }
 
+/*!
+  \details
+  No detailed.
+  */
+inline
+void IntersectionInfo::setInstancedObject(const Object* object) noexcept
+{
+  instanced_object_ = object;
+}
+
 /*!
   \details
   No detailed.
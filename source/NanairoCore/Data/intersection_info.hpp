@@ -47,6 +47,9 @@ class IntersectionInfo
   //! Return the face normal which is oriented to the front side
   Vector3 frontNormal() const noexcept;
 
+  //! Return the intersected object of the bottom level BVH of an instance
+  const Object* instancedObject() const noexcept;
+
   //! Check if the intersection point is back face
   bool isBackFace() const noexcept;
 
@@ -71,6 +74,9 @@ class IntersectionInfo
   //! Set the bitangent vector
   void setBitangent(const Vector3& bitangent) noexcept;
 
+  //! Set the intersected object of the bottom level BVH of an instance
+  void setInstancedObject(const Object* object) noexcept;
+
   //! Set normal direction
   void setNormal(const Vector3& normal) noexcept;
 
@@ -109,6 +115,7 @@ class IntersectionInfo
 
  private:
   const Object* object_;
+  const Object* instanced_object_;
   ShapePoint point_;
   Float ray_distance_;
   uint8 is_back_face_;
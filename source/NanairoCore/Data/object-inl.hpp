@@ -11,12 +11,25 @@
 #define NANAIRO_OBJECT_INL_HPP
 
 #include "object.hpp"
+// Standard C++ library
+#include <limits>
 // Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Shape/shape.hpp"
 #include "NanairoCore/Material/material.hpp"
 
 namespace nanairo {
 
+/*!
+  \details
+  No detailed.
+  */
+inline
+Shape& Object::shape() noexcept
+{
+  return *shape_;
+}
+
 /*!
   \details
   No detailed.
@@ -27,6 +40,17 @@ const Shape& Object::shape() const noexcept
   return *shape_;
 }
 
+/*!
+  \details
+  The index is set by the world so that the light samplers look up
+  the information of a light source directly.
+  */
+inline
+uint32 Object::lightSourceIndex() const noexcept
+{
+  return light_source_index_;
+}
+
 /*!
   \details
   No detailed.
@@ -37,6 +61,16 @@ const Material& Object::material() const noexcept
   return *material_;
 }
 
+/*!
+  \details
+  No detailed.
+  */
+inline
+constexpr uint32 Object::nonLightSourceIndex() noexcept
+{
+  return std::numeric_limits<uint32>::max();
+}
+
 /*!
   \details
   No detailed.
@@ -30,7 +30,8 @@ namespace nanairo {
 Object::Object(zisc::UniqueMemoryPointer<Shape>&& shape,
                const Material* material) noexcept :
     shape_{std::move(shape)},
-    material_{material}
+    material_{material},
+    light_source_index_{nonLightSourceIndex()}
 {
   ZISC_ASSERT(material != nullptr, "The material is null.");
 }
@@ -40,7 +41,8 @@ Object::Object(zisc::UniqueMemoryPointer<Shape>&& shape,
   No detailed.
   */
 Object::Object(Object&& other) noexcept :
-    material_{nullptr}
+    material_{nullptr},
+    light_source_index_{nonLightSourceIndex()}
 {
   swap(other);
 }
@@ -64,6 +66,13 @@ std::string_view Object::name() const noexcept
 #endif // Z_DEBUG_MODE
 }
 
+/*!
+  */
+void Object::setLightSourceIndex(const uint32 index) noexcept
+{
+  light_source_index_ = index;
+}
+
 /*!
   */
 void Object::setName(const std::string_view& object_name) noexcept
@@ -74,6 +83,16 @@ void Object::setName(const std::string_view& object_name) noexcept
   static_cast<void>(object_name);
 }
 
+/*!
+  \details
+  The old shape is destroyed.
+  */
+void Object::setShape(zisc::UniqueMemoryPointer<Shape>&& shape) noexcept
+{
+  ZISC_ASSERT(shape, "The shape is null.");
+  shape_ = std::move(shape);
+}
+
 /*!
   */
 void Object::swap(Object& other) noexcept
@@ -90,6 +109,12 @@ void Object::swap(Object& other) noexcept
     other.material_ = material_;
     material_ = tmp;
   }
+  // Light source index
+  {
+    const auto tmp = other.light_source_index_;
+    other.light_source_index_ = light_source_index_;
+    light_source_index_ = tmp;
+  }
 #ifdef Z_DEBUG_MODE
   // Name
   {
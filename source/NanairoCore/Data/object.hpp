@@ -20,6 +20,7 @@
 #include "zisc/non_copyable.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Material/material.hpp"
 #include "NanairoCore/Shape/shape.hpp"
 
@@ -50,12 +51,27 @@ class Object : public zisc::NonCopyable<Object>
   //! Return the name of the object
   std::string_view name() const noexcept;
 
+  //! Return the index of the object in the light source list of the world
+  uint32 lightSourceIndex() const noexcept;
+
   //! Get material
   const Material& material() const noexcept;
 
+  //! Return the index which represents the object isn't a light source
+  static constexpr uint32 nonLightSourceIndex() noexcept;
+
+  //! Set the index of the object in the light source list of the world
+  void setLightSourceIndex(const uint32 index) noexcept;
+
   //! Set the name of the object
   void setName(const std::string_view& object_name) noexcept;
 
+  //! Replace the shape of the object
+  void setShape(zisc::UniqueMemoryPointer<Shape>&& shape) noexcept;
+
+  //! Get shape
+  Shape& shape() noexcept;
+
   //! Get shape
   const Shape& shape() const noexcept;
 
@@ -65,6 +81,7 @@ class Object : public zisc::NonCopyable<Object>
  private:
   zisc::UniqueMemoryPointer<Shape> shape_;
   const Material* material_;
+  uint32 light_source_index_;
 #ifdef Z_DEBUG_MODE
   std::string name_;
 #endif // Z_DEBUG_MODE
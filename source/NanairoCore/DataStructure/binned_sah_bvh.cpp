@@ -0,0 +1,447 @@
+/*!
+  \file binned_sah_bvh.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "binned_sah_bvh.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "bvh_building_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+BinnedSahBvh::BuildingData::BuildingData(
+    const zisc::pmr::vector<Object>& object_list,
+    zisc::pmr::memory_resource* work_resource) noexcept :
+        leaf_node_list_{work_resource},
+        centroid_list_{work_resource},
+        cost_list_{work_resource},
+        index_list_{work_resource}
+{
+  const uint32 num_of_objects = zisc::cast<uint32>(object_list.size());
+  leaf_node_list_.reserve(num_of_objects);
+  centroid_list_.reserve(num_of_objects);
+  cost_list_.reserve(num_of_objects);
+  index_list_.reserve(num_of_objects);
+  for (uint32 index = 0; index < num_of_objects; ++index) {
+    const auto& object = object_list[index];
+    leaf_node_list_.emplace_back(&object);
+    centroid_list_.emplace_back(leaf_node_list_.back().boundingBox().centroid());
+    cost_list_.emplace_back(object.shape().getTraversalCost());
+    index_list_.emplace_back(index);
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+BinnedSahBvh::BinnedSahBvh(System& system,
+                           const SettingNodeBase* settings) noexcept :
+    Bvh(system, settings)
+{
+  initialize(settings);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void BinnedSahBvh::binObjects(const BuildingData& data,
+                              const uint32 begin,
+                              const uint32 end,
+                              const Aabb& centroid_box,
+                              Bin* bin_list) const noexcept
+{
+  const uint n = numOfBins();
+  const auto& min_point = centroid_box.minPoint();
+  const auto extent = centroid_box.maxPoint() - min_point;
+
+  for (uint i = 0; i < 3 * n; ++i)
+    bin_list[i] = Bin{Aabb{}, 0.0, 0};
+
+  for (uint32 i = begin; i < end; ++i) {
+    const uint32 index = data.index_list_[i];
+    const auto& centroid = data.centroid_list_[index];
+    const Bin bin{data.leaf_node_list_[index].boundingBox(),
+                  data.cost_list_[index],
+                  1};
+    for (uint axis = 0; axis < 3; ++axis) {
+      if (extent[axis] <= 0.0)
+        continue;
+      const Float scale = zisc::cast<Float>(n) / extent[axis];
+      const uint k = calcBinIndex(centroid[axis], min_point[axis], scale, n);
+      mergeBin(bin, &bin_list[axis * n + k]);
+    }
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint BinnedSahBvh::calcBinIndex(const Float centroid,
+                                const Float min_centroid,
+                                const Float scale,
+                                const uint num_of_bins) noexcept
+{
+  const uint k = zisc::cast<uint>((centroid - min_centroid) * scale);
+  return zisc::min(k, num_of_bins - 1);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+Aabb BinnedSahBvh::calcCentroidBox(const BuildingData& data,
+                                   const uint32 begin,
+                                   const uint32 end) noexcept
+{
+  ZISC_ASSERT(begin < end, "The range is empty.");
+  auto min_point = data.centroid_list_[data.index_list_[begin]].data();
+  auto max_point = min_point;
+  for (uint32 i = begin + 1; i < end; ++i) {
+    const auto& centroid = data.centroid_list_[data.index_list_[i]];
+    min_point = zisc::minElements(min_point, centroid.data());
+    max_point = zisc::maxElements(max_point, centroid.data());
+  }
+  return Aabb{Point3{min_point}, Point3{max_point}};
+}
+
+/*!
+  \details
+  The top levels are split on the calling thread and
+  the objects of large nodes are binned by all threads.
+  After enough subtrees are made, they are built in parallel.
+  */
+void BinnedSahBvh::constructBvh(
+    System& system,
+    const zisc::pmr::vector<Object>& object_list,
+    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+{
+  const uint32 num_of_objects = zisc::cast<uint32>(object_list.size());
+  tree.resize(2 * num_of_objects - 1);
+
+  auto work_resource = tree.get_allocator().resource();
+  BuildingData data{object_list, work_resource};
+
+  auto& threads = system.threadManager();
+  const uint num_of_threads = threads.numOfThreads();
+  constexpr bool threading = threadingIsEnabled();
+
+  // Split the top levels
+  zisc::pmr::vector<BuildingTask> subtree_list{work_resource};
+  {
+    zisc::pmr::vector<Bin> bin_list{work_resource};
+    bin_list.resize(zisc::max(4 * numOfBins(), 3 * numOfBins() * num_of_threads));
+
+    const std::size_t num_of_subtrees = threading ? 4 * num_of_threads : 1;
+    zisc::pmr::vector<BuildingTask> task_list{work_resource};
+    task_list.push_back(BuildingTask{0, BvhBuildingNode::nullIndex(),
+                                     0, num_of_objects});
+    for (std::size_t i = 0; i < task_list.size(); ++i) {
+      const auto task = task_list[i];
+      const uint32 size = task.end_ - task.begin_;
+      if (size == 1) {
+        setLeafNode(data, task, tree);
+        continue;
+      }
+      const std::size_t num_of_tasks = (task_list.size() - i) + subtree_list.size();
+      if (num_of_subtrees <= num_of_tasks) {
+        subtree_list.push_back(task);
+        continue;
+      }
+      const auto children = (threading && (parallelBinningThreshold() <= size))
+          ? split<threading>(system, data, task, bin_list, tree)
+          : split<>(system, data, task, bin_list, tree);
+      task_list.push_back(children[0]);
+      task_list.push_back(children[1]);
+    }
+  }
+
+  // Build the subtrees
+  auto build_subtree =
+  [this, &system, &data, &subtree_list, &tree, work_resource](const uint task_id)
+  {
+    zisc::pmr::vector<Bin> bin_list{work_resource};
+    bin_list.resize(4 * numOfBins());
+    splitRecursively(system, data, subtree_list[task_id], bin_list, tree);
+  };
+  if (threading) {
+    constexpr uint start = 0;
+    const uint end = zisc::cast<uint>(subtree_list.size());
+    auto result = threads.enqueueLoop(build_subtree, start, end, work_resource);
+    result.wait();
+  }
+  else {
+    for (uint i = 0; i < subtree_list.size(); ++i)
+      build_subtree(i);
+  }
+
+  setupBoundingBoxes<threading>(system, tree, 0);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void BinnedSahBvh::initialize(const SettingNodeBase* settings) noexcept
+{
+  const auto bvh_settings = castNode<BvhSettingNode>(settings);
+
+  const auto& parameters = bvh_settings->binnedSahParameters();
+  {
+    num_of_bins_ = parameters.num_of_bins_;
+    ZISC_ASSERT(2 <= num_of_bins_, "Invalid number of bins is specified.");
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void BinnedSahBvh::mergeBin(const Bin& bin, Bin* other) noexcept
+{
+  if (bin.num_of_objects_ == 0)
+    return;
+  other->bounding_box_ = (other->num_of_objects_ == 0)
+      ? bin.bounding_box_
+      : combine(other->bounding_box_, bin.bounding_box_);
+  other->cost_ += bin.cost_;
+  other->num_of_objects_ += bin.num_of_objects_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint BinnedSahBvh::numOfBins() const noexcept
+{
+  return num_of_bins_;
+}
+
+/*!
+  */
+inline
+constexpr uint32 BinnedSahBvh::parallelBinningThreshold() noexcept
+{
+  return 1u << 16;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void BinnedSahBvh::setLeafNode(
+    const BuildingData& data,
+    const BuildingTask& task,
+    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+{
+  ZISC_ASSERT(task.end_ - task.begin_ == 1, "The node has multiple objects.");
+  auto& node = tree[task.node_index_];
+  node = data.leaf_node_list_[data.index_list_[task.begin_]];
+  node.setParentIndex(task.parent_index_);
+}
+
+/*!
+  \details
+  The subtree of a node which has n objects occupies 2n - 1 nodes,
+  so the left child is placed next to the node and
+  the right child is placed after the left subtree.
+  */
+template <bool threading>
+auto BinnedSahBvh::split(
+    System& system,
+    BuildingData& data,
+    const BuildingTask& task,
+    zisc::pmr::vector<Bin>& bin_list,
+    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+        -> std::array<BuildingTask, 2>
+{
+  const uint32 begin = task.begin_;
+  const uint32 end = task.end_;
+  ZISC_ASSERT(1 < (end - begin), "The node has only one object.");
+  const uint n = numOfBins();
+
+  // Bin the objects
+  Aabb centroid_box;
+  if (threading) {
+    auto& threads = system.threadManager();
+    const uint num_of_threads = threads.numOfThreads();
+    auto work_resource = tree.get_allocator().resource();
+    ZISC_ASSERT(3 * n * num_of_threads <= bin_list.size(),
+                "The bin list is too small.");
+    constexpr uint start = 0;
+    // Calculate the centroid box
+    {
+      zisc::pmr::vector<Aabb> box_list{work_resource};
+      box_list.resize(num_of_threads);
+      auto calc_centroid_box =
+      [&data, &box_list, begin, end, num_of_threads](const uint task_id)
+      {
+        const auto range = System::calcTaskRange(end - begin,
+                                                 num_of_threads,
+                                                 task_id);
+        box_list[task_id] = (range[0] < range[1])
+            ? calcCentroidBox(data, begin + range[0], begin + range[1])
+            : calcCentroidBox(data, begin, begin + 1);
+      };
+      auto result = threads.enqueueLoop(calc_centroid_box, start, num_of_threads,
+                                        work_resource);
+      result.wait();
+      centroid_box = box_list[0];
+      for (uint i = 1; i < num_of_threads; ++i)
+        centroid_box = combine(centroid_box, box_list[i]);
+    }
+    // Bin the objects for each thread and merge them
+    {
+      auto bin_objects =
+      [this, &data, &bin_list, &centroid_box, begin, end, n, num_of_threads]
+      (const uint task_id)
+      {
+        const auto range = System::calcTaskRange(end - begin,
+                                                 num_of_threads,
+                                                 task_id);
+        binObjects(data, begin + range[0], begin + range[1], centroid_box,
+                   &bin_list[3 * n * task_id]);
+      };
+      auto result = threads.enqueueLoop(bin_objects, start, num_of_threads,
+                                        work_resource);
+      result.wait();
+      for (uint t = 1; t < num_of_threads; ++t) {
+        for (uint i = 0; i < 3 * n; ++i)
+          mergeBin(bin_list[3 * n * t + i], &bin_list[i]);
+      }
+    }
+  }
+  else {
+    centroid_box = calcCentroidBox(data, begin, end);
+    binObjects(data, begin, end, centroid_box, bin_list.data());
+  }
+
+  // Find the split which has the minimum SAH cost
+  uint best_axis = 3;
+  uint best_bin = 0;
+  {
+    Float best_cost = std::numeric_limits<Float>::max();
+    Bin* right_list = &bin_list[3 * n];
+    const auto extent = centroid_box.maxPoint() - centroid_box.minPoint();
+    for (uint axis = 0; axis < 3; ++axis) {
+      if (extent[axis] <= 0.0)
+        continue;
+      const Bin* axis_bin_list = &bin_list[axis * n];
+      Bin right{Aabb{}, 0.0, 0};
+      for (uint k = n - 1; 0 < k; --k) {
+        mergeBin(axis_bin_list[k], &right);
+        right_list[k] = right;
+      }
+      Bin left{Aabb{}, 0.0, 0};
+      for (uint k = 0; k < (n - 1); ++k) {
+        mergeBin(axis_bin_list[k], &left);
+        const auto& r = right_list[k + 1];
+        if ((left.num_of_objects_ == 0) || (r.num_of_objects_ == 0))
+          continue;
+        const Float cost = left.bounding_box_.surfaceArea() * left.cost_ +
+                           r.bounding_box_.surfaceArea() * r.cost_;
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = axis;
+          best_bin = k;
+        }
+      }
+    }
+  }
+
+  // Partition the objects
+  uint32 middle = begin;
+  if (best_axis < 3) {
+    const Float min_centroid = centroid_box.minPoint()[best_axis];
+    const Float extent = centroid_box.maxPoint()[best_axis] - min_centroid;
+    const Float scale = zisc::cast<Float>(n) / extent;
+    const auto& centroid_list = data.centroid_list_;
+    auto is_left = [&centroid_list, best_axis, best_bin, min_centroid, scale, n]
+    (const uint32 index)
+    {
+      const Float c = centroid_list[index][best_axis];
+      return calcBinIndex(c, min_centroid, scale, n) <= best_bin;
+    };
+    auto first = data.index_list_.begin() + begin;
+    auto last = data.index_list_.begin() + end;
+    const auto position = std::partition(first, last, is_left);
+    middle = begin + zisc::cast<uint32>(std::distance(first, position));
+  }
+  // All centroids are at the same position
+  if ((middle == begin) || (middle == end))
+    middle = begin + ((end - begin) >> 1);
+
+  // Set the children
+  const uint32 num_of_left_objects = middle - begin;
+  const uint32 left_child_index = task.node_index_ + 1;
+  const uint32 right_child_index = task.node_index_ + 2 * num_of_left_objects;
+  auto& node = tree[task.node_index_];
+  node.setParentIndex(task.parent_index_);
+  node.setLeftChildIndex(left_child_index);
+  node.setRightChildIndex(right_child_index);
+  return std::array<BuildingTask, 2>{{
+      BuildingTask{left_child_index, task.node_index_, begin, middle},
+      BuildingTask{right_child_index, task.node_index_, middle, end}}};
+}
+
+/*!
+  \details
+  The smaller child is processed recursively and
+  the larger one is processed in the loop,
+  so the recursion depth is bounded by log2 of the number of objects.
+  */
+void BinnedSahBvh::splitRecursively(
+    System& system,
+    BuildingData& data,
+    const BuildingTask& task,
+    zisc::pmr::vector<Bin>& bin_list,
+    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+{
+  auto current = task;
+  while (1 < (current.end_ - current.begin_)) {
+    const auto children = split<>(system, data, current, bin_list, tree);
+    const uint32 left_size = children[0].end_ - children[0].begin_;
+    const uint32 right_size = children[1].end_ - children[1].begin_;
+    const bool left_is_small = left_size < right_size;
+    splitRecursively(system, data, children[left_is_small ? 0 : 1], bin_list, tree);
+    current = children[left_is_small ? 1 : 0];
+  }
+  setLeafNode(data, current, tree);
+}
+
+} // namespace nanairo
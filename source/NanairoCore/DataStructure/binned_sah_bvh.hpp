@@ -0,0 +1,145 @@
+/*!
+  \file binned_sah_bvh.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_BINNED_SAH_BVH_HPP
+#define NANAIRO_BINNED_SAH_BVH_HPP
+
+// Standard C++ library
+#include <array>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "bvh_building_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class System;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  The objects are split top-down by the surface area heuristic
+  evaluated on a fixed number of bins.
+  For the details of this algorithm,
+  please see the paper entitled
+  "On fast Construction of SAH-based Bounding Volume Hierarchies"
+  */
+class BinnedSahBvh : public Bvh
+{
+ public:
+  //! Create a binned SAH BVH
+  BinnedSahBvh(System& system, const SettingNodeBase* settings) noexcept;
+
+ private:
+  //! The objects which are referred in building
+  struct BuildingData : public zisc::NonCopyable<BuildingData>
+  {
+    BuildingData(const zisc::pmr::vector<Object>& object_list,
+                 zisc::pmr::memory_resource* work_resource) noexcept;
+
+    zisc::pmr::vector<BvhBuildingNode> leaf_node_list_;
+    zisc::pmr::vector<Point3> centroid_list_;
+    zisc::pmr::vector<Float> cost_list_;
+    zisc::pmr::vector<uint32> index_list_;
+  };
+
+  //! The range of objects which belong to a node
+  struct BuildingTask
+  {
+    uint32 node_index_;
+    uint32 parent_index_;
+    uint32 begin_;
+    uint32 end_;
+  };
+
+  //! The objects which fall into a bin
+  struct Bin
+  {
+    Aabb bounding_box_;
+    Float cost_;
+    uint32 num_of_objects_;
+  };
+
+
+  //! Bin the objects of the range
+  void binObjects(const BuildingData& data,
+                  const uint32 begin,
+                  const uint32 end,
+                  const Aabb& centroid_box,
+                  Bin* bin_list) const noexcept;
+
+  //! Return the bin index of the centroid
+  static uint calcBinIndex(const Float centroid,
+                           const Float min_centroid,
+                           const Float scale,
+                           const uint num_of_bins) noexcept;
+
+  //! Calculate the bounding box of the centroids of the range
+  static Aabb calcCentroidBox(const BuildingData& data,
+                              const uint32 begin,
+                              const uint32 end) noexcept;
+
+  //! Build a binned SAH BVH
+  void constructBvh(
+      System& system,
+      const zisc::pmr::vector<Object>& object_list,
+      zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept override;
+
+  //! Initialize
+  void initialize(const SettingNodeBase* settings) noexcept;
+
+  //! Merge the bin into the other bin
+  static void mergeBin(const Bin& bin, Bin* other) noexcept;
+
+  //! Return the number of bins
+  uint numOfBins() const noexcept;
+
+  //! Return the number of objects which are binned in parallel
+  static constexpr uint32 parallelBinningThreshold() noexcept;
+
+  //! Set the leaf node
+  void setLeafNode(const BuildingData& data,
+                   const BuildingTask& task,
+                   zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept;
+
+  //! Split the objects of the node into two children
+  template <bool threading = false>
+  std::array<BuildingTask, 2> split(
+      System& system,
+      BuildingData& data,
+      const BuildingTask& task,
+      zisc::pmr::vector<Bin>& bin_list,
+      zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept;
+
+  //! Build the subtree of the node
+  void splitRecursively(System& system,
+                        BuildingData& data,
+                        const BuildingTask& task,
+                        zisc::pmr::vector<Bin>& bin_list,
+                        zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept;
+
+
+  uint num_of_bins_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#endif // NANAIRO_BINNED_SAH_BVH_HPP
@@ -12,18 +12,25 @@
 
 #include "bvh.hpp"
 // Standard C++ library
+#include <functional>
 #include <utility>
 #include <vector>
 // Zisc
+#include "zisc/error.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/thread_manager.hpp"
 // Nanairo
 #include "bvh_building_node.hpp"
 #include "bvh_tree_node.hpp"
+#include "packed_triangle_list.hpp"
+#include "traversal_statistics.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/object.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Shape/shape.hpp"
 
 namespace nanairo {
 
@@ -37,6 +44,26 @@ const zisc::pmr::vector<BvhTreeNode>& Bvh::bvhTree() const noexcept
   return tree_;
 }
 
+/*!
+  \details
+  No detailed.
+  */
+inline
+BvhNodeFormat Bvh::nodeFormat() const noexcept
+{
+  return node_format_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+zisc::pmr::vector<Object>& Bvh::objectList() noexcept
+{
+  return object_list_;
+}
+
 /*!
   \details
   No detailed.
@@ -47,6 +74,87 @@ const zisc::pmr::vector<Object>& Bvh::objectList() const noexcept
   return object_list_;
 }
 
+/*!
+  \details
+  The objects of a leaf node are referred through a contiguous range
+  of the reference list, so an object can be referred by several leaves.
+  */
+inline
+const zisc::pmr::vector<uint32>& Bvh::referenceList() const noexcept
+{
+  return reference_list_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+BvhTraversalType Bvh::traversalType() const noexcept
+{
+  return traversal_type_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+const PackedTriangleList& Bvh::triangleList() const noexcept
+{
+  return triangle_list_;
+}
+
+/*!
+  \details
+  The hit attributes are computed only for the closest intersection.
+  */
+inline
+void Bvh::finalizeIntersection(const Ray& ray,
+                               IntersectionInfo* intersection) const noexcept
+{
+  ZISC_ASSERT(intersection != nullptr, "The intersection is null.");
+  const auto object = intersection->object();
+  if (object != nullptr)
+    object->shape().finalizeIntersection(ray, intersection);
+}
+
+/*!
+  \details
+  The nodes of the tree are sorted in depth-first order,
+  so the left child is placed next to the parent.
+  */
+inline
+uint32 Bvh::leftChildIndex(const uint32 index) const noexcept
+{
+  ZISC_ASSERT(!tree_[index].isLeafNode(), "The node is leaf node.");
+  return index + 1;
+}
+
+/*!
+  \details
+  The failure next index of the left child points to the right child.
+  */
+inline
+uint32 Bvh::rightChildIndex(const uint32 index) const noexcept
+{
+  const uint32 left_child_index = leftChildIndex(index);
+  return tree_[left_child_index].failureNextIndex();
+}
+
+/*!
+  \details
+  A packet covers the pixels of a rendering tile.
+  */
+inline
+constexpr uint Bvh::maxPacketSize() noexcept
+{
+  constexpr uint s = CoreConfig::sizeOfRenderingTileSide();
+  constexpr uint size = s * s;
+  static_assert(size <= 32, "The ray mask of a packet overflows.");
+  return size;
+}
+
 /*!
   */
 inline
@@ -95,6 +203,117 @@ void Bvh::setupBoundingBoxes(System& system,
   setupBoundingBox(tree, index);
 }
 
+/*!
+  \details
+  Only the ray distance, the st coordinate and the object are recorded.
+  The triangles are tested in packs without accessing the objects.
+  */
+inline
+void Bvh::testRayObjectsIntersection(const Ray& ray,
+                                     const uint32 object_index,
+                                     const uint num_of_objects,
+                                     IntersectionInfo* intersection) const noexcept
+{
+  ZISC_ASSERT(intersection != nullptr, "The intersection is null.");
+  TraversalStatistics::countObjectTests(num_of_objects);
+  const auto& object_list = objectList();
+  const auto& triangle_list = triangleList();
+  // Triangles
+  {
+    Float ray_distance = intersection->rayDistance();
+    Point2 st;
+    const uint32 index = triangle_list.findClosestTriangle(ray,
+                                                           object_index,
+                                                           num_of_objects,
+                                                           &ray_distance,
+                                                           &st);
+    if (index != BvhBuildingNode::nullIndex()) {
+      intersection->setRayDistance(ray_distance);
+      intersection->setSt(st);
+      intersection->setObject(&object_list[index]);
+    }
+  }
+  // Other shapes
+  if (triangle_list.hasOtherShape()) {
+    for (uint i = 0; i < num_of_objects; ++i) {
+      const uint32 index = object_index + i;
+      if (triangle_list.isTriangle(index))
+        continue;
+      const auto& object = object_list[reference_list_[index]];
+      const auto result = object.shape().testIntersection(ray, intersection);
+      if (result)
+        intersection->setObject(&object);
+    }
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+bool Bvh::testRayObjectsOcclusion(const Ray& ray,
+                                  const Float max_distance,
+                                  const Object* ignore_object,
+                                  const uint32 object_index,
+                                  const uint num_of_objects) const noexcept
+{
+  TraversalStatistics::countObjectTests(num_of_objects);
+  const auto& object_list = objectList();
+  const auto& triangle_list = triangleList();
+  // The ignored object can belong to another list, e.g. the object of
+  // an instance, and then no object of the list is ignored
+  const std::less<const Object*> less;
+  const Object* data = object_list.data();
+  const bool is_in_list = (ignore_object != nullptr) &&
+                          !less(ignore_object, data) &&
+                          less(ignore_object, data + object_list.size());
+  const uint32 ignore_index = is_in_list
+      ? zisc::cast<uint32>(ignore_object - data)
+      : BvhBuildingNode::nullIndex();
+  // Triangles
+  if (triangle_list.testOcclusion(ray,
+                                  object_index,
+                                  num_of_objects,
+                                  max_distance,
+                                  ignore_index))
+    return true;
+  // Other shapes
+  if (triangle_list.hasOtherShape()) {
+    for (uint i = 0; i < num_of_objects; ++i) {
+      const uint32 index = object_index + i;
+      if (triangle_list.isTriangle(index) || (reference_list_[index] == ignore_index))
+        continue;
+      const auto& object = object_list[reference_list_[index]];
+      if (object.shape().testOcclusion(ray, max_distance))
+        return true;
+    }
+  }
+  return false;
+}
+
+/*!
+  \details
+  The ordered, the packet and the quantized traversals push at most one entry
+  per tree level, so they can be used only if the depth of the tree doesn't
+  exceed the stack size.
+  */
+inline
+bool Bvh::stackTraversalIsAvailable() const noexcept
+{
+  return stack_traversal_is_available_;
+}
+
+/*!
+  \details
+  The stack holds at most one entry per tree level.
+  */
+inline
+constexpr uint Bvh::traversalStackSize() noexcept
+{
+  return 128;
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_BVH_INL_HPP
@@ -10,33 +10,56 @@
 #include "bvh.hpp"
 // Standard C++ library
 #include <algorithm>
+#include <array>
+#include <bitset>
 #include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ios>
 #include <iterator>
 #include <memory>
 #include <limits>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <utility>
 #include <vector>
 // Zics
 #include "zisc/algorithm.hpp"
+#include "zisc/binary_data.hpp"
 #include "zisc/error.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
 #include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "aabb.hpp"
 #include "agglomerative_treelet_restructuring_bvh.hpp"
 #include "binary_radix_tree_bvh.hpp"
+#include "binned_sah_bvh.hpp"
 #include "bvh_building_node.hpp"
 #include "bvh_tree_node.hpp"
+#include "ploc_bvh.hpp"
+#include "spatial_split_bvh.hpp"
+#include "traversal_ray.hpp"
+#include "traversal_statistics.hpp"
+#include "wide_bvh.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
 #include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
 #include "NanairoCore/Setting/bvh_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Shape/shape.hpp"
 
 namespace nanairo {
 
@@ -44,10 +67,16 @@ namespace nanairo {
   \details
   No detailed.
   */
-Bvh::Bvh(System& system, const SettingNodeBase* /* settings */) noexcept :
+Bvh::Bvh(System& system, const SettingNodeBase* settings) noexcept :
+    shape_arena_{&system.dataMemoryManager()},
     tree_{&system.dataMemoryManager()},
-    object_list_{&system.dataMemoryManager()}
+    object_list_{&system.dataMemoryManager()},
+    reference_list_{&system.dataMemoryManager()},
+    quantized8_tree_{&system.dataMemoryManager()},
+    quantized16_tree_{&system.dataMemoryManager()},
+    triangle_list_{&system.dataMemoryManager()}
 {
+  initialize(settings);
 }
 
 /*!
@@ -56,24 +85,535 @@ Bvh::~Bvh() noexcept
 {
 }
 
+/*!
+  */
+inline
+constexpr uint32 Bvh::cacheFileIdentifier() noexcept
+{
+  return zisc::Fnv1aHash32::hash("NanairoBvhCache");
+}
+
+/*!
+  */
+inline
+constexpr uint32 Bvh::cacheFileVersion() noexcept
+{
+  return 1;
+}
+
+/*!
+  \details
+  The key covers the BVH settings, the bounding box and
+  the four corner points of each shape in the order of the objects.
+  The corner points are the vertices of triangles and patches,
+  so the key covers the full vertex data of meshes and
+  the cache is invalidated when any object is changed, added or removed.
+  */
+uint64 Bvh::calcCacheKey(const SettingNodeBase* settings,
+                         const zisc::pmr::vector<Object>& object_list) noexcept
+{
+  // BVH settings
+  uint64 key = 0;
+  {
+    std::ostringstream setting_stream{std::ios::binary};
+    settings->writeData(&setting_stream);
+    const uint32 float_size = zisc::cast<uint32>(sizeof(Float));
+    const uint32 node_size = zisc::cast<uint32>(sizeof(BvhTreeNode));
+    zisc::write(&float_size, &setting_stream);
+    zisc::write(&node_size, &setting_stream);
+    const auto setting_data = setting_stream.str();
+    key = zisc::Fnv1aHash64::hash(setting_data.data(), setting_data.size());
+  }
+  // Geometry
+  constexpr std::size_t num_of_points = 6;
+  constexpr std::size_t data_size =
+      sizeof(uint64) + sizeof(ShapeType) + num_of_points * 3 * sizeof(Float);
+  std::array<char, data_size> data;
+  const std::array<Point2, 4> st_list{{Point2{0.0, 0.0},
+                                       Point2{1.0, 0.0},
+                                       Point2{0.0, 1.0},
+                                       Point2{1.0, 1.0}}};
+  for (const auto& object : object_list) {
+    const auto& shape = object.shape();
+    const auto bounding_box = shape.boundingBox();
+    const ShapeType shape_type = shape.type();
+    const std::array<Point3, num_of_points> point_list{{
+        bounding_box.minPoint(),
+        bounding_box.maxPoint(),
+        shape.getPoint(st_list[0]).point(),
+        shape.getPoint(st_list[1]).point(),
+        shape.getPoint(st_list[2]).point(),
+        shape.getPoint(st_list[3]).point()}};
+    // Chain the hash of the previous objects
+    std::size_t offset = 0;
+    std::memcpy(&data[offset], &key, sizeof(key));
+    offset += sizeof(key);
+    std::memcpy(&data[offset], &shape_type, sizeof(shape_type));
+    offset += sizeof(shape_type);
+    for (const auto& point : point_list) {
+      for (uint i = 0; i < 3; ++i) {
+        const Float value = point[i];
+        std::memcpy(&data[offset], &value, sizeof(value));
+        offset += sizeof(value);
+      }
+    }
+    key = zisc::Fnv1aHash64::hash(data.data(), data.size());
+  }
+  return key;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+Aabb Bvh::calcLeafBoundingBox(const uint32 object_index,
+                              const uint num_of_objects) const noexcept
+{
+  const auto& object_list = objectList();
+  auto bounding_box = object_list[reference_list_[object_index]].shape().boundingBox();
+  for (uint i = 1; i < num_of_objects; ++i) {
+    const auto& object = object_list[reference_list_[object_index + i]];
+    bounding_box = combine(bounding_box, object.shape().boundingBox());
+  }
+  return bounding_box;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer>
+Float Bvh::calcQuantizedSahCost(
+    const zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree) const noexcept
+{
+  Float cost = bvhTree()[0].boundingBox().surfaceArea();
+  for (const auto& node : tree) {
+    for (uint child = 0; child < 2; ++child) {
+      const Float area = node.childBoundingBox(child).surfaceArea();
+      cost += node.isLeafChild(child)
+          ? zisc::cast<Float>(node.numOfObjects(child)) * area
+          : area;
+    }
+  }
+  return cost;
+}
+
+/*!
+  \details
+  The costs of a node traversal and an object intersection test are
+  regarded as the same.
+  The cost is normalized by the surface area of the root node.
+  */
+Float Bvh::calcSahCost() const noexcept
+{
+  Float cost = 0.0;
+  switch (nodeFormat()) {
+   case BvhNodeFormat::kQuantized8: {
+    cost = calcQuantizedSahCost(quantized8_tree_);
+    break;
+   }
+   case BvhNodeFormat::kQuantized16: {
+    cost = calcQuantizedSahCost(quantized16_tree_);
+    break;
+   }
+   case BvhNodeFormat::kFull:
+   default: {
+    for (const auto& node : bvhTree()) {
+      const Float area = node.boundingBox().surfaceArea();
+      cost += node.isLeafNode()
+          ? zisc::cast<Float>(node.numOfObjects()) * area
+          : area;
+    }
+    break;
+   }
+  }
+  const Float root_area = bvhTree()[0].boundingBox().surfaceArea();
+  return (0.0 < root_area) ? cost / root_area : 0.0;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+uint Bvh::calcTreeDepth(const uint32 index) const noexcept
+{
+  const auto& node = bvhTree()[index];
+  uint depth = 1;
+  if (!node.isLeafNode()) {
+    const uint left_depth = calcTreeDepth(leftChildIndex(index));
+    const uint right_depth = calcTreeDepth(rightChildIndex(index));
+    depth += zisc::max(left_depth, right_depth);
+  }
+  return depth;
+}
+
 /*!
   \details
   No detailed.
   */
 IntersectionInfo Bvh::castRay(const Ray& ray,
                               const Float max_distance,
-                              const bool expect_no_hit) const noexcept 
+                              const bool expect_no_hit) const noexcept
+{
+  auto intersection = findClosestIntersection(ray, max_distance, expect_no_hit);
+  finalizeIntersection(ray, &intersection);
+  return intersection;
+}
+
+/*!
+  \details
+  The rays of a packet share the node fetches of the tree.
+  If the rays aren't coherent, the tree is quantized or the tree is deeper
+  than the traversal stack, the rays are cast one by one instead.
+  */
+void Bvh::castRayPacket(const Ray* ray_list,
+                        const uint num_of_rays,
+                        IntersectionInfo* intersection_list) const noexcept
+{
+  ZISC_ASSERT(num_of_rays <= maxPacketSize(), "The packet is too large.");
+  const bool packet_is_enabled = (1 < num_of_rays) &&
+                                 (nodeFormat() == BvhNodeFormat::kFull) &&
+                                 stackTraversalIsAvailable() &&
+                                 isCoherentPacket(ray_list, num_of_rays);
+  if (packet_is_enabled) {
+    castRayPacketOrdered(ray_list, num_of_rays, intersection_list);
+    for (uint i = 0; i < num_of_rays; ++i)
+      finalizeIntersection(ray_list[i], &intersection_list[i]);
+  }
+  else {
+    constexpr Float max_distance = std::numeric_limits<Float>::max();
+    for (uint i = 0; i < num_of_rays; ++i)
+      intersection_list[i] = castRay(ray_list[i], max_distance);
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+IntersectionInfo Bvh::findClosestIntersection(
+    const Ray& ray,
+    const Float max_distance,
+    const bool expect_no_hit) const noexcept
+{
+  const auto intersection =
+      (nodeFormat() == BvhNodeFormat::kQuantized8)
+          ? castRayQuantized(quantized8_tree_, ray, max_distance, expect_no_hit) :
+      (nodeFormat() == BvhNodeFormat::kQuantized16)
+          ? castRayQuantized(quantized16_tree_, ray, max_distance, expect_no_hit) :
+      (traversalType() == BvhTraversalType::kOrdered)
+          ? castRayOrdered(ray, max_distance, expect_no_hit)
+          : castRayStackless(ray, max_distance, expect_no_hit);
+  return intersection;
+}
+
+/*!
+  \details
+  Both children of an internal node are tested and the near child is
+  visited first, so the closest intersection shrinks the ray distance early
+  and the far subtree is often culled.
+  */
+IntersectionInfo Bvh::castRayOrdered(const Ray& ray,
+                                     const Float max_distance,
+                                     const bool expect_no_hit) const noexcept
 {
   ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
   IntersectionInfo intersection;
   intersection.setRayDistance(max_distance);
+  const auto& bvh_tree = bvhTree();
+  const TraversalRay traversal_ray{ray};
+  auto is_hit = [&intersection](const IntersectionTestResult& result)
+  {
+    return result.isSuccess() && (result.rayDistance() < intersection.rayDistance());
+  };
+
+  // Root
+  {
+    TraversalStatistics::countAabbTests(1);
+    const auto result = bvh_tree[0].testIntersection(traversal_ray);
+    if (!is_hit(result))
+      return intersection;
+  }
+
+  std::array<TraversalEntry, traversalStackSize()> stack;
+  uint stack_size = 0;
   uint32 index = 0;
+  while (true) {
+    const auto& node = bvh_tree[index];
+    TraversalStatistics::countNodes(1);
+    bool has_next = false;
+    // A case of leaf node
+    if (node.isLeafNode()) {
+      testRayObjectsIntersection(ray, node, &intersection);
+      if (intersection.isIntersected() && expect_no_hit)
+        break;
+    }
+    // A case of internal node
+    else {
+      const uint32 left_index = leftChildIndex(index);
+      const uint32 right_index = rightChildIndex(index);
+      TraversalStatistics::countAabbTests(2);
+      const auto left_result =
+          bvh_tree[left_index].testIntersection(traversal_ray);
+      const auto right_result =
+          bvh_tree[right_index].testIntersection(traversal_ray);
+      const bool left_is_hit = is_hit(left_result);
+      const bool right_is_hit = is_hit(right_result);
+      if (left_is_hit && right_is_hit) {
+        ZISC_ASSERT(stack_size < traversalStackSize(), "The stack overflowed.");
+        const bool left_is_near =
+            left_result.rayDistance() <= right_result.rayDistance();
+        index = left_is_near ? left_index : right_index;
+        stack[stack_size++] = left_is_near
+            ? TraversalEntry{right_index, right_result.rayDistance()}
+            : TraversalEntry{left_index, left_result.rayDistance()};
+        has_next = true;
+      }
+      else if (left_is_hit || right_is_hit) {
+        index = left_is_hit ? left_index : right_index;
+        has_next = true;
+      }
+    }
+    // Pop the next node which can still contain a closer intersection
+    while (!has_next && (0 < stack_size)) {
+      const auto& entry = stack[--stack_size];
+      if (entry.distance_ < intersection.rayDistance()) {
+        index = entry.index_;
+        has_next = true;
+      }
+    }
+    if (!has_next)
+      break;
+  }
+  return intersection;
+}
+
+/*!
+  \details
+  The rays are stored in SoA layout,
+  so a box is tested against all rays of the packet in a vectorizable loop.
+  The rays share the direction signs,
+  so the near and far planes of a box are selected once for the packet.
+  */
+void Bvh::castRayPacketOrdered(const Ray* ray_list,
+                               const uint num_of_rays,
+                               IntersectionInfo* intersection_list) const noexcept
+{
+  constexpr uint n = maxPacketSize();
+  constexpr Float max_distance = std::numeric_limits<Float>::max();
+  std::array<std::array<Float, n>, 3> origin_list;
+  std::array<std::array<Float, n>, 3> inv_dir_list;
+  std::array<Float, n> distance_list;
+  for (uint i = 0; i < num_of_rays; ++i) {
+    const auto& ray = ray_list[i];
+    const auto inv_dir = invert(ray.direction());
+    for (uint axis = 0; axis < 3; ++axis) {
+      origin_list[axis][i] = ray.origin()[axis];
+      inv_dir_list[axis][i] = inv_dir[axis];
+    }
+    intersection_list[i] = IntersectionInfo{};
+    intersection_list[i].setRayDistance(max_distance);
+    distance_list[i] = max_distance;
+  }
+  std::array<bool, 3> is_negative;
+  for (uint axis = 0; axis < 3; ++axis)
+    is_negative[axis] = inv_dir_list[axis][0] < 0.0;
+
+  // Return the mask of the rays which hit the box before the closest hits
+  auto test_box = [num_of_rays, &origin_list, &inv_dir_list, &distance_list,
+                   &is_negative](const Aabb& box, const uint32 mask)
+  {
+    TraversalStatistics::countAabbTests(zisc::cast<uint>(std::bitset<32>{mask}.count()));
+    std::array<Float, 3> near_plane;
+    std::array<Float, 3> far_plane;
+    for (uint axis = 0; axis < 3; ++axis) {
+      near_plane[axis] = is_negative[axis] ? box.maxPoint()[axis]
+                                           : box.minPoint()[axis];
+      far_plane[axis] = is_negative[axis] ? box.minPoint()[axis]
+                                          : box.maxPoint()[axis];
+    }
+    std::array<uint32, n> hit_list;
+    for (uint i = 0; i < num_of_rays; ++i) {
+      Float tmin = 0.0;
+      Float tmax = distance_list[i];
+      for (uint axis = 0; axis < 3; ++axis) {
+        const Float o = origin_list[axis][i];
+        const Float inv_d = inv_dir_list[axis][i];
+        tmin = zisc::max(tmin, (near_plane[axis] - o) * inv_d);
+        tmax = zisc::min(tmax, (far_plane[axis] - o) * inv_d);
+      }
+      hit_list[i] = (tmin <= tmax) ? 1u : 0u;
+    }
+    uint32 result = 0;
+    for (uint i = 0; i < num_of_rays; ++i)
+      result |= hit_list[i] << i;
+    return result & mask;
+  };
+
   const auto& bvh_tree = bvhTree();
-  const uint32 end_index = zisc::cast<uint32>(bvh_tree.size());
+  const uint32 all_rays = (num_of_rays < 32)
+      ? (1u << num_of_rays) - 1u
+      : std::numeric_limits<uint32>::max();
+  std::array<PacketEntry, traversalStackSize()> stack;
+  uint stack_size = 0;
+  uint32 index = 0;
+  uint32 mask = test_box(bvh_tree[0].boundingBox(), all_rays);
+  while (true) {
+    if (mask != 0) {
+      const auto& node = bvh_tree[index];
+      TraversalStatistics::countNodes(1);
+      // A case of leaf node
+      if (node.isLeafNode()) {
+        for (uint i = 0; i < num_of_rays; ++i) {
+          if ((mask >> i) & 1u) {
+            testRayObjectsIntersection(ray_list[i], node, &intersection_list[i]);
+            distance_list[i] = intersection_list[i].rayDistance();
+          }
+        }
+        mask = 0;
+      }
+      // A case of internal node
+      else {
+        const uint32 left_index = leftChildIndex(index);
+        const uint32 right_index = rightChildIndex(index);
+        const auto& left_box = bvh_tree[left_index].boundingBox();
+        const auto& right_box = bvh_tree[right_index].boundingBox();
+        const uint32 left_mask = test_box(left_box, mask);
+        const uint32 right_mask = test_box(right_box, mask);
+        if ((left_mask != 0) && (right_mask != 0)) {
+          ZISC_ASSERT(stack_size < traversalStackSize(), "The stack overflowed.");
+          // The packet visits the child in front along the directions first
+          const auto diff = right_box.centroid() - left_box.centroid();
+          const bool left_is_near = 0.0 <= zisc::dot(diff, ray_list[0].direction());
+          index = left_is_near ? left_index : right_index;
+          mask = left_is_near ? left_mask : right_mask;
+          stack[stack_size++] = left_is_near
+              ? PacketEntry{right_index, right_mask}
+              : PacketEntry{left_index, left_mask};
+        }
+        else {
+          index = (left_mask != 0) ? left_index : right_index;
+          mask = left_mask | right_mask;
+        }
+      }
+    }
+    // Pop the next node and drop the rays which already found closer hits
+    while ((mask == 0) && (0 < stack_size)) {
+      const auto& entry = stack[--stack_size];
+      index = entry.index_;
+      mask = test_box(bvh_tree[index].boundingBox(), entry.mask_);
+    }
+    if (mask == 0)
+      break;
+  }
+}
+
+/*!
+  \details
+  A node holds the bounding boxes of both children,
+  so each child box is tested before the child is fetched.
+  The leaf children are tested in place and
+  the near internal child is visited first.
+  */
+template <typename Integer>
+IntersectionInfo Bvh::castRayQuantized(
+    const zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+    const Ray& ray,
+    const Float max_distance,
+    const bool expect_no_hit) const noexcept
+{
+  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  IntersectionInfo intersection;
+  intersection.setRayDistance(max_distance);
   const auto inv_dir = invert(ray.direction());
+  auto is_hit = [&intersection](const IntersectionTestResult& result)
+  {
+    return result.isSuccess() && (result.rayDistance() < intersection.rayDistance());
+  };
+
+  // Root
+  {
+    TraversalStatistics::countAabbTests(1);
+    const auto result = tree_[0].boundingBox().testIntersection(ray, inv_dir);
+    if (!is_hit(result))
+      return intersection;
+  }
+
+  std::array<TraversalEntry, traversalStackSize()> stack;
+  uint stack_size = 0;
+  uint32 index = 0;
+  while (true) {
+    const auto& node = tree[index];
+    TraversalStatistics::countNodes(1);
+    TraversalStatistics::countAabbTests(2);
+    const std::array<IntersectionTestResult, 2> result_list{{
+        node.childBoundingBox(0).testIntersection(ray, inv_dir),
+        node.childBoundingBox(1).testIntersection(ray, inv_dir)}};
+    const uint near_child =
+        (result_list[0].rayDistance() <= result_list[1].rayDistance()) ? 0 : 1;
+    const uint far_child = 1 - near_child;
+    // Leaf children
+    for (const uint child : {near_child, far_child}) {
+      if (node.isLeafChild(child) && is_hit(result_list[child])) {
+        testRayObjectsIntersection(ray,
+                                   node.childIndex(child),
+                                   node.numOfObjects(child),
+                                   &intersection);
+      }
+    }
+    if (intersection.isIntersected() && expect_no_hit)
+      break;
+    // Internal children
+    const bool near_is_hit = !node.isLeafChild(near_child) &&
+                             is_hit(result_list[near_child]);
+    const bool far_is_hit = !node.isLeafChild(far_child) &&
+                            is_hit(result_list[far_child]);
+    bool has_next = false;
+    if (near_is_hit && far_is_hit) {
+      ZISC_ASSERT(stack_size < traversalStackSize(), "The stack overflowed.");
+      index = node.childIndex(near_child);
+      stack[stack_size++] = TraversalEntry{node.childIndex(far_child),
+                                           result_list[far_child].rayDistance()};
+      has_next = true;
+    }
+    else if (near_is_hit || far_is_hit) {
+      index = node.childIndex(near_is_hit ? near_child : far_child);
+      has_next = true;
+    }
+    // Pop the next node which can still contain a closer intersection
+    while (!has_next && (0 < stack_size)) {
+      const auto& entry = stack[--stack_size];
+      if (entry.distance_ < intersection.rayDistance()) {
+        index = entry.index_;
+        has_next = true;
+      }
+    }
+    if (!has_next)
+      break;
+  }
+  return intersection;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+IntersectionInfo Bvh::castRayStackless(const Ray& ray,
+                                       const Float max_distance,
+                                       const bool expect_no_hit) const noexcept
+{
+  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  IntersectionInfo intersection;
+  intersection.setRayDistance(max_distance);
+  uint32 index = 0;
+  const auto& bvh_tree = bvhTree();
+  const uint32 end_index = zisc::cast<uint32>(bvh_tree.size());
+  const TraversalRay traversal_ray{ray};
   while ((index != end_index) && !(intersection.isIntersected() && expect_no_hit)) {
     const auto& node = bvh_tree[index];
-    const auto result = node.boundingBox().testIntersection(ray, inv_dir);
+    TraversalStatistics::countNodes(1);
+    TraversalStatistics::countAabbTests(1);
+    const auto result = node.testIntersection(traversal_ray);
     // If the ray hits the bounding box of the node, enter the node
     if (result.isSuccess() && (result.rayDistance() < intersection.rayDistance())) {
       // A case of leaf node
@@ -88,6 +628,106 @@ IntersectionInfo Bvh::castRay(const Ray& ray,
   return intersection;
 }
 
+/*!
+  \details
+  The nodes are sorted in depth-first order,
+  so the children are evaluated before their parent in reverse order.
+  A subtree is collapsed into a leaf if intersecting all the objects
+  is cheaper than traversing the subtree.
+  */
+void Bvh::collapseLeaves(const zisc::pmr::vector<BvhBuildingNode>& tree,
+                         const uint32 max_leaf_size,
+                         zisc::pmr::vector<SubtreeInfo>& subtree_list) noexcept
+{
+  const uint32 max_num_of_objects =
+      zisc::clamp(max_leaf_size, 1u, BvhBuildingNode::maxNumOfLeafObjects());
+  subtree_list.resize(tree.size());
+  for (uint32 i = zisc::cast<uint32>(tree.size()); 0 < i; --i) {
+    const uint32 index = i - 1;
+    const auto& node = tree[index];
+    const Float area = node.boundingBox().surfaceArea();
+    auto& subtree = subtree_list[index];
+    if (node.isLeafNode()) {
+      subtree.object_cost_ = node.object()->shape().getTraversalCost();
+      subtree.cost_ = area * subtree.object_cost_;
+      subtree.num_of_objects_ = 1;
+      subtree.num_of_nodes_ = 1;
+    }
+    else {
+      const auto& left = subtree_list[node.leftChildIndex()];
+      const auto& right = subtree_list[node.rightChildIndex()];
+      subtree.object_cost_ = left.object_cost_ + right.object_cost_;
+      subtree.num_of_objects_ = left.num_of_objects_ + right.num_of_objects_;
+      const Float leaf_cost = area * subtree.object_cost_;
+      const Float node_cost = area * nodeTraversalCost() + left.cost_ + right.cost_;
+      const bool is_collapsed = (subtree.num_of_objects_ <= max_num_of_objects) &&
+                                (leaf_cost <= node_cost);
+      subtree.cost_ = is_collapsed ? leaf_cost : node_cost;
+      subtree.num_of_nodes_ = is_collapsed
+          ? 1
+          : 1 + left.num_of_nodes_ + right.num_of_nodes_;
+    }
+  }
+}
+
+/*!
+  \details
+  The nodes of a subtree are placed in a range in depth-first order,
+  so a subtree is refitted by visiting the range backward.
+  */
+void Bvh::collectRefitTasks(
+    const uint32 index,
+    const uint depth,
+    zisc::pmr::vector<uint32>& top_node_list,
+    zisc::pmr::vector<std::array<uint32, 2>>& subtree_list) const noexcept
+{
+  const auto& node = tree_[index];
+  if (!node.isLeafNode() && (depth == refitTaskDepth())) {
+    subtree_list.push_back({{index, node.failureNextIndex()}});
+  }
+  else {
+    top_node_list.emplace_back(index);
+    if (!node.isLeafNode()) {
+      collectRefitTasks(leftChildIndex(index), depth + 1, top_node_list, subtree_list);
+      collectRefitTasks(rightChildIndex(index), depth + 1, top_node_list, subtree_list);
+    }
+  }
+}
+
+/*!
+  \details
+  The internal nodes of the quantized tree are also placed in depth-first order.
+  The range of the left subtree ends at the right child.
+  */
+template <typename Integer>
+void Bvh::collectRefitTasks(
+    const zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+    const uint32 index,
+    const uint32 end,
+    const uint depth,
+    zisc::pmr::vector<uint32>& top_node_list,
+    zisc::pmr::vector<std::array<uint32, 2>>& subtree_list) const noexcept
+{
+  if (depth == refitTaskDepth()) {
+    subtree_list.push_back({{index, end}});
+  }
+  else {
+    top_node_list.emplace_back(index);
+    const auto& node = tree[index];
+    const bool left_is_internal = !node.isLeafChild(0);
+    const bool right_is_internal = !node.isLeafChild(1);
+    const uint32 left_end = right_is_internal ? node.childIndex(1) : end;
+    if (left_is_internal) {
+      collectRefitTasks(tree, node.childIndex(0), left_end, depth + 1,
+                        top_node_list, subtree_list);
+    }
+    if (right_is_internal) {
+      collectRefitTasks(tree, node.childIndex(1), end, depth + 1,
+                        top_node_list, subtree_list);
+    }
+  }
+}
+
 /*!
   \details
   No detailed.
@@ -106,14 +746,99 @@ void Bvh::construct(System& system,
   }
   else {
     auto work_resource = settings->workResource();
-    zisc::pmr::vector<BvhBuildingNode> tree{work_resource};
-    constructBvh(system, object_list, tree);
-    sortTreeNode(tree);
-    tree_.resize(tree.size());
-    setTreeInfo(tree, object_list, zisc::cast<uint32>(tree.size()), 0);
+    zisc::pmr::vector<uint32> index_map{work_resource};
+    index_map.resize(object_list.size(), BvhBuildingNode::nullIndex());
+    // Load the BVH from the cache if the same scene was built before
+    const auto bvh_settings = castNode<BvhSettingNode>(settings);
+    const auto cache_directory = bvh_settings->cacheDirectory();
+    const bool cache_is_enabled = !cache_directory.empty();
+    const uint64 cache_key = cache_is_enabled
+        ? calcCacheKey(settings, object_list)
+        : 0;
+    const auto cache_file_path = cache_is_enabled
+        ? makeCacheFilePath(cache_directory, cache_key)
+        : std::string{};
+    const bool is_cached = cache_is_enabled &&
+        loadCache(cache_file_path, cache_key, object_list, index_map);
+    if (!is_cached) {
+      zisc::pmr::vector<BvhBuildingNode> tree{work_resource};
+      constructBvh(system, object_list, tree);
+      sortTreeNode(tree);
+      zisc::pmr::vector<SubtreeInfo> subtree_list{work_resource};
+      collapseLeaves(tree, bvh_settings->maxLeafSize(), subtree_list);
+      const uint32 tree_size = subtree_list[0].num_of_nodes_;
+      tree_.resize(tree_size);
+      reference_list_.reserve(subtree_list[0].num_of_objects_);
+      setTreeInfo(tree, subtree_list, object_list, index_map, tree_size, 0, 0);
+      if (cache_is_enabled)
+        saveCache(cache_file_path, cache_key, index_map);
+    }
   }
   ZISC_ASSERT(object_list_.size() == object_list.size(),
               "The object list is collapsed.");
+  triangle_list_.setObjectList(object_list_, reference_list_);
+  // The stack traversals require a stack as deep as the tree
+  stack_traversal_is_available_ = calcTreeDepth(0) <= traversalStackSize();
+  if ((traversalType() == BvhTraversalType::kOrdered) &&
+      !stackTraversalIsAvailable()) {
+    traversal_type_ = BvhTraversalType::kStackless;
+  }
+  constructTraversalTree(system, settings);
+  sah_cost_ = calcSahCost();
+}
+
+/*!
+  \details
+  The tree of BVH is used in ray traversal by default.
+  If a quantized node format is specified, the tree is converted into
+  the quantized tree and only the root of the tree is kept.
+  */
+void Bvh::constructTraversalTree(System& /* system */,
+                                 const SettingNodeBase* settings) noexcept
+{
+  const auto bvh_settings = castNode<BvhSettingNode>(settings);
+  node_format_ = bvh_settings->nodeFormat();
+  // The quantized traversal requires a stack as deep as the tree
+  if ((nodeFormat() != BvhNodeFormat::kFull) &&
+      (tree_[0].isLeafNode() || !stackTraversalIsAvailable())) {
+    node_format_ = BvhNodeFormat::kFull;
+  }
+
+  switch (nodeFormat()) {
+   case BvhNodeFormat::kQuantized8: {
+    constructQuantizedTree(quantized8_tree_);
+    break;
+   }
+   case BvhNodeFormat::kQuantized16: {
+    constructQuantizedTree(quantized16_tree_);
+    break;
+   }
+   case BvhNodeFormat::kFull:
+   default: {
+    node_format_ = BvhNodeFormat::kFull;
+    break;
+   }
+  }
+
+  if (nodeFormat() != BvhNodeFormat::kFull) {
+    tree_.resize(1);
+    tree_.shrink_to_fit();
+  }
+}
+
+/*!
+  \details
+  The internal nodes of the tree are stored in depth-first order.
+  */
+template <typename Integer>
+void Bvh::constructQuantizedTree(
+    zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree) const noexcept
+{
+  const uint32 num_of_internal_nodes = zisc::cast<uint32>(tree_.size() >> 1);
+  tree.resize(num_of_internal_nodes);
+  const uint32 size = setQuantizedNode(tree, 0, 0);
+  ZISC_ASSERT(size == num_of_internal_nodes, "The quantized tree is collapsed.");
+  static_cast<void>(size);
 }
 
 /*!
@@ -129,27 +854,591 @@ zisc::UniqueMemoryPointer<Bvh> Bvh::makeBvh(
   zisc::UniqueMemoryPointer<Bvh> bvh;
   switch (bvh_setting_node->bvhType()) {
    case BvhType::kBinaryRadixTree: {
-    bvh = zisc::UniqueMemoryPointer<BinaryRadixTreeBvh>::make(
+    bvh = makeBvh<BinaryRadixTreeBvh>(system, settings);
+    break;
+   }
+   case BvhType::kAgglomerativeTreeletRestructuring: {
+    bvh = makeBvh<AgglomerativeTreeletRestructuringBvh>(system, settings);
+    break;
+   }
+   case BvhType::kBinnedSah: {
+    bvh = makeBvh<BinnedSahBvh>(system, settings);
+    break;
+   }
+   case BvhType::kPloc: {
+    bvh = makeBvh<PlocBvh>(system, settings);
+    break;
+   }
+   case BvhType::kSpatialSplit: {
+    bvh = makeBvh<SpatialSplitBvh>(system, settings);
+    break;
+   }
+   default: {
+    zisc::raiseError("BvhError: Unsupported type is specified.");
+    break;
+   }
+  }
+  return bvh;
+}
+
+/*!
+  \details
+  The tree built by the builder is collapsed into a wide tree
+  if the node width is 4 or 8.
+  */
+template <typename BuilderBvh>
+zisc::UniqueMemoryPointer<Bvh> Bvh::makeBvh(
+    System& system,
+    const SettingNodeBase* settings) noexcept
+{
+  const auto bvh_setting_node = castNode<BvhSettingNode>(settings);
+
+  zisc::UniqueMemoryPointer<Bvh> bvh;
+  switch (bvh_setting_node->nodeWidth()) {
+   case 4: {
+    bvh = zisc::UniqueMemoryPointer<WideBvh<4, BuilderBvh>>::make(
         &system.dataMemoryManager(),
         system,
         settings);
     break;
    }
-   case BvhType::kAgglomerativeTreeletRestructuring: {
-    bvh = zisc::UniqueMemoryPointer<AgglomerativeTreeletRestructuringBvh>::make(
+   case 8: {
+    bvh = zisc::UniqueMemoryPointer<WideBvh<8, BuilderBvh>>::make(
         &system.dataMemoryManager(),
         system,
         settings);
     break;
    }
    default: {
-    zisc::raiseError("BvhError: Unsupported type is specified.");
+    bvh = zisc::UniqueMemoryPointer<BuilderBvh>::make(
+        &system.dataMemoryManager(),
+        system,
+        settings);
     break;
    }
   }
   return bvh;
 }
 
+/*!
+  \details
+  The traversal order doesn't matter for an occlusion query,
+  so the failure links of the tree are followed without a stack and
+  the traversal ends at the first occluder.
+  */
+bool Bvh::testOcclusion(const Ray& ray,
+                        const Float max_distance,
+                        const Object* ignore_object) const noexcept
+{
+  if (nodeFormat() == BvhNodeFormat::kQuantized8)
+    return testOcclusionQuantized(quantized8_tree_, ray, max_distance, ignore_object);
+  if (nodeFormat() == BvhNodeFormat::kQuantized16)
+    return testOcclusionQuantized(quantized16_tree_, ray, max_distance, ignore_object);
+
+  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  uint32 index = 0;
+  const auto& bvh_tree = bvhTree();
+  const uint32 end_index = zisc::cast<uint32>(bvh_tree.size());
+  const TraversalRay traversal_ray{ray};
+  while (index != end_index) {
+    const auto& node = bvh_tree[index];
+    TraversalStatistics::countNodes(1);
+    TraversalStatistics::countAabbTests(1);
+    const auto result = node.testIntersection(traversal_ray);
+    // If the ray hits the bounding box of the node, enter the node
+    if (result.isSuccess() && (result.rayDistance() < max_distance)) {
+      // A case of leaf node
+      if (node.isLeafNode() && testRayObjectsOcclusion(ray,
+                                                       max_distance,
+                                                       ignore_object,
+                                                       node.objectIndex(),
+                                                       node.numOfObjects()))
+        return true;
+      ++index;
+    }
+    else {
+      index = node.failureNextIndex();
+    }
+  }
+  return false;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer>
+bool Bvh::testOcclusionQuantized(
+    const zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+    const Ray& ray,
+    const Float max_distance,
+    const Object* ignore_object) const noexcept
+{
+  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  const auto inv_dir = invert(ray.direction());
+  auto is_hit = [max_distance](const IntersectionTestResult& result)
+  {
+    return result.isSuccess() && (result.rayDistance() < max_distance);
+  };
+
+  // Root
+  {
+    TraversalStatistics::countAabbTests(1);
+    const auto result = tree_[0].boundingBox().testIntersection(ray, inv_dir);
+    if (!is_hit(result))
+      return false;
+  }
+
+  std::array<uint32, traversalStackSize()> stack;
+  uint stack_size = 0;
+  stack[stack_size++] = 0;
+  while (0 < stack_size) {
+    const auto& node = tree[stack[--stack_size]];
+    TraversalStatistics::countNodes(1);
+    for (uint child = 0; child < 2; ++child) {
+      TraversalStatistics::countAabbTests(1);
+      const auto result = node.childBoundingBox(child).testIntersection(ray, inv_dir);
+      if (!is_hit(result))
+        continue;
+      if (node.isLeafChild(child)) {
+        if (testRayObjectsOcclusion(ray,
+                                    max_distance,
+                                    ignore_object,
+                                    node.childIndex(child),
+                                    node.numOfObjects(child)))
+          return true;
+      }
+      else {
+        ZISC_ASSERT(stack_size < traversalStackSize(), "The stack overflowed.");
+        stack[stack_size++] = node.childIndex(child);
+      }
+    }
+  }
+  return false;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Bvh::initialize(const SettingNodeBase* settings) noexcept
+{
+  const auto bvh_settings = castNode<BvhSettingNode>(settings);
+  traversal_type_ = bvh_settings->traversalType();
+  node_format_ = BvhNodeFormat::kFull;
+  sah_cost_ = 0.0;
+  stack_traversal_is_available_ = false;
+}
+
+/*!
+  \details
+  The rays are coherent if the signs of their directions are the same.
+  */
+bool Bvh::isCoherentPacket(const Ray* ray_list,
+                           const uint num_of_rays) noexcept
+{
+  const auto inv_dir = invert(ray_list[0].direction());
+  for (uint i = 1; i < num_of_rays; ++i) {
+    const auto d = invert(ray_list[i].direction());
+    for (uint axis = 0; axis < 3; ++axis) {
+      if ((inv_dir[axis] < 0.0) != (d[axis] < 0.0))
+        return false;
+    }
+  }
+  return true;
+}
+
+/*!
+  \details
+  The cache is read in bulk and validated before any object is moved,
+  so a broken or stale file just falls back to building the BVH.
+  */
+bool Bvh::loadCache(const std::string& cache_file_path,
+                    const uint64 cache_key,
+                    zisc::pmr::vector<Object>& object_list,
+                    zisc::pmr::vector<uint32>& index_map) noexcept
+{
+  std::ifstream cache_file{cache_file_path, std::ios::binary};
+  if (!cache_file.is_open())
+    return false;
+
+  // Header
+  const uint32 num_of_objects = zisc::cast<uint32>(object_list.size());
+  uint32 tree_size = 0;
+  uint32 num_of_references = 0;
+  {
+    uint32 identifier = 0,
+           version = 0,
+           size = 0;
+    uint64 key = 0;
+    zisc::read(&identifier, &cache_file);
+    zisc::read(&version, &cache_file);
+    zisc::read(&key, &cache_file);
+    zisc::read(&size, &cache_file);
+    zisc::read(&tree_size, &cache_file);
+    zisc::read(&num_of_references, &cache_file);
+    const bool is_valid = cache_file.good() &&
+                          (identifier == cacheFileIdentifier()) &&
+                          (version == cacheFileVersion()) &&
+                          (key == cache_key) &&
+                          (size == num_of_objects) &&
+                          (0 < tree_size) &&
+                          (num_of_objects <= num_of_references) &&
+                          (num_of_references <= BvhBuildingNode::maxNumOfLeafs());
+    if (!is_valid)
+      return false;
+  }
+
+  // Body
+  zisc::pmr::vector<uint32> order_list{index_map.get_allocator().resource()};
+  order_list.resize(num_of_objects);
+  tree_.resize(tree_size);
+  reference_list_.resize(num_of_references);
+  zisc::read(order_list.data(), &cache_file, sizeof(uint32) * num_of_objects);
+  zisc::read(tree_.data(), &cache_file, sizeof(BvhTreeNode) * tree_size);
+  zisc::read(reference_list_.data(), &cache_file, sizeof(uint32) * num_of_references);
+  bool is_valid = cache_file.good();
+  for (uint32 i = 0; is_valid && (i < num_of_objects); ++i) {
+    const uint32 object_index = order_list[i];
+    is_valid = (object_index < num_of_objects) &&
+               (index_map[object_index] == BvhBuildingNode::nullIndex());
+    if (is_valid)
+      index_map[object_index] = i;
+  }
+  for (uint32 i = 0; is_valid && (i < num_of_references); ++i)
+    is_valid = reference_list_[i] < num_of_objects;
+  // The failure links must go forward so that the stackless traversal ends,
+  // and the children of an internal node must follow the node in the tree
+  for (uint32 i = 0; is_valid && (i < tree_size); ++i) {
+    const auto& node = tree_[i];
+    is_valid = (i < node.failureNextIndex()) &&
+               (node.failureNextIndex() <= tree_size);
+    if (is_valid && node.isLeafNode()) {
+      is_valid = (node.objectIndex() <= num_of_references) &&
+                 (node.numOfObjects() <= num_of_references - node.objectIndex());
+    }
+    else if (is_valid) {
+      const uint32 left_child_index = i + 1;
+      is_valid = (left_child_index < tree_size) &&
+                 (tree_[left_child_index].failureNextIndex() < tree_size);
+    }
+  }
+  // The box of a leaf must be made from the boxes of its objects.
+  // The boxes of the objects can be clipped by spatial splits, so the leaf box
+  // is contained in the objects and overlaps every object.
+  // The box of a node is rounded to TraversalFloat,
+  // so the box of the objects is rounded in the same way before comparison
+  auto overlaps = [](const Aabb& a, const Aabb& b)
+  {
+    bool result = true;
+    for (uint axis = 0; result && (axis < 3); ++axis) {
+      result = (a.minPoint()[axis] <= b.maxPoint()[axis]) &&
+               (b.minPoint()[axis] <= a.maxPoint()[axis]);
+    }
+    return result;
+  };
+  auto contains = [](const Aabb& outer, const Aabb& inner)
+  {
+    bool result = true;
+    for (uint axis = 0; result && (axis < 3); ++axis) {
+      result = (outer.minPoint()[axis] <= inner.minPoint()[axis]) &&
+               (inner.maxPoint()[axis] <= outer.maxPoint()[axis]);
+    }
+    return result;
+  };
+  for (uint32 i = 0; is_valid && (i < tree_size); ++i) {
+    const auto& node = tree_[i];
+    if (!node.isLeafNode())
+      continue;
+    Aabb object_box;
+    for (uint k = 0; is_valid && (k < node.numOfObjects()); ++k) {
+      const uint32 index = order_list[reference_list_[node.objectIndex() + k]];
+      const auto box = object_list[index].shape().boundingBox();
+      is_valid = overlaps(node.boundingBox(), box);
+      object_box = (k == 0) ? box : combine(object_box, box);
+    }
+    BvhTreeNode object_node;
+    object_node.setBoundingBox(object_box);
+    is_valid = is_valid && contains(object_node.boundingBox(), node.boundingBox());
+  }
+  if (!is_valid) {
+    tree_.clear();
+    reference_list_.clear();
+    std::fill(index_map.begin(), index_map.end(), BvhBuildingNode::nullIndex());
+    return false;
+  }
+
+  // Objects
+  for (const uint32 object_index : order_list)
+    object_list_.emplace_back(std::move(object_list[object_index]));
+  return true;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+std::string Bvh::makeCacheFilePath(const std::string_view& cache_directory,
+                                   const uint64 cache_key) noexcept
+{
+  constexpr std::size_t num_of_digits = 2 * sizeof(cache_key);
+  std::array<char, num_of_digits + 1> key_string;
+  std::snprintf(key_string.data(), key_string.size(), "%016llx",
+                zisc::cast<unsigned long long>(cache_key));
+  std::string cache_file_path{cache_directory};
+  cache_file_path += "/bvh_";
+  cache_file_path += key_string.data();
+  cache_file_path += ".nanacache";
+  return cache_file_path;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Bvh::rebuild(System& system, const SettingNodeBase* settings) noexcept
+{
+  zisc::pmr::vector<Object> object_list{settings->workResource()};
+  object_list.reserve(object_list_.size());
+  for (auto& object : object_list_)
+    object_list.emplace_back(std::move(object));
+  object_list_.clear();
+  reference_list_.clear();
+  tree_.clear();
+  quantized8_tree_.clear();
+  quantized16_tree_.clear();
+  initialize(settings);
+  construct(system, settings, std::move(object_list));
+}
+
+/*!
+  \details
+  The cost is relative to the traversal cost of a triangle.
+  */
+inline
+constexpr Float Bvh::nodeTraversalCost() noexcept
+{
+  return 1.0;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+constexpr Float Bvh::rebuildCostRatio() noexcept
+{
+  return 1.5;
+}
+
+/*!
+  \details
+  The transformation list is indexed as the object list.
+  The faces of a mesh refer the vertex data shared by the faces,
+  which the BVH doesn't own, so the mesh must be transformed by
+  TriangleMesh before the refit and
+  the faces must be given the identity, then their surface areas are updated.
+  The topology of the tree is kept and only the bounding boxes are updated.
+  If the SAH cost of the refitted tree exceeds the cost when the tree was built
+  by the rebuild ratio, the tree is built again.
+  Returns true if the tree is built again, then the object list is reordered.
+  */
+bool Bvh::refit(System& system,
+                const SettingNodeBase* settings,
+                const zisc::pmr::vector<Matrix4x4>& transformation_list) noexcept
+{
+  ZISC_ASSERT(transformation_list.size() == objectList().size(),
+              "The size of the transformation list is invalid.");
+  transformObjects(system, transformation_list);
+  triangle_list_.setObjectList(object_list_, reference_list_);
+  refitTraversalTree(system, settings);
+
+  const bool is_degraded = rebuildCostRatio() * sah_cost_ < calcSahCost();
+  if (is_degraded)
+    rebuild(system, settings);
+  return is_degraded;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename RefitNode>
+void Bvh::refitInParallel(
+    System& system,
+    const zisc::pmr::vector<uint32>& top_node_list,
+    const zisc::pmr::vector<std::array<uint32, 2>>& subtree_list,
+    RefitNode& refit_node) const noexcept
+{
+  // Refit the subtrees from the bottom
+  auto refit_subtree = [&subtree_list, &refit_node](const uint task_id)
+  {
+    const auto& range = subtree_list[task_id];
+    for (uint32 index = range[1]; range[0] < index; --index)
+      refit_node(index - 1);
+  };
+  constexpr bool threading = threadingIsEnabled();
+  const uint num_of_tasks = zisc::cast<uint>(subtree_list.size());
+  if (threading && (1 < num_of_tasks)) {
+    auto& threads = system.threadManager();
+    auto work_resource = subtree_list.get_allocator().resource();
+    constexpr uint start = 0;
+    auto result = threads.enqueueLoop(refit_subtree, start, num_of_tasks, work_resource);
+    result.wait();
+  }
+  else {
+    for (uint task_id = 0; task_id < num_of_tasks; ++task_id)
+      refit_subtree(task_id);
+  }
+  // Refit the nodes above the subtrees
+  for (auto index = top_node_list.rbegin(); index != top_node_list.rend(); ++index)
+    refit_node(*index);
+}
+
+/*!
+  \details
+  The bounding box of an internal child is taken from the grid of the child,
+  which covers the exact bounding box of the child.
+  */
+template <typename Integer>
+void Bvh::refitQuantizedTree(zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+                             System& system,
+                             zisc::pmr::memory_resource* work_resource) noexcept
+{
+  zisc::pmr::vector<uint32> top_node_list{work_resource};
+  zisc::pmr::vector<std::array<uint32, 2>> subtree_list{work_resource};
+  const uint32 end = zisc::cast<uint32>(tree.size());
+  collectRefitTasks(tree, 0, end, 0, top_node_list, subtree_list);
+
+  auto refit_node = [this, &tree](const uint32 index)
+  {
+    auto& node = tree[index];
+    std::array<Aabb, 2> box_list;
+    for (uint child = 0; child < 2; ++child) {
+      box_list[child] = node.isLeafChild(child)
+          ? calcLeafBoundingBox(node.childIndex(child), node.numOfObjects(child))
+          : tree[node.childIndex(child)].boundingBox();
+    }
+    node.setBoundingBox(combine(box_list[0], box_list[1]));
+    for (uint child = 0; child < 2; ++child) {
+      node.setChild(child,
+                    box_list[child],
+                    node.childIndex(child),
+                    node.numOfObjects(child));
+    }
+  };
+  refitInParallel(system, top_node_list, subtree_list, refit_node);
+  tree_[0].setBoundingBox(tree[0].boundingBox());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+constexpr uint Bvh::refitTaskDepth() noexcept
+{
+  return 6;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Bvh::refitTraversalTree(System& system, const SettingNodeBase* settings) noexcept
+{
+  auto work_resource = settings->workResource();
+  switch (nodeFormat()) {
+   case BvhNodeFormat::kQuantized8: {
+    refitQuantizedTree(quantized8_tree_, system, work_resource);
+    break;
+   }
+   case BvhNodeFormat::kQuantized16: {
+    refitQuantizedTree(quantized16_tree_, system, work_resource);
+    break;
+   }
+   case BvhNodeFormat::kFull:
+   default: {
+    refitTree(system, work_resource);
+    break;
+   }
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Bvh::refitTree(System& system, zisc::pmr::memory_resource* work_resource) noexcept
+{
+  zisc::pmr::vector<uint32> top_node_list{work_resource};
+  zisc::pmr::vector<std::array<uint32, 2>> subtree_list{work_resource};
+  collectRefitTasks(0, 0, top_node_list, subtree_list);
+
+  auto refit_node = [this](const uint32 index)
+  {
+    auto& node = tree_[index];
+    const auto bounding_box = node.isLeafNode()
+        ? calcLeafBoundingBox(node.objectIndex(), node.numOfObjects())
+        : combine(tree_[leftChildIndex(index)].boundingBox(),
+                  tree_[rightChildIndex(index)].boundingBox());
+    node.setBoundingBox(bounding_box);
+  };
+  refitInParallel(system, top_node_list, subtree_list, refit_node);
+}
+
+/*!
+  \details
+  The objects are in the order of the leaves, so the shapes of a leaf
+  become adjacent in memory. The shapes are moved, so the pointers to
+  the shapes are invalidated. The pointers to the objects are kept.
+  */
+void Bvh::relocateShapes() noexcept
+{
+  shape_arena_.relocate(object_list_);
+}
+
+/*!
+  \details
+  Failing to write the cache doesn't affect rendering,
+  so the error is ignored.
+  */
+void Bvh::saveCache(const std::string& cache_file_path,
+                    const uint64 cache_key,
+                    const zisc::pmr::vector<uint32>& index_map) const noexcept
+{
+  std::ofstream cache_file{cache_file_path, std::ios::binary};
+  if (!cache_file.is_open())
+    return;
+
+  // Invert the index map into the original indices in the leaf order
+  const uint32 num_of_objects = zisc::cast<uint32>(index_map.size());
+  zisc::pmr::vector<uint32> order_list{index_map.get_allocator().resource()};
+  order_list.resize(num_of_objects);
+  for (uint32 object_index = 0; object_index < num_of_objects; ++object_index)
+    order_list[index_map[object_index]] = object_index;
+
+  // Header
+  {
+    const uint32 identifier = cacheFileIdentifier();
+    const uint32 version = cacheFileVersion();
+    const uint32 tree_size = zisc::cast<uint32>(tree_.size());
+    const uint32 num_of_references = zisc::cast<uint32>(reference_list_.size());
+    zisc::write(&identifier, &cache_file);
+    zisc::write(&version, &cache_file);
+    zisc::write(&cache_key, &cache_file);
+    zisc::write(&num_of_objects, &cache_file);
+    zisc::write(&tree_size, &cache_file);
+    zisc::write(&num_of_references, &cache_file);
+  }
+  // Body
+  zisc::write(order_list.data(), &cache_file, sizeof(uint32) * num_of_objects);
+  zisc::write(tree_.data(), &cache_file, sizeof(BvhTreeNode) * tree_.size());
+  zisc::write(reference_list_.data(),
+              &cache_file,
+              sizeof(uint32) * reference_list_.size());
+}
+
 /*!
   */
 void Bvh::setupBoundingBox(zisc::pmr::vector<BvhBuildingNode>& tree,
@@ -158,15 +1447,7 @@ void Bvh::setupBoundingBox(zisc::pmr::vector<BvhBuildingNode>& tree,
   auto& node = tree[index];
   // Leaf node
   if (node.isLeafNode()) {
-    ZISC_ASSERT(0 < node.numOfObjects(), "Node has no object.");
-    const auto& object_list = node.objectList();
-    auto bounding_box = object_list[0]->shape().boundingBox();
-    for (uint i = 1; i < node.numOfObjects(); ++i) {
-      const auto object = object_list[i];
-      ZISC_ASSERT(object != nullptr, "The object is null.");
-      bounding_box = combine(bounding_box, object->shape().boundingBox());
-    }
-    node.setBoundingBox(bounding_box);
+    node.setBoundingBox(node.object()->shape().boundingBox());
   }
   // Inernal node
   else {
@@ -178,39 +1459,104 @@ void Bvh::setupBoundingBox(zisc::pmr::vector<BvhBuildingNode>& tree,
   }
 }
 
+/*!
+  \details
+  An object which is referred several times in the subtree by spatial splits
+  is added to the leaf only once.
+  */
+void Bvh::setLeafObjects(const zisc::pmr::vector<BvhBuildingNode>& tree,
+                         zisc::pmr::vector<Object>& object_list,
+                         zisc::pmr::vector<uint32>& index_map,
+                         const uint32 leaf_begin,
+                         const uint32 index) noexcept
+{
+  const auto& node = tree[index];
+  if (node.isLeafNode()) {
+    const uint object_index = zisc::cast<uint>(node.object() - object_list.data());
+    ZISC_ASSERT(object_index < object_list.size(), "invalid index is specified.");
+    // An object referred by several leaves is moved only once
+    if (index_map[object_index] == BvhBuildingNode::nullIndex()) {
+      index_map[object_index] = zisc::cast<uint32>(object_list_.size());
+      object_list_.emplace_back(std::move(object_list[object_index]));
+    }
+    const auto leaf_begin_it = reference_list_.begin() + leaf_begin;
+    const auto position = std::find(leaf_begin_it,
+                                    reference_list_.end(),
+                                    index_map[object_index]);
+    if (position == reference_list_.end())
+      reference_list_.emplace_back(index_map[object_index]);
+  }
+  else {
+    setLeafObjects(tree, object_list, index_map, leaf_begin, node.leftChildIndex());
+    setLeafObjects(tree, object_list, index_map, leaf_begin, node.rightChildIndex());
+  }
+}
+
 /*!
   \details
   No detailed.
   */
+template <typename Integer>
+uint32 Bvh::setQuantizedNode(zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+                             const uint32 index,
+                             uint32 quantized_index) const noexcept
+{
+  const uint32 node_index = quantized_index++;
+  tree[node_index].setBoundingBox(tree_[index].boundingBox());
+  const std::array<uint32, 2> child_list{{leftChildIndex(index),
+                                          rightChildIndex(index)}};
+  for (uint child = 0; child < 2; ++child) {
+    const auto& child_node = tree_[child_list[child]];
+    if (child_node.isLeafNode()) {
+      tree[node_index].setChild(child,
+                                child_node.boundingBox(),
+                                child_node.objectIndex(),
+                                child_node.numOfObjects());
+    }
+    else {
+      tree[node_index].setChild(child, child_node.boundingBox(), quantized_index, 0);
+      quantized_index = setQuantizedNode(tree, child_list[child], quantized_index);
+    }
+  }
+  return quantized_index;
+}
+
+/*!
+  \details
+  A collapsed subtree is set as a leaf which has all the objects of it.
+  */
 void Bvh::setTreeInfo(const zisc::pmr::vector<BvhBuildingNode>& tree,
+                      const zisc::pmr::vector<SubtreeInfo>& subtree_list,
                       zisc::pmr::vector<Object>& object_list,
+                      zisc::pmr::vector<uint32>& index_map,
                       const uint32 failure_next_index,
-                      const uint32 index) noexcept
+                      const uint32 index,
+                      const uint32 node_index) noexcept
 {
   const auto& node = tree[index];
-  // Set the node
-  {
-    auto& new_node = tree_[index];
-    const uint32 object_index = zisc::cast<uint32>(object_list_.size());
-    new_node.setBoundingBox(node.boundingBox());
-    new_node.setObjectInfo(object_index, node.numOfObjects());
-    new_node.setFailureNextIndex(failure_next_index);
-  }
-  // Set the objects
-  const auto& node_object_list = node.objectList();
-  for (uint i = 0; i < node.numOfObjects(); ++i) {
-    ZISC_ASSERT(node_object_list[i] != nullptr, "The object is null.");
-    const uint object_index = zisc::cast<uint>(node_object_list[i] -
-                                               object_list.data());
-    ZISC_ASSERT(object_index < object_list.size(), "invalid index is specified.");
-    object_list_.emplace_back(std::move(object_list[object_index]));
+  auto& new_node = tree_[node_index];
+  new_node.setBoundingBox(node.boundingBox());
+  new_node.setFailureNextIndex(failure_next_index);
+  if (subtree_list[index].num_of_nodes_ == 1) {
+    const uint32 object_index = zisc::cast<uint32>(reference_list_.size());
+    setLeafObjects(tree, object_list, index_map, object_index, index);
+    const uint num_of_objects = zisc::cast<uint>(reference_list_.size() -
+                                                 object_index);
+    new_node.setObjectInfo(object_index, num_of_objects);
   }
-  if (!node.isLeafNode()) {
+  else {
+    // The object info of an internal node must be zero to be distinguished
+    new_node.setObjectInfo(0, 0);
     // Child nodes
     const uint32 left_child_index = node.leftChildIndex();
     const uint32 right_child_index = node.rightChildIndex();
-    setTreeInfo(tree, object_list, right_child_index, left_child_index);
-    setTreeInfo(tree, object_list, failure_next_index, right_child_index);
+    const uint32 left_node_index = node_index + 1;
+    const uint32 right_node_index = left_node_index +
+                                    subtree_list[left_child_index].num_of_nodes_;
+    setTreeInfo(tree, subtree_list, object_list, index_map,
+                right_node_index, left_child_index, left_node_index);
+    setTreeInfo(tree, subtree_list, object_list, index_map,
+                failure_next_index, right_child_index, right_node_index);
   }
 }
 
@@ -222,6 +1568,7 @@ void Bvh::setTreeInfo(zisc::pmr::vector<Object>& object_list) noexcept
 {
   // Set the object
   object_list_.emplace_back(std::move(object_list[0]));
+  reference_list_.emplace_back(0);
   // Set the node
   auto& node = tree_[0];
   node.setBoundingBox(object_list_[0].shape().boundingBox());
@@ -276,6 +1623,43 @@ void Bvh::sortTreeNode(const zisc::pmr::vector<BvhBuildingNode>& tree,
   }
 }
 
+/*!
+  \details
+  No detailed.
+  */
+void Bvh::transformObjects(
+    System& system,
+    const zisc::pmr::vector<Matrix4x4>& transformation_list) noexcept
+{
+  const uint32 num_of_objects = zisc::cast<uint32>(object_list_.size());
+  auto& threads = system.threadManager();
+  constexpr bool threading = threadingIsEnabled();
+  const uint num_of_tasks = threading ? threads.numOfThreads() : 1;
+
+  auto transform_objects =
+  [this, &transformation_list, num_of_objects, num_of_tasks](const uint task_id)
+  {
+    const auto range = System::calcTaskRange(num_of_objects, num_of_tasks, task_id);
+    for (uint32 index = range[0]; index < range[1]; ++index) {
+      auto& shape = object_list_[index].shape();
+      ZISC_ASSERT(((shape.type() != ShapeType::kMesh) &&
+                   (shape.type() != ShapeType::kBilinearPatch)) ||
+                  (transformation_list[index] == Transformation::makeIdentity()),
+                  "The face of a mesh is transformed apart from the mesh.");
+      shape.transform(transformation_list[index]);
+    }
+  };
+  {
+    auto work_resource = transformation_list.get_allocator().resource();
+    constexpr uint start = 0;
+    auto result = threads.enqueueLoop(transform_objects,
+                                      start,
+                                      num_of_tasks,
+                                      work_resource);
+    result.wait();
+  }
+}
+
 /*!
   \details
   No detailed.
@@ -285,15 +1669,10 @@ void Bvh::testRayObjectsIntersection(const Ray& ray,
                                      const BvhTreeNode& leaf_node,
                                      IntersectionInfo* intersection) const noexcept
 {
-  ZISC_ASSERT(intersection != nullptr, "The intersection is null.");
-  const auto& object_list = objectList();
-  for (uint i = 0; i < leaf_node.numOfObjects(); ++i) {
-    const auto object_index = leaf_node.objectIndex() + i;
-    const auto& object = object_list[object_index];
-    const auto result = object.shape().testIntersection(ray, intersection);
-    if (result)
-      intersection->setObject(&object);
-  }
+  testRayObjectsIntersection(ray,
+                             leaf_node.objectIndex(),
+                             leaf_node.numOfObjects(),
+                             intersection);
 }
 
 } // namespace nanairo
@@ -11,8 +11,11 @@
 #define NANAIRO_BVH_HPP
 
 // Standard C++ library
+#include <array>
 #include <cstddef>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
@@ -22,8 +25,12 @@
 // Nanairo
 #include "bvh_building_node.hpp"
 #include "bvh_tree_node.hpp"
+#include "packed_triangle_list.hpp"
+#include "quantized_bvh_node.hpp"
+#include "shape_arena.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
 namespace nanairo {
@@ -40,7 +47,23 @@ class System;
 enum class BvhType : uint32
 {
   kBinaryRadixTree            = zisc::Fnv1aHash32::hash("BinaryRadixTree"),
-  kAgglomerativeTreeletRestructuring = zisc::Fnv1aHash32::hash("AgglomerativeTreeletRestructuring")
+  kAgglomerativeTreeletRestructuring = zisc::Fnv1aHash32::hash("AgglomerativeTreeletRestructuring"),
+  kBinnedSah                  = zisc::Fnv1aHash32::hash("BinnedSah"),
+  kPloc                       = zisc::Fnv1aHash32::hash("Ploc"),
+  kSpatialSplit               = zisc::Fnv1aHash32::hash("SpatialSplit")
+};
+
+enum class BvhTraversalType : uint32
+{
+  kStackless                  = zisc::Fnv1aHash32::hash("Stackless"),
+  kOrdered                    = zisc::Fnv1aHash32::hash("Ordered")
+};
+
+enum class BvhNodeFormat : uint32
+{
+  kFull                       = zisc::Fnv1aHash32::hash("Full"),
+  kQuantized16                = zisc::Fnv1aHash32::hash("Quantized16"),
+  kQuantized8                 = zisc::Fnv1aHash32::hash("Quantized8")
 };
 
 /*!
@@ -60,24 +83,69 @@ class Bvh : public zisc::NonCopyable<Bvh>
   //! Return the tree of BVH
   const zisc::pmr::vector<BvhTreeNode>& bvhTree() const noexcept;
 
+  //! Calculate the SAH cost of the tree used in ray traversal
+  Float calcSahCost() const noexcept;
+
   //! Cast the ray and find the intersection closest to the ray origin
   IntersectionInfo castRay(const Ray& ray,
                            const Float max_distance,
                            const bool expect_no_hit = false) const noexcept;
 
+  //! Cast the rays of a packet together and find the closest intersections
+  void castRayPacket(const Ray* ray_list,
+                     const uint num_of_rays,
+                     IntersectionInfo* intersection_list) const noexcept;
+
   //! Build BVH
   void construct(System& system,
                  const SettingNodeBase* settings,
                  zisc::pmr::vector<Object>&& object_list) noexcept;
 
+  //! Find the closest intersection without computing the hit attributes
+  virtual IntersectionInfo findClosestIntersection(
+      const Ray& ray,
+      const Float max_distance,
+      const bool expect_no_hit = false) const noexcept;
+
   //! Make BVH
   static zisc::UniqueMemoryPointer<Bvh> makeBvh(
       System& system,
       const SettingNodeBase* settings) noexcept;
 
+  //! Return the max number of rays in a packet
+  static constexpr uint maxPacketSize() noexcept;
+
+  //! Return the format of the nodes used in ray traversal
+  BvhNodeFormat nodeFormat() const noexcept;
+
+  //! Return the object list
+  zisc::pmr::vector<Object>& objectList() noexcept;
+
   //! Return the object list
   const zisc::pmr::vector<Object>& objectList() const noexcept;
 
+  //! Return the object indices referred by the leaves
+  const zisc::pmr::vector<uint32>& referenceList() const noexcept;
+
+  //! Apply the transformations to the shapes of the objects and refit the tree
+  bool refit(System& system,
+             const SettingNodeBase* settings,
+             const zisc::pmr::vector<Matrix4x4>& transformation_list) noexcept;
+
+  //! Place the shapes of the objects contiguously in the order of the objects
+  void relocateShapes() noexcept;
+
+  //! Test if the ray is occluded by any object before the max distance
+  virtual bool testOcclusion(const Ray& ray,
+                             const Float max_distance,
+                             const Object* ignore_object = nullptr) const noexcept;
+
+  //! Return the traversal type of the tree
+  BvhTraversalType traversalType() const noexcept;
+
+  //! Return the triangles of the objects packed in leaf order
+  const PackedTriangleList& triangleList() const noexcept;
+
  protected:
   //! Build BVH
   virtual void constructBvh(
@@ -85,6 +153,27 @@ class Bvh : public zisc::NonCopyable<Bvh>
       const zisc::pmr::vector<Object>& object_list,
       zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept = 0;
 
+  //! Build the tree used in ray traversal from the BVH tree
+  virtual void constructTraversalTree(System& system,
+                                      const SettingNodeBase* settings) noexcept;
+
+  //! Compute the hit attributes of the closest intersection
+  void finalizeIntersection(const Ray& ray,
+                            IntersectionInfo* intersection) const noexcept;
+
+  //! Return the left child index of the node in the tree of BVH
+  uint32 leftChildIndex(const uint32 index) const noexcept;
+
+  //! Refit the bounding boxes of the tree of BVH
+  void refitTree(System& system, zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Refit the tree used in ray traversal to the transformed objects
+  virtual void refitTraversalTree(System& system,
+                                  const SettingNodeBase* settings) noexcept;
+
+  //! Return the right child index of the node in the tree of BVH
+  uint32 rightChildIndex(const uint32 index) const noexcept;
+
   //! Check if multi-threading is enabled
   static constexpr bool threadingIsEnabled() noexcept;
 
@@ -98,12 +187,191 @@ class Bvh : public zisc::NonCopyable<Bvh>
   static void setupBoundingBox(zisc::pmr::vector<BvhBuildingNode>& tree,
                                const uint32 index) noexcept;
 
+  //! Test ray-objects of a leaf node intersection
+  void testRayObjectsIntersection(const Ray& ray,
+                                  const uint32 object_index,
+                                  const uint num_of_objects,
+                                  IntersectionInfo* intersection) const noexcept;
+
+  //! Test if the ray is occluded by any object of a leaf node
+  bool testRayObjectsOcclusion(const Ray& ray,
+                               const Float max_distance,
+                               const Object* ignore_object,
+                               const uint32 object_index,
+                               const uint num_of_objects) const noexcept;
+
  private:
-  //! Set the tree node and the object list
+  //! The node which is waiting for ordered traversal
+  struct TraversalEntry
+  {
+    uint32 index_;
+    Float distance_;
+  };
+
+  //! The node which is waiting for packet traversal
+  struct PacketEntry
+  {
+    uint32 index_;
+    uint32 mask_; //!< The rays which hit the node
+  };
+
+  //! The SAH cost and the size of a subtree after leaf collapse
+  struct SubtreeInfo
+  {
+    Float cost_;
+    Float object_cost_; //!< The sum of the traversal costs of the objects
+    uint32 num_of_objects_;
+    uint32 num_of_nodes_;
+  };
+
+
+  //! Return the identifier of a BVH cache file
+  static constexpr uint32 cacheFileIdentifier() noexcept;
+
+  //! Return the version of the BVH cache file format
+  static constexpr uint32 cacheFileVersion() noexcept;
+
+  //! Calculate the hash of the geometry and the BVH settings
+  static uint64 calcCacheKey(const SettingNodeBase* settings,
+                             const zisc::pmr::vector<Object>& object_list) noexcept;
+
+  //! Calculate the bounding box of the objects of a leaf
+  Aabb calcLeafBoundingBox(const uint32 object_index,
+                           const uint num_of_objects) const noexcept;
+
+  //! Calculate the SAH cost of the quantized tree without normalization
+  template <typename Integer>
+  Float calcQuantizedSahCost(
+      const zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree) const noexcept;
+
+  //! Return the depth of the subtree
+  uint calcTreeDepth(const uint32 index) const noexcept;
+
+  //! Collapse the subtrees into leaves where it reduces the SAH cost
+  static void collapseLeaves(const zisc::pmr::vector<BvhBuildingNode>& tree,
+                             const uint32 max_leaf_size,
+                             zisc::pmr::vector<SubtreeInfo>& subtree_list) noexcept;
+
+  //! Collect the subtrees which are refitted in parallel
+  void collectRefitTasks(
+      const uint32 index,
+      const uint depth,
+      zisc::pmr::vector<uint32>& top_node_list,
+      zisc::pmr::vector<std::array<uint32, 2>>& subtree_list) const noexcept;
+
+  //! Collect the subtrees of the quantized tree which are refitted in parallel
+  template <typename Integer>
+  void collectRefitTasks(
+      const zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+      const uint32 index,
+      const uint32 end,
+      const uint depth,
+      zisc::pmr::vector<uint32>& top_node_list,
+      zisc::pmr::vector<std::array<uint32, 2>>& subtree_list) const noexcept;
+
+  //! Find the closest intersection visiting the near child first
+  IntersectionInfo castRayOrdered(const Ray& ray,
+                                  const Float max_distance,
+                                  const bool expect_no_hit) const noexcept;
+
+  //! Find the closest intersections of the rays of a packet
+  void castRayPacketOrdered(const Ray* ray_list,
+                            const uint num_of_rays,
+                            IntersectionInfo* intersection_list) const noexcept;
+
+  //! Find the closest intersection in the quantized tree
+  template <typename Integer>
+  IntersectionInfo castRayQuantized(
+      const zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+      const Ray& ray,
+      const Float max_distance,
+      const bool expect_no_hit) const noexcept;
+
+  //! Find the closest intersection using the failure links of the tree
+  IntersectionInfo castRayStackless(const Ray& ray,
+                                    const Float max_distance,
+                                    const bool expect_no_hit) const noexcept;
+
+  //! Build the quantized tree from the tree of BVH
+  template <typename Integer>
+  void constructQuantizedTree(
+      zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree) const noexcept;
+
+  //! Initialize BVH
+  void initialize(const SettingNodeBase* settings) noexcept;
+
+  //! Check if the rays of a packet can be traversed together
+  static bool isCoherentPacket(const Ray* ray_list,
+                               const uint num_of_rays) noexcept;
+
+  //! Load the tree and the object order from the cache file
+  bool loadCache(const std::string& cache_file_path,
+                 const uint64 cache_key,
+                 zisc::pmr::vector<Object>& object_list,
+                 zisc::pmr::vector<uint32>& index_map) noexcept;
+
+  //! Make BVH of the builder with the node width of the settings
+  template <typename BuilderBvh>
+  static zisc::UniqueMemoryPointer<Bvh> makeBvh(
+      System& system,
+      const SettingNodeBase* settings) noexcept;
+
+  //! Build the tree again from the objects
+  void rebuild(System& system, const SettingNodeBase* settings) noexcept;
+
+  //! Return the SAH cost of traversing a node
+  static constexpr Float nodeTraversalCost() noexcept;
+
+  //! Return the ratio of the SAH cost which triggers a rebuild in refitting
+  static constexpr Float rebuildCostRatio() noexcept;
+
+  //! Refit the nodes from the bottom of the subtrees in parallel
+  template <typename RefitNode>
+  void refitInParallel(
+      System& system,
+      const zisc::pmr::vector<uint32>& top_node_list,
+      const zisc::pmr::vector<std::array<uint32, 2>>& subtree_list,
+      RefitNode& refit_node) const noexcept;
+
+  //! Refit the bounding boxes of the quantized tree
+  template <typename Integer>
+  void refitQuantizedTree(zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+                          System& system,
+                          zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Return the depth of the subtrees which are refitted in parallel
+  static constexpr uint refitTaskDepth() noexcept;
+
+  //! Make the path of the cache file
+  static std::string makeCacheFilePath(const std::string_view& cache_directory,
+                                       const uint64 cache_key) noexcept;
+
+  //! Save the tree and the object order to the cache file
+  void saveCache(const std::string& cache_file_path,
+                 const uint64 cache_key,
+                 const zisc::pmr::vector<uint32>& index_map) const noexcept;
+
+  //! Add the objects of the subtree to the leaf
+  void setLeafObjects(const zisc::pmr::vector<BvhBuildingNode>& tree,
+                      zisc::pmr::vector<Object>& object_list,
+                      zisc::pmr::vector<uint32>& index_map,
+                      const uint32 leaf_begin,
+                      const uint32 index) noexcept;
+
+  //! Set the quantized node of the subtree and return the next node index
+  template <typename Integer>
+  uint32 setQuantizedNode(zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+                          const uint32 index,
+                          uint32 quantized_index) const noexcept;
+
+  //! Set the tree node, the object list and the reference list
   void setTreeInfo(const zisc::pmr::vector<BvhBuildingNode>& tree,
+                   const zisc::pmr::vector<SubtreeInfo>& subtree_list,
                    zisc::pmr::vector<Object>& object_list,
+                   zisc::pmr::vector<uint32>& index_map,
                    const uint32 failure_next_index,
-                   const uint32 index) noexcept;
+                   const uint32 index,
+                   const uint32 node_index) noexcept;
 
   //! Set the tree with a object
   void setTreeInfo(zisc::pmr::vector<Object>& object_list) noexcept;
@@ -117,14 +385,42 @@ class Bvh : public zisc::NonCopyable<Bvh>
                     const uint32 old_index,
                     uint32& index) const noexcept;
 
+  //! Check if the tree is traversed with the stack of the traversal
+  bool stackTraversalIsAvailable() const noexcept;
+
   //! Test ray-objects of a leaf node intersection
   void testRayObjectsIntersection(const Ray& ray,
                                   const BvhTreeNode& leaf_node,
                                   IntersectionInfo* intersection) const noexcept;
 
+  //! Test if the ray is occluded by any object in the quantized tree
+  template <typename Integer>
+  bool testOcclusionQuantized(
+      const zisc::pmr::vector<QuantizedBvhNode<Integer>>& tree,
+      const Ray& ray,
+      const Float max_distance,
+      const Object* ignore_object) const noexcept;
+
+  //! Apply the transformations to the objects in parallel
+  void transformObjects(
+      System& system,
+      const zisc::pmr::vector<Matrix4x4>& transformation_list) noexcept;
+
+  //! Return the size of the stack used in ordered traversal
+  static constexpr uint traversalStackSize() noexcept;
+
 
+  ShapeArena shape_arena_; //!< Must be destroyed after the objects
   zisc::pmr::vector<BvhTreeNode> tree_;
   zisc::pmr::vector<Object> object_list_;
+  zisc::pmr::vector<uint32> reference_list_;
+  zisc::pmr::vector<QuantizedBvhNode<uint8>> quantized8_tree_;
+  zisc::pmr::vector<QuantizedBvhNode<uint16>> quantized16_tree_;
+  PackedTriangleList triangle_list_;
+  Float sah_cost_; //!< The SAH cost when the tree was built
+  BvhTraversalType traversal_type_;
+  BvhNodeFormat node_format_;
+  bool stack_traversal_is_available_; //!< The tree fits in the traversal stack
 };
 
 //! \} Core
@@ -12,7 +12,6 @@
 
 #include "bvh_building_node.hpp"
 // Standard C++ library
-#include <array>
 #include <limits>
 #include <utility>
 // Zisc
@@ -33,12 +32,12 @@ namespace nanairo {
   */
 inline
 BvhBuildingNode::BvhBuildingNode() noexcept :
+    object_{nullptr},
     parent_index_{nullIndex()},
     left_child_index_{nullIndex()},
     right_child_index_{nullIndex()},
     cost_{std::numeric_limits<float>::max()}
 {
-  object_list_.fill(nullptr);
 }
 
 /*!
@@ -48,47 +47,12 @@ BvhBuildingNode::BvhBuildingNode() noexcept :
 inline
 BvhBuildingNode::BvhBuildingNode(const Object* object) noexcept :
     bounding_box_{object->shape().boundingBox()},
+    object_{object},
     parent_index_{BvhBuildingNode::nullIndex()},
     left_child_index_{BvhBuildingNode::nullIndex()},
     right_child_index_{BvhBuildingNode::nullIndex()},
     cost_{std::numeric_limits<float>::max()}
 {
-  object_list_.fill(nullptr);
-  object_list_[0] = object;
-}
-
-
-/*!
-  \details
-  No detailed.
-  */
-inline
-void BvhBuildingNode::addObject(const Object* object) noexcept
-{
-  ZISC_ASSERT(object_list_.back() == nullptr, 
-              "The number of objects exceed the limit.");
-
-  const auto index = numOfObjects();
-  object_list_[index] = object;
-  const auto num_of_objects = index + 1;
-  if (num_of_objects == 1)
-    setBoundingBox(object->shape().boundingBox());
-  else
-    setBoundingBox(combine(boundingBox(), object->shape().boundingBox()));
-}
-
-/*!
-  \details
-  No detailed.
-  */
-inline
-void BvhBuildingNode::addObjectWithoutBoundingBox(const Object* object) noexcept 
-{
-  ZISC_ASSERT(object_list_.back() == nullptr, 
-              "The number of objects exceed the limit.");
-
-  const auto index = numOfObjects();
-  object_list_[index] = object;
 }
 
 /*!
@@ -108,7 +72,7 @@ const Aabb& BvhBuildingNode::boundingBox() const noexcept
 inline
 bool BvhBuildingNode::isLeafNode() const noexcept
 {
-  return object_list_[0] != nullptr;
+  return object_ != nullptr;
 }
 
 /*!
@@ -131,12 +95,14 @@ constexpr uint32 BvhBuildingNode::maxIndex() noexcept
 }
 
 /*!
+  \details
+  The bits which hold the number of objects of a leaf are excluded.
   */
 inline
 constexpr uint32 BvhBuildingNode::maxNumOfLeafs() noexcept
 {
-  uint32 node_objects = CoreConfig::maxNumOfNodeObjects() >> 1;
-  uint32 max_leaf_nodes = std::numeric_limits<uint32>::max() >> 1;
+  uint32 node_objects = maxNumOfLeafObjects();
+  uint32 max_leaf_nodes = std::numeric_limits<uint32>::max();
   while (0 < node_objects) {
     node_objects = node_objects >> 1;
     max_leaf_nodes = max_leaf_nodes >> 1;
@@ -144,6 +110,17 @@ constexpr uint32 BvhBuildingNode::maxNumOfLeafs() noexcept
   return max_leaf_nodes;
 }
 
+/*!
+  \details
+  Leaves are collapsed from the subtrees after building,
+  so the building nodes have only one object.
+  */
+inline
+constexpr uint32 BvhBuildingNode::maxNumOfLeafObjects() noexcept
+{
+  return 15;
+}
+
 /*!
   */
 inline
@@ -159,22 +136,17 @@ constexpr uint32 BvhBuildingNode::nullIndex() noexcept
 inline
 uint BvhBuildingNode::numOfObjects() const noexcept
 {
-  uint index = 0;
-  for (auto object : object_list_) {
-    if (object != nullptr)
-      ++index;
-  }
-  return index;
+  return isLeafNode() ? 1 : 0;
 }
 
 /*!
- \details
- No detailed.
- */
+  \details
+  No detailed.
+  */
 inline
-auto BvhBuildingNode::objectList() const noexcept -> const ObjectList&
+const Object* BvhBuildingNode::object() const noexcept
 {
-  return object_list_;
+  return object_;
 }
 
 /*!
@@ -11,7 +11,6 @@
 #define NANAIRO_BVH_BUILDING_NODE_HPP
 
 // Standard C++ library
-#include <array>
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
@@ -35,9 +34,6 @@ class Object;
 class BvhBuildingNode
 {
  public:
-  using ObjectList = std::array<const Object*, CoreConfig::maxNumOfNodeObjects()>;
-
-
   //! Create empty node
   BvhBuildingNode() noexcept;
 
@@ -45,12 +41,6 @@ class BvhBuildingNode
   BvhBuildingNode(const Object* object) noexcept;
 
 
-  //! Add object
-  void addObject(const Object* object) noexcept;
-
-  //! Add object without updating the BoundingBox
-  void addObjectWithoutBoundingBox(const Object* object) noexcept;
-
   //! Return the bounding box
   const Aabb& boundingBox() const noexcept;
 
@@ -67,6 +57,9 @@ class BvhBuildingNode
   //! Return the max num of objects
   static constexpr uint32 maxNumOfLeafs() noexcept;
 
+  //! Return the upper limit of the number of objects in a leaf
+  static constexpr uint32 maxNumOfLeafObjects() noexcept;
+
   //! Return the null index
   static constexpr uint32 nullIndex() noexcept;
 
@@ -79,8 +72,8 @@ class BvhBuildingNode
   //! Return the right child node index
   uint32 rightChildIndex() const noexcept;
 
-  //! Return the object list
-  const ObjectList& objectList() const noexcept;
+  //! Return the object of the leaf node
+  const Object* object() const noexcept;
 
   //! Return the SAH cost
   Float sahCost() const noexcept;
@@ -102,7 +95,7 @@ class BvhBuildingNode
 
  private:
   Aabb bounding_box_;
-  ObjectList object_list_;
+  const Object* object_;
   uint32 parent_index_,
          left_child_index_,
          right_child_index_;
@@ -12,6 +12,7 @@
 
 #include "bvh_tree_node.hpp"
 // Standard C++ library
+#include <array>
 #include <limits>
 // Zisc
 #include "zisc/error.hpp"
@@ -19,7 +20,10 @@
 // Nanairo
 #include "aabb.hpp"
 #include "bvh_building_node.hpp"
+#include "traversal_ray.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Geometry/point.hpp"
 
 namespace nanairo {
 
@@ -32,6 +36,7 @@ BvhTreeNode::BvhTreeNode() noexcept :
     object_info_{0},
     failure_next_index_{0}
 {
+  bounds_.fill(zisc::cast<TraversalFloat>(0.0));
 }
 
 /*!
@@ -39,9 +44,15 @@ BvhTreeNode::BvhTreeNode() noexcept :
   No detailed.
   */
 inline
-const Aabb& BvhTreeNode::boundingBox() const noexcept
+Aabb BvhTreeNode::boundingBox() const noexcept
 {
-  return bounding_box_;
+  const Point3 min_point{zisc::cast<Float>(bounds_[0]),
+                         zisc::cast<Float>(bounds_[1]),
+                         zisc::cast<Float>(bounds_[2])};
+  const Point3 max_point{zisc::cast<Float>(bounds_[3]),
+                         zisc::cast<Float>(bounds_[4]),
+                         zisc::cast<Float>(bounds_[5])};
+  return Aabb{min_point, max_point};
 }
 
 /*!
@@ -89,12 +100,15 @@ uint32 BvhTreeNode::objectIndex() const noexcept
 
 /*!
   \details
-  No detailed.
+  The box is rounded outward if TraversalFloat is less precise than Float.
   */
 inline
 void BvhTreeNode::setBoundingBox(const Aabb& bounding_box) noexcept
 {
-  bounding_box_ = bounding_box;
+  for (uint axis = 0; axis < 3; ++axis) {
+    bounds_[axis] = TraversalRay::roundDown(bounding_box.minPoint()[axis]);
+    bounds_[axis + 3] = TraversalRay::roundUp(bounding_box.maxPoint()[axis]);
+  }
 }
 
 /*!
@@ -119,6 +133,17 @@ void BvhTreeNode::setObjectInfo(const uint32 object_index,
   object_info_ = objects | object_index;
 }
 
+/*!
+  \details
+  No detailed.
+  */
+inline
+IntersectionTestResult BvhTreeNode::testIntersection(
+    const TraversalRay& ray) const noexcept
+{
+  return ray.testIntersection(bounds_);
+}
+
 /*!
   */
 inline
@@ -11,13 +11,18 @@
 #define NANAIRO_BVH_TREE_NODE_HPP
 
 // Standard C++ library
+#include <array>
 #include <limits>
 // Nanairo
 #include "aabb.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
 
 namespace nanairo {
 
+// Forward declaration
+class TraversalRay;
+
 //! \addtogroup Core
 //! \{
 
@@ -34,7 +39,7 @@ class BvhTreeNode
 
 
   //! Return the bounding box
-  const Aabb& boundingBox() const noexcept;
+  Aabb boundingBox() const noexcept;
 
   //! Check if the node is leaf node
   bool isLeafNode() const noexcept;
@@ -57,6 +62,9 @@ class BvhTreeNode
   //! Set the object info
   void setObjectInfo(const uint32 object_index, const uint num_of_objects) noexcept;
 
+  //! Test ray-box intersection
+  IntersectionTestResult testIntersection(const TraversalRay& ray) const noexcept;
+
  private:
   //! Initialize the node
   void initialize() noexcept;
@@ -74,7 +82,7 @@ class BvhTreeNode
   uint32 objectInfo() const noexcept;
 
 
-  Aabb bounding_box_;
+  std::array<TraversalFloat, 6> bounds_; //!< Min x, y, z and max x, y, z
   uint32 object_info_;
   uint32 failure_next_index_;
 };
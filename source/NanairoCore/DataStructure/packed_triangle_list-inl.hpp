@@ -0,0 +1,81 @@
+/*!
+  \file packed_triangle_list-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PACKED_TRIANGLE_LIST_INL_HPP
+#define NANAIRO_PACKED_TRIANGLE_LIST_INL_HPP
+
+#include "packed_triangle_list.hpp"
+// Standard C++ library
+#include <limits>
+#include <type_traits>
+// Zisc
+#include "zisc/error.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+bool PackedTriangleList::hasOtherShape() const noexcept
+{
+  return has_other_shape_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+constexpr bool PackedTriangleList::isExactTest() noexcept
+{
+  return std::is_same_v<TraversalFloat, Float>;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+bool PackedTriangleList::isTriangle(const uint32 index) const noexcept
+{
+  const uint32 pack_index = index / packWidth();
+  const uint32 lane = index % packWidth();
+  ZISC_ASSERT(pack_index < pack_list_.size(), "The index is out of range.");
+  return (pack_list_[pack_index].triangle_mask_ & (0b01u << lane)) != 0;
+}
+
+/*!
+  \details
+  The packed test has a few roundings in each step,
+  and the bound is enlarged for the errors of the ray in TraversalFloat.
+  */
+inline
+constexpr TraversalFloat PackedTriangleList::errorBound() noexcept
+{
+  constexpr TraversalFloat u = 0.5f * std::numeric_limits<TraversalFloat>::epsilon();
+  return 16.0f * u;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+constexpr uint PackedTriangleList::packWidth() noexcept
+{
+  return 4;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_PACKED_TRIANGLE_LIST_INL_HPP
@@ -0,0 +1,313 @@
+/*!
+  \file packed_triangle_list.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "packed_triangle_list.hpp"
+// Standard C++ library
+#include <array>
+#include <tuple>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "bvh_building_node.hpp"
+#include "traversal_ray.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Shape/flat_triangle.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+#include "NanairoCore/Shape/triangle_mesh.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+PackedTriangleList::PackedTriangleList(
+    zisc::pmr::memory_resource* mem_resource) noexcept :
+        pack_list_{mem_resource},
+        matrix_list_{mem_resource},
+        object_list_{nullptr},
+        has_other_shape_{false}
+{
+  static_assert(std::tuple_size<FloatArray>::value == packWidth(),
+                "The size of the float array is wrong.");
+  static_assert(std::tuple_size<decltype(TrianglePack::object_index_)>::value ==
+                packWidth(),
+                "The size of the index array is wrong.");
+}
+
+/*!
+  \details
+  No detailed.
+  */
+uint32 PackedTriangleList::findClosestTriangle(
+    const Ray& ray,
+    const uint32 index,
+    const uint num_of_objects,
+    Float* ray_distance,
+    Point2* st) const noexcept
+{
+  ZISC_ASSERT(ray_distance != nullptr, "The ray distance is null.");
+  ZISC_ASSERT(st != nullptr, "The st is null.");
+  uint32 closest_index = BvhBuildingNode::nullIndex();
+  auto test_candidate = [this, &ray, ray_distance, st, &closest_index]
+  (const uint32 object_index)
+  {
+    Float t = 0.0;
+    Point2 candidate_st;
+    if (testCandidate(ray, object_index, *ray_distance, &t, &candidate_st)) {
+      *ray_distance = t;
+      *st = candidate_st;
+      closest_index = object_index;
+    }
+  };
+
+  const uint32 end = index + num_of_objects;
+  for (uint32 pack_index = index / packWidth();
+       (pack_index * packWidth()) < end;
+       ++pack_index) {
+    const auto& pack = pack_list_[pack_index];
+    const uint lane_mask = getLaneMask(pack_index, index, end) &
+                           pack.triangle_mask_;
+    // The triangles which have the packed matrices
+    uint hit_mask = 0;
+    if (pack.matrix_index_ != BvhBuildingNode::nullIndex()) {
+      hit_mask = testIntersection(matrix_list_[pack.matrix_index_], ray,
+                                  lane_mask & pack.matrix_mask_, *ray_distance);
+    }
+    // The other triangles are tested with the shared vertices directly
+    hit_mask |= lane_mask & ~pack.matrix_mask_;
+    for (uint lane = 0; hit_mask != 0; ++lane, hit_mask = hit_mask >> 1) {
+      if ((hit_mask & 0b01u) != 0)
+        test_candidate(pack.object_index_[lane]);
+    }
+  }
+  return closest_index;
+}
+
+/*!
+  \details
+  Each triangle is placed in the lane of its reference index,
+  so a triangle referred by several leaves is packed several times.
+  The matrices are made only for the packs which have triangles of
+  uncompressed meshes, since the matrices would be larger than
+  the compressed vertex data. The other lanes have zero matrices
+  which never hit a ray.
+  */
+void PackedTriangleList::setObjectList(
+    const zisc::pmr::vector<Object>& object_list,
+    const zisc::pmr::vector<uint32>& reference_list) noexcept
+{
+  const uint32 num_of_references = zisc::cast<uint32>(reference_list.size());
+  const uint32 num_of_packs = (num_of_references + packWidth() - 1) / packWidth();
+  constexpr TrianglePack empty_pack{{{BvhBuildingNode::nullIndex(),
+                                      BvhBuildingNode::nullIndex(),
+                                      BvhBuildingNode::nullIndex(),
+                                      BvhBuildingNode::nullIndex()}},
+                                    0,
+                                    0,
+                                    BvhBuildingNode::nullIndex()};
+  pack_list_.clear();
+  pack_list_.resize(num_of_packs, empty_pack);
+  matrix_list_.clear();
+  object_list_ = &object_list;
+  has_other_shape_ = false;
+  for (uint32 index = 0; index < num_of_references; ++index) {
+    auto& pack = pack_list_[index / packWidth()];
+    const uint lane = index % packWidth();
+    const uint32 object_index = reference_list[index];
+    ZISC_ASSERT(object_index < object_list.size(), "The reference is invalid.");
+    pack.object_index_[lane] = object_index;
+    const auto& shape = object_list[object_index].shape();
+    if (shape.type() != ShapeType::kMesh) {
+      has_other_shape_ = true;
+      continue;
+    }
+    pack.triangle_mask_ |= 0b01u << lane;
+    // The triangles in Float and the triangles of compressed meshes are
+    // tested with the shared vertices
+    const auto& triangle = static_cast<const FlatTriangle&>(shape);
+    const bool is_compressed =
+        triangle.mesh().compression() != MeshCompression::kNone;
+    if (!isExactTest() && !is_compressed) {
+      if (pack.matrix_index_ == BvhBuildingNode::nullIndex()) {
+        pack.matrix_index_ = zisc::cast<uint32>(matrix_list_.size());
+        matrix_list_.emplace_back();
+        for (auto& row : matrix_list_.back())
+          row.fill(0.0);
+      }
+      auto& matrix = matrix_list_[pack.matrix_index_];
+      const auto m = triangle.makeCanonicalMatrix();
+      const std::array<const Vector3*, 3> xyz{{&m.row1_xyz_,
+                                               &m.row2_xyz_,
+                                               &m.row3_xyz_}};
+      const std::array<Float, 3> w{{m.row1_w_, m.row2_w_, m.row3_w_}};
+      for (uint row = 0; row < 3; ++row) {
+        for (uint i = 0; i < 3; ++i)
+          matrix[4 * row + i][lane] = zisc::cast<TraversalFloat>((*xyz[row])[i]);
+        matrix[4 * row + 3][lane] = zisc::cast<TraversalFloat>(w[row]);
+      }
+      pack.matrix_mask_ |= 0b01u << lane;
+    }
+  }
+  matrix_list_.shrink_to_fit();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+bool PackedTriangleList::testOcclusion(const Ray& ray,
+                                       const uint32 index,
+                                       const uint num_of_objects,
+                                       const Float max_distance,
+                                       const uint32 ignore_index) const noexcept
+{
+  const uint32 end = index + num_of_objects;
+  for (uint32 pack_index = index / packWidth();
+       (pack_index * packWidth()) < end;
+       ++pack_index) {
+    const auto& pack = pack_list_[pack_index];
+    uint lane_mask = getLaneMask(pack_index, index, end) & pack.triangle_mask_;
+    for (uint lane = 0; lane < packWidth(); ++lane) {
+      const uint is_ignored = (pack.object_index_[lane] == ignore_index) ? 1 : 0;
+      lane_mask &= ~(is_ignored << lane);
+    }
+    // The triangles which have the packed matrices
+    uint hit_mask = 0;
+    if (pack.matrix_index_ != BvhBuildingNode::nullIndex()) {
+      hit_mask = testIntersection(matrix_list_[pack.matrix_index_], ray,
+                                  lane_mask & pack.matrix_mask_, max_distance);
+    }
+    // The other triangles are tested with the shared vertices directly
+    hit_mask |= lane_mask & ~pack.matrix_mask_;
+    for (uint lane = 0; hit_mask != 0; ++lane, hit_mask = hit_mask >> 1) {
+      Float t = 0.0;
+      Point2 st;
+      if (((hit_mask & 0b01u) != 0) &&
+          testCandidate(ray, pack.object_index_[lane], max_distance, &t, &st))
+        return true;
+    }
+  }
+  return false;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+uint PackedTriangleList::getLaneMask(const uint32 pack_index,
+                                     const uint32 begin,
+                                     const uint32 end) noexcept
+{
+  const uint32 first = pack_index * packWidth();
+  uint lane_mask = 0;
+  for (uint lane = 0; lane < packWidth(); ++lane) {
+    const uint32 i = first + lane;
+    if ((begin <= i) && (i < end))
+      lane_mask |= 0b01u << lane;
+  }
+  return lane_mask;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+bool PackedTriangleList::testCandidate(const Ray& ray,
+                                       const uint32 object_index,
+                                       const Float max_distance,
+                                       Float* ray_distance,
+                                       Point2* st) const noexcept
+{
+  ZISC_ASSERT(object_list_ != nullptr, "The object list is null.");
+  const auto& shape = (*object_list_)[object_index].shape();
+  ZISC_ASSERT(shape.type() == ShapeType::kMesh, "The shape isn't a triangle.");
+  const auto& triangle = static_cast<const FlatTriangle&>(shape);
+  return triangle.testIntersection(ray, max_distance, ray_distance, st);
+}
+
+/*!
+  \details
+  Please see "Fast Ray-Triangle Intersections by Coordinate Transformation".
+  All lanes are computed without branches so that
+  the compiler can vectorize the loop.
+  The error bounds of the distance and the st coordinate are computed from
+  the magnitudes of the terms and the lanes which can be hit within
+  the bounds are returned as the candidates.
+  */
+uint PackedTriangleList::testIntersection(const MatrixPack& matrix,
+                                          const Ray& ray,
+                                          const uint lane_mask,
+                                          const Float max_distance) noexcept
+{
+  using zisc::abs;
+  const auto& m = matrix;
+  const std::array<TraversalFloat, 3> o{{zisc::cast<TraversalFloat>(ray.origin()[0]),
+                                         zisc::cast<TraversalFloat>(ray.origin()[1]),
+                                         zisc::cast<TraversalFloat>(ray.origin()[2])}};
+  const std::array<TraversalFloat, 3> d{{zisc::cast<TraversalFloat>(ray.direction()[0]),
+                                         zisc::cast<TraversalFloat>(ray.direction()[1]),
+                                         zisc::cast<TraversalFloat>(ray.direction()[2])}};
+  constexpr TraversalFloat zero = zisc::cast<TraversalFloat>(0.0);
+  constexpr TraversalFloat one = zisc::cast<TraversalFloat>(1.0);
+  const TraversalFloat max_t = TraversalRay::roundUp(max_distance);
+  uint hit_mask = 0;
+  for (uint lane = 0; lane < packWidth(); ++lane) {
+    const TraversalFloat dz = m[0][lane] * d[0] + m[1][lane] * d[1] +
+                              m[2][lane] * d[2];
+    const TraversalFloat oz = m[0][lane] * o[0] + m[1][lane] * o[1] +
+                              m[2][lane] * o[2] + m[3][lane];
+    const TraversalFloat t = (dz != zero) ? -oz / dz : zero;
+    const TraversalFloat px = o[0] + t * d[0];
+    const TraversalFloat py = o[1] + t * d[1];
+    const TraversalFloat pz = o[2] + t * d[2];
+    const TraversalFloat s = m[4][lane] * px + m[5][lane] * py +
+                             m[6][lane] * pz + m[7][lane];
+    const TraversalFloat r = m[8][lane] * px + m[9][lane] * py +
+                             m[10][lane] * pz + m[11][lane];
+    const TraversalFloat u = one - (s + r);
+    const TraversalFloat e = errorBound();
+    const TraversalFloat dz_abs = abs(m[0][lane] * d[0]) +
+                                  abs(m[1][lane] * d[1]) +
+                                  abs(m[2][lane] * d[2]);
+    const TraversalFloat oz_abs = abs(m[0][lane] * o[0]) +
+                                  abs(m[1][lane] * o[1]) +
+                                  abs(m[2][lane] * o[2]) + abs(m[3][lane]);
+    const TraversalFloat t_error = (dz != zero)
+        ? e * (oz_abs + abs(t) * dz_abs) / abs(dz)
+        : zero;
+    const std::array<TraversalFloat, 3> p_error{{
+        e * (abs(o[0]) + abs(t * d[0])) + t_error * abs(d[0]),
+        e * (abs(o[1]) + abs(t * d[1])) + t_error * abs(d[1]),
+        e * (abs(o[2]) + abs(t * d[2])) + t_error * abs(d[2])}};
+    const TraversalFloat s_error =
+        e * (abs(m[4][lane] * px) + abs(m[5][lane] * py) +
+             abs(m[6][lane] * pz) + abs(m[7][lane])) +
+        abs(m[4][lane]) * p_error[0] + abs(m[5][lane]) * p_error[1] +
+        abs(m[6][lane]) * p_error[2];
+    const TraversalFloat r_error =
+        e * (abs(m[8][lane] * px) + abs(m[9][lane] * py) +
+             abs(m[10][lane] * pz) + abs(m[11][lane])) +
+        abs(m[8][lane]) * p_error[0] + abs(m[9][lane]) * p_error[1] +
+        abs(m[10][lane]) * p_error[2];
+    const TraversalFloat u_error = s_error + r_error + e;
+    const bool is_hit = (-t_error < t) && (t - t_error < max_t) &&
+                        (-s_error < s) && (-r_error < r) && (-u_error < u);
+    hit_mask |= zisc::cast<uint>(is_hit) << lane;
+  }
+  return hit_mask & lane_mask;
+}
+
+} // namespace nanairo
@@ -0,0 +1,133 @@
+/*!
+  \file packed_triangle_list.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PACKED_TRIANGLE_LIST_HPP
+#define NANAIRO_PACKED_TRIANGLE_LIST_HPP
+
+// Standard C++ library
+#include <array>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Object;
+class Ray;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The triangles of the objects packed in SoA form
+  \details
+  The object references of BVH leaves are contiguous in the reference list,
+  so the triangles are packed in the same order and
+  a range of them is tested without the virtual calls of the shapes.
+  The triangles refer the vertex data shared by the mesh, so a pack only has
+  the indices of the objects. If TraversalFloat is less precise than Float,
+  the world-to-canonical matrices of the triangles are also packed in
+  TraversalFloat, which are half the size of the vertex data in Float.
+  The triangles of compressed meshes aren't packed with the matrices
+  so that the memory of the meshes stays small.
+  The packed test accepts the triangles within its error bounds and
+  the candidates are tested again with the triangles in Float,
+  so the hit distance and the st coordinate are computed in Float.
+  */
+class PackedTriangleList
+{
+ public:
+  //! Create an empty list
+  PackedTriangleList(zisc::pmr::memory_resource* mem_resource) noexcept;
+
+
+  //! Find the closest triangle in the range and return the object index
+  uint32 findClosestTriangle(const Ray& ray,
+                             const uint32 index,
+                             const uint num_of_objects,
+                             Float* ray_distance,
+                             Point2* st) const noexcept;
+
+  //! Check if the list has objects which aren't triangles
+  bool hasOtherShape() const noexcept;
+
+  //! Check if the packed test is as precise as the triangle test
+  static constexpr bool isExactTest() noexcept;
+
+  //! Check if the object of the reference is a triangle
+  bool isTriangle(const uint32 index) const noexcept;
+
+  //! Return the number of triangles in a pack
+  static constexpr uint packWidth() noexcept;
+
+  //! Pack the triangles of the objects in the reference order
+  void setObjectList(const zisc::pmr::vector<Object>& object_list,
+                     const zisc::pmr::vector<uint32>& reference_list) noexcept;
+
+  //! Test if the ray is occluded by any triangle in the range
+  bool testOcclusion(const Ray& ray,
+                     const uint32 index,
+                     const uint num_of_objects,
+                     const Float max_distance,
+                     const uint32 ignore_index) const noexcept;
+
+ private:
+  using FloatArray = std::array<TraversalFloat, 4>;
+  //! The rows of the canonical matrices of a pack
+  using MatrixPack = std::array<FloatArray, 12>;
+
+  //! The triangles of a pack
+  struct TrianglePack
+  {
+    std::array<uint32, 4> object_index_;
+    uint32 triangle_mask_;
+    uint32 matrix_mask_; //!< The lanes which have the packed matrices
+    uint32 matrix_index_; //!< The index of the matrices or the null index
+  };
+
+
+  //! Return the mask of the lanes in the range
+  static uint getLaneMask(const uint32 pack_index,
+                          const uint32 begin,
+                          const uint32 end) noexcept;
+
+  //! Return the relative error bound of the packed test
+  static constexpr TraversalFloat errorBound() noexcept;
+
+  //! Test the candidate triangle of the packed test in Float
+  bool testCandidate(const Ray& ray,
+                     const uint32 object_index,
+                     const Float max_distance,
+                     Float* ray_distance,
+                     Point2* st) const noexcept;
+
+  //! Test ray-triangles intersection of a pack and return the candidate mask
+  static uint testIntersection(const MatrixPack& matrix,
+                               const Ray& ray,
+                               const uint lane_mask,
+                               const Float max_distance) noexcept;
+
+
+  zisc::pmr::vector<TrianglePack> pack_list_;
+  zisc::pmr::vector<MatrixPack> matrix_list_;
+  const zisc::pmr::vector<Object>* object_list_;
+  bool has_other_shape_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "packed_triangle_list-inl.hpp"
+
+#endif // NANAIRO_PACKED_TRIANGLE_LIST_HPP
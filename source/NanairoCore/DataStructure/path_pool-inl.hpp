@@ -0,0 +1,267 @@
+/*!
+  \file path_pool-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PATH_POOL_INL_HPP
+#define NANAIRO_PATH_POOL_INL_HPP
+
+#include "path_pool.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+zisc::pmr::vector<uint32>& PathPool::activePathList() noexcept
+{
+  return active_path_list_;
+}
+
+/*!
+  \details
+  The sign bits of the direction are packed into 3 bits.
+  */
+inline
+uint32 PathPool::calcOctant(const Vector3& direction) noexcept
+{
+  const uint32 octant = ((direction[0] < 0.0) ? 0b001u : 0u) |
+                        ((direction[1] < 0.0) ? 0b010u : 0u) |
+                        ((direction[2] < 0.0) ? 0b100u : 0u);
+  return octant;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+SampledSpectra& PathPool::cameraContribution(const uint32 index) noexcept
+{
+  return camera_contribution_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint PathPool::capacity() const noexcept
+{
+  return zisc::cast<uint>(ray_list_.size());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+SampledSpectra& PathPool::contribution(const uint32 index) noexcept
+{
+  return contribution_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+bool PathPool::explicitConnectionIsEnabled(const uint32 index) const noexcept
+{
+  return explicit_connection_list_[index] == kTrue;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+zisc::pmr::vector<uint32>& PathPool::freePathList() noexcept
+{
+  return free_path_list_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+IntersectionInfo& PathPool::intersection(const uint32 index) noexcept
+{
+  return intersection_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+Float& PathPool::inverseDirectionPdf(const uint32 index) noexcept
+{
+  return inverse_direction_pdf_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+const Object*& PathPool::lightSource(const uint32 index) noexcept
+{
+  return light_source_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+PathState& PathPool::pathState(const uint32 index) noexcept
+{
+  return path_state_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+Index2d& PathPool::pixelIndex(const uint32 index) noexcept
+{
+  return pixel_index_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+Ray& PathPool::ray(const uint32 index) noexcept
+{
+  return ray_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+SampledSpectra& PathPool::rayWeight(const uint32 index) noexcept
+{
+  return ray_weight_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void PathPool::setExplicitConnectionIsEnabled(const uint32 index,
+                                              const bool is_enabled) noexcept
+{
+  explicit_connection_list_[index] = is_enabled ? kTrue : kFalse;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void PathPool::setWavelengthIsSelected(const uint32 index,
+                                       const bool is_selected) noexcept
+{
+  wavelength_is_selected_list_[index] = is_selected ? kTrue : kFalse;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+SampledSpectra& PathPool::shadowContribution(const uint32 index) noexcept
+{
+  return shadow_contribution_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+zisc::pmr::vector<uint32>& PathPool::shadowPathList() noexcept
+{
+  return shadow_path_list_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+Ray& PathPool::shadowRay(const uint32 index) noexcept
+{
+  return shadow_ray_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+Float& PathPool::shadowRayDistance(const uint32 index) noexcept
+{
+  return shadow_ray_distance_list_[index];
+}
+
+/*!
+  \details
+  The paths are sorted by the 32bit keys, and the paths which have the same
+  key keep the order of the path indices.
+  */
+template <typename KeyFunction> inline
+void PathPool::sortPathList(zisc::pmr::vector<uint32>& path_list,
+                            KeyFunction make_key) noexcept
+{
+  key_list_.clear();
+  for (const uint32 index : path_list) {
+    const uint64 key = zisc::cast<uint64>(make_key(index));
+    key_list_.emplace_back((key << 32) | zisc::cast<uint64>(index));
+  }
+  std::sort(key_list_.begin(), key_list_.end());
+  for (uint i = 0; i < key_list_.size(); ++i)
+    path_list[i] = zisc::cast<uint32>(key_list_[i]);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+bool PathPool::wavelengthIsSelected(const uint32 index) const noexcept
+{
+  return wavelength_is_selected_list_[index] == kTrue;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_PATH_POOL_INL_HPP
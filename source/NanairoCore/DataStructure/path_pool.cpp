@@ -0,0 +1,117 @@
+/*!
+  \file path_pool.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "path_pool.hpp"
+// Standard C++ library
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+PathPool::PathPool(zisc::pmr::memory_resource* data_resource) noexcept :
+    ray_list_{data_resource},
+    intersection_list_{data_resource},
+    camera_contribution_list_{data_resource},
+    ray_weight_list_{data_resource},
+    contribution_list_{data_resource},
+    inverse_direction_pdf_list_{data_resource},
+    path_state_list_{data_resource},
+    pixel_index_list_{data_resource},
+    wavelength_is_selected_list_{data_resource},
+    explicit_connection_list_{data_resource},
+    shadow_ray_list_{data_resource},
+    shadow_ray_distance_list_{data_resource},
+    light_source_list_{data_resource},
+    shadow_contribution_list_{data_resource},
+    active_path_list_{data_resource},
+    free_path_list_{data_resource},
+    shadow_path_list_{data_resource},
+    key_list_{data_resource}
+{
+}
+
+/*!
+  \details
+  No detailed.
+  */
+PathPool::PathPool(PathPool&& other) noexcept :
+    ray_list_{std::move(other.ray_list_)},
+    intersection_list_{std::move(other.intersection_list_)},
+    camera_contribution_list_{std::move(other.camera_contribution_list_)},
+    ray_weight_list_{std::move(other.ray_weight_list_)},
+    contribution_list_{std::move(other.contribution_list_)},
+    inverse_direction_pdf_list_{std::move(other.inverse_direction_pdf_list_)},
+    path_state_list_{std::move(other.path_state_list_)},
+    pixel_index_list_{std::move(other.pixel_index_list_)},
+    wavelength_is_selected_list_{std::move(other.wavelength_is_selected_list_)},
+    explicit_connection_list_{std::move(other.explicit_connection_list_)},
+    shadow_ray_list_{std::move(other.shadow_ray_list_)},
+    shadow_ray_distance_list_{std::move(other.shadow_ray_distance_list_)},
+    light_source_list_{std::move(other.light_source_list_)},
+    shadow_contribution_list_{std::move(other.shadow_contribution_list_)},
+    active_path_list_{std::move(other.active_path_list_)},
+    free_path_list_{std::move(other.free_path_list_)},
+    shadow_path_list_{std::move(other.shadow_path_list_)},
+    key_list_{std::move(other.key_list_)}
+{
+}
+
+/*!
+  \details
+  All paths are returned to the free list.
+  The free list is reversed so that the paths are taken in index order.
+  */
+void PathPool::clear() noexcept
+{
+  const uint32 n = zisc::cast<uint32>(capacity());
+  active_path_list_.clear();
+  shadow_path_list_.clear();
+  free_path_list_.resize(n);
+  for (uint32 i = 0; i < n; ++i)
+    free_path_list_[i] = (n - 1) - i;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void PathPool::setCapacity(const uint capacity) noexcept
+{
+  ray_list_.resize(capacity);
+  intersection_list_.resize(capacity);
+  camera_contribution_list_.resize(capacity);
+  ray_weight_list_.resize(capacity);
+  contribution_list_.resize(capacity);
+  inverse_direction_pdf_list_.resize(capacity);
+  path_state_list_.resize(capacity);
+  pixel_index_list_.resize(capacity);
+  wavelength_is_selected_list_.resize(capacity, kFalse);
+  explicit_connection_list_.resize(capacity, kFalse);
+  shadow_ray_list_.resize(capacity);
+  shadow_ray_distance_list_.resize(capacity);
+  light_source_list_.resize(capacity, nullptr);
+  shadow_contribution_list_.resize(capacity);
+  active_path_list_.reserve(capacity);
+  free_path_list_.reserve(capacity);
+  shadow_path_list_.reserve(capacity);
+  key_list_.reserve(capacity);
+  clear();
+}
+
+} // namespace nanairo
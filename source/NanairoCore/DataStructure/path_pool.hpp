@@ -0,0 +1,156 @@
+/*!
+  \file path_pool.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PATH_POOL_HPP
+#define NANAIRO_PATH_POOL_HPP
+
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Object;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  The states of the paths which are traced in a wavefront.
+  Each state is stored in its own array (SoA),
+  and the paths are referred by their slot indices in the arrays.
+  */
+class PathPool : public zisc::NonCopyable<PathPool>
+{
+ public:
+  //! Create a path pool
+  PathPool(zisc::pmr::memory_resource* data_resource) noexcept;
+
+  //! Move data from other
+  PathPool(PathPool&& other) noexcept;
+
+
+  //! Return the indices of the active paths
+  zisc::pmr::vector<uint32>& activePathList() noexcept;
+
+  //! Return the octant of the direction
+  static uint32 calcOctant(const Vector3& direction) noexcept;
+
+  //! Return the camera contribution of the path
+  SampledSpectra& cameraContribution(const uint32 index) noexcept;
+
+  //! Return the max number of paths
+  uint capacity() const noexcept;
+
+  //! Clear the paths
+  void clear() noexcept;
+
+  //! Return the contribution of the path
+  SampledSpectra& contribution(const uint32 index) noexcept;
+
+  //! Check if the explicit connection is enabled at the current vertex
+  bool explicitConnectionIsEnabled(const uint32 index) const noexcept;
+
+  //! Return the indices of the unused paths
+  zisc::pmr::vector<uint32>& freePathList() noexcept;
+
+  //! Return the intersection of the ray of the path
+  IntersectionInfo& intersection(const uint32 index) noexcept;
+
+  //! Return the inverse pdf of the ray direction of the path
+  Float& inverseDirectionPdf(const uint32 index) noexcept;
+
+  //! Return the light source which the shadow ray of the path aims
+  const Object*& lightSource(const uint32 index) noexcept;
+
+  //! Return the state of the path
+  PathState& pathState(const uint32 index) noexcept;
+
+  //! Return the pixel index of the path
+  Index2d& pixelIndex(const uint32 index) noexcept;
+
+  //! Return the ray of the path
+  Ray& ray(const uint32 index) noexcept;
+
+  //! Return the ray weight of the path
+  SampledSpectra& rayWeight(const uint32 index) noexcept;
+
+  //! Set the max number of paths
+  void setCapacity(const uint capacity) noexcept;
+
+  //! Set the explicit connection flag of the path
+  void setExplicitConnectionIsEnabled(const uint32 index,
+                                      const bool is_enabled) noexcept;
+
+  //! Set the wavelength selection flag of the path
+  void setWavelengthIsSelected(const uint32 index,
+                               const bool is_selected) noexcept;
+
+  //! Return the contribution of the path through the shadow ray
+  SampledSpectra& shadowContribution(const uint32 index) noexcept;
+
+  //! Return the indices of the paths which have shadow rays
+  zisc::pmr::vector<uint32>& shadowPathList() noexcept;
+
+  //! Return the shadow ray of the path
+  Ray& shadowRay(const uint32 index) noexcept;
+
+  //! Return the max distance of the shadow ray of the path
+  Float& shadowRayDistance(const uint32 index) noexcept;
+
+  //! Sort the path indices by the keys
+  template <typename KeyFunction>
+  void sortPathList(zisc::pmr::vector<uint32>& path_list,
+                    KeyFunction make_key) noexcept;
+
+  //! Check if a wavelength is selected in the path
+  bool wavelengthIsSelected(const uint32 index) const noexcept;
+
+ private:
+  // Paths
+  zisc::pmr::vector<Ray> ray_list_;
+  zisc::pmr::vector<IntersectionInfo> intersection_list_;
+  zisc::pmr::vector<SampledSpectra> camera_contribution_list_;
+  zisc::pmr::vector<SampledSpectra> ray_weight_list_;
+  zisc::pmr::vector<SampledSpectra> contribution_list_;
+  zisc::pmr::vector<Float> inverse_direction_pdf_list_;
+  zisc::pmr::vector<PathState> path_state_list_;
+  zisc::pmr::vector<Index2d> pixel_index_list_;
+  zisc::pmr::vector<uint8> wavelength_is_selected_list_;
+  zisc::pmr::vector<uint8> explicit_connection_list_;
+  // Shadow rays
+  zisc::pmr::vector<Ray> shadow_ray_list_;
+  zisc::pmr::vector<Float> shadow_ray_distance_list_;
+  zisc::pmr::vector<const Object*> light_source_list_;
+  zisc::pmr::vector<SampledSpectra> shadow_contribution_list_;
+  // Queues
+  zisc::pmr::vector<uint32> active_path_list_;
+  zisc::pmr::vector<uint32> free_path_list_;
+  zisc::pmr::vector<uint32> shadow_path_list_;
+  zisc::pmr::vector<uint64> key_list_;
+};
+
+//! \}
+
+} // namespace nanairo
+
+#include "path_pool-inl.hpp"
+
+#endif // NANAIRO_PATH_POOL_HPP
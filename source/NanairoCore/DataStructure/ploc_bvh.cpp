@@ -0,0 +1,340 @@
+/*!
+  \file ploc_bvh.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "ploc_bvh.hpp"
+// Standard C++ library
+#include <limits>
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "bvh_building_node.hpp"
+#include "morton_code.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+PlocBvh::PlocBvh(System& system, const SettingNodeBase* settings) noexcept :
+    Bvh(system, settings)
+{
+  initialize(settings);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+PlocBvh::ClusteringData::ClusteringData(
+    const uint num_of_objects,
+    const uint num_of_tasks,
+    zisc::pmr::memory_resource* work_resource) noexcept :
+        cluster_list_{work_resource},
+        next_cluster_list_{work_resource},
+        neighbor_list_{work_resource},
+        merge_count_list_{work_resource},
+        cluster_count_list_{work_resource}
+{
+  cluster_list_.resize(num_of_objects);
+  next_cluster_list_.reserve(num_of_objects);
+  neighbor_list_.resize(num_of_objects);
+  merge_count_list_.resize(num_of_tasks);
+  cluster_count_list_.resize(num_of_tasks);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+Float PlocBvh::calcNodeDistance(const BvhBuildingNode& lhs,
+                                const BvhBuildingNode& rhs) noexcept
+{
+  return combine(lhs.boundingBox(), rhs.boundingBox()).surfaceArea();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void PlocBvh::countClusters(ClusteringData& data,
+                            const uint task_id,
+                            const uint32 begin,
+                            const uint32 end) const noexcept
+{
+  const auto& neighbor_list = data.neighbor_list_;
+  uint32 num_of_merges = 0;
+  uint32 num_of_clusters = 0;
+  for (uint32 i = begin; i < end; ++i) {
+    const uint32 neighbor = neighbor_list[i];
+    const bool is_mutual = neighbor_list[neighbor] == i;
+    if (!is_mutual) {
+      ++num_of_clusters;
+    }
+    else if (i < neighbor) {
+      ++num_of_merges;
+      ++num_of_clusters;
+    }
+  }
+  data.merge_count_list_[task_id] = num_of_merges;
+  data.cluster_count_list_[task_id] = num_of_clusters;
+}
+
+/*!
+  \details
+  The internal nodes are allocated from the back of the internal node range
+  in each round, so the last merged node becomes the root node.
+  */
+void PlocBvh::constructBvh(
+    System& system,
+    const zisc::pmr::vector<Object>& object_list,
+    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+{
+  const uint32 num_of_objects = zisc::cast<uint32>(object_list.size());
+  const uint32 internal_node_size = num_of_objects - 1;
+  tree.resize(2 * num_of_objects - 1);
+
+  auto& threads = system.threadManager();
+  constexpr bool threading = threadingIsEnabled();
+  const uint num_of_threads = threading ? threads.numOfThreads() : 1;
+
+  auto work_resource = tree.get_allocator().resource();
+  ClusteringData data{num_of_objects, num_of_threads, work_resource};
+  // Make the leaf nodes sorted by the morton code
+  {
+    zisc::pmr::vector<BvhBuildingNode> leaf_node_list{work_resource};
+    leaf_node_list.reserve(object_list.size());
+    for (const auto& object : object_list)
+      leaf_node_list.emplace_back(&object);
+    const auto morton_code_list = MortonCode::makeList(leaf_node_list);
+    for (uint32 i = 0; i < num_of_objects; ++i) {
+      const uint32 index = internal_node_size + i;
+      tree[index] = *(morton_code_list[i].node());
+      data.cluster_list_[i] = index;
+    }
+  }
+
+  // Merge the clusters until the root node is made
+  uint32 node_index = internal_node_size;
+  while (1 < data.cluster_list_.size()) {
+    const uint32 num_of_clusters = zisc::cast<uint32>(data.cluster_list_.size());
+    const uint num_of_tasks = (parallelClusteringThreshold() <= num_of_clusters)
+        ? num_of_threads
+        : 1;
+    auto process = [&threads, num_of_tasks, work_resource](auto& task)
+    {
+      if (num_of_tasks == 1) {
+        task(0u);
+      }
+      else {
+        constexpr uint start = 0;
+        auto result = threads.enqueueLoop(task, start, num_of_tasks, work_resource);
+        result.wait();
+      }
+    };
+
+    // Find the nearest neighbors
+    {
+      auto find_nearest_neighbors =
+      [this, &tree, &data, num_of_clusters, num_of_tasks](const uint task_id)
+      {
+        const auto range = System::calcTaskRange(num_of_clusters,
+                                                 num_of_tasks,
+                                                 task_id);
+        findNearestNeighbors(tree, data, range[0], range[1]);
+      };
+      process(find_nearest_neighbors);
+    }
+    // Count the merged pairs
+    {
+      auto count_clusters =
+      [this, &data, num_of_clusters, num_of_tasks](const uint task_id)
+      {
+        const auto range = System::calcTaskRange(num_of_clusters,
+                                                 num_of_tasks,
+                                                 task_id);
+        countClusters(data, task_id, range[0], range[1]);
+      };
+      process(count_clusters);
+    }
+    // Merge the clusters
+    {
+      uint32 num_of_merges = 0;
+      uint32 num_of_next_clusters = 0;
+      for (uint task_id = 0; task_id < num_of_tasks; ++task_id) {
+        num_of_merges += data.merge_count_list_[task_id];
+        num_of_next_clusters += data.cluster_count_list_[task_id];
+      }
+      ZISC_ASSERT(0 < num_of_merges, "No cluster is merged.");
+      ZISC_ASSERT(num_of_merges <= node_index, "The internal nodes run out.");
+      node_index -= num_of_merges;
+      data.next_cluster_list_.resize(num_of_next_clusters);
+
+      auto merge_clusters =
+      [this, &tree, &data, num_of_clusters, num_of_tasks, node_index]
+      (const uint task_id)
+      {
+        uint32 node_offset = node_index;
+        uint32 cluster_offset = 0;
+        for (uint i = 0; i < task_id; ++i) {
+          node_offset += data.merge_count_list_[i];
+          cluster_offset += data.cluster_count_list_[i];
+        }
+        const auto range = System::calcTaskRange(num_of_clusters,
+                                                 num_of_tasks,
+                                                 task_id);
+        mergeClusters(tree, data, range[0], range[1], node_offset, cluster_offset);
+      };
+      process(merge_clusters);
+      std::swap(data.cluster_list_, data.next_cluster_list_);
+    }
+  }
+  ZISC_ASSERT(node_index == 0, "The root node isn't the first node.");
+  ZISC_ASSERT(data.cluster_list_[0] == 0, "The root node isn't the first node.");
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void PlocBvh::findNearestNeighbors(const zisc::pmr::vector<BvhBuildingNode>& tree,
+                                   ClusteringData& data,
+                                   const uint32 begin,
+                                   const uint32 end) const noexcept
+{
+  const auto& cluster_list = data.cluster_list_;
+  const uint32 num_of_clusters = zisc::cast<uint32>(cluster_list.size());
+  const uint32 radius = zisc::cast<uint32>(searchRadius());
+  for (uint32 i = begin; i < end; ++i) {
+    const auto& node = tree[cluster_list[i]];
+    const uint32 lower = (radius < i) ? i - radius : 0;
+    const uint32 upper = zisc::min(i + radius + 1, num_of_clusters);
+    uint32 neighbor = BvhBuildingNode::nullIndex();
+    Float neighbor_distance = std::numeric_limits<Float>::max();
+    for (uint32 j = lower; j < upper; ++j) {
+      if (j == i)
+        continue;
+      const Float distance = calcNodeDistance(node, tree[cluster_list[j]]);
+      if (isNearer(i, j, distance, neighbor, neighbor_distance)) {
+        neighbor = j;
+        neighbor_distance = distance;
+      }
+    }
+    ZISC_ASSERT(neighbor != BvhBuildingNode::nullIndex(), "No neighbor is found.");
+    data.neighbor_list_[i] = neighbor;
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void PlocBvh::initialize(const SettingNodeBase* settings) noexcept
+{
+  const auto bvh_settings = castNode<BvhSettingNode>(settings);
+
+  const auto& parameters = bvh_settings->plocParameters();
+  {
+    search_radius_ = parameters.search_radius_;
+    ZISC_ASSERT(0 < search_radius_, "The search radius is zero.");
+  }
+}
+
+/*!
+  \details
+  The ties are broken by the indices of the pairs,
+  so the nearest pair in the cluster list is always mutual
+  and at least one pair is merged in each round.
+  */
+inline
+bool PlocBvh::isNearer(const uint32 index,
+                       const uint32 candidate,
+                       const Float candidate_distance,
+                       const uint32 neighbor,
+                       const Float neighbor_distance) noexcept
+{
+  if (candidate_distance != neighbor_distance)
+    return candidate_distance < neighbor_distance;
+  const auto make_key = [index](const uint32 other)
+  {
+    const uint64 lower = zisc::min(index, other);
+    const uint64 upper = zisc::max(index, other);
+    return (lower << 32) | upper;
+  };
+  return make_key(candidate) < make_key(neighbor);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void PlocBvh::mergeClusters(zisc::pmr::vector<BvhBuildingNode>& tree,
+                            ClusteringData& data,
+                            const uint32 begin,
+                            const uint32 end,
+                            uint32 node_index,
+                            uint32 cluster_index) const noexcept
+{
+  const auto& cluster_list = data.cluster_list_;
+  const auto& neighbor_list = data.neighbor_list_;
+  auto& next_cluster_list = data.next_cluster_list_;
+  for (uint32 i = begin; i < end; ++i) {
+    const uint32 neighbor = neighbor_list[i];
+    const bool is_mutual = neighbor_list[neighbor] == i;
+    if (!is_mutual) {
+      next_cluster_list[cluster_index++] = cluster_list[i];
+    }
+    else if (i < neighbor) {
+      const uint32 left_child_index = cluster_list[i];
+      const uint32 right_child_index = cluster_list[neighbor];
+      auto& node = tree[node_index];
+      node.setLeftChildIndex(left_child_index);
+      node.setRightChildIndex(right_child_index);
+      node.setBoundingBox(combine(tree[left_child_index].boundingBox(),
+                                  tree[right_child_index].boundingBox()));
+      tree[left_child_index].setParentIndex(node_index);
+      tree[right_child_index].setParentIndex(node_index);
+      next_cluster_list[cluster_index++] = node_index++;
+    }
+  }
+}
+
+/*!
+  */
+inline
+constexpr uint32 PlocBvh::parallelClusteringThreshold() noexcept
+{
+  return 1u << 12;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint PlocBvh::searchRadius() const noexcept
+{
+  return search_radius_;
+}
+
+} // namespace nanairo
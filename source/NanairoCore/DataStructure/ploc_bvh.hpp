@@ -0,0 +1,116 @@
+/*!
+  \file ploc_bvh.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PLOC_BVH_HPP
+#define NANAIRO_PLOC_BVH_HPP
+
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "bvh.hpp"
+#include "bvh_building_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class System;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  The clusters sorted by the morton code are merged with their nearest
+  neighbors in a small search window, round by round.
+  For the details of this algorithm,
+  please see the paper entitled
+  "Parallel Locally-Ordered Clustering for Bounding Volume Hierarchy Construction"
+  */
+class PlocBvh : public Bvh
+{
+ public:
+  //! Create a PLOC BVH
+  PlocBvh(System& system, const SettingNodeBase* settings) noexcept;
+
+ private:
+  //! The clusters which are referred in building
+  struct ClusteringData : public zisc::NonCopyable<ClusteringData>
+  {
+    ClusteringData(const uint num_of_objects,
+                   const uint num_of_tasks,
+                   zisc::pmr::memory_resource* work_resource) noexcept;
+
+    zisc::pmr::vector<uint32> cluster_list_;
+    zisc::pmr::vector<uint32> next_cluster_list_;
+    zisc::pmr::vector<uint32> neighbor_list_;
+    zisc::pmr::vector<uint32> merge_count_list_;
+    zisc::pmr::vector<uint32> cluster_count_list_;
+  };
+
+
+  //! Calculate the surface area of the combined bounding box
+  static Float calcNodeDistance(const BvhBuildingNode& lhs,
+                                const BvhBuildingNode& rhs) noexcept;
+
+  //! Count the merged pairs and the remaining clusters of the range
+  void countClusters(ClusteringData& data,
+                     const uint task_id,
+                     const uint32 begin,
+                     const uint32 end) const noexcept;
+
+  //! Build a PLOC BVH
+  void constructBvh(
+      System& system,
+      const zisc::pmr::vector<Object>& object_list,
+      zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept override;
+
+  //! Find the nearest neighbor of each cluster of the range
+  void findNearestNeighbors(const zisc::pmr::vector<BvhBuildingNode>& tree,
+                            ClusteringData& data,
+                            const uint32 begin,
+                            const uint32 end) const noexcept;
+
+  //! Initialize
+  void initialize(const SettingNodeBase* settings) noexcept;
+
+  //! Check if the candidate is nearer than the current neighbor
+  static bool isNearer(const uint32 index,
+                       const uint32 candidate,
+                       const Float candidate_distance,
+                       const uint32 neighbor,
+                       const Float neighbor_distance) noexcept;
+
+  //! Merge the mutual nearest neighbors of the range
+  void mergeClusters(zisc::pmr::vector<BvhBuildingNode>& tree,
+                     ClusteringData& data,
+                     const uint32 begin,
+                     const uint32 end,
+                     uint32 node_index,
+                     uint32 cluster_index) const noexcept;
+
+  //! Return the number of clusters which are processed in parallel
+  static constexpr uint32 parallelClusteringThreshold() noexcept;
+
+  //! Return the search radius
+  uint searchRadius() const noexcept;
+
+
+  uint search_radius_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#endif // NANAIRO_PLOC_BVH_HPP
@@ -0,0 +1,214 @@
+/*!
+  \file quantized_bvh_node-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_QUANTIZED_BVH_NODE_INL_HPP
+#define NANAIRO_QUANTIZED_BVH_NODE_INL_HPP
+
+#include "quantized_bvh_node.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+QuantizedBvhNode<Integer>::QuantizedBvhNode() noexcept :
+    origin_{{0.0f, 0.0f, 0.0f}},
+    scale_{{0.0f, 0.0f, 0.0f}},
+    child_index_{{0, 0}},
+    num_of_objects_{{0, 0}}
+{
+  bounds_.fill(0);
+}
+
+/*!
+  \details
+  The box covers the bounding box set by setBoundingBox.
+  */
+template <typename Integer> inline
+Aabb QuantizedBvhNode<Integer>::boundingBox() const noexcept
+{
+  const Point3 min_point{dequantize(0, 0),
+                         dequantize(1, 0),
+                         dequantize(2, 0)};
+  const Point3 max_point{dequantize(0, maxValue()),
+                         dequantize(1, maxValue()),
+                         dequantize(2, maxValue())};
+  return Aabb{min_point, max_point};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+Aabb QuantizedBvhNode<Integer>::childBoundingBox(const uint child) const noexcept
+{
+  const auto bounds = &bounds_[6 * child];
+  const Point3 min_point{dequantize(0, bounds[0]),
+                         dequantize(1, bounds[1]),
+                         dequantize(2, bounds[2])};
+  const Point3 max_point{dequantize(0, bounds[3]),
+                         dequantize(1, bounds[4]),
+                         dequantize(2, bounds[5])};
+  return Aabb{min_point, max_point};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+uint32 QuantizedBvhNode<Integer>::childIndex(const uint child) const noexcept
+{
+  return child_index_[child];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+bool QuantizedBvhNode<Integer>::isLeafChild(const uint child) const noexcept
+{
+  return num_of_objects_[child] != 0;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+constexpr Integer QuantizedBvhNode<Integer>::maxValue() noexcept
+{
+  return std::numeric_limits<Integer>::max();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+uint QuantizedBvhNode<Integer>::numOfObjects(const uint child) const noexcept
+{
+  return zisc::cast<uint>(num_of_objects_[child]);
+}
+
+/*!
+  \details
+  The origin is rounded downward and the scale is rounded upward,
+  so the grid covers the box in spite of the single precision.
+  */
+template <typename Integer> inline
+void QuantizedBvhNode<Integer>::setBoundingBox(const Aabb& bounding_box) noexcept
+{
+  constexpr float lowest = std::numeric_limits<float>::lowest();
+  constexpr float max_float = std::numeric_limits<float>::max();
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Float min_value = bounding_box.minPoint()[axis];
+    const Float max_value = bounding_box.maxPoint()[axis];
+    float origin = zisc::cast<float>(min_value);
+    if (min_value < zisc::cast<Float>(origin))
+      origin = std::nextafter(origin, lowest);
+    origin_[axis] = origin;
+    const Float extent = max_value - zisc::cast<Float>(origin);
+    scale_[axis] = zisc::cast<float>(extent / zisc::cast<Float>(maxValue()));
+    while (dequantize(axis, maxValue()) < max_value)
+      scale_[axis] = std::nextafter(scale_[axis], max_float);
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+void QuantizedBvhNode<Integer>::setChild(const uint child,
+                                         const Aabb& bounding_box,
+                                         const uint32 child_index,
+                                         const uint num_of_objects) noexcept
+{
+  ZISC_ASSERT(num_of_objects <= std::numeric_limits<uint16>::max(),
+              "The number of objects exceeds the limit.");
+  auto bounds = &bounds_[6 * child];
+  for (uint axis = 0; axis < 3; ++axis) {
+    bounds[axis] = quantizeLower(axis, bounding_box.minPoint()[axis]);
+    bounds[axis + 3] = quantizeUpper(axis, bounding_box.maxPoint()[axis]);
+  }
+  child_index_[child] = child_index;
+  num_of_objects_[child] = zisc::cast<uint16>(num_of_objects);
+}
+
+/*!
+  \details
+  The same function is used in building and in traversal,
+  so the rounding checks in building hold in traversal.
+  */
+template <typename Integer> inline
+Float QuantizedBvhNode<Integer>::dequantize(const uint axis,
+                                            const Integer value) const noexcept
+{
+  return zisc::cast<Float>(origin_[axis]) +
+         zisc::cast<Float>(value) * zisc::cast<Float>(scale_[axis]);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+Integer QuantizedBvhNode<Integer>::quantizeLower(const uint axis,
+                                                 const Float value) const noexcept
+{
+  const Float scale = zisc::cast<Float>(scale_[axis]);
+  Float q = (0.0 < scale)
+      ? std::floor((value - zisc::cast<Float>(origin_[axis])) / scale)
+      : 0.0;
+  q = zisc::min(zisc::max(q, zisc::cast<Float>(0.0)), zisc::cast<Float>(maxValue()));
+  auto result = zisc::cast<Integer>(q);
+  while ((0 < result) && (value < dequantize(axis, result)))
+    --result;
+  return result;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+Integer QuantizedBvhNode<Integer>::quantizeUpper(const uint axis,
+                                                 const Float value) const noexcept
+{
+  const Float scale = zisc::cast<Float>(scale_[axis]);
+  Float q = (0.0 < scale)
+      ? std::ceil((value - zisc::cast<Float>(origin_[axis])) / scale)
+      : 0.0;
+  q = zisc::min(zisc::max(q, zisc::cast<Float>(0.0)), zisc::cast<Float>(maxValue()));
+  auto result = zisc::cast<Integer>(q);
+  while ((result < maxValue()) && (dequantize(axis, result) < value))
+    ++result;
+  return result;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_QUANTIZED_BVH_NODE_INL_HPP
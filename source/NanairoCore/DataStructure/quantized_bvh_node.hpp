@@ -0,0 +1,96 @@
+/*!
+  \file quantized_bvh_node.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_QUANTIZED_BVH_NODE_HPP
+#define NANAIRO_QUANTIZED_BVH_NODE_HPP
+
+// Standard C++ library
+#include <array>
+#include <type_traits>
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The internal node of a BVH which has quantized child boxes
+  \details
+  The bounding boxes of the two children are quantized to the integer grid
+  spanned over the bounding box of the node.
+  The grid is stored in single precision and the quantized boxes are
+  rounded outward, so a dequantized box always contains the original box.
+  */
+template <typename Integer>
+class QuantizedBvhNode
+{
+ public:
+  //! Create an empty node
+  QuantizedBvhNode() noexcept;
+
+
+  //! Return the bounding box which the grid is spanned over
+  Aabb boundingBox() const noexcept;
+
+  //! Return the conservative bounding box of the child
+  Aabb childBoundingBox(const uint child) const noexcept;
+
+  //! Return the index of the child node or the first object
+  uint32 childIndex(const uint child) const noexcept;
+
+  //! Check if the child is a leaf
+  bool isLeafChild(const uint child) const noexcept;
+
+  //! Return the max quantized value
+  static constexpr Integer maxValue() noexcept;
+
+  //! Return the number of objects of the leaf child
+  uint numOfObjects(const uint child) const noexcept;
+
+  //! Set the bounding box which the grid is spanned over
+  void setBoundingBox(const Aabb& bounding_box) noexcept;
+
+  //! Set a child node
+  void setChild(const uint child,
+                const Aabb& bounding_box,
+                const uint32 child_index,
+                const uint num_of_objects) noexcept;
+
+ private:
+  static_assert(std::is_same_v<Integer, uint8> || std::is_same_v<Integer, uint16>,
+                "The quantized value isn't 8 or 16 bit.");
+
+
+  //! Return the value on the grid
+  Float dequantize(const uint axis, const Integer value) const noexcept;
+
+  //! Quantize the lower bound of a box rounding downward
+  Integer quantizeLower(const uint axis, const Float value) const noexcept;
+
+  //! Quantize the upper bound of a box rounding upward
+  Integer quantizeUpper(const uint axis, const Float value) const noexcept;
+
+
+  std::array<float, 3> origin_;
+  std::array<float, 3> scale_;
+  std::array<Integer, 12> bounds_; //!< Min x, y, z and max x, y, z of each child
+  std::array<uint32, 2> child_index_;
+  std::array<uint16, 2> num_of_objects_; //!< 0 means the child is an internal node
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "quantized_bvh_node-inl.hpp"
+
+#endif // NANAIRO_QUANTIZED_BVH_NODE_HPP
@@ -0,0 +1,47 @@
+/*!
+  \file shape_arena-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SHAPE_ARENA_INL_HPP
+#define NANAIRO_SHAPE_ARENA_INL_HPP
+
+#include "shape_arena.hpp"
+// Standard C++ library
+#include <cstddef>
+#include <utility>
+// Zisc
+#include "zisc/unique_memory_pointer.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+std::size_t ShapeArena::memoryUsage() const noexcept
+{
+  return offset_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename ShapeClass> inline
+zisc::UniqueMemoryPointer<Shape> ShapeArena::copyShape(const Shape& shape) noexcept
+{
+  const auto& source = static_cast<const ShapeClass&>(shape);
+  auto s = zisc::UniqueMemoryPointer<ShapeClass>::make(this, source);
+  return zisc::UniqueMemoryPointer<Shape>{std::move(s)};
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_SHAPE_ARENA_INL_HPP
@@ -0,0 +1,195 @@
+/*!
+  \file shape_arena.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "shape_arena.hpp"
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Shape/bilinear_patch.hpp"
+#include "NanairoCore/Shape/disk.hpp"
+#include "NanairoCore/Shape/flat_triangle.hpp"
+#include "NanairoCore/Shape/instance.hpp"
+#include "NanairoCore/Shape/plane.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+#include "NanairoCore/Shape/sphere.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+ShapeArena::ShapeArena(zisc::pmr::memory_resource* mem_resource) noexcept :
+    buffer_{mem_resource},
+    offset_{0}
+{
+}
+
+/*!
+  \details
+  The shapes are copied into a new buffer, and the old buffer is released
+  after the old shapes are destroyed since they may be in the buffer.
+  */
+void ShapeArena::relocate(zisc::pmr::vector<Object>& object_list) noexcept
+{
+  const std::size_t buffer_size = calcBufferSize(object_list);
+  zisc::pmr::vector<CacheLine> buffer{buffer_.get_allocator()};
+  {
+    const std::size_t n = (buffer_size + sizeof(CacheLine) - 1) / sizeof(CacheLine);
+    buffer.resize(n);
+    // The old buffer is kept until the old shapes are destroyed
+    buffer_.swap(buffer);
+    offset_ = 0;
+  }
+  for (auto& object : object_list)
+    object.setShape(copyShape(object.shape()));
+  ZISC_ASSERT(offset_ <= buffer_size, "The buffer of the shapes overflowed.");
+}
+
+/*!
+  \details
+  The shapes are placed in the same way as do_allocate.
+  */
+std::size_t ShapeArena::calcBufferSize(
+    const zisc::pmr::vector<Object>& object_list) noexcept
+{
+  std::size_t size = 0;
+  for (const auto& object : object_list) {
+    const auto layout = getShapeLayout(object.shape());
+    size = ((size + layout[1] - 1) / layout[1]) * layout[1] + layout[0];
+  }
+  return size;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+zisc::UniqueMemoryPointer<Shape> ShapeArena::copyShape(const Shape& shape) noexcept
+{
+  zisc::UniqueMemoryPointer<Shape> s;
+  switch (shape.type()) {
+   case ShapeType::kPlane: {
+    s = copyShape<Plane>(shape);
+    break;
+   }
+   case ShapeType::kMesh: {
+    s = copyShape<FlatTriangle>(shape);
+    break;
+   }
+   case ShapeType::kSphere: {
+    s = copyShape<Sphere>(shape);
+    break;
+   }
+   case ShapeType::kDisk: {
+    s = copyShape<Disk>(shape);
+    break;
+   }
+   case ShapeType::kBilinearPatch: {
+    s = copyShape<BilinearPatch>(shape);
+    break;
+   }
+   case ShapeType::kInstance: {
+    s = copyShape<Instance>(shape);
+    break;
+   }
+   default: {
+    zisc::raiseError("ShapeArenaError: Unsupported type is specified.");
+    break;
+   }
+  }
+  return s;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void* ShapeArena::do_allocate(std::size_t size, std::size_t alignment)
+{
+  ZISC_ASSERT(alignment <= alignof(CacheLine), "The alignment is too large.");
+  const std::size_t offset = ((offset_ + alignment - 1) / alignment) * alignment;
+  ZISC_ASSERT(offset + size <= buffer_.size() * sizeof(CacheLine),
+              "The buffer of the shapes is exhausted.");
+  offset_ = offset + size;
+  auto data = zisc::treatAs<uint8*>(buffer_.data()) + offset;
+  return data;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void ShapeArena::do_deallocate(void* data, std::size_t size, std::size_t alignment)
+{
+  static_cast<void>(data);
+  static_cast<void>(size);
+  static_cast<void>(alignment);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+bool ShapeArena::do_is_equal(const zisc::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+std::array<std::size_t, 2> ShapeArena::getShapeLayout(const Shape& shape) noexcept
+{
+  std::array<std::size_t, 2> layout{{0, 1}};
+  switch (shape.type()) {
+   case ShapeType::kPlane: {
+    layout = {{sizeof(Plane), alignof(Plane)}};
+    break;
+   }
+   case ShapeType::kMesh: {
+    layout = {{sizeof(FlatTriangle), alignof(FlatTriangle)}};
+    break;
+   }
+   case ShapeType::kSphere: {
+    layout = {{sizeof(Sphere), alignof(Sphere)}};
+    break;
+   }
+   case ShapeType::kDisk: {
+    layout = {{sizeof(Disk), alignof(Disk)}};
+    break;
+   }
+   case ShapeType::kBilinearPatch: {
+    layout = {{sizeof(BilinearPatch), alignof(BilinearPatch)}};
+    break;
+   }
+   case ShapeType::kInstance: {
+    layout = {{sizeof(Instance), alignof(Instance)}};
+    break;
+   }
+   default: {
+    zisc::raiseError("ShapeArenaError: Unsupported type is specified.");
+    break;
+   }
+  }
+  return layout;
+}
+
+} // namespace nanairo
@@ -0,0 +1,97 @@
+/*!
+  \file shape_arena.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SHAPE_ARENA_HPP
+#define NANAIRO_SHAPE_ARENA_HPP
+
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Object;
+class Shape;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The memory which holds the shapes of objects contiguously
+  \details
+  The shapes of the objects are copied into one buffer in the order of
+  the object list. The objects of a BVH are in the order of the leaves,
+  so the shapes tested in a traversal are close in memory.
+  The objects keep the materials, which are used only at hit points.
+  The memory is released all at once when the shapes are relocated again or
+  the arena is destroyed.
+  */
+class ShapeArena : public zisc::pmr::memory_resource
+{
+ public:
+  //! Create an empty arena
+  ShapeArena(zisc::pmr::memory_resource* mem_resource) noexcept;
+
+
+  //! Return the size of the memory used by the shapes
+  std::size_t memoryUsage() const noexcept;
+
+  //! Move the shapes of the objects into the arena in the order of the list
+  void relocate(zisc::pmr::vector<Object>& object_list) noexcept;
+
+ private:
+  //! The unit of the buffer
+  struct alignas(64) CacheLine
+  {
+    std::array<uint8, 64> data_;
+  };
+
+
+  //! Calculate the size of the buffer for the shapes
+  static std::size_t calcBufferSize(
+      const zisc::pmr::vector<Object>& object_list) noexcept;
+
+  //! Make a copy of the shape in the arena
+  zisc::UniqueMemoryPointer<Shape> copyShape(const Shape& shape) noexcept;
+
+  //! Make a copy of the shape in the arena
+  template <typename ShapeClass>
+  zisc::UniqueMemoryPointer<Shape> copyShape(const Shape& shape) noexcept;
+
+  //! Allocate the memory from the buffer
+  void* do_allocate(std::size_t size, std::size_t alignment) override;
+
+  //! The memory is released with the buffer
+  void do_deallocate(void* data, std::size_t size, std::size_t alignment) override;
+
+  //! Check if the arena is the other
+  bool do_is_equal(const zisc::pmr::memory_resource& other) const noexcept override;
+
+  //! Return the size and the alignment of the shape
+  static std::array<std::size_t, 2> getShapeLayout(const Shape& shape) noexcept;
+
+
+  zisc::pmr::vector<CacheLine> buffer_;
+  std::size_t offset_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "shape_arena-inl.hpp"
+
+#endif // NANAIRO_SHAPE_ARENA_HPP
@@ -0,0 +1,585 @@
+/*!
+  \file spatial_split_bvh.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "spatial_split_bvh.hpp"
+// Standard C++ library
+#include <array>
+#include <limits>
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "bvh_building_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Shape/flat_triangle.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+
+namespace nanairo {
+
+namespace {
+
+/*!
+  \details
+  The empty box can be combined with any box.
+  */
+inline
+Aabb makeEmptyBox() noexcept
+{
+  constexpr Float max_value = std::numeric_limits<Float>::max();
+  constexpr Float min_value = std::numeric_limits<Float>::lowest();
+  return Aabb{Point3{max_value, max_value, max_value},
+              Point3{min_value, min_value, min_value}};
+}
+
+} // namespace
+
+/*!
+  \details
+  No detailed.
+  */
+SpatialSplitBvh::SpatialSplitBvh(System& system,
+                                 const SettingNodeBase* settings) noexcept :
+    Bvh(system, settings)
+{
+  initialize(settings);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+SpatialSplitBvh::BuildingTask::BuildingTask(
+    const uint32 parent_index,
+    const bool is_right_child,
+    zisc::pmr::memory_resource* work_resource) noexcept :
+        reference_list_{work_resource},
+        parent_index_{parent_index},
+        is_right_child_{is_right_child}
+{
+}
+
+/*!
+  \details
+  No detailed.
+  */
+SpatialSplitBvh::BuildingData::BuildingData(
+    const zisc::pmr::vector<Object>& object_list,
+    const uint num_of_bins,
+    zisc::pmr::memory_resource* work_resource) noexcept :
+        object_list_{&object_list},
+        cost_list_{work_resource},
+        bin_list_{work_resource},
+        root_surface_area_{0.0},
+        num_of_remaining_references_{0}
+{
+  cost_list_.reserve(object_list.size());
+  for (const auto& object : object_list)
+    cost_list_.emplace_back(object.shape().getTraversalCost());
+  bin_list_.resize(2 * num_of_bins);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint SpatialSplitBvh::calcBinIndex(const Float value,
+                                   const Float min_value,
+                                   const Float scale,
+                                   const uint num_of_bins) noexcept
+{
+  const Float position = zisc::max((value - min_value) * scale, 0.0);
+  const uint k = zisc::cast<uint>(position);
+  return zisc::min(k, num_of_bins - 1);
+}
+
+/*!
+  \details
+  A triangle is clipped as a polygon, so the box can be tighter than
+  the box of the reference clipped by the slab.
+  Other shapes are clipped by their bounding boxes.
+  */
+Aabb SpatialSplitBvh::clipReference(const zisc::pmr::vector<Object>& object_list,
+                                    const Reference& reference,
+                                    const uint axis,
+                                    const Float min_value,
+                                    const Float max_value) noexcept
+{
+  // Clip the bounding box by the slab
+  auto min_point = reference.bounding_box_.minPoint();
+  auto max_point = reference.bounding_box_.maxPoint();
+  min_point[axis] = zisc::max(min_point[axis], min_value);
+  max_point[axis] = zisc::max(zisc::min(max_point[axis], max_value),
+                              min_point[axis]);
+
+  const auto& shape = object_list[reference.object_index_].shape();
+  if (shape.type() == ShapeType::kMesh) {
+    // Clip the triangle by the two planes of the slab
+    using Polygon = std::array<Point3, 6>;
+    auto clip_polygon = [axis](const Polygon& polygon,
+                               const uint n,
+                               const Float plane,
+                               const Float sign,
+                               Polygon* clipped)
+    {
+      uint m = 0;
+      for (uint i = 0; i < n; ++i) {
+        const auto& a = polygon[i];
+        const auto& b = polygon[(i + 1) % n];
+        const Float da = sign * (a[axis] - plane);
+        const Float db = sign * (b[axis] - plane);
+        if (0.0 <= da)
+          (*clipped)[m++] = a;
+        if ((da < 0.0) != (db < 0.0)) {
+          auto p = a + (da / (da - db)) * (b - a);
+          p[axis] = plane;
+          (*clipped)[m++] = p;
+        }
+      }
+      return m;
+    };
+    const auto& triangle = static_cast<const FlatTriangle&>(shape);
+    const auto& v0 = triangle.vertex0();
+    const auto& edge = triangle.edge();
+    Polygon polygon{{v0, v0 + edge[0], v0 + edge[1]}};
+    Polygon clipped;
+    uint n = clip_polygon(polygon, 3, min_value, 1.0, &clipped);
+    n = clip_polygon(clipped, n, max_value, -1.0, &polygon);
+    if (0 < n) {
+      auto polygon_min = polygon[0].data();
+      auto polygon_max = polygon_min;
+      for (uint i = 1; i < n; ++i) {
+        polygon_min = zisc::minElements(polygon_min, polygon[i].data());
+        polygon_max = zisc::maxElements(polygon_max, polygon[i].data());
+      }
+      for (uint i = 0; i < 3; ++i) {
+        const Float lower = zisc::max(min_point[i], polygon_min[i]);
+        const Float upper = zisc::min(max_point[i], polygon_max[i]);
+        if (lower <= upper) {
+          min_point[i] = lower;
+          max_point[i] = upper;
+        }
+      }
+    }
+  }
+  return Aabb{min_point, max_point};
+}
+
+/*!
+  \details
+  The nodes are made in depth-first order with an explicit stack,
+  since the number of references in a subtree isn't known in advance.
+  */
+void SpatialSplitBvh::constructBvh(
+    System& /* system */,
+    const zisc::pmr::vector<Object>& object_list,
+    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+{
+  const uint32 num_of_objects = zisc::cast<uint32>(object_list.size());
+  auto work_resource = tree.get_allocator().resource();
+  BuildingData data{object_list, numOfBins(), work_resource};
+
+  // Limit the number of the references
+  {
+    const uint64 max_num_of_references = zisc::min(
+        zisc::cast<uint64>(num_of_objects) +
+            (zisc::cast<uint64>(num_of_objects) * duplication_limit_) / 100,
+        zisc::cast<uint64>(BvhBuildingNode::maxNumOfLeafs()));
+    data.num_of_remaining_references_ =
+        zisc::cast<uint32>(max_num_of_references - num_of_objects);
+    tree.clear();
+    tree.reserve(zisc::cast<std::size_t>(2 * max_num_of_references - 1));
+  }
+
+  zisc::pmr::vector<BuildingTask> task_stack{work_resource};
+  {
+    BuildingTask root{BvhBuildingNode::nullIndex(), false, work_resource};
+    auto& reference_list = root.reference_list_;
+    reference_list.reserve(num_of_objects);
+    for (uint32 index = 0; index < num_of_objects; ++index) {
+      const auto& object = object_list[index];
+      reference_list.emplace_back(Reference{object.shape().boundingBox(), index});
+    }
+    task_stack.emplace_back(std::move(root));
+  }
+
+  while (!task_stack.empty()) {
+    BuildingTask task{std::move(task_stack.back())};
+    task_stack.pop_back();
+    const auto& reference_list = task.reference_list_;
+    ZISC_ASSERT(0 < reference_list.size(), "The node has no reference.");
+
+    // Make a node
+    const uint32 node_index = zisc::cast<uint32>(tree.size());
+    if (reference_list.size() == 1) {
+      const auto& reference = reference_list[0];
+      tree.emplace_back(&object_list[reference.object_index_]);
+      tree[node_index].setBoundingBox(reference.bounding_box_);
+    }
+    else {
+      tree.emplace_back();
+    }
+    auto& node = tree[node_index];
+    node.setParentIndex(task.parent_index_);
+    if (task.parent_index_ != BvhBuildingNode::nullIndex()) {
+      auto& parent = tree[task.parent_index_];
+      if (task.is_right_child_)
+        parent.setRightChildIndex(node_index);
+      else
+        parent.setLeftChildIndex(node_index);
+    }
+    if (reference_list.size() == 1)
+      continue;
+
+    // Calculate the bounding boxes of the node
+    auto node_box = reference_list[0].bounding_box_;
+    auto centroid_box = Aabb{node_box.centroid(), node_box.centroid()};
+    for (const auto& reference : reference_list) {
+      node_box = combine(node_box, reference.bounding_box_);
+      const auto centroid = reference.bounding_box_.centroid();
+      centroid_box = combine(centroid_box, Aabb{centroid, centroid});
+    }
+    node.setBoundingBox(node_box);
+    if (task.parent_index_ == BvhBuildingNode::nullIndex())
+      data.root_surface_area_ = node_box.surfaceArea();
+
+    // Find the best split
+    Aabb left_box,
+         right_box;
+    auto split = findObjectSplit(data, reference_list, centroid_box,
+                                 &left_box, &right_box);
+    if (0 < data.num_of_remaining_references_) {
+      bool try_spatial_split = split.axis_ == 3;
+      if (!try_spatial_split) {
+        const auto overlap_min = zisc::maxElements(left_box.minPoint().data(),
+                                                   right_box.minPoint().data());
+        const auto overlap_max = zisc::minElements(left_box.maxPoint().data(),
+                                                   right_box.maxPoint().data());
+        const bool is_overlapped = (overlap_min[0] < overlap_max[0]) &&
+                                   (overlap_min[1] < overlap_max[1]) &&
+                                   (overlap_min[2] < overlap_max[2]);
+        if (is_overlapped) {
+          const Aabb overlap{Point3{overlap_min}, Point3{overlap_max}};
+          try_spatial_split = overlapThreshold() * data.root_surface_area_ <
+                              overlap.surfaceArea();
+        }
+      }
+      if (try_spatial_split) {
+        const auto spatial_split = findSpatialSplit(data, reference_list, node_box);
+        if (spatial_split.cost_ < split.cost_)
+          split = spatial_split;
+      }
+    }
+
+    // Split the references
+    BuildingTask left_task{node_index, false, work_resource};
+    BuildingTask right_task{node_index, true, work_resource};
+    if (split.is_spatial_)
+      splitSpatially(data, split, task, &left_task, &right_task);
+    else
+      splitObjects(split, centroid_box, numOfBins(), task, &left_task, &right_task);
+    task_stack.emplace_back(std::move(right_task));
+    task_stack.emplace_back(std::move(left_task));
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+auto SpatialSplitBvh::findObjectSplit(
+    BuildingData& data,
+    const zisc::pmr::vector<Reference>& reference_list,
+    const Aabb& centroid_box,
+    Aabb* left_box,
+    Aabb* right_box) const noexcept -> Split
+{
+  const uint n = numOfBins();
+  const auto& min_point = centroid_box.minPoint();
+  const auto extent = centroid_box.maxPoint() - min_point;
+  auto& bin_list = data.bin_list_;
+
+  Split best{std::numeric_limits<Float>::max(), 0.0, 3, 0, false};
+  for (uint axis = 0; axis < 3; ++axis) {
+    if (extent[axis] <= 0.0)
+      continue;
+    // Bin the references by their centroids
+    for (uint k = 0; k < n; ++k)
+      bin_list[k] = Bin{makeEmptyBox(), 0.0, 0.0, 0, 0};
+    const Float scale = zisc::cast<Float>(n) / extent[axis];
+    for (const auto& reference : reference_list) {
+      const auto& box = reference.bounding_box_;
+      const uint k = calcBinIndex(box.centroid()[axis], min_point[axis], scale, n);
+      auto& bin = bin_list[k];
+      bin.bounding_box_ = combine(bin.bounding_box_, box);
+      bin.entry_cost_ += data.cost_list_[reference.object_index_];
+      ++bin.num_of_entries_;
+    }
+    // Sweep the bins
+    Bin* right_list = &bin_list[n];
+    {
+      Bin right{makeEmptyBox(), 0.0, 0.0, 0, 0};
+      for (uint k = n - 1; 0 < k; --k) {
+        const auto& bin = bin_list[k];
+        right.bounding_box_ = combine(right.bounding_box_, bin.bounding_box_);
+        right.entry_cost_ += bin.entry_cost_;
+        right.num_of_entries_ += bin.num_of_entries_;
+        right_list[k] = right;
+      }
+    }
+    Bin left{makeEmptyBox(), 0.0, 0.0, 0, 0};
+    for (uint k = 0; k < (n - 1); ++k) {
+      const auto& bin = bin_list[k];
+      left.bounding_box_ = combine(left.bounding_box_, bin.bounding_box_);
+      left.entry_cost_ += bin.entry_cost_;
+      left.num_of_entries_ += bin.num_of_entries_;
+      const auto& right = right_list[k + 1];
+      if ((left.num_of_entries_ == 0) || (right.num_of_entries_ == 0))
+        continue;
+      const Float cost = left.bounding_box_.surfaceArea() * left.entry_cost_ +
+                         right.bounding_box_.surfaceArea() * right.entry_cost_;
+      if (cost < best.cost_) {
+        best = Split{cost, 0.0, axis, k, false};
+        *left_box = left.bounding_box_;
+        *right_box = right.bounding_box_;
+      }
+    }
+  }
+  return best;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+auto SpatialSplitBvh::findSpatialSplit(
+    BuildingData& data,
+    const zisc::pmr::vector<Reference>& reference_list,
+    const Aabb& node_box) const noexcept -> Split
+{
+  const uint n = numOfBins();
+  const auto& object_list = *data.object_list_;
+  const auto& min_point = node_box.minPoint();
+  const auto extent = node_box.maxPoint() - min_point;
+  auto& bin_list = data.bin_list_;
+
+  Split best{std::numeric_limits<Float>::max(), 0.0, 3, 0, true};
+  for (uint axis = 0; axis < 3; ++axis) {
+    if (extent[axis] <= 0.0)
+      continue;
+    // Clip the references into the bins which they overlap
+    for (uint k = 0; k < n; ++k)
+      bin_list[k] = Bin{makeEmptyBox(), 0.0, 0.0, 0, 0};
+    const Float width = extent[axis] / zisc::cast<Float>(n);
+    const Float scale = zisc::invert(width);
+    for (const auto& reference : reference_list) {
+      const auto& box = reference.bounding_box_;
+      const uint first = calcBinIndex(box.minPoint()[axis], min_point[axis], scale, n);
+      const uint last = calcBinIndex(box.maxPoint()[axis], min_point[axis], scale, n);
+      for (uint k = first; k <= last; ++k) {
+        const Float lower = min_point[axis] + zisc::cast<Float>(k) * width;
+        const Float upper = (k == (n - 1))
+            ? node_box.maxPoint()[axis]
+            : lower + width;
+        const auto clipped_box = clipReference(object_list, reference, axis,
+                                               lower, upper);
+        bin_list[k].bounding_box_ = combine(bin_list[k].bounding_box_, clipped_box);
+      }
+      const Float cost = data.cost_list_[reference.object_index_];
+      bin_list[first].entry_cost_ += cost;
+      ++bin_list[first].num_of_entries_;
+      bin_list[last].exit_cost_ += cost;
+      ++bin_list[last].num_of_exits_;
+    }
+    // Sweep the bins
+    Bin* right_list = &bin_list[n];
+    {
+      Bin right{makeEmptyBox(), 0.0, 0.0, 0, 0};
+      for (uint k = n - 1; 0 < k; --k) {
+        const auto& bin = bin_list[k];
+        right.bounding_box_ = combine(right.bounding_box_, bin.bounding_box_);
+        right.exit_cost_ += bin.exit_cost_;
+        right.num_of_exits_ += bin.num_of_exits_;
+        right_list[k] = right;
+      }
+    }
+    Bin left{makeEmptyBox(), 0.0, 0.0, 0, 0};
+    for (uint k = 0; k < (n - 1); ++k) {
+      const auto& bin = bin_list[k];
+      left.bounding_box_ = combine(left.bounding_box_, bin.bounding_box_);
+      left.entry_cost_ += bin.entry_cost_;
+      left.num_of_entries_ += bin.num_of_entries_;
+      const auto& right = right_list[k + 1];
+      if ((left.num_of_entries_ == 0) || (right.num_of_exits_ == 0))
+        continue;
+      const Float cost = left.bounding_box_.surfaceArea() * left.entry_cost_ +
+                         right.bounding_box_.surfaceArea() * right.exit_cost_;
+      if (cost < best.cost_) {
+        const Float position = min_point[axis] + zisc::cast<Float>(k + 1) * width;
+        best = Split{cost, position, axis, k, true};
+      }
+    }
+  }
+  return best;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void SpatialSplitBvh::initialize(const SettingNodeBase* settings) noexcept
+{
+  const auto bvh_settings = castNode<BvhSettingNode>(settings);
+
+  const auto& parameters = bvh_settings->spatialSplitParameters();
+  {
+    num_of_bins_ = parameters.num_of_bins_;
+    ZISC_ASSERT(2 <= num_of_bins_, "Invalid number of bins is specified.");
+  }
+  {
+    duplication_limit_ = parameters.duplication_limit_;
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint SpatialSplitBvh::numOfBins() const noexcept
+{
+  return num_of_bins_;
+}
+
+/*!
+  \details
+  Spatial splits are tried only if the children of the object split
+  overlap more than this ratio of the root surface area.
+  */
+inline
+constexpr Float SpatialSplitBvh::overlapThreshold() noexcept
+{
+  return 1.0e-5;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void SpatialSplitBvh::splitObjects(const Split& split,
+                                   const Aabb& centroid_box,
+                                   const uint num_of_bins,
+                                   BuildingTask& task,
+                                   BuildingTask* left_task,
+                                   BuildingTask* right_task) noexcept
+{
+  auto& reference_list = task.reference_list_;
+  auto& left_list = left_task->reference_list_;
+  auto& right_list = right_task->reference_list_;
+  left_list.reserve(reference_list.size());
+  right_list.reserve(reference_list.size());
+  if (split.axis_ < 3) {
+    const uint axis = split.axis_;
+    const Float min_centroid = centroid_box.minPoint()[axis];
+    const Float extent = centroid_box.maxPoint()[axis] - min_centroid;
+    const Float scale = zisc::cast<Float>(num_of_bins) / extent;
+    for (const auto& reference : reference_list) {
+      const Float centroid = reference.bounding_box_.centroid()[axis];
+      const uint k = calcBinIndex(centroid, min_centroid, scale, num_of_bins);
+      if (k <= split.bin_)
+        left_list.emplace_back(reference);
+      else
+        right_list.emplace_back(reference);
+    }
+  }
+  // All centroids are at the same position
+  if (left_list.empty() || right_list.empty()) {
+    left_list.clear();
+    right_list.clear();
+    const std::size_t middle = reference_list.size() >> 1;
+    left_list.insert(left_list.end(),
+                     reference_list.begin(),
+                     reference_list.begin() + middle);
+    right_list.insert(right_list.end(),
+                      reference_list.begin() + middle,
+                      reference_list.end());
+  }
+  reference_list.clear();
+}
+
+/*!
+  \details
+  The references crossing the plane are split into two
+  while the limit of the references isn't reached.
+  */
+void SpatialSplitBvh::splitSpatially(BuildingData& data,
+                                     const Split& split,
+                                     BuildingTask& task,
+                                     BuildingTask* left_task,
+                                     BuildingTask* right_task) noexcept
+{
+  constexpr Float min_value = std::numeric_limits<Float>::lowest();
+  constexpr Float max_value = std::numeric_limits<Float>::max();
+  const auto& object_list = *data.object_list_;
+  const uint axis = split.axis_;
+  const Float position = split.position_;
+
+  auto& reference_list = task.reference_list_;
+  auto& left_list = left_task->reference_list_;
+  auto& right_list = right_task->reference_list_;
+  left_list.reserve(reference_list.size());
+  right_list.reserve(reference_list.size());
+  for (const auto& reference : reference_list) {
+    const auto& box = reference.bounding_box_;
+    if (box.maxPoint()[axis] <= position) {
+      left_list.emplace_back(reference);
+    }
+    else if (position <= box.minPoint()[axis]) {
+      right_list.emplace_back(reference);
+    }
+    else if (0 < data.num_of_remaining_references_) {
+      const auto left_box = clipReference(object_list, reference, axis,
+                                          min_value, position);
+      const auto right_box = clipReference(object_list, reference, axis,
+                                           position, max_value);
+      left_list.emplace_back(Reference{left_box, reference.object_index_});
+      right_list.emplace_back(Reference{right_box, reference.object_index_});
+      --data.num_of_remaining_references_;
+    }
+    else if (box.centroid()[axis] < position) {
+      left_list.emplace_back(reference);
+    }
+    else {
+      right_list.emplace_back(reference);
+    }
+  }
+  // No reference is split in this case
+  if (left_list.empty() || right_list.empty()) {
+    auto& list = left_list.empty() ? right_list : left_list;
+    auto& other = left_list.empty() ? left_list : right_list;
+    const std::size_t middle = list.size() >> 1;
+    other.insert(other.end(), list.begin() + middle, list.end());
+    list.erase(list.begin() + middle, list.end());
+  }
+  reference_list.clear();
+}
+
+} // namespace nanairo
@@ -0,0 +1,168 @@
+/*!
+  \file spatial_split_bvh.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SPATIAL_SPLIT_BVH_HPP
+#define NANAIRO_SPATIAL_SPLIT_BVH_HPP
+
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "bvh_building_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Object;
+class System;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  In addition to object splits, a node can be split by a plane
+  which clips the objects crossing it,
+  so an object can be referred by several leaves.
+  For the details of this algorithm,
+  please see the paper entitled
+  "Spatial Splits in Bounding Volume Hierarchies"
+  */
+class SpatialSplitBvh : public Bvh
+{
+ public:
+  //! Create a spatial split BVH
+  SpatialSplitBvh(System& system, const SettingNodeBase* settings) noexcept;
+
+ private:
+  //! A part of an object
+  struct Reference
+  {
+    Aabb bounding_box_;
+    uint32 object_index_;
+  };
+
+  //! The references which belong to a node
+  struct BuildingTask
+  {
+    BuildingTask(const uint32 parent_index,
+                 const bool is_right_child,
+                 zisc::pmr::memory_resource* work_resource) noexcept;
+
+    zisc::pmr::vector<Reference> reference_list_;
+    uint32 parent_index_;
+    bool is_right_child_;
+  };
+
+  //! The references which fall into a bin
+  struct Bin
+  {
+    Aabb bounding_box_;
+    Float entry_cost_;
+    Float exit_cost_;
+    uint32 num_of_entries_;
+    uint32 num_of_exits_;
+  };
+
+  //! The best split of a node
+  struct Split
+  {
+    Float cost_;
+    Float position_;
+    uint axis_;
+    uint bin_;
+    bool is_spatial_;
+  };
+
+  //! The data which is shared in building
+  struct BuildingData : public zisc::NonCopyable<BuildingData>
+  {
+    BuildingData(const zisc::pmr::vector<Object>& object_list,
+                 const uint num_of_bins,
+                 zisc::pmr::memory_resource* work_resource) noexcept;
+
+    const zisc::pmr::vector<Object>* object_list_;
+    zisc::pmr::vector<Float> cost_list_;
+    zisc::pmr::vector<Bin> bin_list_;
+    Float root_surface_area_;
+    uint32 num_of_remaining_references_;
+  };
+
+
+  //! Calculate the bin index of the value
+  static uint calcBinIndex(const Float value,
+                           const Float min_value,
+                           const Float scale,
+                           const uint num_of_bins) noexcept;
+
+  //! Clip the reference by the slab of the axis
+  static Aabb clipReference(const zisc::pmr::vector<Object>& object_list,
+                            const Reference& reference,
+                            const uint axis,
+                            const Float min_value,
+                            const Float max_value) noexcept;
+
+  //! Build a spatial split BVH
+  void constructBvh(
+      System& system,
+      const zisc::pmr::vector<Object>& object_list,
+      zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept override;
+
+  //! Find the best object split of the node
+  Split findObjectSplit(BuildingData& data,
+                        const zisc::pmr::vector<Reference>& reference_list,
+                        const Aabb& centroid_box,
+                        Aabb* left_box,
+                        Aabb* right_box) const noexcept;
+
+  //! Find the best spatial split of the node
+  Split findSpatialSplit(BuildingData& data,
+                         const zisc::pmr::vector<Reference>& reference_list,
+                         const Aabb& node_box) const noexcept;
+
+  //! Initialize
+  void initialize(const SettingNodeBase* settings) noexcept;
+
+  //! Return the number of bins
+  uint numOfBins() const noexcept;
+
+  //! Return the overlap ratio which enables spatial splits
+  static constexpr Float overlapThreshold() noexcept;
+
+  //! Split the references of the node by the object split
+  static void splitObjects(const Split& split,
+                           const Aabb& centroid_box,
+                           const uint num_of_bins,
+                           BuildingTask& task,
+                           BuildingTask* left_task,
+                           BuildingTask* right_task) noexcept;
+
+  //! Split the references of the node by the spatial split
+  static void splitSpatially(BuildingData& data,
+                             const Split& split,
+                             BuildingTask& task,
+                             BuildingTask* left_task,
+                             BuildingTask* right_task) noexcept;
+
+
+  uint num_of_bins_;
+  uint duplication_limit_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#endif // NANAIRO_SPATIAL_SPLIT_BVH_HPP
@@ -0,0 +1,180 @@
+/*!
+  \file traversal_ray-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRAVERSAL_RAY_INL_HPP
+#define NANAIRO_TRAVERSAL_RAY_INL_HPP
+
+#include "traversal_ray.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <limits>
+// Zisc
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+TraversalRay::TraversalRay(const Ray& ray) noexcept
+{
+  const auto& origin = ray.origin();
+  const auto inv_dir = invert(ray.direction());
+  for (uint axis = 0; axis < 3; ++axis) {
+    const bool is_negative = inv_dir[axis] < 0.0;
+    near_origin_[axis] = is_negative ? roundDown(origin[axis])
+                                     : roundUp(origin[axis]);
+    far_origin_[axis] = is_negative ? roundUp(origin[axis])
+                                    : roundDown(origin[axis]);
+    inv_dir_[axis] = zisc::cast<TraversalFloat>(inv_dir[axis]);
+    near_plane_[axis] = is_negative ? axis + 3 : axis;
+    far_plane_[axis] = is_negative ? axis : axis + 3;
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+auto TraversalRay::farOrigin() const noexcept -> const FloatArray&
+{
+  return far_origin_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+auto TraversalRay::farPlane() const noexcept -> const PlaneIndex&
+{
+  return far_plane_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+auto TraversalRay::inverseDirection() const noexcept -> const FloatArray&
+{
+  return inv_dir_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+auto TraversalRay::nearOrigin() const noexcept -> const FloatArray&
+{
+  return near_origin_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+auto TraversalRay::nearPlane() const noexcept -> const PlaneIndex&
+{
+  return near_plane_;
+}
+
+/*!
+  \details
+  The distance is enlarged even if it is minus,
+  so a box which the origin lies on isn't missed.
+  */
+inline
+TraversalFloat TraversalRay::enlargeFarDistance(
+    const TraversalFloat distance) noexcept
+{
+  return distance + zisc::abs(distance) * farDistanceError();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+TraversalFloat TraversalRay::roundDown(const Float value) noexcept
+{
+  constexpr auto lowest = std::numeric_limits<TraversalFloat>::lowest();
+  auto result = zisc::cast<TraversalFloat>(value);
+  if (value < zisc::cast<Float>(result))
+    result = std::nextafter(result, lowest);
+  return result;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+TraversalFloat TraversalRay::roundUp(const Float value) noexcept
+{
+  constexpr auto max_value = std::numeric_limits<TraversalFloat>::max();
+  auto result = zisc::cast<TraversalFloat>(value);
+  if (zisc::cast<Float>(result) < value)
+    result = std::nextafter(result, max_value);
+  return result;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+IntersectionTestResult TraversalRay::testIntersection(
+    const std::array<TraversalFloat, 6>& bounds) const noexcept
+{
+  std::array<TraversalFloat, 3> t0;
+  std::array<TraversalFloat, 3> t1;
+  for (uint axis = 0; axis < 3; ++axis) {
+    t0[axis] = (bounds[near_plane_[axis]] - near_origin_[axis]) * inv_dir_[axis];
+    t1[axis] = (bounds[far_plane_[axis]] - far_origin_[axis]) * inv_dir_[axis];
+  }
+  const TraversalFloat tmin = zisc::max(zisc::max(t0[0], t0[1]), t0[2]);
+  const TraversalFloat tmax =
+      enlargeFarDistance(zisc::min(zisc::min(t1[0], t1[1]), t1[2]));
+
+  const auto result = (tmin <= tmax)
+      ? IntersectionTestResult{zisc::cast<Float>(tmin)}
+      : IntersectionTestResult{};
+  return result;
+}
+
+/*!
+  \details
+  Each distance is computed with three roundings,
+  the inverse direction, the subtraction and the multiplication,
+  so the bound is 2 * gamma(3) where gamma(n) = n * u / (1 - n * u).
+  */
+inline
+constexpr TraversalFloat TraversalRay::farDistanceError() noexcept
+{
+  constexpr TraversalFloat u = 0.5f * std::numeric_limits<TraversalFloat>::epsilon();
+  constexpr TraversalFloat gamma3 = (3.0f * u) / (1.0f - 3.0f * u);
+  return 2.0f * gamma3;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TRAVERSAL_RAY_INL_HPP
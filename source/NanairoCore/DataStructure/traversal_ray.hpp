@@ -0,0 +1,93 @@
+/*!
+  \file traversal_ray.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRAVERSAL_RAY_HPP
+#define NANAIRO_TRAVERSAL_RAY_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Ray;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The ray data used in the box tests of BVH traversal
+  \details
+  The data is stored in TraversalFloat which can be single precision.
+  The origin is rounded toward the near planes of boxes for the entry distances
+  and away from the far planes for the exit distances,
+  and the exit distances are enlarged by the rounding errors of the tests.
+  Please see "Robust BVH Ray Traversal".
+  */
+class TraversalRay
+{
+ public:
+  using FloatArray = std::array<TraversalFloat, 3>;
+  using PlaneIndex = std::array<uint, 3>;
+
+
+  //! Create a traversal ray
+  TraversalRay(const Ray& ray) noexcept;
+
+
+  //! Return the origin for the exit distances
+  const FloatArray& farOrigin() const noexcept;
+
+  //! Return the planes which the ray exits through
+  const PlaneIndex& farPlane() const noexcept;
+
+  //! Return the inverse direction
+  const FloatArray& inverseDirection() const noexcept;
+
+  //! Return the origin for the entry distances
+  const FloatArray& nearOrigin() const noexcept;
+
+  //! Return the planes which the ray enters through
+  const PlaneIndex& nearPlane() const noexcept;
+
+  //! Enlarge the exit distance by the rounding errors of the test
+  static TraversalFloat enlargeFarDistance(const TraversalFloat distance) noexcept;
+
+  //! Round the value downward to TraversalFloat
+  static TraversalFloat roundDown(const Float value) noexcept;
+
+  //! Round the value upward to TraversalFloat
+  static TraversalFloat roundUp(const Float value) noexcept;
+
+  //! Test ray-box intersection, the bounds are min x, y, z and max x, y, z
+  IntersectionTestResult testIntersection(
+      const std::array<TraversalFloat, 6>& bounds) const noexcept;
+
+ private:
+  //! Return the relative error bound of the exit distance
+  static constexpr TraversalFloat farDistanceError() noexcept;
+
+
+  FloatArray near_origin_;
+  FloatArray far_origin_;
+  FloatArray inv_dir_;
+  PlaneIndex near_plane_;
+  PlaneIndex far_plane_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "traversal_ray-inl.hpp"
+
+#endif // NANAIRO_TRAVERSAL_RAY_HPP
@@ -0,0 +1,191 @@
+/*!
+  \file traversal_statistics-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRAVERSAL_STATISTICS_INL_HPP
+#define NANAIRO_TRAVERSAL_STATISTICS_INL_HPP
+
+#include "traversal_statistics.hpp"
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  It is defined first since the other functions use it in constexpr if.
+  */
+inline
+constexpr bool TraversalStatistics::isEnabled() noexcept
+{
+  return CoreConfig::traversalStatisticsIsEnabled();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+auto TraversalStatistics::Counter::operator+=(const Counter& other) noexcept
+    -> Counter&
+{
+  num_of_nodes_ += other.num_of_nodes_;
+  num_of_aabb_tests_ += other.num_of_aabb_tests_;
+  num_of_object_tests_ += other.num_of_object_tests_;
+  num_of_hits_ += other.num_of_hits_;
+  num_of_rays_ += other.num_of_rays_;
+  return *this;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint64 TraversalStatistics::Counter::count(const Type type) const noexcept
+{
+  const uint64 c = (type == Type::kNode)       ? num_of_nodes_ :
+                   (type == Type::kAabbTest)   ? num_of_aabb_tests_ :
+                   (type == Type::kObjectTest) ? num_of_object_tests_ :
+                   (type == Type::kHit)        ? num_of_hits_
+                                               : num_of_rays_;
+  return c;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void TraversalStatistics::addThreadCounter(const Index2d& position) noexcept
+{
+  if constexpr (isEnabled()) {
+    auto& counter = threadCounter();
+    counter_table_[getIndex(position)] += counter;
+    counter = Counter{};
+  }
+  else {
+    static_cast<void>(position);
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void TraversalStatistics::countAabbTests(const uint num_of_tests) noexcept
+{
+  if constexpr (isEnabled())
+    threadCounter().num_of_aabb_tests_ += num_of_tests;
+  else
+    static_cast<void>(num_of_tests);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void TraversalStatistics::countHit() noexcept
+{
+  if constexpr (isEnabled())
+    ++threadCounter().num_of_hits_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void TraversalStatistics::countNodes(const uint num_of_nodes) noexcept
+{
+  if constexpr (isEnabled())
+    threadCounter().num_of_nodes_ += num_of_nodes;
+  else
+    static_cast<void>(num_of_nodes);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void TraversalStatistics::countObjectTests(const uint num_of_tests) noexcept
+{
+  if constexpr (isEnabled())
+    threadCounter().num_of_object_tests_ += num_of_tests;
+  else
+    static_cast<void>(num_of_tests);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void TraversalStatistics::countRay() noexcept
+{
+  if constexpr (isEnabled())
+    ++threadCounter().num_of_rays_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+auto TraversalStatistics::counter(const Index2d& position) const noexcept
+    -> const Counter&
+{
+  ZISC_ASSERT(isEnabled(), "The traversal statistics isn't enabled.");
+  return counter_table_[getIndex(position)];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void TraversalStatistics::resetThreadCounter() noexcept
+{
+  if constexpr (isEnabled())
+    threadCounter() = Counter{};
+}
+
+/*!
+  \details
+  Each thread has its own counter,
+  so the counts are added without synchronization.
+  */
+inline
+auto TraversalStatistics::threadCounter() noexcept -> Counter&
+{
+  thread_local Counter counter;
+  return counter;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint TraversalStatistics::getIndex(const Index2d& position) const noexcept
+{
+  const uint index = zisc::cast<uint>(position[0] + position[1] * resolution_[0]);
+  ZISC_ASSERT(index < counter_table_.size(), "The position is out of range.");
+  return index;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TRAVERSAL_STATISTICS_INL_HPP
@@ -0,0 +1,141 @@
+/*!
+  \file traversal_statistics.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "traversal_statistics.hpp"
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Color/rgba_32.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+namespace {
+
+/*!
+  \details
+  The value in [0, 1] is mapped from blue to red through green.
+  */
+inline
+Rgba32 toHeatmapColor(const Float value) noexcept
+{
+  const Float t = zisc::clamp(value, 0.0, 1.0);
+  const Float r = zisc::clamp(2.0 * t - 1.0, 0.0, 1.0);
+  const Float g = 1.0 - zisc::abs(2.0 * t - 1.0);
+  const Float b = zisc::clamp(1.0 - 2.0 * t, 0.0, 1.0);
+  return Rgba32{r, g, b};
+}
+
+} // namespace
+
+/*!
+  \details
+  No detailed.
+  */
+TraversalStatistics::TraversalStatistics(System& system) noexcept :
+    counter_table_{&system.dataMemoryManager()},
+    resolution_{system.imageResolution()}
+{
+  if (isEnabled())
+    counter_table_.resize(resolution_[0] * resolution_[1]);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void TraversalStatistics::clear() noexcept
+{
+  for (auto& counter : counter_table_)
+    counter = Counter{};
+}
+
+/*!
+  \details
+  The count per ray of each pixel is normalized by the max in the image.
+  */
+void TraversalStatistics::makeHeatmap(const Type type,
+                                      LdrImage* image) const noexcept
+{
+  ZISC_ASSERT(isEnabled(), "The traversal statistics isn't enabled.");
+  ZISC_ASSERT(image != nullptr, "The image is null.");
+  ZISC_ASSERT(image->size() == counter_table_.size(),
+              "The resolution of the image is different from the statistics.");
+  auto count_per_ray = [](const Counter& counter, const Type t)
+  {
+    const uint64 num_of_rays = counter.num_of_rays_;
+    return (0 < num_of_rays)
+        ? zisc::cast<Float>(counter.count(t)) / zisc::cast<Float>(num_of_rays)
+        : 0.0;
+  };
+
+  Float max_value = 0.0;
+  for (const auto& counter : counter_table_)
+    max_value = zisc::max(max_value, count_per_ray(counter, type));
+  const Float inverse_max = (0.0 < max_value) ? 1.0 / max_value : 0.0;
+  for (uint index = 0; index < counter_table_.size(); ++index) {
+    const Float value = inverse_max * count_per_ray(counter_table_[index], type);
+    image->set(index, toHeatmapColor(value));
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+const char* TraversalStatistics::name(const Type type) noexcept
+{
+  const char* n = nullptr;
+  switch (type) {
+   case Type::kNode: {
+    n = "nodes";
+    break;
+   }
+   case Type::kAabbTest: {
+    n = "aabb-tests";
+    break;
+   }
+   case Type::kObjectTest: {
+    n = "object-tests";
+    break;
+   }
+   case Type::kHit: {
+    n = "hits";
+    break;
+   }
+   case Type::kRay:
+   default: {
+    n = "rays";
+    break;
+   }
+  }
+  return n;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+auto TraversalStatistics::totalCounter() const noexcept -> Counter
+{
+  Counter total;
+  for (const auto& counter : counter_table_)
+    total += counter;
+  return total;
+}
+
+} // namespace nanairo
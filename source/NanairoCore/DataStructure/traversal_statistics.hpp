@@ -0,0 +1,128 @@
+/*!
+  \file traversal_statistics.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRAVERSAL_STATISTICS_HPP
+#define NANAIRO_TRAVERSAL_STATISTICS_HPP
+
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class LdrImage;
+class System;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  The BVH traversal counts of the rays are accumulated in a counter
+  of the current thread, and then moved to the pixel
+  which the rays contribute to.
+  The counting is compiled only if the statistics are enabled in the build.
+  */
+class TraversalStatistics
+{
+ public:
+  //! The type of a count
+  enum class Type : uint32
+  {
+    kNode = 0,
+    kAabbTest,
+    kObjectTest,
+    kHit,
+    kRay
+  };
+
+  //! The traversal counts
+  struct Counter
+  {
+    //! Add the counts of other
+    Counter& operator+=(const Counter& other) noexcept;
+
+    //! Return the count of the type
+    uint64 count(const Type type) const noexcept;
+
+    uint64 num_of_nodes_ = 0;
+    uint64 num_of_aabb_tests_ = 0;
+    uint64 num_of_object_tests_ = 0;
+    uint64 num_of_hits_ = 0;
+    uint64 num_of_rays_ = 0;
+  };
+
+
+  //! Initialize the pixel counters
+  TraversalStatistics(System& system) noexcept;
+
+
+  //! Move the counts of the current thread to the pixel
+  void addThreadCounter(const Index2d& position) noexcept;
+
+  //! Clear the counts
+  void clear() noexcept;
+
+  //! Count AABB tests
+  static void countAabbTests(const uint num_of_tests) noexcept;
+
+  //! Count a hit
+  static void countHit() noexcept;
+
+  //! Count visited nodes
+  static void countNodes(const uint num_of_nodes) noexcept;
+
+  //! Count object tests
+  static void countObjectTests(const uint num_of_tests) noexcept;
+
+  //! Count a ray
+  static void countRay() noexcept;
+
+  //! Return the counter of the pixel
+  const Counter& counter(const Index2d& position) const noexcept;
+
+  //! Check if the statistics are enabled
+  static constexpr bool isEnabled() noexcept;
+
+  //! Make a heatmap of the count per ray
+  void makeHeatmap(const Type type, LdrImage* image) const noexcept;
+
+  //! Return the name of the count type
+  static const char* name(const Type type) noexcept;
+
+  //! Reset the counter of the current thread
+  static void resetThreadCounter() noexcept;
+
+  //! Return the counter of the current thread
+  static Counter& threadCounter() noexcept;
+
+  //! Return the sum of the counts of all pixels
+  Counter totalCounter() const noexcept;
+
+ private:
+  //! Return the index of the pixel
+  uint getIndex(const Index2d& position) const noexcept;
+
+
+  zisc::pmr::vector<Counter> counter_table_;
+  Index2d resolution_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "traversal_statistics-inl.hpp"
+
+#endif // NANAIRO_TRAVERSAL_STATISTICS_HPP
@@ -0,0 +1,57 @@
+/*!
+  \file wide_bvh-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WIDE_BVH_INL_HPP
+#define NANAIRO_WIDE_BVH_INL_HPP
+
+#include "wide_bvh.hpp"
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "wide_bvh_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The traversal stack holds at most (kWidth - 1) entries per tree level.
+  */
+template <uint kWidth, typename BuilderBvh> inline
+constexpr uint WideBvh<kWidth, BuilderBvh>::traversalStackSize() noexcept
+{
+  return 64 * kWidth;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth, typename BuilderBvh> inline
+auto WideBvh<kWidth, BuilderBvh>::wideTree() const noexcept
+    -> const zisc::pmr::vector<NodeType>&
+{
+  return wide_tree_;
+}
+
+/*!
+  \details
+  The wide tree is empty if the tree of BVH is used in ray traversal instead.
+  */
+template <uint kWidth, typename BuilderBvh> inline
+bool WideBvh<kWidth, BuilderBvh>::wideTreeIsUsed() const noexcept
+{
+  return !wide_tree_.empty();
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_WIDE_BVH_INL_HPP
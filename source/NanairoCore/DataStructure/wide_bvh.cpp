@@ -0,0 +1,297 @@
+/*!
+  \file wide_bvh.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "wide_bvh.hpp"
+// Standard C++ library
+#include <array>
+#include <vector>
+// Zisc
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "agglomerative_treelet_restructuring_bvh.hpp"
+#include "binary_radix_tree_bvh.hpp"
+#include "binned_sah_bvh.hpp"
+#include "bvh.hpp"
+#include "bvh_tree_node.hpp"
+#include "ploc_bvh.hpp"
+#include "spatial_split_bvh.hpp"
+#include "traversal_ray.hpp"
+#include "traversal_statistics.hpp"
+#include "wide_bvh_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth, typename BuilderBvh>
+WideBvh<kWidth, BuilderBvh>::WideBvh(System& system,
+                                     const SettingNodeBase* settings) noexcept :
+    BuilderBvh(system, settings),
+    wide_tree_{&system.dataMemoryManager()}
+{
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth, typename BuilderBvh>
+IntersectionInfo WideBvh<kWidth, BuilderBvh>::findClosestIntersection(
+    const Ray& ray,
+    const Float max_distance,
+    const bool expect_no_hit) const noexcept
+{
+  if (!wideTreeIsUsed())
+    return BuilderBvh::findClosestIntersection(ray, max_distance, expect_no_hit);
+
+  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  IntersectionInfo intersection;
+  intersection.setRayDistance(max_distance);
+
+  const TraversalRay traversal_ray{ray};
+  const auto& wide_tree = wideTree();
+
+  std::array<TraversalEntry, traversalStackSize()> stack;
+  uint stack_size = 0;
+  stack[stack_size++] = TraversalEntry{0, 0, 0.0};
+  while ((0 < stack_size) && !(intersection.isIntersected() && expect_no_hit)) {
+    const auto entry = stack[--stack_size];
+    // Skip the entry if a closer intersection is already found
+    if (intersection.rayDistance() < entry.distance_)
+      continue;
+    TraversalStatistics::countNodes(1);
+    // A case of leaf node
+    if (0 < entry.num_of_objects_) {
+      this->testRayObjectsIntersection(ray,
+                                       entry.index_,
+                                       entry.num_of_objects_,
+                                       &intersection);
+      continue;
+    }
+    // Test all children of the node at once
+    const auto& node = wide_tree[entry.index_];
+    TraversalStatistics::countAabbTests(kWidth);
+    typename NodeType::FloatArray distance_list;
+    uint hit_mask = node.testIntersection(traversal_ray,
+                                          intersection.rayDistance(),
+                                          &distance_list);
+    // Push the hit children in far-to-near order so that the nearest is popped
+    const uint first = stack_size;
+    for (uint lane = 0; hit_mask != 0; ++lane, hit_mask = hit_mask >> 1) {
+      if ((hit_mask & 0b01u) == 0)
+        continue;
+      ZISC_ASSERT(stack_size < traversalStackSize(), "The stack overflowed.");
+      const TraversalEntry child{node.childIndex(lane),
+                                 zisc::cast<uint32>(node.numOfObjects(lane)),
+                                 distance_list[lane]};
+      uint i = stack_size;
+      for (; (first < i) && (stack[i - 1].distance_ < child.distance_); --i)
+        stack[i] = stack[i - 1];
+      stack[i] = child;
+      ++stack_size;
+    }
+  }
+  return intersection;
+}
+
+/*!
+  \details
+  The hit children are pushed without sorting since
+  the traversal ends at the first occluder.
+  */
+template <uint kWidth, typename BuilderBvh>
+bool WideBvh<kWidth, BuilderBvh>::testOcclusion(
+    const Ray& ray,
+    const Float max_distance,
+    const Object* ignore_object) const noexcept
+{
+  if (!wideTreeIsUsed())
+    return BuilderBvh::testOcclusion(ray, max_distance, ignore_object);
+
+  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  const TraversalRay traversal_ray{ray};
+  const auto& wide_tree = wideTree();
+
+  std::array<TraversalEntry, traversalStackSize()> stack;
+  uint stack_size = 0;
+  stack[stack_size++] = TraversalEntry{0, 0, 0.0};
+  while (0 < stack_size) {
+    const auto entry = stack[--stack_size];
+    TraversalStatistics::countNodes(1);
+    // A case of leaf node
+    if (0 < entry.num_of_objects_) {
+      if (this->testRayObjectsOcclusion(ray,
+                                        max_distance,
+                                        ignore_object,
+                                        entry.index_,
+                                        entry.num_of_objects_))
+        return true;
+      continue;
+    }
+    // Test all children of the node at once
+    const auto& node = wide_tree[entry.index_];
+    TraversalStatistics::countAabbTests(kWidth);
+    typename NodeType::FloatArray distance_list;
+    uint hit_mask = node.testIntersection(traversal_ray,
+                                          max_distance,
+                                          &distance_list);
+    for (uint lane = 0; hit_mask != 0; ++lane, hit_mask = hit_mask >> 1) {
+      if ((hit_mask & 0b01u) == 0)
+        continue;
+      ZISC_ASSERT(stack_size < traversalStackSize(), "The stack overflowed.");
+      stack[stack_size++] = TraversalEntry{
+          node.childIndex(lane),
+          zisc::cast<uint32>(node.numOfObjects(lane)),
+          distance_list[lane]};
+    }
+  }
+  return false;
+}
+
+/*!
+  \details
+  The internal child which has the largest surface area is opened
+  repeatedly until the node is full.
+  */
+template <uint kWidth, typename BuilderBvh>
+uint WideBvh<kWidth, BuilderBvh>::collapse(const uint32 binary_index,
+                                           const uint32 wide_index) noexcept
+{
+  const auto& bvh_tree = this->bvhTree();
+
+  // Gather the children of the wide node
+  std::array<uint32, kWidth> child_list;
+  uint num_of_children = 0;
+  child_list[num_of_children++] = this->leftChildIndex(binary_index);
+  child_list[num_of_children++] = this->rightChildIndex(binary_index);
+  while (num_of_children < kWidth) {
+    uint target = kWidth;
+    Float max_surface_area = 0.0;
+    for (uint i = 0; i < num_of_children; ++i) {
+      const auto& child = bvh_tree[child_list[i]];
+      if (child.isLeafNode())
+        continue;
+      const Float surface_area = child.boundingBox().surfaceArea();
+      if ((target == kWidth) || (max_surface_area < surface_area)) {
+        target = i;
+        max_surface_area = surface_area;
+      }
+    }
+    if (target == kWidth)
+      break;
+    const uint32 index = child_list[target];
+    child_list[target] = this->leftChildIndex(index);
+    child_list[num_of_children++] = this->rightChildIndex(index);
+  }
+
+  // Set the children
+  uint stack_size = num_of_children;
+  for (uint lane = 0; lane < num_of_children; ++lane) {
+    const auto& child = bvh_tree[child_list[lane]];
+    if (child.isLeafNode()) {
+      wide_tree_[wide_index].setChild(lane,
+                                      child.boundingBox(),
+                                      child.objectIndex(),
+                                      child.numOfObjects());
+    }
+    else {
+      const uint32 child_index = zisc::cast<uint32>(wide_tree_.size());
+      wide_tree_.emplace_back();
+      const uint child_stack_size = collapse(child_list[lane], child_index);
+      wide_tree_[wide_index].setChild(lane, child.boundingBox(), child_index, 0);
+      stack_size = zisc::max(stack_size, (num_of_children - 1) + child_stack_size);
+    }
+  }
+  return stack_size;
+}
+
+/*!
+  \details
+  The wide nodes are stored in full precision, so if a quantized node format
+  is specified, the quantized tree of the base class is used instead.
+  If the wide tree is too deep for the traversal stack,
+  the tree of BVH is traversed instead.
+  The tree of BVH is kept since the wide tree is collapsed from it again
+  in refitting.
+  */
+template <uint kWidth, typename BuilderBvh>
+void WideBvh<kWidth, BuilderBvh>::constructTraversalTree(
+    System& system,
+    const SettingNodeBase* settings) noexcept
+{
+  wide_tree_.clear();
+  const auto bvh_settings = castNode<BvhSettingNode>(settings);
+  if (bvh_settings->nodeFormat() == BvhNodeFormat::kFull) {
+    const auto& bvh_tree = this->bvhTree();
+    wide_tree_.reserve((bvh_tree.size() >> 1) / (kWidth - 1) + 1);
+    wide_tree_.emplace_back();
+
+    const auto& root = bvh_tree[0];
+    if (root.isLeafNode()) {
+      wide_tree_[0].setChild(0,
+                             root.boundingBox(),
+                             root.objectIndex(),
+                             root.numOfObjects());
+    }
+    else {
+      const uint stack_size = collapse(0, 0);
+      if (traversalStackSize() < stack_size)
+        wide_tree_.clear();
+    }
+  }
+  if (!wideTreeIsUsed())
+    BuilderBvh::constructTraversalTree(system, settings);
+  wide_tree_.shrink_to_fit();
+}
+
+/*!
+  \details
+  The collapse takes linear time in the size of the tree,
+  so the wide tree is collapsed again from the refitted tree of BVH.
+  */
+template <uint kWidth, typename BuilderBvh>
+void WideBvh<kWidth, BuilderBvh>::refitTraversalTree(
+    System& system,
+    const SettingNodeBase* settings) noexcept
+{
+  if (wideTreeIsUsed()) {
+    this->refitTree(system, settings->workResource());
+    constructTraversalTree(system, settings);
+  }
+  else {
+    BuilderBvh::refitTraversalTree(system, settings);
+  }
+}
+
+// Instantiation
+template class WideBvh<4, AgglomerativeTreeletRestructuringBvh>;
+template class WideBvh<4, BinaryRadixTreeBvh>;
+template class WideBvh<4, BinnedSahBvh>;
+template class WideBvh<4, PlocBvh>;
+template class WideBvh<4, SpatialSplitBvh>;
+template class WideBvh<8, AgglomerativeTreeletRestructuringBvh>;
+template class WideBvh<8, BinaryRadixTreeBvh>;
+template class WideBvh<8, BinnedSahBvh>;
+template class WideBvh<8, PlocBvh>;
+template class WideBvh<8, SpatialSplitBvh>;
+
+} // namespace nanairo
@@ -0,0 +1,103 @@
+/*!
+  \file wide_bvh.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WIDE_BVH_HPP
+#define NANAIRO_WIDE_BVH_HPP
+
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "bvh.hpp"
+#include "wide_bvh_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class IntersectionInfo;
+class Object;
+class Ray;
+class System;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  The binary tree built by BuilderBvh is collapsed into a tree of
+  kWidth-ary nodes.
+  A ray is tested against all children of a node at once and
+  the hit children are traversed in front-to-back order.
+  */
+template <uint kWidth, typename BuilderBvh>
+class WideBvh : public BuilderBvh
+{
+ public:
+  using NodeType = WideBvhNode<kWidth>;
+
+
+  //! Create a wide BVH
+  WideBvh(System& system, const SettingNodeBase* settings) noexcept;
+
+
+  //! Find the closest intersection without computing the hit attributes
+  IntersectionInfo findClosestIntersection(
+      const Ray& ray,
+      const Float max_distance,
+      const bool expect_no_hit = false) const noexcept override;
+
+  //! Test if the ray is occluded by any object before the max distance
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance,
+                     const Object* ignore_object = nullptr) const noexcept override;
+
+  //! Return the size of the stack used in ray traversal
+  static constexpr uint traversalStackSize() noexcept;
+
+  //! Return the wide tree
+  const zisc::pmr::vector<NodeType>& wideTree() const noexcept;
+
+  //! Check if the wide tree is used in ray traversal
+  bool wideTreeIsUsed() const noexcept;
+
+ private:
+  //! The node which is waiting for traversal
+  struct TraversalEntry
+  {
+    uint32 index_; //!< Node index or first object index
+    uint32 num_of_objects_; //!< 0 means the entry is an internal node
+    Float distance_;
+  };
+
+
+  //! Collapse the binary subtree into the wide node and return the stack size
+  uint collapse(const uint32 binary_index, const uint32 wide_index) noexcept;
+
+  //! Collapse the tree of BVH into the wide tree
+  void constructTraversalTree(System& system,
+                              const SettingNodeBase* settings) noexcept override;
+
+  //! Refit the tree of BVH and collapse it into the wide tree again
+  void refitTraversalTree(System& system,
+                          const SettingNodeBase* settings) noexcept override;
+
+
+  zisc::pmr::vector<NodeType> wide_tree_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "wide_bvh-inl.hpp"
+
+#endif // NANAIRO_WIDE_BVH_HPP
@@ -0,0 +1,206 @@
+/*!
+  \file wide_bvh_node-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WIDE_BVH_NODE_INL_HPP
+#define NANAIRO_WIDE_BVH_NODE_INL_HPP
+
+#include "wide_bvh_node.hpp"
+// Standard C++ library
+#include <array>
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "bvh_building_node.hpp"
+#include "traversal_ray.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The bounding boxes of empty lanes are inverted so that
+  any ray never hits them.
+  */
+template <uint kWidth> inline
+WideBvhNode<kWidth>::WideBvhNode() noexcept
+{
+  constexpr TraversalFloat max_value = std::numeric_limits<TraversalFloat>::max();
+  for (uint axis = 0; axis < 3; ++axis) {
+    bounds_[axis].fill(max_value);
+    bounds_[axis + 3].fill(-max_value);
+  }
+  child_index_.fill(BvhBuildingNode::nullIndex());
+  num_of_objects_.fill(0);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth> inline
+Aabb WideBvhNode<kWidth>::childBoundingBox(const uint lane) const noexcept
+{
+  ZISC_ASSERT(lane < width(), "The lane is out of range.");
+  const Point3 min_point{zisc::cast<Float>(bounds_[0][lane]),
+                         zisc::cast<Float>(bounds_[1][lane]),
+                         zisc::cast<Float>(bounds_[2][lane])};
+  const Point3 max_point{zisc::cast<Float>(bounds_[3][lane]),
+                         zisc::cast<Float>(bounds_[4][lane]),
+                         zisc::cast<Float>(bounds_[5][lane])};
+  return Aabb{min_point, max_point};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth> inline
+uint32 WideBvhNode<kWidth>::childIndex(const uint lane) const noexcept
+{
+  ZISC_ASSERT(lane < width(), "The lane is out of range.");
+  return child_index_[lane];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth> inline
+bool WideBvhNode<kWidth>::hasChild(const uint lane) const noexcept
+{
+  return childIndex(lane) != BvhBuildingNode::nullIndex();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth> inline
+bool WideBvhNode<kWidth>::isLeafChild(const uint lane) const noexcept
+{
+  return 0 < numOfObjects(lane);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth> inline
+uint WideBvhNode<kWidth>::numOfChildren() const noexcept
+{
+  uint num_of_children = 0;
+  for (uint lane = 0; lane < width(); ++lane) {
+    if (hasChild(lane))
+      ++num_of_children;
+  }
+  return num_of_children;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth> inline
+uint WideBvhNode<kWidth>::numOfObjects(const uint lane) const noexcept
+{
+  ZISC_ASSERT(lane < width(), "The lane is out of range.");
+  return zisc::cast<uint>(num_of_objects_[lane]);
+}
+
+/*!
+  \details
+  If the num_of_objects is 0, the child is an internal node and
+  the child_index is the index of the node.
+  Otherwise, the child is a leaf and the child_index is the first object index.
+  */
+template <uint kWidth> inline
+void WideBvhNode<kWidth>::setChild(const uint lane,
+                                   const Aabb& bounding_box,
+                                   const uint32 child_index,
+                                   const uint num_of_objects) noexcept
+{
+  ZISC_ASSERT(lane < width(), "The lane is out of range.");
+  ZISC_ASSERT(child_index != BvhBuildingNode::nullIndex(),
+              "The child index is null.");
+  for (uint axis = 0; axis < 3; ++axis) {
+    bounds_[axis][lane] = TraversalRay::roundDown(bounding_box.minPoint()[axis]);
+    bounds_[axis + 3][lane] = TraversalRay::roundUp(bounding_box.maxPoint()[axis]);
+  }
+  child_index_[lane] = child_index;
+  num_of_objects_[lane] = zisc::cast<uint32>(num_of_objects);
+}
+
+/*!
+  \details
+  The slab test is performed for all lanes at once.
+  The i-th bit of the returned mask is set if the ray hits the i-th child
+  within the max_distance, and the entry distance is stored in the list.
+  */
+template <uint kWidth> inline
+uint WideBvhNode<kWidth>::testIntersection(
+    const TraversalRay& ray,
+    const Float max_distance,
+    FloatArray* distance_list) const noexcept
+{
+  ZISC_ASSERT(distance_list != nullptr, "The distance list is null.");
+  const auto& near_plane = ray.nearPlane();
+  const auto& far_plane = ray.farPlane();
+  const auto& near_x = bounds_[near_plane[0]];
+  const auto& near_y = bounds_[near_plane[1]];
+  const auto& near_z = bounds_[near_plane[2]];
+  const auto& far_x = bounds_[far_plane[0]];
+  const auto& far_y = bounds_[far_plane[1]];
+  const auto& far_z = bounds_[far_plane[2]];
+  const TraversalFloat nox = ray.nearOrigin()[0],
+                       noy = ray.nearOrigin()[1],
+                       noz = ray.nearOrigin()[2];
+  const TraversalFloat fox = ray.farOrigin()[0],
+                       foy = ray.farOrigin()[1],
+                       foz = ray.farOrigin()[2];
+  const TraversalFloat ix = ray.inverseDirection()[0],
+                       iy = ray.inverseDirection()[1],
+                       iz = ray.inverseDirection()[2];
+  const TraversalFloat max_t = TraversalRay::roundUp(max_distance);
+  constexpr TraversalFloat zero = zisc::cast<TraversalFloat>(0.0);
+
+  uint hit_mask = 0;
+  for (uint lane = 0; lane < kWidth; ++lane) {
+    const TraversalFloat tmin = zisc::max(zisc::max((near_x[lane] - nox) * ix,
+                                                    (near_y[lane] - noy) * iy),
+                                          zisc::max((near_z[lane] - noz) * iz, zero));
+    const TraversalFloat t1 = zisc::min(zisc::min((far_x[lane] - fox) * ix,
+                                                  (far_y[lane] - foy) * iy),
+                                        (far_z[lane] - foz) * iz);
+    const TraversalFloat tmax = zisc::min(TraversalRay::enlargeFarDistance(t1),
+                                          max_t);
+    (*distance_list)[lane] = tmin;
+    hit_mask = hit_mask | (zisc::cast<uint>(tmin <= tmax) << lane);
+  }
+  return hit_mask;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <uint kWidth> inline
+constexpr uint WideBvhNode<kWidth>::width() noexcept
+{
+  return kWidth;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_WIDE_BVH_NODE_INL_HPP
@@ -0,0 +1,94 @@
+/*!
+  \file wide_bvh_node.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WIDE_BVH_NODE_HPP
+#define NANAIRO_WIDE_BVH_NODE_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class TraversalRay;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The node of a BVH which has kWidth children
+  \details
+  The bounding boxes of the children are stored in SoA form,
+  so the ray-children intersection tests are performed in one loop
+  which the compiler can vectorize.
+  */
+template <uint kWidth>
+class WideBvhNode
+{
+ public:
+  using FloatArray = std::array<TraversalFloat, kWidth>;
+
+
+  //! Create an empty node
+  WideBvhNode() noexcept;
+
+
+  //! Return the bounding box of the child
+  Aabb childBoundingBox(const uint lane) const noexcept;
+
+  //! Return the index of the child node or the first object
+  uint32 childIndex(const uint lane) const noexcept;
+
+  //! Check if the lane has a child
+  bool hasChild(const uint lane) const noexcept;
+
+  //! Check if the child is a leaf
+  bool isLeafChild(const uint lane) const noexcept;
+
+  //! Return the number of children
+  uint numOfChildren() const noexcept;
+
+  //! Return the number of objects of the leaf child
+  uint numOfObjects(const uint lane) const noexcept;
+
+  //! Set a child node
+  void setChild(const uint lane,
+                const Aabb& bounding_box,
+                const uint32 child_index,
+                const uint num_of_objects) noexcept;
+
+  //! Test ray-children intersection and return the hit mask of the children
+  uint testIntersection(const TraversalRay& ray,
+                        const Float max_distance,
+                        FloatArray* distance_list) const noexcept;
+
+  //! Return the width of the node
+  static constexpr uint width() noexcept;
+
+ private:
+  static_assert((kWidth == 4) || (kWidth == 8), "The width isn't 4 or 8.");
+
+
+  std::array<FloatArray, 6> bounds_; //!< Min x, y, z and max x, y, z
+  std::array<uint32, kWidth> child_index_;
+  std::array<uint32, kWidth> num_of_objects_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "wide_bvh_node-inl.hpp"
+
+#endif // NANAIRO_WIDE_BVH_NODE_HPP
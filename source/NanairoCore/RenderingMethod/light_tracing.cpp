@@ -67,6 +67,25 @@ LightTracing::LightTracing(System& system,
   initialize(system, settings, scene);
 }
 
+/*!
+  \details
+  The sampler refers the light sources of the world,
+  so it must be made again when the world is updated.
+  */
+void LightTracing::makeLightSourceSampler(System& system,
+                                          const SettingNodeBase* settings,
+                                          const Scene& scene) noexcept
+{
+  const auto method_settings = castNode<RenderingMethodSettingNode>(settings);
+  const auto& parameters = method_settings->lightTracingParameters();
+  const auto sampler_type = parameters.light_path_light_sampler_type_;
+  light_path_light_sampler_ = LightSourceSampler::makeSampler(
+      system,
+      sampler_type,
+      scene.world(),
+      settings->workResource());
+}
+
 /*!
   \details
   No detailed.
@@ -117,12 +136,10 @@ void LightTracing::evalExplicitConnection(
   const auto diff2 = (camera.sampledLensPoint() - shadow_ray.origin()).squareNorm();
   ZISC_ASSERT(0.0 < diff2, "Diff^2 isn't greater than 0.");
   const Float max_shadow_ray_distance = zisc::sqrt(diff2);
-  const bool expect_no_hit = true;
-  const auto shadow_intersection = Method::castRay(world,
-                                                   shadow_ray,
-                                                   max_shadow_ray_distance,
-                                                   expect_no_hit);
-  if (shadow_intersection.isIntersected())
+  const bool is_occluded = Method::testOcclusion(world,
+                                                 shadow_ray,
+                                                 max_shadow_ray_distance);
+  if (is_occluded)
     return;
 
   // Get the pixel location
@@ -235,17 +252,7 @@ void LightTracing::initialize(System& system,
                               const SettingNodeBase* settings,
                               const Scene& scene) noexcept
 {
-  const auto method_settings = castNode<RenderingMethodSettingNode>(settings);
-  const auto& parameters = method_settings->lightTracingParameters();
-
-  {
-    const auto sampler_type = parameters.light_path_light_sampler_type_;
-    light_path_light_sampler_ = LightSourceSampler::makeSampler(
-        system,
-        sampler_type,
-        scene.world(),
-        settings->workResource());
-  }
+  makeLightSourceSampler(system, settings, scene);
 }
 
 /*!
@@ -58,6 +58,11 @@ class LightTracing : public RenderingMethod
                const Scene& scene) noexcept;
 
 
+  //! Make the light source sampler of the method from the world
+  void makeLightSourceSampler(System& system,
+                              const SettingNodeBase* settings,
+                              const Scene& scene) noexcept override;
+
   //! Render scene using light tracing method
   void render(System& system,
               Scene& scene,
@@ -9,6 +9,7 @@
 
 #include "path_tracing.hpp"
 // Standard C++ library
+#include <array>
 #include <atomic>
 #include <future>
 #include <thread>
@@ -33,8 +34,10 @@
 #include "NanairoCore/Data/light_source_info.hpp"
 #include "NanairoCore/Data/path_state.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
 #include "NanairoCore/Data/wavelength_samples.hpp"
 #include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/DataStructure/traversal_statistics.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
 #include "NanairoCore/Material/material.hpp"
@@ -60,11 +63,32 @@ namespace nanairo {
 PathTracing::PathTracing(System& system,
                          const SettingNodeBase* settings,
                          const Scene& scene) noexcept :
-    RenderingMethod(system, settings)
+    RenderingMethod(system, settings),
+    path_pool_list_{
+        decltype(path_pool_list_)::allocator_type{&system.dataMemoryManager()}}
 {
   initialize(system, settings, scene);
 }
 
+/*!
+  \details
+  The sampler refers the light sources of the world,
+  so it must be made again when the world is updated.
+  */
+void PathTracing::makeLightSourceSampler(System& system,
+                                         const SettingNodeBase* settings,
+                                         const Scene& scene) noexcept
+{
+  const auto method_settings = castNode<RenderingMethodSettingNode>(settings);
+  const auto& parameters = method_settings->pathTracingParameters();
+  const auto sampler_type = parameters.eye_path_light_sampler_type_;
+  eye_path_light_sampler_ = LightSourceSampler::makeSampler(
+      system,
+      sampler_type,
+      scene.world(),
+      settings->workResource());
+}
+
 /*!
   \details
   No detailed.
@@ -98,6 +122,108 @@ void PathTracing::evalExplicitConnection(
   if (!explicit_connection_is_enabled)
     return;
 
+  Ray shadow_ray;
+  Float max_shadow_ray_distance;
+  const Object* light_source = nullptr;
+  Spectra c;
+  const bool is_connected = sampleExplicitConnection(ray, bxdf, intersection,
+                                                     camera_contribution,
+                                                     ray_weight,
+                                                     implicit_connection_is_enabled,
+                                                     sampler, path_state,
+                                                     mem_resource,
+                                                     &shadow_ray,
+                                                     &max_shadow_ray_distance,
+                                                     &light_source,
+                                                     &c);
+  if (!is_connected)
+    return;
+
+  // Check the visibility of the light source
+  const bool is_occluded = Method::testOcclusion(world,
+                                                 shadow_ray,
+                                                 max_shadow_ray_distance,
+                                                 light_source);
+  if (!is_occluded)
+    *contribution += c;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void PathTracing::evalImplicitConnection(
+    const World& /* world */,
+    const Ray& ray,
+    const Float inverse_direction_pdf,
+    const IntersectionInfo& intersection,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const bool implicit_connection_is_enabled,
+    const bool explicit_connection_is_enabled,
+    zisc::pmr::memory_resource* mem_resource,
+    Spectra* contribution) const noexcept
+{
+  if (!implicit_connection_is_enabled)
+    return;
+
+  const auto object = intersection.object();
+  const auto& material = object->material();
+  if (!material.isLightSource() || intersection.isBackFace())
+    return;
+
+  const auto& wavelengths = ray_weight.wavelengths();
+  const auto vout = -ray.direction();
+
+  // Get the light
+  const auto& emitter = material.emitter();
+  const auto light = emitter.makeLight(intersection.uv(), wavelengths, mem_resource);
+
+  // Evaluate the radiance
+  const auto radiance = light->evalRadiance(nullptr,
+                                            &vout,
+                                            wavelengths,
+                                            &intersection);
+
+  // Calculate the MIS weight
+  Float mis_weight = 1.0;
+  if (explicit_connection_is_enabled) {
+    const auto& light_sampler = eyePathLightSampler();
+    const auto light_source_info = light_sampler.getInfo(intersection, object);
+    const Float inverse_point_pdf =
+        object->shape().getInversePdfFrom(ray.origin(), intersection.point());
+    const Float selection_pdf = zisc::invert(light_source_info.inverseWeight() *
+                                             inverse_point_pdf);
+    mis_weight = calcMisWeight(selection_pdf, inverse_direction_pdf);
+  }
+
+  // Calculate the contribution
+  const auto c = (camera_contribution * ray_weight * radiance) * mis_weight;
+  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
+  *contribution += c;
+}
+
+/*!
+  \details
+  A light point is sampled and the contribution through the shadow ray is
+  evaluated, but the visibility of the light point isn't checked.
+  Return false if the light point can't contribute.
+  */
+bool PathTracing::sampleExplicitConnection(
+    const Ray& ray,
+    const ShaderPointer& bxdf,
+    const IntersectionInfo& intersection,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const bool implicit_connection_is_enabled,
+    Sampler& sampler,
+    PathState& path_state,
+    zisc::pmr::memory_resource* mem_resource,
+    Ray* light_ray,
+    Float* max_shadow_ray_distance,
+    const Object** light_object,
+    Spectra* contribution) const noexcept
+{
   // Select a light source and sample a point on the light source
   const auto& light_sampler = eyePathLightSampler();
   path_state.setDimension(SampleDimension::kLightSourceSelection);
@@ -106,14 +232,16 @@ void PathTracing::evalExplicitConnection(
                                                       path_state);
   const auto light_source = light_source_info.object();
   path_state.setDimension(SampleDimension::kLightPointSample);
-  const auto light_point_info = light_source->shape().samplePoint(sampler,
-                                                                  path_state);
+  const auto light_point_info = light_source->shape().samplePointFrom(
+      intersection.point(),
+      sampler,
+      path_state);
 
   // Check if the light is in front or back of the surface
   const bool is_in_front = 0.0 < zisc::dot(intersection.normal(),
                                            light_point_info.point() - intersection.point());
   if (!(is_in_front ? bxdf->isReflective() : bxdf->isTransmissive()))
-    return;
+    return false;
 
   // Make a shadow ray
   const auto shadow_ray = Method::makeShadowRay(intersection.point(),
@@ -124,18 +252,19 @@ void PathTracing::evalExplicitConnection(
       ? zisc::dot(intersection.normal(), shadow_ray.direction())
       : -zisc::dot(intersection.normal(), shadow_ray.direction());
   if (cos_no <= 0.0)
-    return;
+    return false;
 
-  // Check the visibility of the light source
+  // Check if the light point faces the surface
+  const auto light_dir = -shadow_ray.direction();
+  const Float cos_sni = zisc::dot(light_point_info.normal(), light_dir);
+  if (cos_sni <= 0.0)
+    return false;
+
+  // The visibility of the light point is checked by the caller
   const Float diff2 = (light_point_info.point() - shadow_ray.origin()).squareNorm();
   ZISC_ASSERT(0.0 < diff2, "The diff2 isn't greater than 0.");
-  const Float max_shadow_ray_distance = Method::calcShadowRayDistance(diff2);
-  const auto shadow_intersection = Method::castRay(world,
-                                                   shadow_ray,
-                                                   max_shadow_ray_distance);
-  if (shadow_intersection.object() != light_source ||
-      shadow_intersection.isBackFace())
-    return;
+  *max_shadow_ray_distance = zisc::sqrt(diff2);
+  const IntersectionInfo light_intersection{light_source, light_point_info};
 
   // Evaluate the surface reflectance
   const auto& wavelengths = ray_weight.wavelengths();
@@ -150,17 +279,15 @@ void PathTracing::evalExplicitConnection(
 
   // Evaluate the light radiance
   const auto& emitter = light_source->material().emitter();
-  const auto light = emitter.makeLight(shadow_intersection.uv(),
+  const auto light = emitter.makeLight(light_intersection.uv(),
                                        wavelengths,
                                        mem_resource);
-  const auto light_dir = -shadow_ray.direction();
   const auto radiance = light->evalRadiance(nullptr,
                                             &light_dir,
                                             wavelengths,
-                                            &shadow_intersection);
+                                            &light_intersection);
 
   // Calculate the geometry term
-  const Float cos_sni = zisc::dot(shadow_intersection.normal(), light_dir);
   const Float geometry_term = cos_sni * cos_no / diff2;
   ZISC_ASSERT(0.0 <= geometry_term, "Geometry term is negative.");
 
@@ -175,60 +302,10 @@ void PathTracing::evalExplicitConnection(
   const auto c = (camera_contribution * ray_weight * f * radiance) *
                  (geometry_term * inverse_selection_pdf * mis_weight);
   ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
-  *contribution += c;
-}
-
-/*!
-  \details
-  No detailed.
-  */
-void PathTracing::evalImplicitConnection(
-    const World& /* world */,
-    const Ray& ray,
-    const Float inverse_direction_pdf,
-    const IntersectionInfo& intersection,
-    const Spectra& camera_contribution,
-    const Spectra& ray_weight,
-    const bool implicit_connection_is_enabled,
-    const bool explicit_connection_is_enabled,
-    zisc::pmr::memory_resource* mem_resource,
-    Spectra* contribution) const noexcept
-{
-  if (!implicit_connection_is_enabled)
-    return;
-
-  const auto object = intersection.object();
-  const auto& material = object->material();
-  if (!material.isLightSource() || intersection.isBackFace())
-    return;
-
-  const auto& wavelengths = ray_weight.wavelengths();
-  const auto vout = -ray.direction();
-
-  // Get the light
-  const auto& emitter = material.emitter();
-  const auto light = emitter.makeLight(intersection.uv(), wavelengths, mem_resource);
-
-  // Evaluate the radiance
-  const auto radiance = light->evalRadiance(nullptr,
-                                            &vout,
-                                            wavelengths,
-                                            &intersection);
-
-  // Calculate the MIS weight
-  Float mis_weight = 1.0;
-  if (explicit_connection_is_enabled) {
-    const auto& light_sampler = eyePathLightSampler();
-    const auto light_source_info = light_sampler.getInfo(intersection, object);
-    const Float selection_pdf = zisc::invert(light_source_info.inverseWeight() *
-                                             object->shape().surfaceArea());
-    mis_weight = calcMisWeight(selection_pdf, inverse_direction_pdf);
-  }
-
-  // Calculate the contribution
-  const auto c = (camera_contribution * ray_weight * radiance) * mis_weight;
-  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
-  *contribution += c;
+  *light_ray = shadow_ray;
+  *light_object = light_source;
+  *contribution = c;
+  return true;
 }
 
 /*!
@@ -277,16 +354,35 @@ void PathTracing::initialize(System& system,
   const auto method_settings = castNode<RenderingMethodSettingNode>(settings);
   const auto& parameters = method_settings->pathTracingParameters();
 
+  makeLightSourceSampler(system, settings, scene);
+
   {
-    const auto sampler_type = parameters.eye_path_light_sampler_type_;
-    eye_path_light_sampler_ = LightSourceSampler::makeSampler(
-        system,
-        sampler_type,
-        scene.world(),
-        settings->workResource());
+    wavefront_is_enabled_ = parameters.wavefront_is_enabled_ == kTrue;
+    if (wavefrontIsEnabled()) {
+      auto& threads = system.threadManager();
+      path_pool_list_.reserve(threads.numOfThreads());
+      for (uint i = 0; i < threads.numOfThreads(); ++i) {
+        path_pool_list_.emplace_back(&system.dataMemoryManager());
+        path_pool_list_.back().setCapacity(pathPoolSize());
+      }
+    }
   }
 }
 
+/*!
+  \details
+  The pool of a thread holds the paths of many tiles,
+  so the paths in a stage can be sorted for coherence.
+  */
+inline
+constexpr uint PathTracing::pathPoolSize() noexcept
+{
+  constexpr uint tile_size = CoreConfig::sizeOfRenderingTileSide() *
+                             CoreConfig::sizeOfRenderingTileSide();
+  constexpr uint pool_size = 128 * tile_size;
+  return pool_size;
+}
+
 /*!
   \details
   No detailed.
@@ -324,17 +420,19 @@ void PathTracing::traceCameraPath(System& system,
   [this, &system, &scene, &sampled_wavelengths, cycle, &tile_count]
   (const uint thread_id, const uint) noexcept
   {
-    const auto& camera = scene.camera();
-    const uint num_of_tiles =
-        RenderingMethod::calcNumOfTiles(camera.imageResolution());
-
-    for (uint index = tile_count++; index < num_of_tiles; index = tile_count++) {
-      auto tile = RenderingMethod::getRenderingTile(camera.imageResolution(), index);
-      for (uint i = 0; i < tile.numOfPixels(); ++i) {
-        const auto& pixel_index = tile.current();
-        traceCameraPath(system, scene, sampled_wavelengths,
-                        cycle, thread_id, pixel_index);
-        tile.next();
+    // Trace the paths of the tiles in a wavefront
+    if (wavefrontIsEnabled()) {
+      traceCameraPathWavefront(system, scene, sampled_wavelengths,
+                               cycle, thread_id, tile_count);
+    }
+    // Trace the paths of a tile one by one
+    else {
+      const auto& camera = scene.camera();
+      const uint num_of_tiles =
+          RenderingMethod::calcNumOfTiles(camera.imageResolution());
+      for (uint index = tile_count++; index < num_of_tiles; index = tile_count++) {
+        auto tile = RenderingMethod::getRenderingTile(camera.imageResolution(), index);
+        traceCameraPath(system, scene, sampled_wavelengths, cycle, thread_id, tile);
       }
     }
   };
@@ -349,6 +447,79 @@ void PathTracing::traceCameraPath(System& system,
   }
 }
 
+/*!
+  \details
+  The camera rays of the pixels in a tile are nearly coherent,
+  so they are cast together as a packet. Then the path of each pixel
+  is traced from the intersection of its camera ray.
+  */
+void PathTracing::traceCameraPath(System& system,
+                                  Scene& scene,
+                                  const Wavelengths& sampled_wavelengths,
+                                  const uint32 cycle,
+                                  const uint thread_id,
+                                  RenderingTile& tile) noexcept
+{
+  constexpr uint max_num_of_pixels = Bvh::maxPacketSize();
+  ZISC_ASSERT(tile.numOfPixels() <= max_num_of_pixels,
+              "The number of pixels in the tile exceeds the packet size.");
+  // System
+  auto& memory_manager = system.threadMemoryManager(thread_id);
+  // Scene
+  const auto& world = scene.world();
+  const auto& camera = scene.camera();
+
+  // Generate the camera rays of the tile
+  std::array<CameraRay, max_num_of_pixels> camera_ray_list;
+  std::array<Ray, max_num_of_pixels> ray_list;
+  const uint num_of_pixels = tile.numOfPixels();
+  tile.reset();
+  for (uint i = 0; i < num_of_pixels; ++i) {
+    const auto& pixel_index = tile.current();
+    const uint path_index = pixel_index[0] +
+                            pixel_index[1] * system.imageWidthResolution();
+    auto& sampler = system.localSampler(path_index);
+    PathState path_state{cycle};
+    path_state.setLength(1);
+    auto& camera_ray = camera_ray_list[i];
+    camera_ray.contribution_ = makeSampledSpectra(sampled_wavelengths);
+    camera_ray.ray_ = generateRay(camera, pixel_index, sampler, path_state,
+                                  &memory_manager,
+                                  &camera_ray.contribution_,
+                                  &camera_ray.inverse_direction_pdf_);
+    ray_list[i] = camera_ray.ray_;
+    tile.next();
+  }
+  memory_manager.reset();
+
+  // Cast the camera rays
+  std::array<IntersectionInfo, max_num_of_pixels> intersection_list;
+  if constexpr (TraversalStatistics::isEnabled()) {
+    // The rays are cast one by one so that the counts are kept per pixel
+    auto& statistics = scene.camera().film().traversalStatistics();
+    TraversalStatistics::resetThreadCounter();
+    tile.reset();
+    for (uint i = 0; i < num_of_pixels; ++i) {
+      intersection_list[i] = Method::castRay(world, ray_list[i]);
+      statistics.addThreadCounter(tile.current());
+      tile.next();
+    }
+  }
+  else {
+    Method::castRayPacket(world, ray_list.data(), num_of_pixels,
+                          intersection_list.data());
+  }
+
+  // Trace the camera paths
+  tile.reset();
+  for (uint i = 0; i < num_of_pixels; ++i) {
+    const auto& pixel_index = tile.current();
+    traceCameraPath(system, scene, sampled_wavelengths, cycle, thread_id,
+                    pixel_index, camera_ray_list[i], intersection_list[i]);
+    tile.next();
+  }
+}
+
 /*!
   \details
   No detailed.
@@ -358,7 +529,9 @@ void PathTracing::traceCameraPath(System& system,
                                   const Wavelengths& sampled_wavelengths,
                                   const uint32 cycle,
                                   const uint thread_id,
-                                  const Index2d& pixel_index) noexcept
+                                  const Index2d& pixel_index,
+                                  const CameraRay& camera_ray,
+                                  const IntersectionInfo& camera_intersection) noexcept
 {
   // System
   auto& memory_manager = system.threadMemoryManager(thread_id);
@@ -372,26 +545,26 @@ void PathTracing::traceCameraPath(System& system,
   PathState path_state{cycle};
   path_state.setLength(1);
   const auto& wavelengths = sampled_wavelengths.wavelengths();
-  auto camera_contribution = makeSampledSpectra(sampled_wavelengths);
+  auto camera_contribution = camera_ray.contribution_;
   Spectra contribution{wavelengths};
-  IntersectionInfo intersection;
+  IntersectionInfo intersection = camera_intersection;
   bool wavelength_is_selected = false;
 
   constexpr bool implicit_connection_is_enabled =
       CoreConfig::pathTracingImplicitConnectionIsEnabled();
   bool explicit_connection_is_enabled = false; // Explicit camera-light connection isn't performed
 
-  // Generate a camera ray
-  Float inverse_direction_pdf;
+  // The camera ray was already cast in the packet of the tile
+  Float inverse_direction_pdf = camera_ray.inverse_direction_pdf_;
   Spectra ray_weight{wavelengths, 1.0};
-  auto ray = generateRay(camera, pixel_index, sampler, path_state, &memory_manager,
-                         &camera_contribution, &inverse_direction_pdf);
+  auto ray = camera_ray.ray_;
 
   while (true) {
     // Reset memory
     memory_manager.reset();
     // Cast the ray
-    intersection = Method::castRay(world, ray);
+    if (1 < path_state.length())
+      intersection = Method::castRay(world, ray);
     if (!intersection.isIntersected())
       break;
 
@@ -435,8 +608,281 @@ void PathTracing::traceCameraPath(System& system,
     ray_weight = next_ray_weight;
   }
   camera.addContribution(pixel_index, contribution);
+  camera.film().traversalStatistics().addThreadCounter(pixel_index);
   // Reset memory
   memory_manager.reset();
 }
 
+/*!
+  \details
+  The rays are sorted by the octants of the directions before the traversal,
+  so the rays which are cast in succession visit similar nodes.
+  */
+void PathTracing::extendPaths(const World& world,
+                              PathPool& pool,
+                              TraversalStatistics& statistics) const noexcept
+{
+  auto& path_list = pool.activePathList();
+  pool.sortPathList(path_list, [&pool](const uint32 index)
+  {
+    return PathPool::calcOctant(pool.ray(index).direction());
+  });
+  for (const uint32 index : path_list) {
+    pool.intersection(index) = Method::castRay(world, pool.ray(index));
+    statistics.addThreadCounter(pool.pixelIndex(index));
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void PathTracing::generatePath(System& system,
+                               const CameraModel& camera,
+                               const Wavelengths& sampled_wavelengths,
+                               const uint32 cycle,
+                               const uint thread_id,
+                               const Index2d& pixel_index,
+                               const uint32 index,
+                               PathPool& pool) const noexcept
+{
+  auto& memory_manager = system.threadMemoryManager(thread_id);
+  const uint path_index = pixel_index[0] +
+                          pixel_index[1] * system.imageWidthResolution();
+  auto& sampler = system.localSampler(path_index);
+  const auto& wavelengths = sampled_wavelengths.wavelengths();
+
+  auto& path_state = pool.pathState(index);
+  path_state = PathState{cycle};
+  path_state.setLength(1);
+  pool.pixelIndex(index) = pixel_index;
+  pool.cameraContribution(index) = makeSampledSpectra(sampled_wavelengths);
+  pool.rayWeight(index) = Spectra{wavelengths, 1.0};
+  pool.contribution(index) = Spectra{wavelengths};
+  pool.setWavelengthIsSelected(index, false);
+  pool.setExplicitConnectionIsEnabled(index, false);
+
+  // Generate a camera ray
+  pool.ray(index) = generateRay(camera, pixel_index, sampler, path_state,
+                                &memory_manager,
+                                &pool.cameraContribution(index),
+                                &pool.inverseDirectionPdf(index));
+  memory_manager.reset();
+}
+
+/*!
+  \details
+  This is a bounce of the loop in the per pixel path tracing.
+  The shadow ray of the explicit connection is queued instead of being tested.
+  Return false if the path is terminated.
+  */
+bool PathTracing::shadePath(System& system,
+                            const World& world,
+                            const Wavelengths& sampled_wavelengths,
+                            const uint thread_id,
+                            const uint32 index,
+                            PathPool& pool) const noexcept
+{
+  // System
+  auto& memory_manager = system.threadMemoryManager(thread_id);
+  const auto& pixel_index = pool.pixelIndex(index);
+  const uint path_index = pixel_index[0] +
+                          pixel_index[1] * system.imageWidthResolution();
+  auto& sampler = system.localSampler(path_index);
+  // Trace info
+  auto& path_state = pool.pathState(index);
+  const auto& wavelengths = sampled_wavelengths.wavelengths();
+  const auto& ray = pool.ray(index);
+  const auto& intersection = pool.intersection(index);
+  auto& camera_contribution = pool.cameraContribution(index);
+  auto& ray_weight = pool.rayWeight(index);
+
+  constexpr bool implicit_connection_is_enabled =
+      CoreConfig::pathTracingImplicitConnectionIsEnabled();
+
+  evalImplicitConnection(world, ray, pool.inverseDirectionPdf(index),
+                         intersection, camera_contribution, ray_weight,
+                         implicit_connection_is_enabled,
+                         pool.explicitConnectionIsEnabled(index),
+                         &memory_manager, &pool.contribution(index));
+
+  // Get a BxDF of the surface
+  const auto& material = intersection.object()->material();
+  const auto& surface = material.surface();
+  path_state.setDimension(SampleDimension::kBxdfSample1);
+  const auto bxdf = surface.makeBxdf(intersection, wavelengths,
+                                     sampler, path_state, &memory_manager);
+  bool wavelength_is_selected = pool.wavelengthIsSelected(index);
+  Method::updateSelectedWavelengthInfo(bxdf,
+                                       &camera_contribution,
+                                       &wavelength_is_selected);
+  pool.setWavelengthIsSelected(index, wavelength_is_selected);
+
+  // Sample next ray
+  auto next_ray_weight = ray_weight;
+  const auto next_ray = Method::sampleNextRay(ray, bxdf, intersection,
+                                              &ray_weight, &next_ray_weight,
+                                              sampler, path_state,
+                                              &pool.inverseDirectionPdf(index));
+  if (!next_ray.isAlive())
+    return false;
+  path_state.incrementLength();
+
+  const bool explicit_connection_is_enabled =
+      (bxdf->type() != ShaderType::Specular) &&
+      CoreConfig::pathTracingExplicitConnectionIsEnabled();
+  pool.setExplicitConnectionIsEnabled(index, explicit_connection_is_enabled);
+
+  // Queue the shadow ray
+  if (explicit_connection_is_enabled) {
+    const bool is_connected = sampleExplicitConnection(
+        ray, bxdf, intersection, camera_contribution, ray_weight,
+        implicit_connection_is_enabled, sampler, path_state, &memory_manager,
+        &pool.shadowRay(index),
+        &pool.shadowRayDistance(index),
+        &pool.lightSource(index),
+        &pool.shadowContribution(index));
+    if (is_connected)
+      pool.shadowPathList().emplace_back(index);
+  }
+
+  // Update ray
+  pool.ray(index) = next_ray;
+  ray_weight = next_ray_weight;
+  return true;
+}
+
+/*!
+  \details
+  The paths are sorted by the surface types of the hit materials,
+  so the same BxDF code runs in succession.
+  The paths which missed or were terminated are finished here.
+  */
+void PathTracing::shadePaths(System& system,
+                             Scene& scene,
+                             const Wavelengths& sampled_wavelengths,
+                             const uint thread_id,
+                             PathPool& pool) const noexcept
+{
+  const auto& world = scene.world();
+  auto& camera = scene.camera();
+  auto& memory_manager = system.threadMemoryManager(thread_id);
+
+  auto& path_list = pool.activePathList();
+  pool.sortPathList(path_list, [&pool](const uint32 index)
+  {
+    const auto& intersection = pool.intersection(index);
+    const uint32 key = intersection.isIntersected()
+        ? zisc::cast<uint32>(intersection.object()->material().surface().type())
+        : 0;
+    return key;
+  });
+
+  uint32 num_of_active_paths = 0;
+  for (const uint32 index : path_list) {
+    const bool is_alive = pool.intersection(index).isIntersected() &&
+        shadePath(system, world, sampled_wavelengths, thread_id, index, pool);
+    memory_manager.reset();
+    // Keep the path
+    if (is_alive) {
+      path_list[num_of_active_paths++] = index;
+    }
+    // Finish the path
+    else {
+      camera.addContribution(pool.pixelIndex(index), pool.contribution(index));
+      pool.freePathList().emplace_back(index);
+    }
+  }
+  path_list.resize(num_of_active_paths);
+}
+
+/*!
+  \details
+  Each thread takes tiles and starts their paths in the free slots
+  of its pool. Then the stages are applied to all active paths:
+  extending the rays, shading the intersections and testing the shadow rays.
+  The paths of a pixel are traced by only one thread,
+  so the contributions are accumulated without locking.
+  */
+void PathTracing::traceCameraPathWavefront(System& system,
+                                           Scene& scene,
+                                           const Wavelengths& sampled_wavelengths,
+                                           const uint32 cycle,
+                                           const uint thread_id,
+                                           std::atomic<uint>& tile_count) noexcept
+{
+  const auto& world = scene.world();
+  const auto& camera = scene.camera();
+  const auto& resolution = camera.imageResolution();
+  const uint num_of_tiles = RenderingMethod::calcNumOfTiles(resolution);
+
+  auto& statistics = scene.camera().film().traversalStatistics();
+  TraversalStatistics::resetThreadCounter();
+
+  auto& pool = path_pool_list_[thread_id];
+  pool.clear();
+  auto& path_list = pool.activePathList();
+  auto& free_path_list = pool.freePathList();
+
+  auto tile = RenderingMethod::getRenderingTile(resolution, 0);
+  uint num_of_remaining_pixels = 0;
+  while (true) {
+    // Start new paths in the free slots
+    while (!free_path_list.empty()) {
+      if (num_of_remaining_pixels == 0) {
+        const uint index = tile_count++;
+        if (num_of_tiles <= index)
+          break;
+        tile = RenderingMethod::getRenderingTile(resolution, index);
+        num_of_remaining_pixels = tile.numOfPixels();
+      }
+      const uint32 index = free_path_list.back();
+      free_path_list.pop_back();
+      generatePath(system, camera, sampled_wavelengths, cycle, thread_id,
+                   tile.current(), index, pool);
+      path_list.emplace_back(index);
+      tile.next();
+      --num_of_remaining_pixels;
+    }
+    if (path_list.empty())
+      break;
+
+    extendPaths(world, pool, statistics);
+    shadePaths(system, scene, sampled_wavelengths, thread_id, pool);
+    traceShadowRays(world, pool, statistics);
+  }
+}
+
+/*!
+  \details
+  The shadow rays are sorted by the octants of the directions.
+  */
+void PathTracing::traceShadowRays(const World& world,
+                                  PathPool& pool,
+                                  TraversalStatistics& statistics) const noexcept
+{
+  auto& path_list = pool.shadowPathList();
+  pool.sortPathList(path_list, [&pool](const uint32 index)
+  {
+    return PathPool::calcOctant(pool.shadowRay(index).direction());
+  });
+  for (const uint32 index : path_list) {
+    const bool is_occluded = Method::testOcclusion(world,
+                                                   pool.shadowRay(index),
+                                                   pool.shadowRayDistance(index),
+                                                   pool.lightSource(index));
+    statistics.addThreadCounter(pool.pixelIndex(index));
+    if (!is_occluded)
+      pool.contribution(index) += pool.shadowContribution(index);
+  }
+  path_list.clear();
+}
+
+/*!
+  */
+bool PathTracing::wavefrontIsEnabled() const noexcept
+{
+  return wavefront_is_enabled_;
+}
+
 } // namespace nanairo
@@ -11,14 +11,19 @@
 #define NANAIRO_PATH_TRACING_HPP
 
 // Standard C++ library
+#include <atomic>
 #include <memory>
+#include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "rendering_method.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/DataStructure/path_pool.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
 #include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
 
 namespace nanairo {
@@ -27,12 +32,15 @@ namespace nanairo {
 class CameraModel;
 class IntersectionInfo;
 class Material;
+class Object;
 class PathState;
 class Ray;
+class RenderingTile;
 class Sampler;
 class Scene;
 class ShaderModel;
 class System;
+class TraversalStatistics;
 
 //! \addtogroup Core
 //! \{
@@ -69,6 +77,11 @@ class PathTracing : public RenderingMethod
                          Spectra* ray_weight,
                          Float* inverse_direction_pdf) noexcept;
 
+  //! Make the light source sampler of the method from the world
+  void makeLightSourceSampler(System& system,
+                              const SettingNodeBase* settings,
+                              const Scene& scene) noexcept override;
+
   //! Render scene using path tracing method
   void render(System& system,
               Scene& scene,
@@ -76,6 +89,15 @@ class PathTracing : public RenderingMethod
               const uint32 cycle) noexcept override;
 
  private:
+  //! The camera ray of a pixel which is cast in the packet of a tile
+  struct CameraRay
+  {
+    Ray ray_;
+    Spectra contribution_;
+    Float inverse_direction_pdf_;
+  };
+
+
   //! Evaluate the explicit connection
   void evalExplicitConnection(
       const World& world,
@@ -104,30 +126,107 @@ class PathTracing : public RenderingMethod
       zisc::pmr::memory_resource* mem_resource,
       Spectra* contribution) const noexcept;
 
+  //! Find the intersections of the rays of the active paths
+  void extendPaths(const World& world,
+                   PathPool& pool,
+                   TraversalStatistics& statistics) const noexcept;
+
   //! Return the light source sampler for eye path
   const LightSourceSampler& eyePathLightSampler() const noexcept;
 
+  //! Start a camera path in the pool
+  void generatePath(System& system,
+                    const CameraModel& camera,
+                    const Wavelengths& sampled_wavelengths,
+                    const uint32 cycle,
+                    const uint thread_id,
+                    const Index2d& pixel_index,
+                    const uint32 index,
+                    PathPool& pool) const noexcept;
+
   //! Initialize
   void initialize(System& system,
                   const SettingNodeBase* settings,
                   const Scene& scene) noexcept;
 
+  //! Return the number of paths in a pool of a thread
+  static constexpr uint pathPoolSize() noexcept;
+
+  //! Sample a light point and evaluate the contribution through the shadow ray
+  bool sampleExplicitConnection(
+      const Ray& ray,
+      const ShaderPointer& bxdf,
+      const IntersectionInfo& intersection,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const bool implicit_connection_is_enabled,
+      Sampler& sampler,
+      PathState& path_state,
+      zisc::pmr::memory_resource* mem_resource,
+      Ray* light_ray,
+      Float* max_shadow_ray_distance,
+      const Object** light_object,
+      Spectra* contribution) const noexcept;
+
+  //! Shade the intersection of the path and sample the next ray
+  bool shadePath(System& system,
+                 const World& world,
+                 const Wavelengths& sampled_wavelengths,
+                 const uint thread_id,
+                 const uint32 index,
+                 PathPool& pool) const noexcept;
+
+  //! Shade the intersections of the active paths and finish the dead paths
+  void shadePaths(System& system,
+                  Scene& scene,
+                  const Wavelengths& sampled_wavelengths,
+                  const uint thread_id,
+                  PathPool& pool) const noexcept;
+
   //! Parallelize path tracing
   void traceCameraPath(System& system,
                        Scene& scene,
                        const Wavelengths& sampled_wavelengths,
                        const uint32 cycle) noexcept;
 
-  //! Trace the camera path
+  //! Trace the camera paths of the pixels in the tile
   void traceCameraPath(System& system,
                        Scene& scene,
                        const Wavelengths& sampled_wavelengths,
                        const uint32 cycle,
                        const uint thread_id,
-                       const Index2d& pixel_index) noexcept;
+                       RenderingTile& tile) noexcept;
+
+  //! Trace the camera path from the intersection of the camera ray
+  void traceCameraPath(System& system,
+                       Scene& scene,
+                       const Wavelengths& sampled_wavelengths,
+                       const uint32 cycle,
+                       const uint thread_id,
+                       const Index2d& pixel_index,
+                       const CameraRay& camera_ray,
+                       const IntersectionInfo& camera_intersection) noexcept;
+
+  //! Trace the camera paths of the tiles in a wavefront
+  void traceCameraPathWavefront(System& system,
+                                Scene& scene,
+                                const Wavelengths& sampled_wavelengths,
+                                const uint32 cycle,
+                                const uint thread_id,
+                                std::atomic<uint>& tile_count) noexcept;
+
+  //! Test the shadow rays of the paths and add the unoccluded contributions
+  void traceShadowRays(const World& world,
+                       PathPool& pool,
+                       TraversalStatistics& statistics) const noexcept;
+
+  //! Check if the camera paths are traced in a wavefront
+  bool wavefrontIsEnabled() const noexcept;
 
 
   zisc::UniqueMemoryPointer<LightSourceSampler> eye_path_light_sampler_;
+  zisc::pmr::vector<PathPool> path_pool_list_;
+  bool wavefront_is_enabled_;
 };
 
 //! \} Core
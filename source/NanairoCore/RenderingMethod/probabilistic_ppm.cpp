@@ -70,6 +70,25 @@ ProbabilisticPpm::ProbabilisticPpm(System& system,
   initialize(system, settings, scene);
 }
 
+/*!
+  \details
+  The sampler refers the light sources of the world,
+  so it must be made again when the world is updated.
+  */
+void ProbabilisticPpm::makeLightSourceSampler(System& system,
+                                              const SettingNodeBase* settings,
+                                              const Scene& scene) noexcept
+{
+  const auto method_settings = castNode<RenderingMethodSettingNode>(settings);
+  const auto& parameters = method_settings->probabilisticPpmParameters();
+  const auto sampler_type = parameters.light_path_light_sampler_type_;
+  light_path_light_sampler_ = LightSourceSampler::makeSampler(
+      system,
+      sampler_type,
+      scene.world(),
+      settings->workResource());
+}
+
 /*!
   \details
   No detailed.
@@ -322,14 +341,7 @@ void ProbabilisticPpm::initialize(System& system,
     }
   }
 
-  {
-    const auto sampler_type = parameters.light_path_light_sampler_type_;
-    light_path_light_sampler_ = LightSourceSampler::makeSampler(
-            system,
-            sampler_type,
-            scene.world(),
-            settings->workResource());
-  }
+  makeLightSourceSampler(system, settings, scene);
 }
 
 /*!
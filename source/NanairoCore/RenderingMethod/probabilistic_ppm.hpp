@@ -62,6 +62,11 @@ class ProbabilisticPpm : public RenderingMethod
                    const Scene& scene) noexcept;
 
 
+  //! Make the light source sampler of the method from the world
+  void makeLightSourceSampler(System& system,
+                              const SettingNodeBase* settings,
+                              const Scene& scene) noexcept override;
+
   //! Render scene using probabilistic ppm method
   void render(System& system,
               Scene& scene,
@@ -31,6 +31,7 @@
 #include "NanairoCore/Data/ray.hpp"
 #include "NanairoCore/Data/rendering_tile.hpp"
 #include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/DataStructure/traversal_statistics.hpp"
 #include "NanairoCore/Sampling/russian_roulette.hpp"
 #include "NanairoCore/Sampling/sampled_direction.hpp"
 #include "NanairoCore/Sampling/sampled_spectra.hpp"
@@ -78,13 +79,22 @@ uint RenderingMethod::calcNumOfTiles(const Index2d& resolution) const noexcept
 }
 
 /*!
+  \details
+  The rays and the hits are counted here instead of in the BVH,
+  since the BVH of an instance is traversed as a part of the ray.
   */
 inline
-Float RenderingMethod::calcShadowRayDistance(const Float diff2) const noexcept
+IntersectionInfo RenderingMethod::castRay(const World& world,
+                                          const Ray& ray,
+                                          const Float max_distance,
+                                          const bool expect_no_hit) const noexcept
 {
-  constexpr Float extension = 1.0 + 1.0e-6;
-  static_assert(1.0 < extension, "The extension isn't greater than 1.");
-  return extension * zisc::sqrt(diff2);
+  const auto& bvh = world.bvh();
+  const auto intersection = bvh.castRay(ray, max_distance, expect_no_hit);
+  TraversalStatistics::countRay();
+  if (intersection.isIntersected())
+    TraversalStatistics::countHit();
+  return intersection;
 }
 
 /*!
@@ -92,13 +102,18 @@ Float RenderingMethod::calcShadowRayDistance(const Float diff2) const noexcept
   No detailed.
   */
 inline
-IntersectionInfo RenderingMethod::castRay(const World& world,
-                                          const Ray& ray,
-                                          const Float max_distance,
-                                          const bool expect_no_hit) const noexcept
+void RenderingMethod::castRayPacket(const World& world,
+                                    const Ray* ray_list,
+                                    const uint num_of_rays,
+                                    IntersectionInfo* intersection_list) const noexcept
 {
   const auto& bvh = world.bvh();
-  return bvh.castRay(ray, max_distance, expect_no_hit);
+  bvh.castRayPacket(ray_list, num_of_rays, intersection_list);
+  for (uint i = 0; i < num_of_rays; ++i) {
+    TraversalStatistics::countRay();
+    if (intersection_list[i].isIntersected())
+      TraversalStatistics::countHit();
+  }
 }
 
 /*!
@@ -207,6 +222,24 @@ Ray RenderingMethod::sampleNextRay(const Ray& ray,
   return next_ray;
 }
 
+/*!
+  \details
+  No detailed.
+  */
+inline
+bool RenderingMethod::testOcclusion(const World& world,
+                                    const Ray& ray,
+                                    const Float max_distance,
+                                    const Object* ignore_object) const noexcept
+{
+  const auto& bvh = world.bvh();
+  const bool is_occluded = bvh.testOcclusion(ray, max_distance, ignore_object);
+  TraversalStatistics::countRay();
+  if (is_occluded)
+    TraversalStatistics::countHit();
+  return is_occluded;
+}
+
 /*!
   \details
   No detailed.
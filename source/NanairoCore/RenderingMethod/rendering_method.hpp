@@ -30,6 +30,7 @@ namespace nanairo {
 
 // Forward declaration
 class IntersectionInfo;
+class Object;
 class PathState;
 class SampledSpectra;
 class Sampler;
@@ -84,6 +85,11 @@ class RenderingMethod
       const SettingNodeBase* settings,
       const Scene& scene) noexcept;
 
+  //! Make the light source samplers of the method from the world
+  virtual void makeLightSourceSampler(System& system,
+                                      const SettingNodeBase* settings,
+                                      const Scene& scene) noexcept = 0;
+
   //! Return the ray cast epsilon
   Float rayCastEpsilon() const noexcept;
 
@@ -100,9 +106,6 @@ class RenderingMethod
   //! Calculate the number of pixel blocks
   uint calcPixelBlockSize(const uint width, const uint height) const noexcept;
 
-  //! Calculate the max distance of the shadow ray
-  Float calcShadowRayDistance(const Float diff2) const noexcept;
-
   //! Find and return the closest intersection of the ray
   IntersectionInfo castRay(
       const World& world,
@@ -110,6 +113,12 @@ class RenderingMethod
       const Float max_distance = std::numeric_limits<Float>::max(),
       const bool expect_no_hit = false) const noexcept;
 
+  //! Find the closest intersections of the coherent rays together
+  void castRayPacket(const World& world,
+                     const Ray* ray_list,
+                     const uint num_of_rays,
+                     IntersectionInfo* intersection_list) const noexcept;
+
   //! Get the rendering tile
   RenderingTile getRenderingTile(const Index2d& resolution,
                                  const uint index) const noexcept;
@@ -135,6 +144,12 @@ class RenderingMethod
                     PathState& path_state,
                     Float* inverse_direction_pdf = nullptr) const noexcept;
 
+  //! Test if the ray is occluded by any object before the max distance
+  bool testOcclusion(const World& world,
+                     const Ray& ray,
+                     const Float max_distance,
+                     const Object* ignore_object = nullptr) const noexcept;
+
   //! Update the wavelength selection info and the weight of the selected wavelength
   void updateSelectedWavelengthInfo(const ShaderPointer& bxdf,
                                     Spectra* weight,
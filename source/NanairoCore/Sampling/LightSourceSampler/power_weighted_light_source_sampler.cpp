@@ -9,7 +9,6 @@
 
 #include "power_weighted_light_source_sampler.hpp"
 // Standard C++ library
-#include <algorithm>
 #include <utility>
 #include <vector>
 // Zisc
@@ -87,18 +86,11 @@ LightSourceInfo PowerWeightedLightSourceSampler::getInfo(
   ZISC_ASSERT(light_source != nullptr, "The light source is null.");
   ZISC_ASSERT(light_source->material().isLightSource(),
               "The object isn't light source.");
-  const auto comp = [](const LightSourceInfo& lhs, const Object* rhs)
-  {
-    return lhs.object() < rhs;
-  };
   const auto& info_list = infoList();
-  auto info = std::lower_bound(info_list.begin(),
-                               info_list.end(),
-                               light_source,
-                               comp);
-  ZISC_ASSERT((info != info_list.end()) && (info->object() == light_source),
+  const uint32 index = light_source->lightSourceIndex();
+  ZISC_ASSERT((index < info_list.size()) && (info_list[index].object() == light_source),
               "The light source isn't in the light source list.");
-  return *info;
+  return info_list[index];
 }
 
 /*!
@@ -119,19 +111,15 @@ void PowerWeightedLightSourceSampler::initialize(
                         light_source->material().emitter().radiantExitance();
       total_flux.add(flux);
     }
-    // Initialize info list
+    // Initialize info list in the order of the light source indices
     info_list_.reserve(light_source_list.size());
     for (const auto light_source : light_source_list) {
+      ZISC_ASSERT(light_source->lightSourceIndex() == info_list_.size(),
+                  "The light source index is wrong.");
       const auto flux = light_source->shape().surfaceArea() *
                         light_source->material().emitter().radiantExitance();
       info_list_.emplace_back(light_source, flux / total_flux.get());
     }
-    // Sort the info list
-    const auto comp = [](const LightSourceInfo& lhs, const LightSourceInfo& rhs)
-    {
-      return lhs.object() < rhs.object();
-    };
-    std::sort(info_list_.begin(), info_list_.end(), comp);
   }
   {
     auto data_resource = &system.dataMemoryManager();
@@ -12,6 +12,7 @@
 #include <istream>
 #include <memory>
 #include <ostream>
+#include <string_view>
 // Zisc
 #include "zisc/binary_data.hpp"
 #include "zisc/error.hpp"
@@ -41,10 +42,55 @@ void AgglomerativeTreeletRestructuringParameters::writeData(
   zisc::write(&optimization_loop_, data_stream);
 }
 
+/*!
+  */
+void BinnedSahParameters::readData(std::istream* data_stream) noexcept
+{
+  zisc::read(&num_of_bins_, data_stream);
+}
+
+/*!
+  */
+void BinnedSahParameters::writeData(std::ostream* data_stream) const noexcept
+{
+  zisc::write(&num_of_bins_, data_stream);
+}
+
+/*!
+  */
+void PlocParameters::readData(std::istream* data_stream) noexcept
+{
+  zisc::read(&search_radius_, data_stream);
+}
+
+/*!
+  */
+void PlocParameters::writeData(std::ostream* data_stream) const noexcept
+{
+  zisc::write(&search_radius_, data_stream);
+}
+
+/*!
+  */
+void SpatialSplitParameters::readData(std::istream* data_stream) noexcept
+{
+  zisc::read(&num_of_bins_, data_stream);
+  zisc::read(&duplication_limit_, data_stream);
+}
+
+/*!
+  */
+void SpatialSplitParameters::writeData(std::ostream* data_stream) const noexcept
+{
+  zisc::write(&num_of_bins_, data_stream);
+  zisc::write(&duplication_limit_, data_stream);
+}
+
 /*!
   */
 BvhSettingNode::BvhSettingNode(const SettingNodeBase* parent) noexcept :
-    SettingNodeBase(parent)
+    SettingNodeBase(parent),
+    cache_directory_{dataResource()}
 {
 }
 
@@ -72,6 +118,24 @@ BvhSettingNode::agglomerativeTreeletRestructuringParameters() const noexcept
   return *parameter;
 }
 
+/*!
+  */
+BinnedSahParameters& BvhSettingNode::binnedSahParameters() noexcept
+{
+  ZISC_ASSERT(bvhType() == BvhType::kBinnedSah, "Invalid BVH type is specified.");
+  auto parameter = zisc::cast<BinnedSahParameters*>(parameters_.get());
+  return *parameter;
+}
+
+/*!
+  */
+const BinnedSahParameters& BvhSettingNode::binnedSahParameters() const noexcept
+{
+  ZISC_ASSERT(bvhType() == BvhType::kBinnedSah, "Invalid BVH type is specified.");
+  auto parameter = zisc::cast<const BinnedSahParameters*>(parameters_.get());
+  return *parameter;
+}
+
 /*!
   */
 BvhType BvhSettingNode::bvhType() const noexcept
@@ -79,11 +143,31 @@ BvhType BvhSettingNode::bvhType() const noexcept
   return bvh_type_;
 }
 
+/*!
+  \details
+  An empty directory means that the BVH cache is disabled.
+  */
+std::string_view BvhSettingNode::cacheDirectory() const noexcept
+{
+  return std::string_view{cache_directory_};
+}
+
 /*!
   */
 void BvhSettingNode::initialize() noexcept
 {
   setBvhType(BvhType::kBinaryRadixTree);
+  setTraversalType(BvhTraversalType::kOrdered);
+  setNodeFormat(BvhNodeFormat::kFull);
+  setMaxLeafSize(8);
+  setNodeWidth(2);
+}
+
+/*!
+  */
+uint32 BvhSettingNode::maxLeafSize() const noexcept
+{
+  return max_leaf_size_;
 }
 
 /*!
@@ -93,6 +177,40 @@ SettingNodeType BvhSettingNode::nodeType() noexcept
   return SettingNodeType::kBvh;
 }
 
+/*!
+  */
+BvhNodeFormat BvhSettingNode::nodeFormat() const noexcept
+{
+  return node_format_;
+}
+
+/*!
+  \details
+  The binary tree is collapsed into a wide tree if the width is 4 or 8.
+  */
+uint32 BvhSettingNode::nodeWidth() const noexcept
+{
+  return node_width_;
+}
+
+/*!
+  */
+PlocParameters& BvhSettingNode::plocParameters() noexcept
+{
+  ZISC_ASSERT(bvhType() == BvhType::kPloc, "Invalid BVH type is specified.");
+  auto parameter = zisc::cast<PlocParameters*>(parameters_.get());
+  return *parameter;
+}
+
+/*!
+  */
+const PlocParameters& BvhSettingNode::plocParameters() const noexcept
+{
+  ZISC_ASSERT(bvhType() == BvhType::kPloc, "Invalid BVH type is specified.");
+  auto parameter = zisc::cast<const PlocParameters*>(parameters_.get());
+  return *parameter;
+}
+
 /*!
   */
 void BvhSettingNode::readData(std::istream* data_stream) noexcept
@@ -101,6 +219,18 @@ void BvhSettingNode::readData(std::istream* data_stream) noexcept
     zisc::read(&bvh_type_, data_stream);
     setBvhType(bvh_type_);
   }
+  {
+    zisc::read(&traversal_type_, data_stream);
+  }
+  {
+    zisc::read(&node_format_, data_stream);
+  }
+  {
+    zisc::read(&max_leaf_size_, data_stream);
+  }
+  {
+    zisc::read(&node_width_, data_stream);
+  }
   if (parameters_)
     parameters_->readData(data_stream);
 }
@@ -118,12 +248,93 @@ void BvhSettingNode::setBvhType(const BvhType type) noexcept
         zisc::UniqueMemoryPointer<AgglomerativeTreeletRestructuringParameters>::make(dataResource());
     break;
    }
+   case BvhType::kBinnedSah: {
+    parameters_ =
+        zisc::UniqueMemoryPointer<BinnedSahParameters>::make(dataResource());
+    break;
+   }
+   case BvhType::kPloc: {
+    parameters_ =
+        zisc::UniqueMemoryPointer<PlocParameters>::make(dataResource());
+    break;
+   }
+   case BvhType::kSpatialSplit: {
+    parameters_ =
+        zisc::UniqueMemoryPointer<SpatialSplitParameters>::make(dataResource());
+    break;
+   }
    case BvhType::kBinaryRadixTree:
    default:
     break;
   }
 }
 
+/*!
+  \details
+  The cache directory depends on the machine which renders the scene,
+  so it isn't written to the scene binary.
+  */
+void BvhSettingNode::setCacheDirectory(
+    const std::string_view& cache_directory) noexcept
+{
+  cache_directory_ = cache_directory;
+}
+
+/*!
+  */
+void BvhSettingNode::setMaxLeafSize(const uint32 max_leaf_size) noexcept
+{
+  max_leaf_size_ = max_leaf_size;
+}
+
+/*!
+  */
+void BvhSettingNode::setNodeFormat(const BvhNodeFormat format) noexcept
+{
+  node_format_ = format;
+}
+
+/*!
+  */
+void BvhSettingNode::setNodeWidth(const uint32 node_width) noexcept
+{
+  ZISC_ASSERT((node_width == 2) || (node_width == 4) || (node_width == 8),
+              "The node width isn't 2, 4 or 8.");
+  node_width_ = node_width;
+}
+
+/*!
+  */
+void BvhSettingNode::setTraversalType(const BvhTraversalType type) noexcept
+{
+  traversal_type_ = type;
+}
+
+/*!
+  */
+SpatialSplitParameters& BvhSettingNode::spatialSplitParameters() noexcept
+{
+  ZISC_ASSERT(bvhType() == BvhType::kSpatialSplit, "Invalid BVH type is specified.");
+  auto parameter = zisc::cast<SpatialSplitParameters*>(parameters_.get());
+  return *parameter;
+}
+
+/*!
+  */
+const SpatialSplitParameters& BvhSettingNode::spatialSplitParameters() const noexcept
+{
+  ZISC_ASSERT(bvhType() == BvhType::kSpatialSplit, "Invalid BVH type is specified.");
+  auto parameter = zisc::cast<const SpatialSplitParameters*>(parameters_.get());
+  return *parameter;
+}
+
+/*!
+  */
+BvhTraversalType BvhSettingNode::traversalType() const noexcept
+{
+  return traversal_type_;
+}
+
 /*!
   */
 SettingNodeType BvhSettingNode::type() const noexcept
@@ -138,6 +349,10 @@ void BvhSettingNode::writeData(std::ostream* data_stream) const noexcept
   writeType(data_stream);
   // Write properties
   zisc::write(&bvh_type_, data_stream);
+  zisc::write(&traversal_type_, data_stream);
+  zisc::write(&node_format_, data_stream);
+  zisc::write(&max_leaf_size_, data_stream);
+  zisc::write(&node_width_, data_stream);
   if (parameters_)
     parameters_->writeData(data_stream);
 }
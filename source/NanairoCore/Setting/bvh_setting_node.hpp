@@ -14,6 +14,7 @@
 #include <istream>
 #include <memory>
 #include <ostream>
+#include <string_view>
 // Zisc
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
@@ -41,6 +42,43 @@ struct AgglomerativeTreeletRestructuringParameters : public NodeParameterBase
   uint32 optimization_loop_ = 2;
 };
 
+//! Binned SAH BVH parameters
+struct BinnedSahParameters : public NodeParameterBase
+{
+  //! Read the parameters from the setting
+  void readData(std::istream* data_stream) noexcept override;
+
+  //! Write the parameters to the setting
+  void writeData(std::ostream* data_stream) const noexcept override;
+
+  uint32 num_of_bins_ = 16;
+};
+
+//! PLOC BVH parameters
+struct PlocParameters : public NodeParameterBase
+{
+  //! Read the parameters from the setting
+  void readData(std::istream* data_stream) noexcept override;
+
+  //! Write the parameters to the setting
+  void writeData(std::ostream* data_stream) const noexcept override;
+
+  uint32 search_radius_ = 16;
+};
+
+//! Spatial split BVH parameters
+struct SpatialSplitParameters : public NodeParameterBase
+{
+  //! Read the parameters from the setting
+  void readData(std::istream* data_stream) noexcept override;
+
+  //! Write the parameters to the setting
+  void writeData(std::ostream* data_stream) const noexcept override;
+
+  uint32 num_of_bins_ = 16;
+  uint32 duplication_limit_ = 30; //!< The max additional references in percent
+};
+
 /*!
   */
 class BvhSettingNode : public SettingNodeBase
@@ -58,21 +96,69 @@ class BvhSettingNode : public SettingNodeBase
   const AgglomerativeTreeletRestructuringParameters&
   agglomerativeTreeletRestructuringParameters() const noexcept;
 
+  //! Return the binned SAH BVH parameters
+  BinnedSahParameters& binnedSahParameters() noexcept;
+
+  //! Return the binned SAH BVH parameters
+  const BinnedSahParameters& binnedSahParameters() const noexcept;
+
   //! Return the bvh type
   BvhType bvhType() const noexcept;
 
+  //! Return the directory in which built BVHs are cached
+  std::string_view cacheDirectory() const noexcept;
+
   //! Initialize a bvh setting
   void initialize() noexcept override;
 
+  //! Return the max number of objects in a leaf
+  uint32 maxLeafSize() const noexcept;
+
   //! Return the node type
   static SettingNodeType nodeType() noexcept;
 
+  //! Return the node format
+  BvhNodeFormat nodeFormat() const noexcept;
+
+  //! Return the number of children of a node in ray traversal
+  uint32 nodeWidth() const noexcept;
+
+  //! Return the PLOC BVH parameters
+  PlocParameters& plocParameters() noexcept;
+
+  //! Return the PLOC BVH parameters
+  const PlocParameters& plocParameters() const noexcept;
+
   //! Read the bvh setting data from the stream
   void readData(std::istream* data_stream) noexcept override;
 
   //! Set the bvh type
   void setBvhType(const BvhType type) noexcept;
 
+  //! Set the directory in which built BVHs are cached
+  void setCacheDirectory(const std::string_view& cache_directory) noexcept;
+
+  //! Set the max number of objects in a leaf
+  void setMaxLeafSize(const uint32 max_leaf_size) noexcept;
+
+  //! Set the node format
+  void setNodeFormat(const BvhNodeFormat format) noexcept;
+
+  //! Set the number of children of a node in ray traversal
+  void setNodeWidth(const uint32 node_width) noexcept;
+
+  //! Set the traversal type
+  void setTraversalType(const BvhTraversalType type) noexcept;
+
+  //! Return the spatial split BVH parameters
+  SpatialSplitParameters& spatialSplitParameters() noexcept;
+
+  //! Return the spatial split BVH parameters
+  const SpatialSplitParameters& spatialSplitParameters() const noexcept;
+
+  //! Return the traversal type
+  BvhTraversalType traversalType() const noexcept;
+
   //! Return the node type
   SettingNodeType type() const noexcept override;
 
@@ -81,7 +167,12 @@ class BvhSettingNode : public SettingNodeBase
 
  private:
   zisc::UniqueMemoryPointer<NodeParameterBase> parameters_;
+  zisc::pmr::string cache_directory_;
   BvhType bvh_type_;
+  BvhTraversalType traversal_type_;
+  BvhNodeFormat node_format_;
+  uint32 max_leaf_size_;
+  uint32 node_width_;
 };
 
 //! \} Core
@@ -32,6 +32,7 @@ namespace nanairo {
 void PathTracingParameters::readData(std::istream* data_stream) noexcept
 {
   zisc::read(&eye_path_light_sampler_type_, data_stream);
+  zisc::read(&wavefront_is_enabled_, data_stream);
 }
 
 /*!
@@ -39,6 +40,7 @@ void PathTracingParameters::readData(std::istream* data_stream) noexcept
 void PathTracingParameters::writeData(std::ostream* data_stream) const noexcept
 {
   zisc::write(&eye_path_light_sampler_type_, data_stream);
+  zisc::write(&wavefront_is_enabled_, data_stream);
 }
 
 /*!
@@ -40,6 +40,7 @@ struct PathTracingParameters : public NodeParameterBase
 
   LightSourceSamplerType eye_path_light_sampler_type_ =
       LightSourceSamplerType::kPowerWeighted;
+  uint8 wavefront_is_enabled_ = kFalse; //!< Only path tracing has the wavefront mode
 };
 
 // LightTracing parameters
@@ -25,6 +25,7 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/face.hpp"
 #include "NanairoCore/Shape/shape.hpp"
+#include "NanairoCore/Shape/triangle_mesh.hpp"
 
 namespace nanairo {
 
@@ -43,6 +44,7 @@ MeshParameters::MeshParameters(zisc::pmr::memory_resource* data_resource) noexce
 void MeshParameters::readData(std::istream* data_stream) noexcept
 {
   zisc::read(&smoothing_, data_stream);
+  zisc::read(&compression_, data_stream);
   // Read mesh information
   // Face
   {
@@ -94,6 +96,7 @@ void MeshParameters::readData(std::istream* data_stream) noexcept
 void MeshParameters::writeData(std::ostream* data_stream) const noexcept
 {
   zisc::write(&smoothing_, data_stream);
+  zisc::write(&compression_, data_stream);
   // Face
   {
     constexpr uint face_size = sizeof(face_list_[0]);
@@ -232,6 +235,8 @@ void SingleObjectSettingNode::setShapeType(const ShapeType type) noexcept
     break;
    }
    case ShapeType::kPlane:
+   case ShapeType::kSphere:
+   case ShapeType::kDisk:
    default:
     break;
   }
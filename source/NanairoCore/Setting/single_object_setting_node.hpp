@@ -25,6 +25,7 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/face.hpp"
 #include "NanairoCore/Shape/shape.hpp"
+#include "NanairoCore/Shape/triangle_mesh.hpp"
 
 namespace nanairo {
 
@@ -48,6 +49,7 @@ struct MeshParameters : public NodeParameterBase
   zisc::pmr::vector<std::array<double, 3>> vertex_list_;
   zisc::pmr::vector<std::array<double, 3>> vnormal_list_;
   zisc::pmr::vector<std::array<double, 2>> vuv_list_;
+  MeshCompression compression_ = MeshCompression::kNone;
   uint8 smoothing_ = kFalse;
 };
 
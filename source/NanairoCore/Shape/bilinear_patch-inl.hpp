@@ -0,0 +1,140 @@
+/*!
+  \file bilinear_patch-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_BILINEAR_PATCH_INL_HPP
+#define NANAIRO_BILINEAR_PATCH_INL_HPP
+
+#include "bilinear_patch.hpp"
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "triangle_mesh.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+const TriangleMesh& BilinearPatch::mesh() const noexcept
+{
+  return *mesh_;
+}
+
+/*!
+  \details
+  The normal of a planar quad is same at any point.
+  */
+inline
+Vector3 BilinearPatch::normal(const Point2& st) const noexcept
+{
+  const auto n = calcJacobian(vertex(0), vertex(1), vertex(2), vertex(3), st);
+  const auto normal = n.normalized();
+  ZISC_ASSERT(isUnitVector(normal), "The normal isn't unit vector.");
+  return normal;
+}
+
+/*!
+  */
+inline
+uint32 BilinearPatch::quadIndex() const noexcept
+{
+  return quad_index_;
+}
+
+/*!
+  */
+inline
+Point3 BilinearPatch::vertex(const uint corner) const noexcept
+{
+  ZISC_ASSERT(corner < 4, "The corner index is out of range.");
+  const auto& q = mesh().quad(quadIndex());
+  return mesh().vertex(q[corner]);
+}
+
+/*!
+  \details
+  The jacobian is bilinear in the st coordinate.
+  */
+inline
+Vector3 BilinearPatch::calcJacobian(const Point3& p0,
+                                    const Point3& p1,
+                                    const Point3& p2,
+                                    const Point3& p3,
+                                    const Point2& st) noexcept
+{
+  const auto dpds = (1.0 - st[1]) * (p1 - p0) + st[1] * (p2 - p3);
+  const auto dpdt = (1.0 - st[0]) * (p3 - p0) + st[0] * (p2 - p1);
+  return zisc::cross(dpds, dpdt);
+}
+
+/*!
+  \details
+  The interpolated normal is oriented to the side of the patch normal.
+  The patch normal is used if the face doesn't have vertex normals.
+  */
+inline
+Vector3 BilinearPatch::calcShadingNormal(const Point2& st,
+                                         const Vector3& normal) const noexcept
+{
+  if (!mesh().hasNormal())
+    return normal;
+  const auto& q = mesh().quad(quadIndex());
+  const auto n = (1.0 - st[1]) * ((1.0 - st[0]) * mesh().normal(q[0]) +
+                                  st[0] * mesh().normal(q[1])) +
+                 st[1] * ((1.0 - st[0]) * mesh().normal(q[3]) +
+                          st[0] * mesh().normal(q[2]));
+  const Float cos_theta = zisc::dot(n, normal);
+  if (!(0.0 < n.squareNorm()) || (cos_theta == 0.0))
+    return normal;
+  const auto shading_normal = n.normalized();
+  return (0.0 < cos_theta) ? shading_normal : -shading_normal;
+}
+
+/*!
+  */
+inline
+Point2 BilinearPatch::calcUv(const Point2& st) const noexcept
+{
+  if (!mesh().hasUv())
+    return Point2{0.0, 0.0};
+  const auto& q = mesh().quad(quadIndex());
+  const auto& uv0 = mesh().uv(q[0]);
+  const auto& uv1 = mesh().uv(q[1]);
+  const auto& uv2 = mesh().uv(q[2]);
+  const auto& uv3 = mesh().uv(q[3]);
+  Point2 uv = uv0 + st[0] * (uv1 - uv0) + st[1] * (uv3 - uv0) +
+              (st[0] * st[1]) * ((uv2 - uv3) - (uv1 - uv0));
+  for (uint i = 0; i < uv.size(); ++i) {
+    while (!zisc::isInClosedBounds(uv[i], 0.0, 1.0))
+      uv[i] = (uv[i] < 0.0) ? (uv[i] + 1.0) : (uv[i] - 1.0);
+  }
+  return uv;
+}
+
+/*!
+  */
+inline
+Point3 BilinearPatch::getPosition(const Point2& st) const noexcept
+{
+  const auto& p0 = vertex(0);
+  const auto& p1 = vertex(1);
+  const auto& p2 = vertex(2);
+  const auto& p3 = vertex(3);
+  return p0 + st[0] * (p1 - p0) + st[1] * (p3 - p0) +
+         (st[0] * st[1]) * ((p2 - p3) - (p1 - p0));
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_BILINEAR_PATCH_INL_HPP
@@ -0,0 +1,401 @@
+/*!
+  \file bilinear_patch.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "bilinear_patch.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <utility>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "shape.hpp"
+#include "triangle_mesh.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Sampling/sampled_point.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+
+namespace nanairo  {
+
+/*!
+  \details
+  No detailed.
+  */
+BilinearPatch::BilinearPatch(const TriangleMesh* mesh,
+                             const uint32 quad_index) noexcept :
+    mesh_{mesh},
+    quad_index_{quad_index}
+{
+  ZISC_ASSERT(mesh_ != nullptr, "The mesh is null.");
+  ZISC_ASSERT(quad_index_ < mesh_->numOfQuads(), "The quad index is out of range.");
+  setSurfaceArea(calcSurfaceArea());
+}
+
+/*!
+  \details
+  The patch lies in the convex hull of the corners.
+
+  \return AABB
+  */
+Aabb BilinearPatch::boundingBox() const noexcept
+{
+  auto min_point = vertex(0).data();
+  auto max_point = vertex(0).data();
+  for (uint corner = 1; corner < 4; ++corner) {
+    const auto& point = vertex(corner);
+    min_point = zisc::minElements(min_point, point.data());
+    max_point = zisc::maxElements(max_point, point.data());
+  }
+  return Aabb{Point3{min_point}, Point3{max_point}};
+}
+
+/*!
+  \details
+  The area is integrated by 3 x 3 point Gauss-Legendre quadrature,
+  which is exact for planar quads since the norm of the jacobian is bilinear.
+  */
+Float BilinearPatch::calcSurfaceArea(const Point3& p0,
+                                     const Point3& p1,
+                                     const Point3& p2,
+                                     const Point3& p3) noexcept
+{
+  const Float d = 0.5 * zisc::sqrt(0.6);
+  const std::array<Float, 3> x_list{{0.5 - d, 0.5, 0.5 + d}};
+  const std::array<Float, 3> w_list{{5.0 / 18.0, 8.0 / 18.0, 5.0 / 18.0}};
+  Float area = 0.0;
+  for (uint i = 0; i < 3; ++i) {
+    for (uint j = 0; j < 3; ++j) {
+      const Point2 st{x_list[i], x_list[j]};
+      const auto jacobian = calcJacobian(p0, p1, p2, p3, st);
+      Float n = jacobian.squareNorm();
+      if (0.0 < n)
+        n = zisc::sqrt(n);
+      area += (w_list[i] * w_list[j]) * n;
+    }
+  }
+  return area;
+}
+
+/*!
+  \details
+  The hit attributes are computed only once for the closest intersection.
+  */
+void BilinearPatch::finalizeIntersection(
+    const Ray& ray,
+    IntersectionInfo* intersection) const noexcept
+{
+  const auto& st = intersection->st();
+  const auto normal = this->normal(st);
+  const Float cos_theta = -zisc::dot(normal, ray.direction());
+  const bool is_back_face = cos_theta < 0.0;
+
+  const auto point = ray.origin() + intersection->rayDistance() * ray.direction();
+  const auto shading_normal = calcShadingNormal(st, normal);
+  const auto n = (!is_back_face) ? shading_normal : -shading_normal;
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  intersection->setPoint(point);
+  intersection->setNormal(n);
+  intersection->setTangent(tangent);
+  intersection->setBitangent(bitangent);
+  intersection->setAsBackFace(is_back_face);
+  intersection->setUv(calcUv(st));
+}
+
+/*!
+  */
+ShapePoint BilinearPatch::getPoint(const Point2& st) const noexcept
+{
+  const auto point = getPosition(st);
+  const auto uv = calcUv(st);
+
+  const auto normal = calcShadingNormal(st, this->normal(st));
+  const auto tangents = Transformation::calcDefaultTangent(normal);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  return ShapePoint{SampledPoint{point, surfaceArea()},
+                    normal,
+                    tangent,
+                    bitangent,
+                    uv,
+                    st};
+}
+
+/*!
+  \details
+  A patch replaces two triangles and the test costs less than two triangle tests.
+  */
+Float BilinearPatch::getTraversalCost() const noexcept
+{
+  return 1.5;
+}
+
+/*!
+  \details
+  The patch is planar if the normals at the corners are parallel.
+  */
+bool BilinearPatch::isPlanar(const Point3& p0,
+                             const Point3& p1,
+                             const Point3& p2,
+                             const Point3& p3) noexcept
+{
+  constexpr Float threshold = 1.0 - 1.0e-6;
+  const auto n = calcJacobian(p0, p1, p2, p3, Point2{0.5, 0.5});
+  const std::array<Point2, 4> st_list{{Point2{0.0, 0.0},
+                                       Point2{1.0, 0.0},
+                                       Point2{1.0, 1.0},
+                                       Point2{0.0, 1.0}}};
+  bool is_planar = isRegular(p0, p1, p2, p3);
+  for (uint corner = 0; is_planar && (corner < 4); ++corner) {
+    const auto jacobian = calcJacobian(p0, p1, p2, p3, st_list[corner]);
+    const Float cos_theta = zisc::dot(jacobian, n);
+    is_planar = (threshold * threshold) * jacobian.squareNorm() * n.squareNorm() <=
+                cos_theta * cos_theta;
+  }
+  return is_planar;
+}
+
+/*!
+  \details
+  The jacobian is bilinear, so the patch doesn't fold if the normals at
+  the corners face the same side. Concave and degenerate quads fold.
+  */
+bool BilinearPatch::isRegular(const Point3& p0,
+                              const Point3& p1,
+                              const Point3& p2,
+                              const Point3& p3) noexcept
+{
+  const auto n = calcJacobian(p0, p1, p2, p3, Point2{0.5, 0.5});
+  const std::array<Point2, 4> st_list{{Point2{0.0, 0.0},
+                                       Point2{1.0, 0.0},
+                                       Point2{1.0, 1.0},
+                                       Point2{0.0, 1.0}}};
+  bool is_regular = true;
+  for (uint corner = 0; is_regular && (corner < 4); ++corner) {
+    const auto jacobian = calcJacobian(p0, p1, p2, p3, st_list[corner]);
+    is_regular = 0.0 < zisc::dot(jacobian, n);
+  }
+  return is_regular;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+IntersectionTestResult BilinearPatch::testIntersection(
+    const Ray& ray,
+    IntersectionInfo* intersection) const noexcept
+{
+  Float t = 0.0;
+  Point2 st;
+  const bool is_hit = testIntersection(ray, intersection->rayDistance(), &t, &st);
+  if (is_hit) {
+    intersection->setRayDistance(t);
+    intersection->setSt(st);
+  }
+  return (is_hit)
+      ? IntersectionTestResult{t}
+      : IntersectionTestResult{};
+}
+
+/*!
+  \details
+  Please see "Cool Patches: A Geometric Approach to Ray/Bilinear Patch
+  Intersections". The distance and the st coordinate are written only if
+  the ray hits.
+  */
+bool BilinearPatch::testIntersection(const Ray& ray,
+                                     const Float max_distance,
+                                     Float* t,
+                                     Point2* st) const noexcept
+{
+  const auto& d = ray.direction();
+  const auto q00 = vertex(0) - ray.origin();
+  const auto q10 = vertex(1) - ray.origin();
+  const auto q11 = vertex(2) - ray.origin();
+  const auto q01 = vertex(3) - ray.origin();
+  const auto e10 = q10 - q00;
+  const auto e11 = q11 - q10;
+  const auto e00 = q01 - q00;
+
+  // Solve the quadratic equation of s, a + b * s + c * s^2 = 0
+  const auto qn = zisc::cross(e10, q01 - q11);
+  const Float a = zisc::dot(zisc::cross(q00, d), e00);
+  const Float c = zisc::dot(qn, d);
+  const Float b = zisc::dot(zisc::cross(q10, d), e11) - (a + c);
+  Float discriminant = b * b - 4.0 * a * c;
+  if ((discriminant < 0.0) || ((c == 0.0) && (b == 0.0)))
+    return false;
+  discriminant = zisc::sqrt(discriminant);
+  std::array<Float, 2> s_list;
+  if (c == 0.0) {
+    s_list = {{-a / b, -1.0}};
+  }
+  else {
+    const Float q = -0.5 * (b + std::copysign(discriminant, b));
+    s_list = {{q / c, (q != 0.0) ? a / q : -1.0}};
+  }
+
+  bool is_hit = false;
+  Float distance = max_distance;
+  for (const Float s : s_list) {
+    if (!zisc::isInClosedBounds(s, 0.0, 1.0))
+      continue;
+    // The line between the edges p0-p3 and p1-p2 at s
+    const auto pa = q00 + s * e10;
+    const auto pb = e00 + s * (e11 - e00);
+    auto n = zisc::cross(d, pb);
+    const Float determinant = zisc::dot(n, n);
+    n = zisc::cross(n, pa);
+    const Float t1 = zisc::dot(n, pb);
+    const Float t2 = zisc::dot(n, d);
+    if ((0.0 < t1) && zisc::isInClosedBounds(t2, 0.0, determinant)) {
+      const Float inverse_determinant = 1.0 / determinant;
+      const Float candidate = t1 * inverse_determinant;
+      if (zisc::isInOpenBounds(candidate, 0.0, distance)) {
+        is_hit = true;
+        distance = candidate;
+        *st = Point2{s, t2 * inverse_determinant};
+      }
+    }
+  }
+  if (is_hit)
+    *t = distance;
+  return is_hit;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+bool BilinearPatch::testOcclusion(const Ray& ray,
+                                  const Float max_distance) const noexcept
+{
+  Float t = 0.0;
+  Point2 st;
+  return testIntersection(ray, max_distance, &t, &st);
+}
+
+/*!
+  \details
+  The st coordinate is sampled from the bilinear distribution of the norms of
+  the jacobian at the corners. It's uniform by area on a planar quad since
+  the norm of the jacobian is bilinear. Please see
+  "Physically Based Rendering: From Theory to Implementation, 4th edition".
+  */
+ShapePoint BilinearPatch::samplePoint(Sampler& sampler,
+                                      const PathState& path_state) const noexcept
+{
+  const auto& p0 = vertex(0);
+  const auto& p1 = vertex(1);
+  const auto& p2 = vertex(2);
+  const auto& p3 = vertex(3);
+  const Float w00 = calcJacobian(p0, p1, p2, p3, Point2{0.0, 0.0}).norm();
+  const Float w10 = calcJacobian(p0, p1, p2, p3, Point2{1.0, 0.0}).norm();
+  const Float w11 = calcJacobian(p0, p1, p2, p3, Point2{1.0, 1.0}).norm();
+  const Float w01 = calcJacobian(p0, p1, p2, p3, Point2{0.0, 1.0}).norm();
+
+  const auto r = sampler.draw2D(path_state);
+  const Float t = sampleLinear(r[1], w00 + w10, w01 + w11);
+  const Float s = sampleLinear(r[0],
+                               (1.0 - t) * w00 + t * w01,
+                               (1.0 - t) * w10 + t * w11);
+  const Point2 st{s, t};
+  const Float pdf = 4.0 * ((1.0 - t) * ((1.0 - s) * w00 + s * w10) +
+                           t * ((1.0 - s) * w01 + s * w11)) /
+                    (w00 + w10 + w11 + w01);
+  const auto jacobian = calcJacobian(p0, p1, p2, p3, st);
+  const Float inverse_pdf = jacobian.norm() / pdf;
+
+  const auto point = getPosition(st);
+  const auto uv = calcUv(st);
+
+  const auto normal = calcShadingNormal(st, jacobian.normalized());
+  const auto tangents = Transformation::calcDefaultTangent(normal);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  return ShapePoint{SampledPoint{point, inverse_pdf},
+                    normal,
+                    tangent,
+                    bitangent,
+                    uv,
+                    st};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+ShapeType BilinearPatch::type() const noexcept
+{
+  return ShapeType::kBilinearPatch;
+}
+
+// private member function
+
+/*!
+  */
+Float BilinearPatch::calcSurfaceArea() const noexcept
+{
+  return calcSurfaceArea(vertex(0), vertex(1), vertex(2), vertex(3));
+}
+
+/*!
+  \details
+  The vertices are shared by the faces of the mesh,
+  so they are made again by TriangleMesh::setTransformation.
+  */
+void BilinearPatch::resetShape() noexcept
+{
+}
+
+/*!
+  \details
+  No detailed.
+  */
+Float BilinearPatch::sampleLinear(const Float r,
+                                  const Float a,
+                                  const Float b) noexcept
+{
+  if ((r == 0.0) && (a == 0.0))
+    return 0.0;
+  const Float x = r * (a + b) /
+                  (a + zisc::sqrt((1.0 - r) * (a * a) + r * (b * b)));
+  return zisc::min(x, 1.0);
+}
+
+/*!
+  \details
+  Only the surface area is updated by Shape::transform
+  after the mesh is transformed by TriangleMesh,
+  so the matrix must be the identity. Please see Bvh::refit.
+  */
+void BilinearPatch::transformShape(const Matrix4x4& matrix) noexcept
+{
+  // The vertices are shared by the faces of the mesh,
+  // so they are transformed by the mesh
+  static_cast<void>(matrix);
+}
+
+} // namespace nanairo
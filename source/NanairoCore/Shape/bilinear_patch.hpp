@@ -0,0 +1,157 @@
+/*!
+  \file bilinear_patch.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_BILINEAR_PATCH_HPP
+#define NANAIRO_BILINEAR_PATCH_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "shape.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Aabb;
+class IntersectionInfo;
+class PathState;
+class Ray;
+class Sampler;
+class TriangleMesh;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  A bilinear patch made by a quadrangular face of a mesh.
+  The corners p0, p1, p2 and p3 of the face are mapped to the st coordinate
+  (0, 0), (1, 0), (1, 1) and (0, 1). A planar quad is a special case.
+  The vertex data is shared by the faces of the mesh,
+  so a patch only has the mesh and the quad index.
+  */
+class BilinearPatch : public Shape
+{
+ public:
+  //! Create a bilinear patch of the quad of the mesh
+  BilinearPatch(const TriangleMesh* mesh, const uint32 quad_index) noexcept;
+
+
+  //! Return the bounding box
+  Aabb boundingBox() const noexcept override;
+
+  //! Calculate the surface area of the front side of the patch
+  static Float calcSurfaceArea(const Point3& p0,
+                               const Point3& p1,
+                               const Point3& p2,
+                               const Point3& p3) noexcept;
+
+  //! Compute the hit attributes of the intersection
+  void finalizeIntersection(const Ray& ray,
+                            IntersectionInfo* intersection) const noexcept override;
+
+  //! Return the point data by the st coordinate
+  ShapePoint getPoint(const Point2& st) const noexcept override;
+
+  //! Return the cost of a ray-patch intersection test
+  Float getTraversalCost() const noexcept override;
+
+  //! Check if the patch of the corners is planar
+  static bool isPlanar(const Point3& p0,
+                       const Point3& p1,
+                       const Point3& p2,
+                       const Point3& p3) noexcept;
+
+  //! Check if the patch of the corners doesn't fold
+  static bool isRegular(const Point3& p0,
+                        const Point3& p1,
+                        const Point3& p2,
+                        const Point3& p3) noexcept;
+
+  //! Return the mesh which the patch belongs to
+  const TriangleMesh& mesh() const noexcept;
+
+  //! Return the normal of the patch at the st coordinate
+  Vector3 normal(const Point2& st) const noexcept;
+
+  //! Return the quad index in the mesh
+  uint32 quadIndex() const noexcept;
+
+  //! Test ray-patch intersection
+  IntersectionTestResult testIntersection(
+      const Ray& ray,
+      IntersectionInfo* intersection) const noexcept override;
+
+  //! Test ray-patch intersection and return the distance and st coordinate
+  bool testIntersection(const Ray& ray,
+                        const Float max_distance,
+                        Float* t,
+                        Point2* st) const noexcept;
+
+  //! Test if the ray is occluded by the patch
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance) const noexcept override;
+
+  //! Sample a point randomly on the surface of the patch
+  ShapePoint samplePoint(Sampler& sampler,
+                         const PathState& path_state) const noexcept override;
+
+  //! Return the type of the patch
+  ShapeType type() const noexcept override;
+
+  //! Return the corner of the patch
+  Point3 vertex(const uint corner) const noexcept;
+
+ private:
+  //! Calculate the tangent cross bitangent at the st coordinate
+  static Vector3 calcJacobian(const Point3& p0,
+                              const Point3& p1,
+                              const Point3& p2,
+                              const Point3& p3,
+                              const Point2& st) noexcept;
+
+  //! Calculate the shading normal at the st coordinate
+  Vector3 calcShadingNormal(const Point2& st,
+                            const Vector3& normal) const noexcept;
+
+  //! Calculate the surface area of the front side of the patch
+  Float calcSurfaceArea() const noexcept override;
+
+  //! Calculate the UV of the point
+  Point2 calcUv(const Point2& st) const noexcept;
+
+  //! Return the point by the st coordinate
+  Point3 getPosition(const Point2& st) const noexcept;
+
+  //! Return the shape to the object space
+  void resetShape() noexcept override;
+
+  //! Sample a value in [0, 1] with the density linear from a to b
+  static Float sampleLinear(const Float r, const Float a, const Float b) noexcept;
+
+  //! Apply affine transformation
+  void transformShape(const Matrix4x4& matrix) noexcept override;
+
+
+  const TriangleMesh* mesh_;
+  uint32 quad_index_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "bilinear_patch-inl.hpp"
+
+#endif // NANAIRO_BILINEAR_PATCH_HPP
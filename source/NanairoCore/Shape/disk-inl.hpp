@@ -0,0 +1,49 @@
+/*!
+  \file disk-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_DISK_INL_HPP
+#define NANAIRO_DISK_INL_HPP
+
+#include "disk.hpp"
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+const std::array<Vector3, 2>& Disk::axis() const noexcept
+{
+  return axis_;
+}
+
+/*!
+  */
+inline
+const Point3& Disk::center() const noexcept
+{
+  return center_;
+}
+
+/*!
+  */
+inline
+const Vector3& Disk::normal() const noexcept
+{
+  return normal_;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_DISK_INL_HPP
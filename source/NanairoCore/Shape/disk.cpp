@@ -0,0 +1,277 @@
+/*!
+  \file disk.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "disk.hpp"
+// Standard C++ library
+#include <array>
+#include <tuple>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "shape.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Sampling/sampled_point.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+Disk::Disk() noexcept :
+    center_{0.0, 0.0, 0.0},
+    axis_{{Vector3{0.5, 0.0, 0.0}, Vector3{0.0, 0.5, 0.0}}}
+{
+  initialize();
+}
+
+/*!
+  \details
+  The extent of the ellipse on an axis is the norm of
+  the components of the semi axes.
+  */
+Aabb Disk::boundingBox() const noexcept
+{
+  const auto& a = axis();
+  Vector3 extent;
+  for (uint i = 0; i < 3; ++i)
+    extent[i] = zisc::sqrt(zisc::power<2>(a[0][i]) + zisc::power<2>(a[1][i]));
+  return Aabb{center() - extent, center() + extent};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Disk::finalizeIntersection(const Ray& ray,
+                                IntersectionInfo* intersection) const noexcept
+{
+  const Float cos_theta = -zisc::dot(normal(), ray.direction());
+  const bool is_back_face = cos_theta < 0.0;
+
+  const auto point = ray.origin() + (intersection->rayDistance() * ray.direction());
+  const auto n = (!is_back_face) ? normal() : -normal();
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  intersection->setPoint(point);
+  intersection->setNormal(n);
+  intersection->setTangent(tangent);
+  intersection->setBitangent(bitangent);
+  intersection->setAsBackFace(is_back_face);
+  intersection->setUv(intersection->st());
+}
+
+/*!
+  */
+ShapePoint Disk::getPoint(const Point2& st) const noexcept
+{
+  const Point2 xy{2.0 * st[0] - 1.0, 2.0 * st[1] - 1.0};
+  return makePoint(xy);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+Float Disk::getTraversalCost() const noexcept
+{
+  return 1.0;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+IntersectionTestResult Disk::testIntersection(
+    const Ray& ray,
+    IntersectionInfo* intersection) const noexcept
+{
+  Float t = 0.0;
+  Point2 st;
+  const bool is_hit = testIntersection(ray, intersection->rayDistance(), &t, &st);
+  if (is_hit) {
+    intersection->setRayDistance(t);
+    intersection->setSt(st);
+  }
+  return (is_hit)
+      ? IntersectionTestResult{t}
+      : IntersectionTestResult{};
+}
+
+/*!
+  \details
+  The hit point on the plane of the disk is expressed by the semi axes.
+  The distance and the st coordinate are written only if the ray hits.
+  */
+bool Disk::testIntersection(const Ray& ray,
+                            const Float max_distance,
+                            Float* t,
+                            Point2* st) const noexcept
+{
+  const Float cos_theta = -zisc::dot(normal(), ray.direction());
+  // In the case that the ray is parallel to the disk
+  if (cos_theta == 0.0)
+    return false;
+  const Float distance = zisc::dot(normal(), ray.origin() - center()) / cos_theta;
+  if (!zisc::isInOpenBounds(distance, 0.0, max_distance))
+    return false;
+
+  // Solve p - center = x * a0 + y * a1
+  const auto& a = axis();
+  const auto q = (ray.origin() + distance * ray.direction()) - center();
+  const Float a00 = a[0].squareNorm();
+  const Float a01 = zisc::dot(a[0], a[1]);
+  const Float a11 = a[1].squareNorm();
+  const Float q0 = zisc::dot(a[0], q);
+  const Float q1 = zisc::dot(a[1], q);
+  const Float inverse_determinant = 1.0 / (a00 * a11 - a01 * a01);
+  const Float x = (a11 * q0 - a01 * q1) * inverse_determinant;
+  const Float y = (a00 * q1 - a01 * q0) * inverse_determinant;
+
+  const bool is_hit = (x * x + y * y) <= 1.0;
+  if (is_hit) {
+    *t = distance;
+    *st = Point2{0.5 * (x + 1.0), 0.5 * (y + 1.0)};
+  }
+  return is_hit;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+bool Disk::testOcclusion(const Ray& ray, const Float max_distance) const noexcept
+{
+  Float t = 0.0;
+  Point2 st;
+  return testIntersection(ray, max_distance, &t, &st);
+}
+
+/*!
+  \details
+  The point is sampled by the concentric mapping, which is uniform by area
+  even if the disk is an ellipse.
+  Please see "A Low Distortion Map Between Disk and Square".
+  */
+ShapePoint Disk::samplePoint(Sampler& sampler,
+                             const PathState& path_state) const noexcept
+{
+  const auto r = sampler.draw2D(path_state);
+  const Float u = 2.0 * r[0] - 1.0;
+  const Float v = 2.0 * r[1] - 1.0;
+  Point2 xy{0.0, 0.0};
+  if ((u != 0.0) || (v != 0.0)) {
+    constexpr Float quarter_pi = 0.25 * zisc::kPi<Float>;
+    const bool is_u_major = zisc::abs(v) < zisc::abs(u);
+    const Float radius = is_u_major ? u : v;
+    const Float phi = is_u_major
+        ? quarter_pi * (v / u)
+        : 2.0 * quarter_pi - quarter_pi * (u / v);
+    xy = Point2{radius * zisc::cos(phi), radius * zisc::sin(phi)};
+  }
+  return makePoint(xy);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+ShapeType Disk::type() const noexcept
+{
+  return ShapeType::kDisk;
+}
+
+// private member function
+
+/*!
+  */
+Vector3 Disk::calcNormal() const noexcept
+{
+  const auto& a = axis();
+  const auto n = zisc::cross(a[0], a[1]).normalized();
+  ZISC_ASSERT(isUnitVector(n), "Normal isn't unit vector.");
+  return n;
+}
+
+/*!
+  \details
+  The area of an ellipse is pi times the parallelogram of the semi axes.
+  */
+Float Disk::calcSurfaceArea() const noexcept
+{
+  const auto& a = axis();
+  return zisc::kPi<Float> * zisc::cross(a[0], a[1]).norm();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Disk::initialize() noexcept
+{
+  normal_ = calcNormal();
+  setSurfaceArea(calcSurfaceArea());
+}
+
+/*!
+  */
+ShapePoint Disk::makePoint(const Point2& xy) const noexcept
+{
+  const auto& a = axis();
+  const auto point = center() + xy[0] * a[0] + xy[1] * a[1];
+  const Point2 st{0.5 * (xy[0] + 1.0), 0.5 * (xy[1] + 1.0)};
+
+  const auto tangents = Transformation::calcDefaultTangent(normal());
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  return ShapePoint{SampledPoint{point, surfaceArea()},
+                    normal(),
+                    tangent,
+                    bitangent,
+                    st,
+                    st};
+}
+
+/*!
+  \details
+  The shape is made again in the canonical space.
+  */
+void Disk::resetShape() noexcept
+{
+  *this = Disk{};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Disk::transformShape(const Matrix4x4& matrix) noexcept
+{
+  Transformation::affineTransform(matrix, &center_);
+  Transformation::affineTransform(matrix, &axis_[0]);
+  Transformation::affineTransform(matrix, &axis_[1]);
+  normal_ = calcNormal();
+}
+
+} // namespace nanairo
@@ -0,0 +1,125 @@
+/*!
+  \file disk.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_DISK_HPP
+#define NANAIRO_DISK_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "shape.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Aabb;
+class IntersectionInfo;
+class PathState;
+class Ray;
+class Sampler;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief 3D disk
+  \details
+  The default disk has the radius 0.5 at the origin and faces z axis.
+  A point of the disk is center + x * axis0 + y * axis1 where x^2 + y^2 <= 1,
+  so the disk becomes an ellipse by non-uniform scaling.
+  The st coordinate is (x, y) mapped to [0, 1].
+  */
+class Disk : public Shape
+{
+ public:
+  //! Initialize
+  Disk() noexcept;
+
+
+  //! Return the semi axes of the disk
+  const std::array<Vector3, 2>& axis() const noexcept;
+
+  //! Return the bounding box
+  Aabb boundingBox() const noexcept override;
+
+  //! Return the center of the disk
+  const Point3& center() const noexcept;
+
+  //! Compute the hit attributes of the intersection
+  void finalizeIntersection(const Ray& ray,
+                            IntersectionInfo* intersection) const noexcept override;
+
+  //! Return the point and the normal by the st coordinate
+  ShapePoint getPoint(const Point2& st) const noexcept override;
+
+  //! Return the cost of a ray-disk intersection test
+  Float getTraversalCost() const noexcept override;
+
+  //! Return the normal of the disk
+  const Vector3& normal() const noexcept;
+
+  //! Test ray-disk intersection
+  IntersectionTestResult testIntersection(
+      const Ray& ray,
+      IntersectionInfo* intersection) const noexcept override;
+
+  //! Test ray-disk intersection and return the distance and st coordinate
+  bool testIntersection(const Ray& ray,
+                        const Float max_distance,
+                        Float* t,
+                        Point2* st) const noexcept;
+
+  //! Test if the ray is occluded by the disk
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance) const noexcept override;
+
+  //! Sample a point randomly on the surface of the disk
+  ShapePoint samplePoint(Sampler& sampler,
+                         const PathState& path_state) const noexcept override;
+
+  //! Return the type of the disk
+  ShapeType type() const noexcept override;
+
+ private:
+  //! Calculate the normal of the disk
+  Vector3 calcNormal() const noexcept;
+
+  //! Calculate the surface area of the front side of the disk
+  Float calcSurfaceArea() const noexcept override;
+
+  //! Initialize
+  void initialize() noexcept;
+
+  //! Make the point data by the disk coordinate
+  ShapePoint makePoint(const Point2& xy) const noexcept;
+
+  //! Return the shape to the object space
+  void resetShape() noexcept override;
+
+  //! Apply affine transformation
+  void transformShape(const Matrix4x4& matrix) noexcept override;
+
+
+  Point3 center_;
+  std::array<Vector3, 2> axis_; //!< The semi axes
+  Vector3 normal_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "disk-inl.hpp"
+
+#endif // NANAIRO_DISK_HPP
@@ -14,8 +14,11 @@
 // Standard C++ library
 #include <array>
 // Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "triangle_mesh.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
@@ -25,63 +28,88 @@ namespace nanairo {
 /*!
   */
 inline
-const std::array<Vector3, 2>& FlatTriangle::edge() const noexcept
+std::array<Vector3, 2> FlatTriangle::edge() const noexcept
 {
-  return edge_;
+  const auto& f = mesh().face(faceIndex());
+  const auto& v0 = mesh().vertex(f[0]);
+  return std::array<Vector3, 2>{{mesh().vertex(f[1]) - v0,
+                                 mesh().vertex(f[2]) - v0}};
 }
 
 /*!
   */
 inline
-const Vector3& FlatTriangle::normal() const noexcept
+uint32 FlatTriangle::faceIndex() const noexcept
 {
-  return normal_;
+  return face_index_;
 }
 
 /*!
   */
 inline
-const Point2& FlatTriangle::uv0() const noexcept
+const TriangleMesh& FlatTriangle::mesh() const noexcept
 {
-  return uv0_;
+  return *mesh_;
 }
 
 /*!
   */
 inline
-const std::array<Vector2, 2>& FlatTriangle::uvEdge() const noexcept
+Vector3 FlatTriangle::normal() const noexcept
 {
-  return uv_edge_;
+  const auto e = edge();
+  const auto n = zisc::cross(e[0], e[1]).normalized();
+  ZISC_ASSERT(isUnitVector(n), "The normal isn't unit vector.");
+  return n;
 }
 
 /*!
   */
 inline
-const Point3& FlatTriangle::vertex0() const noexcept
+Point3 FlatTriangle::vertex0() const noexcept
 {
-  return vertex0_;
+  const auto& f = mesh().face(faceIndex());
+  return mesh().vertex(f[0]);
 }
 
 /*!
+  \details
+  The interpolated normal is oriented to the side of the face normal.
+  The face normal is used if the face doesn't have vertex normals.
   */
 inline
-Point2 FlatTriangle::calcUv(const Point2& st) const noexcept
+Vector3 FlatTriangle::calcShadingNormal(const Point2& st,
+                                        const Vector3& normal) const noexcept
 {
-  const auto& uv_edge = uvEdge();
-  Point2 uv = uv0() + st[0] * uv_edge[0] + st[1] * uv_edge[1];
-  for (uint i = 0; i < uv.size(); ++i) {
-    while (!zisc::isInClosedBounds(uv[i], 0.0, 1.0))
-      uv[i] = (uv[i] < 0.0) ? (uv[i] + 1.0) : (uv[i] - 1.0);
-  }
-  return uv;
+  if (!mesh().hasNormal())
+    return normal;
+  const auto& f = mesh().face(faceIndex());
+  const auto n = (1.0 - (st[0] + st[1])) * mesh().normal(f[0]) +
+                 st[0] * mesh().normal(f[1]) +
+                 st[1] * mesh().normal(f[2]);
+  const Float cos_theta = zisc::dot(n, normal);
+  if (!(0.0 < n.squareNorm()) || (cos_theta == 0.0))
+    return normal;
+  const auto shading_normal = n.normalized();
+  return (0.0 < cos_theta) ? shading_normal : -shading_normal;
 }
 
 /*!
   */
 inline
-auto FlatTriangle::toCanonicalMatrix() const noexcept -> const CanonicalMatrix&
+Point2 FlatTriangle::calcUv(const Point2& st) const noexcept
 {
-  return to_canonical_;
+  if (!mesh().hasUv())
+    return Point2{0.0, 0.0};
+  const auto& f = mesh().face(faceIndex());
+  const auto& uv0 = mesh().uv(f[0]);
+  Point2 uv = uv0 + st[0] * (mesh().uv(f[1]) - uv0) +
+                    st[1] * (mesh().uv(f[2]) - uv0);
+  for (uint i = 0; i < uv.size(); ++i) {
+    while (!zisc::isInClosedBounds(uv[i], 0.0, 1.0))
+      uv[i] = (uv[i] < 0.0) ? (uv[i] + 1.0) : (uv[i] - 1.0);
+  }
+  return uv;
 }
 
 } // namespace nanairo
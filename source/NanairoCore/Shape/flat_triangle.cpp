@@ -38,15 +38,14 @@ namespace nanairo  {
   \details
   No detailed.
   */
-FlatTriangle::FlatTriangle(const Point3& vertex1,
-                           const Point3& vertex2,
-                           const Point3& vertex3) noexcept :
-    vertex0_{vertex1},
-    edge_{{Vector3{vertex2 - vertex1}, Vector3{vertex3 - vertex1}}},
-    uv0_{0.0, 0.0},
-    uv_edge_{{Vector2{0.0, 0.0}, Vector2{0.0, 0.0}}}
+FlatTriangle::FlatTriangle(const TriangleMesh* mesh,
+                           const uint32 face_index) noexcept :
+    mesh_{mesh},
+    face_index_{face_index}
 {
-  initialize();
+  ZISC_ASSERT(mesh_ != nullptr, "The mesh is null.");
+  ZISC_ASSERT(face_index_ < mesh_->numOfFaces(), "The face index is out of range.");
+  setSurfaceArea(calcSurfaceArea());
 }
 
 /*!
@@ -84,6 +83,33 @@ Float FlatTriangle::calcSurfaceArea(const Point3& vertex1,
   return area;
 }
 
+/*!
+  \details
+  The hit attributes are computed only once for the closest intersection.
+  */
+void FlatTriangle::finalizeIntersection(
+    const Ray& ray,
+    IntersectionInfo* intersection) const noexcept
+{
+  const auto normal = this->normal();
+  const Float cos_theta = -zisc::dot(normal, ray.direction());
+  const bool is_back_face = cos_theta < 0.0;
+
+  const auto point = ray.origin() + intersection->rayDistance() * ray.direction();
+  const auto shading_normal = calcShadingNormal(intersection->st(), normal);
+  const auto n = (!is_back_face) ? shading_normal : -shading_normal;
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  intersection->setPoint(point);
+  intersection->setNormal(n);
+  intersection->setTangent(tangent);
+  intersection->setBitangent(bitangent);
+  intersection->setAsBackFace(is_back_face);
+  intersection->setUv(calcUv(intersection->st()));
+}
+
 /*!
   */
 ShapePoint FlatTriangle::getPoint(const Point2& st) const noexcept
@@ -94,12 +120,13 @@ ShapePoint FlatTriangle::getPoint(const Point2& st) const noexcept
   const auto point = v + st[0] * e[0] + st[1] * e[1];
   const auto uv = calcUv(st);
 
-  const auto tangents = Transformation::calcDefaultTangent(normal());
+  const auto normal = calcShadingNormal(st, this->normal());
+  const auto tangents = Transformation::calcDefaultTangent(normal);
   const auto& tangent = std::get<0>(tangents);
   const auto& bitangent = std::get<1>(tangents);
 
   return ShapePoint{SampledPoint{point, surfaceArea()},
-                    normal(),
+                    normal,
                     tangent,
                     bitangent,
                     uv,
@@ -119,52 +146,105 @@ Float FlatTriangle::getTraversalCost() const noexcept
   \details
   Please see "Fast Ray-Triangle Intersections by Coordinate Transformation"
   */
+auto FlatTriangle::makeCanonicalMatrix() const noexcept -> CanonicalMatrix
+{
+  const auto e = edge();
+  const auto& e1 = e[0];
+  const auto& e2 = e[1];
+  const auto v0 = vertex0();
+  const Vector3 v1 = *zisc::treatAs<const Vector3*>(&v0);
+  const Vector3 v2 = v1 + e1;
+  const Vector3 v3 = v1 + e2;
+  const Vector3 n = zisc::cross(e1, e2);
+
+  CanonicalMatrix to_canonical;
+  using zisc::abs;
+  if ((abs(n[1]) < abs(n[0])) && (abs(n[2]) < abs(n[0]))) {
+    to_canonical.row1_xyz_[0] = 1.0;
+    to_canonical.row1_xyz_[1] = n[1] / n[0];
+    to_canonical.row1_xyz_[2] = n[2] / n[0];
+    to_canonical.row1_w_ = -zisc::dot(v1, n) / n[0];
+
+    to_canonical.row2_xyz_[0] = 0.0;
+    to_canonical.row2_xyz_[1] = e2[2] / n[0];
+    to_canonical.row2_xyz_[2] = -e2[1] / n[0];
+    to_canonical.row2_w_ = zisc::cross(v3, v1)[0] / n[0];
+
+    to_canonical.row3_xyz_[0] = 0.0;
+    to_canonical.row3_xyz_[1] = -e1[2] / n[0];
+    to_canonical.row3_xyz_[2] = e1[1] / n[0];
+    to_canonical.row3_w_ = -zisc::cross(v2, v1)[0] / n[0];
+  }
+  else if (abs(n[2]) < abs(n[1])) {
+    to_canonical.row1_xyz_[0] = n[0] / n[1];
+    to_canonical.row1_xyz_[1] = 1.0;
+    to_canonical.row1_xyz_[2] = n[2] / n[1];
+    to_canonical.row1_w_ = -zisc::dot(v1, n) / n[1];
+
+    to_canonical.row2_xyz_[0] = -e2[2] / n[1];
+    to_canonical.row2_xyz_[1] = 0.0;
+    to_canonical.row2_xyz_[2] = e2[0] / n[1];
+    to_canonical.row2_w_ = zisc::cross(v3, v1)[1] / n[1];
+
+    to_canonical.row3_xyz_[0] = e1[2] / n[1];
+    to_canonical.row3_xyz_[1] = 0.0;
+    to_canonical.row3_xyz_[2] = -e1[0] / n[1];
+    to_canonical.row3_w_ = -zisc::cross(v2, v1)[1] / n[1];
+  }
+  else if (0.0 < abs(n[2])) {
+    to_canonical.row1_xyz_[0] = n[0] / n[2];
+    to_canonical.row1_xyz_[1] = n[1] / n[2];
+    to_canonical.row1_xyz_[2] = 1.0;
+    to_canonical.row1_w_ = -zisc::dot(v1, n) / n[2];
+
+    to_canonical.row2_xyz_[0] = e2[1] / n[2];
+    to_canonical.row2_xyz_[1] = -e2[0] / n[2];
+    to_canonical.row2_xyz_[2] = 0.0;
+    to_canonical.row2_w_ = zisc::cross(v3, v1)[2] / n[2];
+
+    to_canonical.row3_xyz_[0] = -e1[1] / n[2];
+    to_canonical.row3_xyz_[1] = e1[0] / n[2];
+    to_canonical.row3_xyz_[2] = 0.0;
+    to_canonical.row3_w_ = -zisc::cross(v2, v1)[2] / n[2];
+  }
+  else {
+    zisc::raiseError("Making world-to-canonical matrix failed.");
+  }
+  return to_canonical;
+}
+
+/*!
+  \details
+  No detailed.
+  */
 IntersectionTestResult FlatTriangle::testIntersection(
     const Ray& ray,
     IntersectionInfo* intersection) const noexcept
 {
-  const auto& to_canonical = toCanonicalMatrix();
-
-  const Float dz = zisc::dot(to_canonical.row1_xyz_, ray.direction());
-  const Float oz = zisc::dot(to_canonical.row1_xyz_.data(), ray.origin().data()) +
-                   to_canonical.row1_w_;
-  if (dz == 0.0)
-    return IntersectionTestResult{};
-
-  const Float t = -oz / dz;
-  if (!zisc::isInOpenBounds(t, 0.0, intersection->rayDistance()))
-    return IntersectionTestResult{};
-
-  const auto point = ray.origin() + t * ray.direction();
-  const Point2 st{zisc::dot(to_canonical.row2_xyz_.data(), point.data()) +
-                  to_canonical.row2_w_,
-                  zisc::dot(to_canonical.row3_xyz_.data(), point.data()) +
-                  to_canonical.row3_w_};
-  const Float u = 1.0 - (st[0] + st[1]);
-  const bool is_hit = (0.0 < st[0]) && (0.0 < st[1]) && (0.0 < u);
+  Float t = 0.0;
+  Point2 st;
+  const bool is_hit = testIntersection(ray, intersection->rayDistance(), &t, &st);
   if (is_hit) {
-    const Float cos_theta = -zisc::dot(normal(), ray.direction());
-    const bool is_back_face = cos_theta < 0.0;
-
-    const auto n = (!is_back_face) ? normal() : -normal();
-    const auto tangents = Transformation::calcDefaultTangent(n);
-    const auto& tangent = std::get<0>(tangents);
-    const auto& bitangent = std::get<1>(tangents);
-
-    intersection->setPoint(point);
-    intersection->setNormal(n);
-    intersection->setTangent(tangent);
-    intersection->setBitangent(bitangent);
-    intersection->setAsBackFace(is_back_face);
     intersection->setRayDistance(t);
     intersection->setSt(st);
-    intersection->setUv(calcUv(st));
   }
   return (is_hit)
       ? IntersectionTestResult{t}
       : IntersectionTestResult{};
 }
 
+/*!
+  \details
+  No detailed.
+  */
+bool FlatTriangle::testOcclusion(const Ray& ray,
+                                 const Float max_distance) const noexcept
+{
+  Float t = 0.0;
+  Point2 st;
+  return testIntersection(ray, max_distance, &t, &st);
+}
+
 /*!
   \details
   No detailed.
@@ -184,138 +264,94 @@ ShapePoint FlatTriangle::samplePoint(Sampler& sampler,
   const auto point = v + st[0] * e[0] + st[1] * e[1];
   const auto uv = calcUv(st);
 
-  const auto tangents = Transformation::calcDefaultTangent(normal());
+  const auto normal = calcShadingNormal(st, this->normal());
+  const auto tangents = Transformation::calcDefaultTangent(normal);
   const auto& tangent = std::get<0>(tangents);
   const auto& bitangent = std::get<1>(tangents);
 
   return ShapePoint{SampledPoint{point, surfaceArea()},
-                    normal(),
+                    normal,
                     tangent,
                     bitangent,
                     uv,
                     st};
 }
 
-/*!
-  */
-void FlatTriangle::setUv(const Point2& uv1,
-                         const Point2& uv2,
-                         const Point2& uv3) noexcept
-{
-  uv0_ = uv1;
-  uv_edge_[0] = uv2 - uv1;
-  uv_edge_[1] = uv3 - uv1;
-}
-
-// private member function
-
 /*!
   \details
   No detailed.
   */
-Vector3 FlatTriangle::calcNormal() const noexcept
+ShapeType FlatTriangle::type() const noexcept
 {
-  const auto n = zisc::cross(edge_[0], edge_[1]).normalized();
-  ZISC_ASSERT(isUnitVector(n), "The normal isn't unit vector.");
-  return n;
+  return ShapeType::kMesh;
 }
 
+// private member function
+
 /*!
   */
 Float FlatTriangle::calcSurfaceArea() const noexcept
 {
-  const auto vertex2 = vertex0() + edge()[0];
-  const auto vertex3 = vertex0() + edge()[1];
-  return calcSurfaceArea(vertex0(), vertex2, vertex3);
+  const auto& f = mesh().face(faceIndex());
+  return calcSurfaceArea(mesh().vertex(f[0]),
+                         mesh().vertex(f[1]),
+                         mesh().vertex(f[2]));
 }
 
 /*!
+  \details
+  Please see "Fast, Minimum Storage Ray/Triangle Intersection".
+  The distance and the st coordinate are written only if the ray hits.
   */
-void FlatTriangle::initCanonicalMatrix() noexcept
+bool FlatTriangle::testIntersection(const Ray& ray,
+                                    const Float max_distance,
+                                    Float* t,
+                                    Point2* st) const noexcept
 {
-  const auto& e1 = edge()[0];
-  const auto& e2 = edge()[1];
-  const Vector3 v1 = *zisc::treatAs<const Vector3*>(&vertex0());
-  const Vector3 v2 = v1 + e1;
-  const Vector3 v3 = v1 + e2;
-  const Vector3 n = zisc::cross(e1, e2);
-
-  using zisc::abs;
-  if ((abs(n[1]) < abs(n[0])) && (abs(n[2]) < abs(n[0]))) {
-    to_canonical_.row1_xyz_[0] = 1.0;
-    to_canonical_.row1_xyz_[1] = n[1] / n[0];
-    to_canonical_.row1_xyz_[2] = n[2] / n[0];
-    to_canonical_.row1_w_ = -zisc::dot(v1, n) / n[0];
-
-    to_canonical_.row2_xyz_[0] = 0.0;
-    to_canonical_.row2_xyz_[1] = e2[2] / n[0];
-    to_canonical_.row2_xyz_[2] = -e2[1] / n[0];
-    to_canonical_.row2_w_ = zisc::cross(v3, v1)[0] / n[0];
-
-    to_canonical_.row3_xyz_[0] = 0.0;
-    to_canonical_.row3_xyz_[1] = -e1[2] / n[0];
-    to_canonical_.row3_xyz_[2] = e1[1] / n[0];
-    to_canonical_.row3_w_ = -zisc::cross(v2, v1)[0] / n[0];
-  }
-  else if (abs(n[2]) < abs(n[1])) {
-    to_canonical_.row1_xyz_[0] = n[0] / n[1];
-    to_canonical_.row1_xyz_[1] = 1.0;
-    to_canonical_.row1_xyz_[2] = n[2] / n[1];
-    to_canonical_.row1_w_ = -zisc::dot(v1, n) / n[1];
-
-    to_canonical_.row2_xyz_[0] = -e2[2] / n[1];
-    to_canonical_.row2_xyz_[1] = 0.0;
-    to_canonical_.row2_xyz_[2] = e2[0] / n[1];
-    to_canonical_.row2_w_ = zisc::cross(v3, v1)[1] / n[1];
-
-    to_canonical_.row3_xyz_[0] = e1[2] / n[1];
-    to_canonical_.row3_xyz_[1] = 0.0;
-    to_canonical_.row3_xyz_[2] = -e1[0] / n[1];
-    to_canonical_.row3_w_ = -zisc::cross(v2, v1)[1] / n[1];
-  }
-  else if (0.0 < abs(n[2])) {
-    to_canonical_.row1_xyz_[0] = n[0] / n[2];
-    to_canonical_.row1_xyz_[1] = n[1] / n[2];
-    to_canonical_.row1_xyz_[2] = 1.0;
-    to_canonical_.row1_w_ = -zisc::dot(v1, n) / n[2];
-
-    to_canonical_.row2_xyz_[0] = e2[1] / n[2];
-    to_canonical_.row2_xyz_[1] = -e2[0] / n[2];
-    to_canonical_.row2_xyz_[2] = 0.0;
-    to_canonical_.row2_w_ = zisc::cross(v3, v1)[2] / n[2];
-
-    to_canonical_.row3_xyz_[0] = -e1[1] / n[2];
-    to_canonical_.row3_xyz_[1] = e1[0] / n[2];
-    to_canonical_.row3_xyz_[2] = 0.0;
-    to_canonical_.row3_w_ = -zisc::cross(v2, v1)[2] / n[2];
-  }
-  else {
-    zisc::raiseError("Making world-to-canonical matrix failed.");
+  const auto& v0 = vertex0();
+  const auto e = edge();
+
+  const auto p = zisc::cross(ray.direction(), e[1]);
+  const Float determinant = zisc::dot(e[0], p);
+  if (determinant == 0.0)
+    return false;
+  const Float inverse_determinant = 1.0 / determinant;
+
+  const auto s = ray.origin() - v0;
+  const Float b1 = inverse_determinant * zisc::dot(s, p);
+  const auto q = zisc::cross(s, e[0]);
+  const Float b2 = inverse_determinant * zisc::dot(ray.direction(), q);
+  const Float distance = inverse_determinant * zisc::dot(e[1], q);
+
+  const bool is_hit = (0.0 < b1) && (0.0 < b2) && ((b1 + b2) < 1.0) &&
+                      zisc::isInOpenBounds(distance, 0.0, max_distance);
+  if (is_hit) {
+    *t = distance;
+    *st = Point2{b1, b2};
   }
+  return is_hit;
 }
 
 /*!
   \details
-  No detailed.
+  The vertices are shared by the triangles of the mesh,
+  so they are made again by TriangleMesh::setTransformation.
   */
-void FlatTriangle::initialize() noexcept
+void FlatTriangle::resetShape() noexcept
 {
-  normal_ = calcNormal();
-  initCanonicalMatrix();
-  setSurfaceArea(calcSurfaceArea());
 }
 
 /*!
   \details
-  No detailed.
+  Only the surface area is updated by Shape::transform
+  after the mesh is transformed by TriangleMesh,
+  so the matrix must be the identity. Please see Bvh::refit.
   */
 void FlatTriangle::transformShape(const Matrix4x4& matrix) noexcept
 {
-  Transformation::affineTransform(matrix, &vertex0_);
-  Transformation::affineTransform(matrix, &edge_[0]);
-  Transformation::affineTransform(matrix, &edge_[1]);
-  normal_ = calcNormal();
-  initCanonicalMatrix();
+  // The vertices are shared by the triangles of the mesh,
+  // so they are transformed by the mesh
+  static_cast<void>(matrix);
 }
 
 
@@ -30,21 +30,35 @@ class IntersectionInfo;
 class PathState;
 class Ray;
 class Sampler;
+class TriangleMesh;
 
 //! \addtogroup Core
 //! \{
 
 /*!
   \details
-  No detailed.
+  The vertex data is shared by the triangles of a mesh,
+  so a triangle only has the mesh and the face index.
+  If the mesh has vertex normals, the normals at the points are
+  interpolated from them for shading.
   */
 class FlatTriangle : public Shape
 {
  public:
-  //! Create a flat triangle 
-  FlatTriangle(const Point3& vertex1,
-               const Point3& vertex2,
-               const Point3& vertex3) noexcept;
+  //! The matrix to transform world coordinate to the canonical triangle space
+  struct CanonicalMatrix
+  {
+    Vector3 row1_xyz_;
+    Float row1_w_;
+    Vector3 row2_xyz_;
+    Float row2_w_;
+    Vector3 row3_xyz_;
+    Float row3_w_;
+  };
+
+
+  //! Create a flat triangle of the face of the mesh
+  FlatTriangle(const TriangleMesh* mesh, const uint32 face_index) noexcept;
 
 
   //! Return the bounding box
@@ -56,7 +70,14 @@ class FlatTriangle : public Shape
                                const Point3& vertex3) noexcept;
 
   //! Return the edges of the triangle
-  const std::array<Vector3, 2>& edge() const noexcept;
+  std::array<Vector3, 2> edge() const noexcept;
+
+  //! Return the face index in the mesh
+  uint32 faceIndex() const noexcept;
+
+  //! Compute the hit attributes of the intersection
+  void finalizeIntersection(const Ray& ray,
+                            IntersectionInfo* intersection) const noexcept override;
 
   //! Return the point data by the st coordinate
   ShapePoint getPoint(const Point2& st) const noexcept override;
@@ -64,46 +85,44 @@ class FlatTriangle : public Shape
   //! Return the cost of a ray-triangle intersection test
   Float getTraversalCost() const noexcept override;
 
+  //! Make the matrix to transform world coordinate to the canonical triangle space
+  CanonicalMatrix makeCanonicalMatrix() const noexcept;
+
+  //! Return the mesh which the triangle belongs to
+  const TriangleMesh& mesh() const noexcept;
+
   //! Return the normal of the triangle
-  const Vector3& normal() const noexcept;
+  Vector3 normal() const noexcept;
 
   //! Test ray-triangle intersection
   IntersectionTestResult testIntersection(
       const Ray& ray,
       IntersectionInfo* intersection) const noexcept override;
 
+  //! Test ray-triangle intersection and return the distance and st coordinate
+  bool testIntersection(const Ray& ray,
+                        const Float max_distance,
+                        Float* t,
+                        Point2* st) const noexcept;
+
+  //! Test if the ray is occluded by the triangle
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance) const noexcept override;
+
   //! Sample a point randomly on the surface of the triangle
   ShapePoint samplePoint(Sampler& sampler,
                          const PathState& path_state) const noexcept override;
 
-  //! Set the UVs of the vertice
-  void setUv(const Point2& uv1,
-             const Point2& uv2,
-             const Point2& uv3) noexcept;
-
-  //! Return the UV of the vertex0
-  const Point2& uv0() const noexcept;
-
-  //! Return the UV edges
-  const std::array<Vector2, 2>& uvEdge() const noexcept;
+  //! Return the type of the triangle
+  ShapeType type() const noexcept override;
 
   //! Return the vertex of the triangle
-  const Point3& vertex0() const noexcept;
+  Point3 vertex0() const noexcept;
 
  private:
-  struct CanonicalMatrix
-  {
-    Vector3 row1_xyz_;
-    Float row1_w_;
-    Vector3 row2_xyz_;
-    Float row2_w_;
-    Vector3 row3_xyz_;
-    Float row3_w_;
-  };
-
-
-  //! Calculate the normal vector
-  Vector3 calcNormal() const noexcept;
+  //! Calculate the shading normal at the st coordinate
+  Vector3 calcShadingNormal(const Point2& st,
+                            const Vector3& normal) const noexcept;
 
   //! Calculate the surface area of the front side of the triangle
   Float calcSurfaceArea() const noexcept override;
@@ -111,25 +130,15 @@ class FlatTriangle : public Shape
   //! Calculate the UV of the point
   Point2 calcUv(const Point2& st) const noexcept;
 
-  //! Initialize the matrix to transform canonical coordinate
-  void initCanonicalMatrix() noexcept;
-
-  // Initialize the flat triangle
-  void initialize() noexcept;
-
-  //! Return the matrix to transform canonical coordinate
-  const CanonicalMatrix& toCanonicalMatrix() const noexcept;
+  //! Return the shape to the object space
+  void resetShape() noexcept override;
 
   //! Apply affine transformation
   void transformShape(const Matrix4x4& matrix) noexcept override;
 
 
-  CanonicalMatrix to_canonical_;
-  Point3 vertex0_; //!< The v0
-  std::array<Vector3, 2> edge_; //!< Edges to v1 and v2
-  Vector3 normal_;
-  Point2 uv0_;
-  std::array<Vector2, 2> uv_edge_;
+  const TriangleMesh* mesh_;
+  uint32 face_index_;
 };
 
 //! \} Core
@@ -0,0 +1,52 @@
+/*!
+  \file instance-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_INSTANCE_INL_HPP
+#define NANAIRO_INSTANCE_INL_HPP
+
+#include "instance.hpp"
+// Zisc
+#include "zisc/error.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Bvh;
+
+/*!
+  */
+inline
+const Bvh& Instance::bvh() const noexcept
+{
+  ZISC_ASSERT(bvh_ != nullptr, "The BVH is null.");
+  return *bvh_;
+}
+
+/*!
+  */
+inline
+const Matrix4x4& Instance::inverseTransformation() const noexcept
+{
+  return inverse_transformation_;
+}
+
+/*!
+  */
+inline
+const Matrix4x4& Instance::transformation() const noexcept
+{
+  return transformation_;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_INSTANCE_INL_HPP
@@ -0,0 +1,294 @@
+/*!
+  \file instance.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "instance.hpp"
+// Standard C++ library
+#include <cmath>
+#include <limits>
+#include <tuple>
+// Zisc
+#include "zisc/arith_array.hpp"
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "shape.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Sampling/sampled_point.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+Instance::Instance(const Bvh* bvh) noexcept :
+    bvh_{bvh}
+{
+  initialize();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+Aabb Instance::boundingBox() const noexcept
+{
+  const auto& root_box = bvh().bvhTree()[0].boundingBox();
+  const auto& lower = root_box.minPoint();
+  const auto& upper = root_box.maxPoint();
+
+  Point3 corner{lower};
+  Transformation::affineTransform(transformation(), &corner);
+  auto min_point = corner.data();
+  auto max_point = corner.data();
+  for (uint i = 1; i < 8; ++i) {
+    corner = Point3{((i & 0b001u) == 0) ? lower[0] : upper[0],
+                    ((i & 0b010u) == 0) ? lower[1] : upper[1],
+                    ((i & 0b100u) == 0) ? lower[2] : upper[2]};
+    Transformation::affineTransform(transformation(), &corner);
+    min_point = zisc::minElements(min_point, corner.data());
+    max_point = zisc::maxElements(max_point, corner.data());
+  }
+  return Aabb{Point3{min_point}, Point3{max_point}};
+}
+
+/*!
+  \details
+  The intersected object of the bottom level BVH and the st coordinate
+  are recorded in testIntersection, so the hit attributes are computed
+  from them in the object space.
+  */
+void Instance::finalizeIntersection(const Ray& ray,
+                                    IntersectionInfo* intersection) const noexcept
+{
+  const auto object = intersection->instancedObject();
+  ZISC_ASSERT(object != nullptr, "The instanced object isn't recorded.");
+  Float distance_scale = 0.0;
+  const auto object_ray = toObjectSpace(ray, &distance_scale);
+  IntersectionInfo result;
+  result.setObject(object);
+  result.setRayDistance(distance_scale * intersection->rayDistance());
+  result.setSt(intersection->st());
+  object->shape().finalizeIntersection(object_ray, &result);
+
+  const auto point = ray.origin() + intersection->rayDistance() * ray.direction();
+  auto n = result.normal();
+  Transformation::affineTransform(inverseTransformation().transposedMatrix(), &n);
+  n = n.normalized();
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  intersection->setPoint(point);
+  intersection->setNormal(n);
+  intersection->setTangent(tangent);
+  intersection->setBitangent(bitangent);
+  intersection->setAsBackFace(result.isBackFace());
+  intersection->setUv(result.uv());
+}
+
+/*!
+  \details
+  The point is taken from the first object of the instance.
+  */
+ShapePoint Instance::getPoint(const Point2& st) const noexcept
+{
+  const auto& object = bvh().objectList()[0];
+  auto point = toWorldSpace(object.shape().getPoint(st));
+  point.setSampledPoint(SampledPoint{point.point(), surfaceArea()});
+  return point;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+Float Instance::getTraversalCost() const noexcept
+{
+  const Float num_of_objects = zisc::cast<Float>(bvh().objectList().size());
+  return 1.0 + std::log2(num_of_objects);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+IntersectionTestResult Instance::testIntersection(
+    const Ray& ray,
+    IntersectionInfo* intersection) const noexcept
+{
+  Float distance_scale = 0.0;
+  const auto object_ray = toObjectSpace(ray, &distance_scale);
+  const Float max_distance = zisc::min(distance_scale * intersection->rayDistance(),
+                                       std::numeric_limits<Float>::max());
+  const auto result = bvh().findClosestIntersection(object_ray, max_distance);
+  const bool is_hit = result.isIntersected();
+  const Float t = result.rayDistance() / distance_scale;
+  if (is_hit) {
+    intersection->setRayDistance(t);
+    intersection->setSt(result.st());
+    intersection->setInstancedObject(result.object());
+  }
+  return (is_hit)
+      ? IntersectionTestResult{t}
+      : IntersectionTestResult{};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+bool Instance::testOcclusion(const Ray& ray, const Float max_distance) const noexcept
+{
+  Float distance_scale = 0.0;
+  const auto object_ray = toObjectSpace(ray, &distance_scale);
+  const Float distance = zisc::min(distance_scale * max_distance,
+                                   std::numeric_limits<Float>::max());
+  return bvh().testOcclusion(object_ray, distance);
+}
+
+/*!
+  \details
+  An object of the instance is selected uniformly.
+  The instances are made only from non-emissive objects,
+  so the point isn't sampled in light sampling.
+  */
+ShapePoint Instance::samplePoint(Sampler& sampler,
+                                 const PathState& path_state) const noexcept
+{
+  const auto& object_list = bvh().objectList();
+  const uint num_of_objects = zisc::cast<uint>(object_list.size());
+  const Float u = sampler.draw1D(path_state);
+  const uint index = zisc::min(zisc::cast<uint>(u * zisc::cast<Float>(num_of_objects)),
+                               num_of_objects - 1);
+  const auto& object = object_list[index];
+  auto point = toWorldSpace(object.shape().samplePoint(sampler, path_state));
+  point.setPdf(point.pdf() / zisc::cast<Float>(num_of_objects));
+  return point;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+ShapeType Instance::type() const noexcept
+{
+  return ShapeType::kInstance;
+}
+
+/*!
+  \details
+  The ratio is exact for uniform scaling.
+  */
+Float Instance::calcAreaScale() const noexcept
+{
+  const auto& m = transformation();
+  const Matrix3x3 linear_part{m(0, 0), m(0, 1), m(0, 2),
+                              m(1, 0), m(1, 1), m(1, 2),
+                              m(2, 0), m(2, 1), m(2, 2)};
+  const Float determinant = linear_part.determinant();
+  return std::cbrt(determinant * determinant);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+Float Instance::calcSurfaceArea() const noexcept
+{
+  Float surface_area = 0.0;
+  for (const auto& object : bvh().objectList())
+    surface_area += object.shape().surfaceArea();
+  return calcAreaScale() * surface_area;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Instance::initialize() noexcept
+{
+  transformation_ = Transformation::makeIdentity();
+  inverse_transformation_ = Transformation::makeIdentity();
+  setSurfaceArea(calcSurfaceArea());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Instance::resetShape() noexcept
+{
+  initialize();
+}
+
+/*!
+  \details
+  The direction is normalized in the object space,
+  so a ray distance in the object space is the distance in the world space
+  multiplied by the scale.
+  */
+Ray Instance::toObjectSpace(const Ray& ray, Float* distance_scale) const noexcept
+{
+  auto origin = ray.origin();
+  auto direction = ray.direction();
+  Transformation::affineTransform(inverseTransformation(), &origin);
+  Transformation::affineTransform(inverseTransformation(), &direction);
+  *distance_scale = direction.norm();
+  ZISC_ASSERT(0.0 < *distance_scale, "The transformation is degenerate.");
+  return Ray::makeRay(origin, direction.normalized());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+ShapePoint Instance::toWorldSpace(const ShapePoint& point) const noexcept
+{
+  auto p = point.point();
+  Transformation::affineTransform(transformation(), &p);
+  auto n = point.normal();
+  Transformation::affineTransform(inverseTransformation().transposedMatrix(), &n);
+  n = n.normalized();
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+  const Float inverse_pdf = point.inversePdf() * calcAreaScale();
+  return ShapePoint{SampledPoint{p, inverse_pdf},
+                    n,
+                    tangent,
+                    bitangent,
+                    point.uv(),
+                    point.st()};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Instance::transformShape(const Matrix4x4& matrix) noexcept
+{
+  transformation_ = matrix * transformation_;
+  inverse_transformation_ = transformation_.inverseMatrix();
+}
+
+} // namespace nanairo
@@ -0,0 +1,120 @@
+/*!
+  \file instance.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_INSTANCE_HPP
+#define NANAIRO_INSTANCE_HPP
+
+// Nanairo
+#include "shape.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Aabb;
+class Bvh;
+class IntersectionInfo;
+class PathState;
+class Ray;
+class Sampler;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief An instance of the objects of a bottom level BVH
+  \details
+  The objects are shared by all instances and are kept in the object space.
+  A ray is transformed into the object space and
+  is traversed in the bottom level BVH.
+  */
+class Instance : public Shape
+{
+ public:
+  //! Create an instance of the objects of the BVH
+  Instance(const Bvh* bvh) noexcept;
+
+
+  //! Return the bounding box
+  Aabb boundingBox() const noexcept override;
+
+  //! Return the bottom level BVH
+  const Bvh& bvh() const noexcept;
+
+  //! Compute the hit attributes of the intersection
+  void finalizeIntersection(const Ray& ray,
+                            IntersectionInfo* intersection) const noexcept override;
+
+  //! Return the point and the normal by the st coordinate
+  ShapePoint getPoint(const Point2& st) const noexcept override;
+
+  //! Return the cost of a ray-instance intersection test
+  Float getTraversalCost() const noexcept override;
+
+  //! Return the transformation from the world space to the object space
+  const Matrix4x4& inverseTransformation() const noexcept;
+
+  //! Test ray-instance intersection
+  IntersectionTestResult testIntersection(
+      const Ray& ray,
+      IntersectionInfo* intersection) const noexcept override;
+
+  //! Test if the ray is occluded by the instance
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance) const noexcept override;
+
+  //! Return the transformation from the object space to the world space
+  const Matrix4x4& transformation() const noexcept;
+
+  //! Sample a point randomly on the surface of the instance
+  ShapePoint samplePoint(Sampler& sampler,
+                         const PathState& path_state) const noexcept override;
+
+  //! Return the type of the instance
+  ShapeType type() const noexcept override;
+
+ private:
+  //! Calculate the ratio of a surface area in the world space to the object space
+  Float calcAreaScale() const noexcept;
+
+  //! Calculate the surface area of the front side of the instance
+  Float calcSurfaceArea() const noexcept override;
+
+  //! Initialize
+  void initialize() noexcept;
+
+  //! Return the shape to the object space
+  void resetShape() noexcept override;
+
+  //! Transform the ray into the object space and return the scale of distance
+  Ray toObjectSpace(const Ray& ray, Float* distance_scale) const noexcept;
+
+  //! Transform the point of the object space into the world space
+  ShapePoint toWorldSpace(const ShapePoint& point) const noexcept;
+
+  //! Apply affine transformation
+  void transformShape(const Matrix4x4& matrix) noexcept override;
+
+
+  const Bvh* bvh_;
+  Matrix4x4 transformation_;
+  Matrix4x4 inverse_transformation_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "instance-inl.hpp"
+
+#endif // NANAIRO_INSTANCE_HPP
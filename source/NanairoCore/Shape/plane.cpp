@@ -92,21 +92,51 @@ Float Plane::getTraversalCost() const noexcept
   return 1.0;
 }
 
+/*!
+  \details
+  No detailed.
+  */
+void Plane::finalizeIntersection(const Ray& ray,
+                                 IntersectionInfo* intersection) const noexcept
+{
+  const Float cos_theta = -zisc::dot(normal(), ray.direction());
+  const bool is_back_face = cos_theta < 0.0;
+
+  const auto point = ray.origin() + (intersection->rayDistance() * ray.direction());
+  const auto n = (!is_back_face) ? normal() : -normal();
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  intersection->setPoint(point);
+  intersection->setNormal(n);
+  intersection->setTangent(tangent);
+  intersection->setBitangent(bitangent);
+  intersection->setAsBackFace(is_back_face);
+  intersection->setUv(intersection->st());
+}
+
 /*!
  */
 IntersectionTestResult Plane::testIntersection(
     const Ray& ray,
     IntersectionInfo* intersection) const noexcept
 {
+  Float t = 0.0;
+  Point2 st;
   const bool is_hit = testIntersection(vertex0(),
                                        edge(),
                                        normal(),
                                        ray,
                                        intersection->rayDistance(),
-                                       nullptr,
-                                       intersection);
+                                       &st,
+                                       &t);
+  if (is_hit) {
+    intersection->setRayDistance(t);
+    intersection->setSt(st);
+  }
   return (is_hit)
-      ? IntersectionTestResult{intersection->rayDistance()}
+      ? IntersectionTestResult{t}
       : IntersectionTestResult{};
 }
 
@@ -121,48 +151,41 @@ bool Plane::testIntersection(const Point3& v,
                              const Ray& ray,
                              const Float max_distance,
                              Point2* st,
-                             IntersectionInfo* intersection) noexcept
+                             Float* t) noexcept
 {
   const Float cos_theta = -zisc::dot(normal, ray.direction());
   // In the case that the ray is parallel to the normal
   if (cos_theta == 0.0)
     return false;
   // Calculate the time that ray hit plane
-  const Float t = zisc::dot(normal, ray.origin() - v) / cos_theta;
-  if (!zisc::isInOpenBounds(t, 0.0, max_distance))
+  const Float distance = zisc::dot(normal, ray.origin() - v) / cos_theta;
+  if (!zisc::isInOpenBounds(distance, 0.0, max_distance))
     return false;
   // Check if the hit point is in the plane
-  const auto point = ray.origin() + (t * ray.direction());
+  const auto point = ray.origin() + (distance * ray.direction());
   const auto am = point - v;
   const Float x = zisc::dot(am, e[0]);
   const Float y = zisc::dot(am, e[1]);
   const bool is_hit = zisc::isInClosedBounds(x, 0.0, e[0].squareNorm()) &&
                       zisc::isInClosedBounds(y, 0.0, e[1].squareNorm());
   if (is_hit) {
-    const Point2 st_coordinate{x / e[0].squareNorm(), y / e[1].squareNorm()};
     if (st != nullptr)
-      *st = st_coordinate;
-    if (intersection != nullptr) {
-      const bool is_back_face = cos_theta < 0.0;
-
-      const auto n = (!is_back_face) ? normal : -normal;
-      const auto tangents = Transformation::calcDefaultTangent(n);
-      const auto& tangent = std::get<0>(tangents);
-      const auto& bitangent = std::get<1>(tangents);
-
-      intersection->setPoint(point);
-      intersection->setNormal(n);
-      intersection->setTangent(tangent);
-      intersection->setBitangent(bitangent);
-      intersection->setAsBackFace(is_back_face);
-      intersection->setRayDistance(t);
-      intersection->setSt(st_coordinate);
-      intersection->setUv(st_coordinate);
-    }
+      *st = Point2{x / e[0].squareNorm(), y / e[1].squareNorm()};
+    if (t != nullptr)
+      *t = distance;
   }
   return is_hit;
 }
 
+/*!
+  \details
+  No detailed.
+  */
+bool Plane::testOcclusion(const Ray& ray, const Float max_distance) const noexcept
+{
+  return testIntersection(vertex0(), edge(), normal(), ray, max_distance, nullptr);
+}
+
 /*!
   \details
   No detailed.
@@ -189,6 +212,15 @@ ShapePoint Plane::samplePoint(Sampler& sampler,
                     st};
 }
 
+/*!
+  \details
+  No detailed.
+  */
+ShapeType Plane::type() const noexcept
+{
+  return ShapeType::kPlane;
+}
+
 /*!
   */
 Vector3 Plane::calcNormal() const noexcept
@@ -218,6 +250,15 @@ void Plane::initialize() noexcept
   setSurfaceArea(calcSurfaceArea());
 }
 
+/*!
+  \details
+  The shape is made again in the canonical space.
+  */
+void Plane::resetShape() noexcept
+{
+  *this = Plane{};
+}
+
 /*!
  \details
  No detailed.
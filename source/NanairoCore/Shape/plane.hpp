@@ -50,6 +50,10 @@ class Plane : public Shape
   //! Return the edges of the plane
   const std::array<Vector3, 2>& edge() const noexcept;
 
+  //! Compute the hit attributes of the intersection
+  void finalizeIntersection(const Ray& ray,
+                            IntersectionInfo* intersection) const noexcept override;
+
   //! Return the point and the normal by the st coordinate
   ShapePoint getPoint(const Point2& st) const noexcept override;
 
@@ -71,12 +75,19 @@ class Plane : public Shape
                                const Ray& ray, 
                                const Float max_distance,
                                Point2* st,
-                               IntersectionInfo* intersection = nullptr) noexcept;
+                               Float* t = nullptr) noexcept;
+
+  //! Test if the ray is occluded by the plane
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance) const noexcept override;
 
   //! Sample a point randomly on the surface of the plane 
   ShapePoint samplePoint(Sampler& sampler,
                          const PathState& path_state) const noexcept override;
 
+  //! Return the type of the plane
+  ShapeType type() const noexcept override;
+
   //! Return the vertex of the plane
   const Point3& vertex0() const noexcept;
 
@@ -90,6 +101,9 @@ class Plane : public Shape
   //! Initialize
   void initialize() noexcept;
 
+  //! Return the shape to the object space
+  void resetShape() noexcept override;
+
   //! Apply affine transformation
   void transformShape(const Matrix4x4& matrix) noexcept override;
 
@@ -19,7 +19,9 @@
 #include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "disk.hpp"
 #include "plane.hpp"
+#include "sphere.hpp"
 #include "triangle_mesh.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
@@ -44,11 +46,27 @@ Shape::~Shape() noexcept
 
 /*!
   \details
-  No detailed.
+  The point is sampled uniformly by area by default.
+  */
+Float Shape::getInversePdfFrom(const Point3& reference,
+                               const Point3& point) const noexcept
+{
+  static_cast<void>(reference);
+  static_cast<void>(point);
+  return surfaceArea();
+}
+
+/*!
+  \details
+  If threading is enabled, a large mesh is made by all threads.
+  Please see TriangleMesh::makeMeshes.
   */
 zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> Shape::makeShape(
     System& system,
-    const SettingNodeBase* settings) noexcept
+    const SettingNodeBase* settings,
+    const Matrix4x4& transformation,
+    const bool threading,
+    zisc::UniqueMemoryPointer<TriangleMesh>* mesh) noexcept
 {
   const auto object_settings = castNode<SingleObjectSettingNode>(settings);
 
@@ -62,7 +80,21 @@ zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> Shape::makeShape(
     break;
    }
    case ShapeType::kMesh: {
-    shape_list = TriangleMesh::makeMeshes(system, settings);
+    shape_list = TriangleMesh::makeMeshes(system,
+                                          settings,
+                                          transformation,
+                                          threading,
+                                          mesh);
+    break;
+   }
+   case ShapeType::kSphere: {
+    auto s = zisc::UniqueMemoryPointer<Sphere>::make(data_resource);
+    shape_list.emplace_back(std::move(s));
+    break;
+   }
+   case ShapeType::kDisk: {
+    auto s = zisc::UniqueMemoryPointer<Disk>::make(data_resource);
+    shape_list.emplace_back(std::move(s));
     break;
    }
    default: {
@@ -70,9 +102,37 @@ zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> Shape::makeShape(
     break;
    }
   }
+  // The shapes of a mesh are already made in the world space
+  if (object_settings->shapeType() != ShapeType::kMesh) {
+    for (auto& shape : shape_list)
+      shape->transform(transformation);
+  }
   return shape_list;
 }
 
+/*!
+  \details
+  The errors of the transformations don't accumulate
+  if the shape is transformed again from the object space.
+  */
+void Shape::resetTransformation() noexcept
+{
+  resetShape();
+  setSurfaceArea(calcSurfaceArea());
+}
+
+/*!
+  \details
+  The point is sampled uniformly by area by default.
+  */
+ShapePoint Shape::samplePointFrom(const Point3& reference,
+                                  Sampler& sampler,
+                                  const PathState& path_state) const noexcept
+{
+  static_cast<void>(reference);
+  return samplePoint(sampler, path_state);
+}
+
 /*!
   \details
   No detailed.
@@ -35,6 +35,7 @@ class PathState;
 class Ray;
 class Sampler;
 class System;
+class TriangleMesh;
 
 //! \addtogroup Core
 //! \{
@@ -44,7 +45,11 @@ class System;
 enum class ShapeType : uint32
 {
   kPlane                      = zisc::Fnv1aHash32::hash("Plane"),
-  kMesh                       = zisc::Fnv1aHash32::hash("Mesh")
+  kMesh                       = zisc::Fnv1aHash32::hash("Mesh"),
+  kSphere                     = zisc::Fnv1aHash32::hash("Sphere"),
+  kDisk                       = zisc::Fnv1aHash32::hash("Disk"),
+  kBilinearPatch              = zisc::Fnv1aHash32::hash("BilinearPatch"), //!< Made by a mesh
+  kInstance                   = zisc::Fnv1aHash32::hash("Instance") //!< Made by the world
 };
 
 /*!
@@ -64,39 +69,69 @@ class Shape
   //! Return the bounding box
   virtual Aabb boundingBox() const noexcept = 0;
 
+  //! Compute the hit attributes of the intersection found by testIntersection
+  virtual void finalizeIntersection(
+      const Ray& ray,
+      IntersectionInfo* intersection) const noexcept = 0;
+
   //! Return the point and the normal by the st coordinate
   virtual ShapePoint getPoint(const Point2& st) const noexcept = 0;
 
+  //! Return the inverse pdf by area of the point sampled for the reference point
+  virtual Float getInversePdfFrom(const Point3& reference,
+                                  const Point3& point) const noexcept;
+
   //! Return the ray traversal cost
   virtual Float getTraversalCost() const noexcept = 0;
 
-  //! Make geometries
+  //! Make transformed geometries, the vertex data of a mesh is returned through mesh
   static zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> makeShape(
       System& system,
-      const SettingNodeBase* settings) noexcept;
+      const SettingNodeBase* settings,
+      const Matrix4x4& transformation,
+      const bool threading,
+      zisc::UniqueMemoryPointer<TriangleMesh>* mesh) noexcept;
 
   //! Return the surface area of the shape
   Float surfaceArea() const noexcept;
 
-  //! Test ray-shape intersection
+  //! Test ray-shape intersection and write the ray distance and st coordinate
   virtual IntersectionTestResult testIntersection(
       const Ray& ray,
       IntersectionInfo* intersection) const noexcept = 0;
 
+  //! Test if the ray is occluded by the shape before the max distance
+  virtual bool testOcclusion(const Ray& ray,
+                             const Float max_distance) const noexcept = 0;
+
   //! Sample a point randomly on the surface of the shape
   virtual ShapePoint samplePoint(Sampler& sampler,
                                  const PathState& path_state) const noexcept = 0;
 
+  //! Sample a point on the surface of the shape for the reference point
+  virtual ShapePoint samplePointFrom(const Point3& reference,
+                                     Sampler& sampler,
+                                     const PathState& path_state) const noexcept;
+
   //! Set surface area of shape
   void setSurfaceArea(const Float surface_area) noexcept;
 
   //! Apply affine transformation
   void transform(const Matrix4x4& matrix) noexcept;
 
+  //! Return the shape to the object space
+  void resetTransformation() noexcept;
+
+  //! Return the type of the shape
+  virtual ShapeType type() const noexcept = 0;
+
  protected:
   //! Calculate the surface area of the front side of the shape
   virtual Float calcSurfaceArea() const noexcept = 0;
 
+  //! Return the shape to the object space
+  virtual void resetShape() noexcept = 0;
+
   //! Apply affine transformation
   virtual void transformShape(const Matrix4x4& matrix) noexcept = 0;
 
@@ -0,0 +1,38 @@
+/*!
+  \file sphere-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SPHERE_INL_HPP
+#define NANAIRO_SPHERE_INL_HPP
+
+#include "sphere.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+const Point3& Sphere::center() const noexcept
+{
+  return center_;
+}
+
+/*!
+  */
+inline
+Float Sphere::radius() const noexcept
+{
+  return radius_;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_SPHERE_INL_HPP
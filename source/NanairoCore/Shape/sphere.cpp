@@ -0,0 +1,349 @@
+/*!
+  \file sphere.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "sphere.hpp"
+// Standard C++ library
+#include <cmath>
+#include <limits>
+#include <tuple>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/matrix.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "shape.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Sampling/sampled_point.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+Sphere::Sphere() noexcept :
+    center_{0.0, 0.0, 0.0},
+    radius_{0.5}
+{
+  setSurfaceArea(calcSurfaceArea());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+Aabb Sphere::boundingBox() const noexcept
+{
+  const Vector3 r{radius(), radius(), radius()};
+  return Aabb{center() - r, center() + r};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Sphere::finalizeIntersection(const Ray& ray,
+                                  IntersectionInfo* intersection) const noexcept
+{
+  const auto point = ray.origin() + (intersection->rayDistance() * ray.direction());
+  const auto normal = (point - center()).normalized();
+  const Float cos_theta = -zisc::dot(normal, ray.direction());
+  const bool is_back_face = cos_theta < 0.0;
+
+  const auto n = (!is_back_face) ? normal : -normal;
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  intersection->setPoint(point);
+  intersection->setNormal(n);
+  intersection->setTangent(tangent);
+  intersection->setBitangent(bitangent);
+  intersection->setAsBackFace(is_back_face);
+  intersection->setUv(intersection->st());
+}
+
+/*!
+  \details
+  The points outside the cone can't be sampled from the reference point.
+  */
+Float Sphere::getInversePdfFrom(const Point3& reference,
+                                const Point3& point) const noexcept
+{
+  const Float square_distance = (center() - reference).squareNorm();
+  if (square_distance <= zisc::power<2>(radius()))
+    return surfaceArea();
+
+  const auto v = reference - point;
+  const Float diff2 = v.squareNorm();
+  const Float cos_theta = zisc::dot((point - center()).normalized(), v) /
+                          zisc::sqrt(diff2);
+  if (cos_theta <= 0.0)
+    return std::numeric_limits<Float>::max();
+  const Float solid_angle = 2.0 * zisc::kPi<Float> * calcConeAngle(square_distance);
+  return solid_angle * diff2 / cos_theta;
+}
+
+/*!
+  */
+ShapePoint Sphere::getPoint(const Point2& st) const noexcept
+{
+  const Float phi = 2.0 * zisc::kPi<Float> * st[0];
+  const Float theta = zisc::kPi<Float> * st[1];
+  const Float sin_theta = zisc::sin(theta);
+  const Vector3 normal{sin_theta * zisc::cos(phi),
+                       sin_theta * zisc::sin(phi),
+                       zisc::cos(theta)};
+  return makePoint(normal, surfaceArea());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+Float Sphere::getTraversalCost() const noexcept
+{
+  return 1.0;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+IntersectionTestResult Sphere::testIntersection(
+    const Ray& ray,
+    IntersectionInfo* intersection) const noexcept
+{
+  Float t = 0.0;
+  const bool is_hit = testIntersection(ray, intersection->rayDistance(), &t);
+  if (is_hit) {
+    const auto point = ray.origin() + t * ray.direction();
+    const auto normal = (point - center()).normalized();
+    intersection->setRayDistance(t);
+    intersection->setSt(calcSt(normal));
+  }
+  return (is_hit)
+      ? IntersectionTestResult{t}
+      : IntersectionTestResult{};
+}
+
+/*!
+  \details
+  The discriminant is computed from the distance between the center and
+  the ray instead of the coefficients of the quadratic equation.
+  Please see "Precision Improvements for Ray/Sphere Intersection".
+  */
+bool Sphere::testIntersection(const Ray& ray,
+                              const Float max_distance,
+                              Float* t) const noexcept
+{
+  const auto& d = ray.direction();
+  const auto f = ray.origin() - center();
+  const Float b = -zisc::dot(f, d);
+  const auto l = f + b * d;
+  const Float r2 = zisc::power<2>(radius());
+  const Float discriminant = r2 - l.squareNorm();
+  if (discriminant < 0.0)
+    return false;
+
+  const Float q = b + std::copysign(zisc::sqrt(discriminant), b);
+  if (q == 0.0)
+    return false;
+  const Float c = f.squareNorm() - r2;
+  const Float t0 = zisc::min(c / q, q);
+  const Float t1 = zisc::max(c / q, q);
+
+  const bool is_hit = zisc::isInOpenBounds(t0, 0.0, max_distance) ||
+                      zisc::isInOpenBounds(t1, 0.0, max_distance);
+  if (is_hit)
+    *t = (0.0 < t0) ? t0 : t1;
+  return is_hit;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+bool Sphere::testOcclusion(const Ray& ray, const Float max_distance) const noexcept
+{
+  Float t = 0.0;
+  return testIntersection(ray, max_distance, &t);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+ShapePoint Sphere::samplePoint(Sampler& sampler,
+                               const PathState& path_state) const noexcept
+{
+  const auto r = sampler.draw2D(path_state);
+  const Float cos_theta = 1.0 - 2.0 * r[0];
+  const Float sin_theta = zisc::sqrt(zisc::max(0.0, 1.0 - zisc::power<2>(cos_theta)));
+  const Float phi = 2.0 * zisc::kPi<Float> * r[1];
+  const Vector3 normal{sin_theta * zisc::cos(phi),
+                       sin_theta * zisc::sin(phi),
+                       cos_theta};
+  return makePoint(normal, surfaceArea());
+}
+
+/*!
+  \details
+  A direction is sampled uniformly in the cone which the sphere subtends,
+  and the point where the direction hits the sphere first is returned with
+  the pdf converted to the area measure. If the reference point is in
+  the sphere, the point is sampled uniformly by area.
+  Please see "Physically Based Rendering: From Theory to Implementation,
+  4th edition".
+  */
+ShapePoint Sphere::samplePointFrom(const Point3& reference,
+                                   Sampler& sampler,
+                                   const PathState& path_state) const noexcept
+{
+  const Float square_distance = (center() - reference).squareNorm();
+  const Float r2 = zisc::power<2>(radius());
+  if (square_distance <= r2)
+    return samplePoint(sampler, path_state);
+
+  const Float sin2_theta_max = r2 / square_distance;
+  const Float sin_theta_max = zisc::sqrt(sin2_theta_max);
+  const Float one_minus_cos_max = calcConeAngle(square_distance);
+
+  // Sample a direction in the cone
+  const auto r = sampler.draw2D(path_state);
+  const Float one_minus_cos = r[0] * one_minus_cos_max;
+  const Float cos_theta = 1.0 - one_minus_cos;
+  const Float sin2_theta = one_minus_cos * (2.0 - one_minus_cos);
+  const Float phi = 2.0 * zisc::kPi<Float> * r[1];
+
+  // Compute the angle from the center to the point
+  const Float cos_alpha = sin2_theta / sin_theta_max +
+      cos_theta * zisc::sqrt(zisc::max(0.0, 1.0 - sin2_theta / sin2_theta_max));
+  const Float sin_alpha = zisc::sqrt(zisc::max(0.0, 1.0 - zisc::power<2>(cos_alpha)));
+
+  const auto w = (center() - reference).normalized();
+  const auto axes = Transformation::calcDefaultTangent(w);
+  const auto& x = std::get<0>(axes);
+  const auto& y = std::get<1>(axes);
+  const auto normal = -(sin_alpha * zisc::cos(phi) * x +
+                        sin_alpha * zisc::sin(phi) * y +
+                        cos_alpha * w);
+
+  auto point = makePoint(normal, 1.0);
+  const auto v = reference - point.point();
+  const Float diff2 = v.squareNorm();
+  const Float cos_light = zisc::dot(normal, v) / zisc::sqrt(diff2);
+  const Float solid_angle = 2.0 * zisc::kPi<Float> * one_minus_cos_max;
+  const Float inverse_pdf = (0.0 < cos_light)
+      ? solid_angle * diff2 / cos_light
+      : std::numeric_limits<Float>::max();
+  point.setSampledPoint(SampledPoint{point.point(), inverse_pdf});
+  return point;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+ShapeType Sphere::type() const noexcept
+{
+  return ShapeType::kSphere;
+}
+
+// private member function
+
+/*!
+  \details
+  1 - cos(theta max) is approximated by sin^2(theta max) / 2
+  for a small cone to avoid the cancellation.
+  */
+Float Sphere::calcConeAngle(const Float square_distance) const noexcept
+{
+  const Float sin2_theta_max = zisc::power<2>(radius()) / square_distance;
+  // sin^2(1.5 degree)
+  constexpr Float small_angle = 0.00068523;
+  return (sin2_theta_max < small_angle)
+      ? 0.5 * sin2_theta_max
+      : 1.0 - zisc::sqrt(1.0 - sin2_theta_max);
+}
+
+/*!
+  */
+Point2 Sphere::calcSt(const Vector3& normal) noexcept
+{
+  Float s = std::atan2(normal[1], normal[0]) / (2.0 * zisc::kPi<Float>);
+  if (s < 0.0)
+    s = s + 1.0;
+  const Float theta = std::acos(zisc::clamp(normal[2], -1.0, 1.0));
+  return Point2{s, theta / zisc::kPi<Float>};
+}
+
+/*!
+  */
+Float Sphere::calcSurfaceArea() const noexcept
+{
+  return 4.0 * zisc::kPi<Float> * zisc::power<2>(radius());
+}
+
+/*!
+  */
+ShapePoint Sphere::makePoint(const Vector3& normal,
+                             const Float inverse_pdf) const noexcept
+{
+  const auto point = center() + radius() * normal;
+  const auto st = calcSt(normal);
+
+  const auto tangents = Transformation::calcDefaultTangent(normal);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  return ShapePoint{SampledPoint{point, inverse_pdf},
+                    normal,
+                    tangent,
+                    bitangent,
+                    st,
+                    st};
+}
+
+/*!
+  \details
+  The shape is made again in the canonical space.
+  */
+void Sphere::resetShape() noexcept
+{
+  *this = Sphere{};
+}
+
+/*!
+  \details
+  The radius is scaled by the cube root of the volume ratio,
+  which is exact for uniform scaling.
+  */
+void Sphere::transformShape(const Matrix4x4& matrix) noexcept
+{
+  const Matrix3x3 linear_part{matrix(0, 0), matrix(0, 1), matrix(0, 2),
+                              matrix(1, 0), matrix(1, 1), matrix(1, 2),
+                              matrix(2, 0), matrix(2, 1), matrix(2, 2)};
+  const Float determinant = linear_part.determinant();
+  Transformation::affineTransform(matrix, &center_);
+  radius_ = radius_ * std::cbrt(zisc::abs(determinant));
+}
+
+} // namespace nanairo
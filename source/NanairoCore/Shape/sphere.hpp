@@ -0,0 +1,126 @@
+/*!
+  \file sphere.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SPHERE_HPP
+#define NANAIRO_SPHERE_HPP
+
+// Nanairo
+#include "shape.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Aabb;
+class IntersectionInfo;
+class PathState;
+class Ray;
+class Sampler;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief 3D sphere
+  \details
+  The default sphere has the radius 0.5 at the origin.
+  The st coordinate is the azimuth and the polar angle from z axis
+  normalized to [0, 1].
+  */
+class Sphere : public Shape
+{
+ public:
+  //! Initialize
+  Sphere() noexcept;
+
+
+  //! Return the bounding box
+  Aabb boundingBox() const noexcept override;
+
+  //! Return the center of the sphere
+  const Point3& center() const noexcept;
+
+  //! Compute the hit attributes of the intersection
+  void finalizeIntersection(const Ray& ray,
+                            IntersectionInfo* intersection) const noexcept override;
+
+  //! Return the inverse pdf by area of the point sampled for the reference point
+  Float getInversePdfFrom(const Point3& reference,
+                          const Point3& point) const noexcept override;
+
+  //! Return the point and the normal by the st coordinate
+  ShapePoint getPoint(const Point2& st) const noexcept override;
+
+  //! Return the cost of a ray-sphere intersection test
+  Float getTraversalCost() const noexcept override;
+
+  //! Return the radius of the sphere
+  Float radius() const noexcept;
+
+  //! Test ray-sphere intersection
+  IntersectionTestResult testIntersection(
+      const Ray& ray,
+      IntersectionInfo* intersection) const noexcept override;
+
+  //! Test ray-sphere intersection and return the distance
+  bool testIntersection(const Ray& ray,
+                        const Float max_distance,
+                        Float* t) const noexcept;
+
+  //! Test if the ray is occluded by the sphere
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance) const noexcept override;
+
+  //! Sample a point randomly on the surface of the sphere
+  ShapePoint samplePoint(Sampler& sampler,
+                         const PathState& path_state) const noexcept override;
+
+  //! Sample a point in the cone of the sphere seen from the reference point
+  ShapePoint samplePointFrom(const Point3& reference,
+                             Sampler& sampler,
+                             const PathState& path_state) const noexcept override;
+
+  //! Return the type of the sphere
+  ShapeType type() const noexcept override;
+
+ private:
+  //! Calculate 1 - cos(theta max) of the cone seen from the distance
+  Float calcConeAngle(const Float square_distance) const noexcept;
+
+  //! Calculate the st coordinate of the point by the normal
+  static Point2 calcSt(const Vector3& normal) noexcept;
+
+  //! Calculate the surface area of the sphere
+  Float calcSurfaceArea() const noexcept override;
+
+  //! Make the point data by the normal
+  ShapePoint makePoint(const Vector3& normal, const Float inverse_pdf) const noexcept;
+
+  //! Return the shape to the object space
+  void resetShape() noexcept override;
+
+  //! Apply affine transformation
+  void transformShape(const Matrix4x4& matrix) noexcept override;
+
+
+  Point3 center_;
+  Float radius_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "sphere-inl.hpp"
+
+#endif // NANAIRO_SPHERE_HPP
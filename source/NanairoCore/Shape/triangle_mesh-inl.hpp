@@ -0,0 +1,271 @@
+/*!
+  \file triangle_mesh-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRIANGLE_MESH_INL_HPP
+#define NANAIRO_TRIANGLE_MESH_INL_HPP
+
+#include "triangle_mesh.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+MeshCompression TriangleMesh::compression() const noexcept
+{
+  return compression_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+auto TriangleMesh::face(const uint32 index) const noexcept -> const FaceIndex&
+{
+  ZISC_ASSERT(index < face_list_.size(), "The face index is out of range.");
+  return face_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+bool TriangleMesh::hasNormal() const noexcept
+{
+  return (0 < normal_list_.size()) || (0 < encoded_normal_list_.size());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+bool TriangleMesh::hasUv() const noexcept
+{
+  return (0 < uv_list_.size()) || (0 < encoded_uv_list_.size());
+}
+
+/*!
+  \details
+  A compressed normal is transformed by the normal matrix of the mesh.
+  */
+inline
+Vector3 TriangleMesh::normal(const uint32 index) const noexcept
+{
+  ZISC_ASSERT(hasNormal(), "The mesh doesn't have normals.");
+  ZISC_ASSERT(index < numOfVertices(), "The normal index is out of range.");
+  if (compression() == MeshCompression::kNone)
+    return normal_list_[index];
+  const auto n = normal_matrix_ * decodeNormal(encoded_normal_list_[index]);
+  return (0.0 < n.squareNorm()) ? n.normalized() : n;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint32 TriangleMesh::numOfFaces() const noexcept
+{
+  return zisc::cast<uint32>(face_list_.size());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint32 TriangleMesh::numOfVertices() const noexcept
+{
+  const auto num_of_vertices =
+      (compression() == MeshCompression::kQuantized16) ? position16_list_.size() :
+      (compression() == MeshCompression::kQuantized32) ? position32_list_.size()
+                                                       : vertex_list_.size();
+  return zisc::cast<uint32>(num_of_vertices);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint32 TriangleMesh::numOfQuads() const noexcept
+{
+  return zisc::cast<uint32>(quad_list_.size());
+}
+
+/*!
+  \details
+  Smaller meshes are made by a thread since the objects are made in parallel.
+  */
+inline
+constexpr uint32 TriangleMesh::parallelConstructionSize() noexcept
+{
+  return 1u << 16;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+auto TriangleMesh::quad(const uint32 index) const noexcept -> const QuadIndex&
+{
+  ZISC_ASSERT(index < quad_list_.size(), "The quad index is out of range.");
+  return quad_list_[index];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+Point2 TriangleMesh::uv(const uint32 index) const noexcept
+{
+  ZISC_ASSERT(hasUv(), "The mesh doesn't have UVs.");
+  ZISC_ASSERT(index < numOfVertices(), "The UV index is out of range.");
+  if (compression() == MeshCompression::kNone)
+    return uv_list_[index];
+  const auto& uv = encoded_uv_list_[index];
+  return Point2{decodeHalf(uv[0]), decodeHalf(uv[1])};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+Point3 TriangleMesh::vertex(const uint32 index) const noexcept
+{
+  ZISC_ASSERT(index < numOfVertices(), "The vertex index is out of range.");
+  switch (compression()) {
+   case MeshCompression::kQuantized16: {
+    return decodePosition(position16_list_[index]);
+   }
+   case MeshCompression::kQuantized32: {
+    return decodePosition(position32_list_[index]);
+   }
+   case MeshCompression::kNone:
+   default: {
+    break;
+   }
+  }
+  return vertex_list_[index];
+}
+
+/*!
+  \details
+  Subnormal numbers are decoded, and infinities are decoded as
+  the largest numbers since they aren't encoded.
+  */
+inline
+Float TriangleMesh::decodeHalf(const uint16 value) noexcept
+{
+  const int exponent = zisc::cast<int>((value >> 10) & 0x1fu);
+  const uint32 mantissa = zisc::cast<uint32>(value & 0x3ffu);
+  const Float magnitude = (exponent == 0)
+      ? std::ldexp(zisc::cast<Float>(mantissa), -24)
+      : std::ldexp(zisc::cast<Float>(mantissa | 0x400u), exponent - 25);
+  return ((value & 0x8000u) != 0) ? -magnitude : magnitude;
+}
+
+/*!
+  \details
+  Please see "A Survey of Efficient Representations for Independent Unit Vectors"
+  for the details of the octahedral encoding.
+  */
+inline
+Vector3 TriangleMesh::decodeNormal(const EncodedNormal& value) noexcept
+{
+  if ((value[0] == 0) || (value[1] == 0))
+    return Vector3{0.0, 0.0, 0.0};
+
+  constexpr Float k = 2.0 / zisc::cast<Float>(std::numeric_limits<uint16>::max() - 1);
+  const Float x = k * zisc::cast<Float>(value[0] - 1) - 1.0;
+  const Float y = k * zisc::cast<Float>(value[1] - 1) - 1.0;
+  const Float z = 1.0 - (zisc::abs(x) + zisc::abs(y));
+  // The lower hemisphere is folded over the diagonals
+  const Vector3 n = (z < 0.0)
+      ? Vector3{(1.0 - zisc::abs(y)) * ((x < 0.0) ? -1.0 : 1.0),
+                (1.0 - zisc::abs(x)) * ((y < 0.0) ? -1.0 : 1.0),
+                z}
+      : Vector3{x, y, z};
+  return n.normalized();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <typename Integer> inline
+Point3 TriangleMesh::decodePosition(const std::array<Integer, 3>& value) const noexcept
+{
+  return grid_origin_ + (zisc::cast<Float>(value[0]) * grid_axis_[0] +
+                         zisc::cast<Float>(value[1]) * grid_axis_[1] +
+                         zisc::cast<Float>(value[2]) * grid_axis_[2]);
+}
+
+/*!
+  \details
+  The grid has the origin at the min point of the bounding box and
+  the max integer is mapped to the max point.
+  The positions are rounded to the nearest grid points,
+  so a vertex shared by faces is decoded to the same point and
+  the mesh remains watertight.
+  */
+template <typename Integer> inline
+void TriangleMesh::quantizePositions(
+    zisc::pmr::vector<std::array<Integer, 3>>* position_list) noexcept
+{
+  constexpr Float max_integer = zisc::cast<Float>(std::numeric_limits<Integer>::max());
+  position_list->resize(vertex_list_.size());
+  for (uint axis = 0; axis < 3; ++axis) {
+    Float min_value = std::numeric_limits<Float>::max();
+    Float max_value = std::numeric_limits<Float>::lowest();
+    for (const auto& v : vertex_list_) {
+      min_value = zisc::min(min_value, v[axis]);
+      max_value = zisc::max(max_value, v[axis]);
+    }
+    const Float step = (min_value < max_value)
+        ? (max_value - min_value) / max_integer
+        : 0.0;
+    grid_origin_[axis] = min_value;
+    grid_axis_[axis] = Vector3{0.0, 0.0, 0.0};
+    grid_axis_[axis][axis] = step;
+    for (std::size_t index = 0; index < vertex_list_.size(); ++index) {
+      Float q = (0.0 < step)
+          ? std::round((vertex_list_[index][axis] - min_value) / step)
+          : 0.0;
+      q = zisc::min(zisc::max(q, zisc::cast<Float>(0.0)), max_integer);
+      (*position_list)[index][axis] = zisc::cast<Integer>(q);
+    }
+  }
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TRIANGLE_MESH_INL_HPP
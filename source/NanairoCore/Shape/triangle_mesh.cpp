@@ -9,16 +9,23 @@
 
 #include "triangle_mesh.hpp"
 // Standard C++ library
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <utility>
 #include <vector>
 // Zisc
 #include "zisc/error.hpp"
+#include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "bilinear_patch.hpp"
 #include "flat_triangle.hpp"
 #include "shape.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
@@ -36,72 +43,522 @@ namespace nanairo  {
   \details
   No detailed.
   */
+TriangleMesh::TriangleMesh(const MeshParameters& parameters,
+                           zisc::pmr::memory_resource* data_resource,
+                           zisc::pmr::memory_resource* work_resource) noexcept :
+    vertex_list_{data_resource},
+    uv_list_{data_resource},
+    normal_list_{data_resource},
+    face_list_{data_resource},
+    quad_list_{data_resource},
+    position16_list_{data_resource},
+    position32_list_{data_resource},
+    encoded_uv_list_{data_resource},
+    encoded_normal_list_{data_resource},
+    grid_origin_{0.0, 0.0, 0.0},
+    grid_axis_{{Vector3{1.0, 0.0, 0.0},
+                Vector3{0.0, 1.0, 0.0},
+                Vector3{0.0, 0.0, 1.0}}},
+    normal_matrix_{1.0, 0.0, 0.0,
+                   0.0, 1.0, 0.0,
+                   0.0, 0.0, 1.0},
+    compression_{MeshCompression::kNone}
+{
+  initialize(parameters, work_resource);
+}
+
+/*!
+  \details
+  The mesh data is made in the data resource and is returned through mesh,
+  it must live as long as the shapes.
+  The shared vertex data is transformed once before the shapes are made,
+  so the shapes are made in the world space and needn't be transformed.
+  If threading is enabled, a large mesh is transformed and made by
+  the ranges of the faces in parallel,
+  so the caller mustn't be a task of the thread manager.
+  A compressed mesh is transformed by the grid of the positions at once.
+  The curved quads of an emissive mesh are split into triangles,
+  because the points on lights are sampled uniformly by area.
+  */
 zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> TriangleMesh::makeMeshes(
     System& system,
-    const SettingNodeBase* settings) noexcept
+    const SettingNodeBase* settings,
+    const Matrix4x4& transformation,
+    const bool threading,
+    zisc::UniqueMemoryPointer<TriangleMesh>* mesh) noexcept
 {
+  ZISC_ASSERT(mesh != nullptr, "The mesh is null.");
   const auto object_settings = castNode<SingleObjectSettingNode>(settings);
 
   auto data_resource = &system.dataMemoryManager();
   auto work_resource = settings->workResource();
 
   const auto& parameters = object_settings->meshParameters();
-  zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> mesh_list{work_resource};
-  mesh_list.reserve(parameters.face_list_.size());
-
-  //! \todo Add smoothed mesh
-  //! \todo Add quadrangle mesh
-  for (const auto& face : parameters.face_list_) {
-    const auto vertices = getVertices(parameters, face);
-    // Skip invisible mesh
-    if (FlatTriangle::calcSurfaceArea(vertices[0], vertices[1], vertices[2]) <= 0.0)
-      continue;
-    auto mesh = zisc::UniqueMemoryPointer<FlatTriangle>::make(data_resource,
-                                                              vertices[0],
-                                                              vertices[1],
-                                                              vertices[2]);
-    if (face.hasVuv()) {
-      const auto vuvs = getUvs(parameters, face);
-      mesh->setUv(vuvs[0], vuvs[1], vuvs[2]);
+  const bool is_parallel = threading &&
+      (parallelConstructionSize() <= parameters.face_list_.size());
+  auto& threads = system.threadManager();
+  const uint num_of_threads = threads.numOfThreads();
+  auto process = [&threads, num_of_threads, work_resource, is_parallel]
+  (const uint32 size, auto& func)
+  {
+    if (is_parallel) {
+      auto process_range = [&func, size, num_of_threads](const uint task_id)
+      {
+        const auto range = System::calcTaskRange(size, num_of_threads, task_id);
+        func(range[0], range[1]);
+      };
+      constexpr uint start = 0;
+      auto result = threads.enqueueLoop(process_range,
+                                        start,
+                                        num_of_threads,
+                                        work_resource);
+      result.wait();
     }
-    mesh_list.emplace_back(std::move(mesh));
+    else {
+      func(0, size);
+    }
+  };
+
+  *mesh = zisc::UniqueMemoryPointer<TriangleMesh>::make(data_resource,
+                                                        parameters,
+                                                        data_resource,
+                                                        work_resource);
+  auto& m = **mesh;
+
+  // Transform the vertices
+  if (m.compression() != MeshCompression::kNone) {
+    m.transform(transformation);
+  }
+  else {
+    const auto normal_matrix = transformation.inverseMatrix().transposedMatrix();
+    auto transform_vertices =
+    [&m, &transformation, &normal_matrix](const uint32 begin, const uint32 end)
+    {
+      m.transformVertices(transformation, normal_matrix, begin, end);
+    };
+    process(m.numOfVertices(), transform_vertices);
+  }
+  if (object_settings->isEmissiveObject())
+    m.splitQuads(true);
+
+  // Make the shapes
+  const uint32 num_of_faces = m.numOfFaces();
+  const uint32 num_of_shapes = num_of_faces + m.numOfQuads();
+  zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> mesh_list{work_resource};
+  mesh_list.resize(num_of_shapes);
+  {
+    const TriangleMesh* mesh_data = &m;
+    auto make_shapes =
+    [data_resource, mesh_data, num_of_faces, &mesh_list](const uint32 begin,
+                                                         const uint32 end)
+    {
+      for (uint32 index = begin; index < end; ++index) {
+        if (index < num_of_faces) {
+          mesh_list[index] = zisc::UniqueMemoryPointer<FlatTriangle>::make(
+              data_resource,
+              mesh_data,
+              index);
+        }
+        else {
+          mesh_list[index] = zisc::UniqueMemoryPointer<BilinearPatch>::make(
+              data_resource,
+              mesh_data,
+              index - num_of_faces);
+        }
+      }
+    };
+    process(num_of_shapes, make_shapes);
   }
   return mesh_list;
 }
 
 /*!
+  \details
+  The vertex data is made in the object space from the parameters which
+  the mesh was made from, and the transformation is applied to it.
+  So the errors of the transformations don't accumulate over updates.
+  The faces aren't changed.
   */
-std::array<Point3, 3> TriangleMesh::getVertices(
+void TriangleMesh::setTransformation(
     const MeshParameters& parameters,
-    const Face& face) noexcept
+    const Matrix4x4& transformation,
+    zisc::pmr::memory_resource* work_resource) noexcept
 {
-  std::array<Point3, 3> vertices;
+  TriangleMesh mesh{parameters, work_resource, work_resource};
+  ZISC_ASSERT((mesh.compression() == compression()) &&
+              (mesh.numOfVertices() == numOfVertices()),
+              "The parameters don't match the mesh.");
+  mesh.transform(transformation);
+  if (compression() != MeshCompression::kNone) {
+    grid_origin_ = mesh.grid_origin_;
+    grid_axis_ = mesh.grid_axis_;
+    normal_matrix_ = mesh.normal_matrix_;
+  }
+  else {
+    vertex_list_ = mesh.vertex_list_;
+    normal_list_ = mesh.normal_list_;
+  }
+}
+
+/*!
+  \details
+  A quad is split along the diagonal which makes the two triangles
+  face the same side as much as possible.
+  */
+void TriangleMesh::splitQuads(const bool split_curved_quads) noexcept
+{
+  auto calc_cos = [](const Point3& p0,
+                     const Point3& p1,
+                     const Point3& p2,
+                     const Point3& p3)
   {
-    const auto& vertex_indices = face.triangleVertexIndices();
-    for (uint i = 0; i < 3; ++i) {
-      auto& vertex = vertices[i];
-      const auto& vertex_data = parameters.vertex_list_[vertex_indices[i]];
-      for (uint axis = 0; axis < 3; ++axis)
-        vertex[axis] = zisc::cast<Float>(vertex_data[axis]);
+    // The cosine between the normals of the triangles (p0, p1, p2), (p0, p2, p3)
+    const auto n1 = zisc::cross(p1 - p0, p2 - p0);
+    const auto n2 = zisc::cross(p2 - p0, p3 - p0);
+    const Float n = n1.squareNorm() * n2.squareNorm();
+    return (0.0 < n) ? zisc::dot(n1, n2) / zisc::sqrt(n) : 1.0;
+  };
+
+  uint32 num_of_quads = 0;
+  for (uint32 index = 0; index < numOfQuads(); ++index) {
+    const QuadIndex q = quad(index);
+    const auto& p0 = vertex(q[0]);
+    const auto& p1 = vertex(q[1]);
+    const auto& p2 = vertex(q[2]);
+    const auto& p3 = vertex(q[3]);
+    const bool is_patch = (split_curved_quads)
+        ? BilinearPatch::isPlanar(p0, p1, p2, p3)
+        : BilinearPatch::isRegular(p0, p1, p2, p3);
+    if (is_patch) {
+      quad_list_[num_of_quads++] = q;
+    }
+    else if (calc_cos(p1, p2, p3, p0) <= calc_cos(p0, p1, p2, p3)) {
+      face_list_.emplace_back(FaceIndex{{q[0], q[1], q[2]}});
+      face_list_.emplace_back(FaceIndex{{q[0], q[2], q[3]}});
+    }
+    else {
+      face_list_.emplace_back(FaceIndex{{q[1], q[2], q[3]}});
+      face_list_.emplace_back(FaceIndex{{q[1], q[3], q[0]}});
     }
   }
-  return vertices;
+  quad_list_.resize(num_of_quads);
 }
 
 /*!
+  \details
+  No detailed.
+  */
+void TriangleMesh::transform(const Matrix4x4& matrix) noexcept
+{
+  const auto normal_matrix = matrix.inverseMatrix().transposedMatrix();
+  if (compression() != MeshCompression::kNone)
+    transformQuantization(matrix, normal_matrix);
+  else
+    transformVertices(matrix, normal_matrix, 0, numOfVertices());
+}
+
+/*!
+  \details
+  The uncompressed data is released after the compression.
+  */
+void TriangleMesh::compress(const MeshCompression compression) noexcept
+{
+  if ((compression == MeshCompression::kNone) || vertex_list_.empty())
+    return;
+
+  switch (compression) {
+   case MeshCompression::kQuantized16: {
+    quantizePositions(&position16_list_);
+    break;
+   }
+   case MeshCompression::kQuantized32: {
+    quantizePositions(&position32_list_);
+    break;
+   }
+   case MeshCompression::kNone:
+   default: {
+    ZISC_ASSERT(false, "The compression isn't supported.");
+    break;
+   }
+  }
+  encoded_uv_list_.reserve(uv_list_.size());
+  for (const auto& uv : uv_list_)
+    encoded_uv_list_.emplace_back(EncodedUv{{encodeHalf(uv[0]), encodeHalf(uv[1])}});
+  encoded_normal_list_.reserve(normal_list_.size());
+  for (const auto& normal : normal_list_)
+    encoded_normal_list_.emplace_back(encodeNormal(normal));
+  compression_ = compression;
+
+  vertex_list_.clear();
+  vertex_list_.shrink_to_fit();
+  uv_list_.clear();
+  uv_list_.shrink_to_fit();
+  normal_list_.clear();
+  normal_list_.shrink_to_fit();
+}
+
+/*!
+  \details
+  The value is rounded to the nearest half float.
+  The values out of the range are clamped to the largest numbers.
+  */
+uint16 TriangleMesh::encodeHalf(const Float value) noexcept
+{
+  const float f = zisc::cast<float>(value);
+  uint32 bits = 0;
+  std::memcpy(&bits, &f, sizeof(f));
+  const uint32 sign = (bits >> 16) & 0x8000u;
+  const int exponent = zisc::cast<int>((bits >> 23) & 0xffu) - 127 + 15;
+  uint32 mantissa = bits & 0x7fffffu;
+  uint32 result = 0;
+  if (exponent <= 0) {
+    // Subnormal numbers
+    if (-10 <= exponent) {
+      mantissa = (mantissa | 0x800000u) >> zisc::cast<uint32>(1 - exponent);
+      result = (mantissa + 0x1000u) >> 13;
+    }
+  }
+  else {
+    result = (zisc::cast<uint32>(exponent) << 10) | (mantissa >> 13);
+    // Round half up, the carry moves to the exponent
+    result += (mantissa >> 12) & 1u;
+  }
+  constexpr uint32 max_half = 0x7bffu;
+  return zisc::cast<uint16>(sign | zisc::min(result, max_half));
+}
+
+/*!
+  \details
+  The zero normal is encoded as 0.
+  */
+auto TriangleMesh::encodeNormal(const Vector3& normal) noexcept -> EncodedNormal
+{
+  const Float l1_norm = zisc::abs(normal[0]) + zisc::abs(normal[1]) +
+                        zisc::abs(normal[2]);
+  if (!(0.0 < l1_norm))
+    return EncodedNormal{{0, 0}};
+
+  Float x = normal[0] / l1_norm;
+  Float y = normal[1] / l1_norm;
+  if (normal[2] < 0.0) {
+    const Float folded_x = (1.0 - zisc::abs(y)) * ((x < 0.0) ? -1.0 : 1.0);
+    const Float folded_y = (1.0 - zisc::abs(x)) * ((y < 0.0) ? -1.0 : 1.0);
+    x = folded_x;
+    y = folded_y;
+  }
+  // Map [-1, 1] to [1, max]
+  constexpr Float k = 0.5 * zisc::cast<Float>(std::numeric_limits<uint16>::max() - 1);
+  auto encode = [k](const Float value)
+  {
+    const Float v = std::round(k * (zisc::clamp(value, -1.0, 1.0) + 1.0));
+    return zisc::cast<uint16>(zisc::cast<uint32>(v) + 1);
+  };
+  return EncodedNormal{{encode(x), encode(y)}};
+}
+
+/*!
+  \details
+  The quads which fold are split into triangles and
+  the invisible faces, which have no area, are removed.
+  The vertex normals are used only if the mesh is smoothed.
+  */
+void TriangleMesh::initialize(const MeshParameters& parameters,
+                              zisc::pmr::memory_resource* work_resource) noexcept
+{
+  const auto& face_list = parameters.face_list_;
+  const bool has_uv = std::any_of(face_list.begin(), face_list.end(),
+  [](const Face& face)
+  {
+    return face.hasVuv();
+  });
+  const bool has_normal = (parameters.smoothing_ == kTrue) &&
+                          std::any_of(face_list.begin(), face_list.end(),
+  [](const Face& face)
+  {
+    return face.hasVnormal();
+  });
+  if (has_uv || has_normal)
+    setAttributeFaces(parameters, has_uv, has_normal, work_resource);
+  else
+    setFaces(parameters);
+  // The faces are checked with the quantized positions
+  compress(parameters.compression_);
+  splitQuads(false);
+
+  // Skip invisible faces
+  const auto end = std::remove_if(face_list_.begin(), face_list_.end(),
+  [this](const FaceIndex& f)
+  {
+    return FlatTriangle::calcSurfaceArea(vertex(f[0]),
+                                         vertex(f[1]),
+                                         vertex(f[2])) <= 0.0;
+  });
+  face_list_.erase(end, face_list_.end());
+  face_list_.shrink_to_fit();
+  quad_list_.shrink_to_fit();
+}
+
+/*!
+  \details
+  The attributes which the face doesn't have are null indices.
+  */
+auto TriangleMesh::makeVertexKey(const Face& face,
+                                 const uint corner,
+                                 const bool has_uv,
+                                 const bool has_normal) noexcept -> VertexKey
+{
+  const uint32 uv_index = (has_uv && face.hasVuv())
+      ? face.quadrangleVuvIndices()[corner]
+      : Face::nullIndex();
+  const uint32 normal_index = (has_normal && face.hasVnormal())
+      ? face.quadrangleVnormalIndices()[corner]
+      : Face::nullIndex();
+  return VertexKey{{face.quadrangleVertexIndices()[corner], uv_index, normal_index}};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void TriangleMesh::setFaces(const MeshParameters& parameters) noexcept
+{
+  vertex_list_.reserve(parameters.vertex_list_.size());
+  for (const auto& vertex_data : parameters.vertex_list_) {
+    vertex_list_.emplace_back(zisc::cast<Float>(vertex_data[0]),
+                              zisc::cast<Float>(vertex_data[1]),
+                              zisc::cast<Float>(vertex_data[2]));
+  }
+
+  face_list_.reserve(parameters.face_list_.size());
+  for (const auto& face : parameters.face_list_) {
+    if (face.isQuadrangular())
+      quad_list_.emplace_back(face.quadrangleVertexIndices());
+    else
+      face_list_.emplace_back(face.triangleVertexIndices());
+  }
+}
+
+/*!
+  \details
+  A vertex of the mesh is made for each combination of a vertex, a UV and
+  a normal referred by the faces, so the faces can refer the attributes
+  by one index. The faces without UVs refer the zero UV and
+  the faces without normals refer the zero normal.
+  */
+void TriangleMesh::setAttributeFaces(
+    const MeshParameters& parameters,
+    const bool has_uv,
+    const bool has_normal,
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  const auto& face_list = parameters.face_list_;
+  // Collect the combinations of the vertex attributes
+  zisc::pmr::vector<VertexKey> key_list{work_resource};
+  key_list.reserve(4 * face_list.size());
+  for (const auto& face : face_list) {
+    const uint num_of_corners = face.isQuadrangular() ? 4 : 3;
+    for (uint corner = 0; corner < num_of_corners; ++corner)
+      key_list.emplace_back(makeVertexKey(face, corner, has_uv, has_normal));
+  }
+  std::sort(key_list.begin(), key_list.end());
+  key_list.erase(std::unique(key_list.begin(), key_list.end()), key_list.end());
+
+  // Make the vertices
+  vertex_list_.reserve(key_list.size());
+  if (has_uv)
+    uv_list_.reserve(key_list.size());
+  if (has_normal)
+    normal_list_.reserve(key_list.size());
+  for (const auto& key : key_list) {
+    const auto& vertex_data = parameters.vertex_list_[key[0]];
+    vertex_list_.emplace_back(zisc::cast<Float>(vertex_data[0]),
+                              zisc::cast<Float>(vertex_data[1]),
+                              zisc::cast<Float>(vertex_data[2]));
+    if (has_uv) {
+      const uint32 uv_index = key[1];
+      if (uv_index != Face::nullIndex()) {
+        const auto& uv_data = parameters.vuv_list_[uv_index];
+        uv_list_.emplace_back(zisc::cast<Float>(uv_data[0]),
+                              zisc::cast<Float>(uv_data[1]));
+      }
+      else {
+        uv_list_.emplace_back(0.0, 0.0);
+      }
+    }
+    if (has_normal) {
+      const uint32 normal_index = key[2];
+      if (normal_index != Face::nullIndex()) {
+        const auto& normal_data = parameters.vnormal_list_[normal_index];
+        const Vector3 normal{zisc::cast<Float>(normal_data[0]),
+                             zisc::cast<Float>(normal_data[1]),
+                             zisc::cast<Float>(normal_data[2])};
+        const bool is_valid = 0.0 < normal.squareNorm();
+        normal_list_.emplace_back(is_valid ? normal.normalized() : normal);
+      }
+      else {
+        normal_list_.emplace_back(0.0, 0.0, 0.0);
+      }
+    }
+  }
+
+  // Make the faces
+  face_list_.reserve(face_list.size());
+  for (const auto& face : face_list) {
+    QuadIndex quad_index;
+    const uint num_of_corners = face.isQuadrangular() ? 4 : 3;
+    for (uint corner = 0; corner < num_of_corners; ++corner) {
+      const auto key = makeVertexKey(face, corner, has_uv, has_normal);
+      const auto position = std::lower_bound(key_list.begin(), key_list.end(), key);
+      ZISC_ASSERT((position != key_list.end()) && (*position == key),
+                  "The vertex isn't found.");
+      quad_index[corner] =
+          zisc::cast<uint32>(std::distance(key_list.begin(), position));
+    }
+    if (face.isQuadrangular())
+      quad_list_.emplace_back(quad_index);
+    else
+      face_list_.emplace_back(FaceIndex{{quad_index[0], quad_index[1], quad_index[2]}});
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void TriangleMesh::transformVertices(const Matrix4x4& matrix,
+                                     const Matrix4x4& normal_matrix,
+                                     const uint32 begin,
+                                     const uint32 end) noexcept
+{
+  ZISC_ASSERT(compression() == MeshCompression::kNone,
+              "The vertices of the compressed mesh are transformed.");
+  for (uint32 index = begin; index < end; ++index)
+    Transformation::affineTransform(matrix, &vertex_list_[index]);
+  if (hasNormal()) {
+    for (uint32 index = begin; index < end; ++index) {
+      auto& normal = normal_list_[index];
+      if (normal.squareNorm() == 0.0)
+        continue;
+      Transformation::affineTransform(normal_matrix, &normal);
+      normal = normal.normalized();
+    }
+  }
+}
+
+/*!
+  \details
+  No detailed.
   */
-std::array<Point2, 3> TriangleMesh::getUvs(const MeshParameters& parameters,
-                                           const Face& face) noexcept
+void TriangleMesh::transformQuantization(const Matrix4x4& matrix,
+                                         const Matrix4x4& normal_matrix) noexcept
 {
-  std::array<Point2, 3> uvs;
-  const auto& uv_indices = face.triangleVuvIndices();
-  for (uint i = 0; i < 3; ++i) {
-    auto& uv = uvs[i];
-    const auto& uv_data = parameters.vuv_list_[uv_indices[i]];
-    for (uint axis = 0; axis < 2; ++axis)
-      uv[axis] = zisc::cast<Float>(uv_data[axis]);
-  }
-  return uvs;
+  Transformation::affineTransform(matrix, &grid_origin_);
+  for (auto& axis : grid_axis_)
+    Transformation::affineTransform(matrix, &axis);
+  const Matrix3x3 m{normal_matrix(0, 0), normal_matrix(0, 1), normal_matrix(0, 2),
+                    normal_matrix(1, 0), normal_matrix(1, 1), normal_matrix(1, 2),
+                    normal_matrix(2, 0), normal_matrix(2, 1), normal_matrix(2, 2)};
+  normal_matrix_ = m * normal_matrix_;
 }
 
 } // namespace nanairo
@@ -11,15 +11,19 @@
 #define NANAIRO_TRIANGLE_MESH_HPP
 
 // Standard C++ library
+#include <array>
 #include <memory>
 #include <vector>
 // Zisc
+#include "zisc/fnv_1a_hash_engine.hpp"
 #include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "shape.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
@@ -48,26 +52,177 @@ enum class MeshType : int
   \details
   No detailed.
   */
-class TriangleMesh
+enum class MeshCompression : uint32
+{
+  kNone                       = zisc::Fnv1aHash32::hash("None"),
+  kQuantized16                = zisc::Fnv1aHash32::hash("Quantized16"),
+  kQuantized32                = zisc::Fnv1aHash32::hash("Quantized32")
+};
+
+/*!
+  \details
+  The vertices, the UVs and the vertex normals are shared by
+  the triangles and the quads of a mesh. A face refers the vertex data by
+  three indices, a quad by four indices, and the shapes only have the index.
+  The quads which fold are split into triangles.
+  The vertex normals are kept only if the mesh is smoothed.
+
+  A compressed mesh keeps the positions as 16 or 32 bit integers on
+  the grid of the mesh bounding box, the normals by the octahedral encoding and
+  the UVs as half floats, and they are decoded when they are accessed.
+  The grid and the normal matrix are transformed instead of the vertices,
+  so the quantization is done only once in the object space.
+  */
+class TriangleMesh : public zisc::NonCopyable<TriangleMesh>
 {
  public:
-  //! Make meshes
+  using FaceIndex = std::array<uint32, 3>;
+  using QuadIndex = std::array<uint32, 4>;
+
+
+  //! Create a mesh from the parameters
+  TriangleMesh(const MeshParameters& parameters,
+               zisc::pmr::memory_resource* data_resource,
+               zisc::pmr::memory_resource* work_resource) noexcept;
+
+
+  //! Return the compression of the vertex data
+  MeshCompression compression() const noexcept;
+
+  //! Return the vertex indices of the face
+  const FaceIndex& face(const uint32 index) const noexcept;
+
+  //! Check if the mesh has vertex normals
+  bool hasNormal() const noexcept;
+
+  //! Check if the mesh has UVs
+  bool hasUv() const noexcept;
+
+  //! Make the triangles and the bilinear patches of the transformed mesh
   static zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> makeMeshes(
       System& system,
-      const SettingNodeBase* settings) noexcept;
+      const SettingNodeBase* settings,
+      const Matrix4x4& transformation,
+      const bool threading,
+      zisc::UniqueMemoryPointer<TriangleMesh>* mesh) noexcept;
+
+  //! Return the vertex normal, zero vector if the face doesn't have normals
+  Vector3 normal(const uint32 index) const noexcept;
+
+  //! Return the number of triangular faces
+  uint32 numOfFaces() const noexcept;
+
+  //! Return the number of quads
+  uint32 numOfQuads() const noexcept;
+
+  //! Return the number of vertices
+  uint32 numOfVertices() const noexcept;
+
+  //! Return the number of faces from which a mesh is made by all threads
+  static constexpr uint32 parallelConstructionSize() noexcept;
+
+  //! Return the vertex indices of the quad
+  const QuadIndex& quad(const uint32 index) const noexcept;
+
+  //! Make the vertex data from the parameters again and transform it
+  void setTransformation(const MeshParameters& parameters,
+                         const Matrix4x4& transformation,
+                         zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Split the quads which fold, or aren't planar if the flag is true
+  void splitQuads(const bool split_curved_quads) noexcept;
+
+  //! Apply affine transformation to the vertices and the normals
+  void transform(const Matrix4x4& matrix) noexcept;
+
+  //! Return the UV of the vertex
+  Point2 uv(const uint32 index) const noexcept;
+
+  //! Return the vertex
+  Point3 vertex(const uint32 index) const noexcept;
 
  private:
-  //! Return the vertices of the face
-  static std::array<Point3, 3> getVertices(const MeshParameters& parameters,
-                                           const Face& face) noexcept;
+  //! The indices of a vertex, a UV and a normal
+  using VertexKey = std::array<uint32, 3>;
+  //! The octahedral encoded normal, 0 means the zero normal
+  using EncodedNormal = std::array<uint16, 2>;
+  //! The UV in half floats
+  using EncodedUv = std::array<uint16, 2>;
+
+
+  //! Compress the vertex data and release the uncompressed data
+  void compress(const MeshCompression compression) noexcept;
+
+  //! Decode the half float
+  static Float decodeHalf(const uint16 value) noexcept;
+
+  //! Decode the octahedral encoded normal in the object space
+  static Vector3 decodeNormal(const EncodedNormal& value) noexcept;
+
+  //! Decode the quantized position
+  template <typename Integer>
+  Point3 decodePosition(const std::array<Integer, 3>& value) const noexcept;
+
+  //! Encode the value into a half float
+  static uint16 encodeHalf(const Float value) noexcept;
 
-  //! Return the UVs of the face
-  static std::array<Point2, 3> getUvs(const MeshParameters& parameters,
-                                      const Face& face) noexcept;
+  //! Encode the normal by the octahedral encoding
+  static EncodedNormal encodeNormal(const Vector3& normal) noexcept;
+
+  //! Initialize the mesh
+  void initialize(const MeshParameters& parameters,
+                  zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Return the key of a corner of the face
+  static VertexKey makeVertexKey(const Face& face,
+                                 const uint corner,
+                                 const bool has_uv,
+                                 const bool has_normal) noexcept;
+
+  //! Quantize the positions on the grid of the bounding box
+  template <typename Integer>
+  void quantizePositions(zisc::pmr::vector<std::array<Integer, 3>>* position_list) noexcept;
+
+  //! Set the faces which refer the vertices of the parameters directly
+  void setFaces(const MeshParameters& parameters) noexcept;
+
+  //! Set the faces which refer the combinations of the vertex attributes
+  void setAttributeFaces(const MeshParameters& parameters,
+                         const bool has_uv,
+                         const bool has_normal,
+                         zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Transform the vertices and the normals in the range
+  void transformVertices(const Matrix4x4& matrix,
+                         const Matrix4x4& normal_matrix,
+                         const uint32 begin,
+                         const uint32 end) noexcept;
+
+  //! Transform the grid of the positions and the normal matrix
+  void transformQuantization(const Matrix4x4& matrix,
+                             const Matrix4x4& normal_matrix) noexcept;
+
+
+  zisc::pmr::vector<Point3> vertex_list_;
+  zisc::pmr::vector<Point2> uv_list_;
+  zisc::pmr::vector<Vector3> normal_list_;
+  zisc::pmr::vector<FaceIndex> face_list_;
+  zisc::pmr::vector<QuadIndex> quad_list_;
+  // Compressed data
+  zisc::pmr::vector<std::array<uint16, 3>> position16_list_;
+  zisc::pmr::vector<std::array<uint32, 3>> position32_list_;
+  zisc::pmr::vector<EncodedUv> encoded_uv_list_;
+  zisc::pmr::vector<EncodedNormal> encoded_normal_list_;
+  Point3 grid_origin_;
+  std::array<Vector3, 3> grid_axis_; //!< The steps of the grid
+  Matrix3x3 normal_matrix_;
+  MeshCompression compression_;
 };
 
 //! \} Core
 
 } // namespace nanairo
 
+#include "triangle_mesh-inl.hpp"
+
 #endif // NANAIRO_TRIANGLE_MESH_HPP
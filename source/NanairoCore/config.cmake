@@ -39,6 +39,24 @@ function(makeCoreConfigFile config_file_path config_file_inl_path)
      NANAIRO_PATH_TRACING_IMPLICIT_CONNECTION_ONLY)
     message(FATAL_ERROR "'NANAIRO_PATH_TRACING_EXPLICIT_CONNECTION_ONLY' and 'NANAIRO_PATH_TRACING_IMPLICIT_CONNECTION_ONLY' can not be specified together.")
   endif()
+  # Traversal statistics
+  if(NANAIRO_TRAVERSAL_STATISTICS)
+    set(NANAIRO_TRAVERSAL_STATISTICS_IS_ENABLED "true")
+  else()
+    set(NANAIRO_TRAVERSAL_STATISTICS_IS_ENABLED "false")
+  endif()
+  # Object layout
+  if(NANAIRO_CONTIGUOUS_OBJECT_LAYOUT)
+    set(NANAIRO_CONTIGUOUS_OBJECT_LAYOUT_IS_ENABLED "true")
+  else()
+    set(NANAIRO_CONTIGUOUS_OBJECT_LAYOUT_IS_ENABLED "false")
+  endif()
+  # Traversal floating point type
+  if(NANAIRO_SINGLE_PRECISION_TRAVERSAL)
+    set(NANAIRO_TRAVERSAL_FLOATING_POINT_TYPE "float")
+  else()
+    set(NANAIRO_TRAVERSAL_FLOATING_POINT_TYPE ${NANAIRO_FLOATING_POINT_TYPE})
+  endif()
 
   configure_file(${__nanairo_core_root__}/nanairo_core_config.hpp.in
                  ${config_file_path})
@@ -37,6 +37,19 @@ Scene::Scene(System& system, const SettingNodeBase* settings) noexcept
   initialize(system, settings);
 }
 
+/*!
+  \details
+  Returns false if the visible objects of the settings are changed,
+  then the scene must be made again.
+  The light source samplers which refer the world must be made again
+  after the update.
+  */
+bool Scene::updateTransformation(System& system,
+                                 const SettingNodeBase* settings) noexcept
+{
+  return world_->updateTransformation(system, settings);
+}
+
 /*!
   \details
   No detailed.
@@ -53,6 +53,10 @@ class Scene : public zisc::NonCopyable<Scene>
   //! Returh the film
   const Film& film() const noexcept;
 
+  //! Apply the transformations of the settings to the objects of the world
+  bool updateTransformation(System& system,
+                            const SettingNodeBase* settings) noexcept;
+
   //! Return the world data
   const World& world() const noexcept;
 
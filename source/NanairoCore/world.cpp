@@ -13,15 +13,20 @@
 #include <cstdint>
 #include <cstddef>
 #include <future>
+#include <limits>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 // Zisc
 #include "zisc/algorithm.hpp"
 #include "zisc/compensated_summation.hpp"
 #include "zisc/error.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
 #include "zisc/thread_manager.hpp"
 #include "zisc/utility.hpp"
 #include "zisc/unit.hpp"
@@ -35,12 +40,16 @@
 #include "Material/SurfaceModel/surface_model.hpp"
 #include "Material/TextureModel/texture_model.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "Setting/bvh_setting_node.hpp"
 #include "Setting/group_object_setting_node.hpp"
 #include "Setting/material_setting_node.hpp"
 #include "Setting/object_model_setting_node.hpp"
 #include "Setting/scene_setting_node.hpp"
 #include "Setting/setting_node_base.hpp"
 #include "Setting/single_object_setting_node.hpp"
+#include "Shape/instance.hpp"
+#include "Shape/shape.hpp"
+#include "Shape/triangle_mesh.hpp"
 
 
 namespace nanairo {
@@ -58,7 +67,12 @@ World::World(System& system, const SettingNodeBase* settings) noexcept :
     emitter_body_list_{&system.dataMemoryManager()},
     surface_body_list_{&system.dataMemoryManager()},
     texture_body_list_{&system.dataMemoryManager()},
-    material_body_list_{&system.dataMemoryManager()}
+    material_body_list_{&system.dataMemoryManager()},
+    instance_source_list_{&system.dataMemoryManager()},
+    instance_map_{&system.dataMemoryManager()},
+    model_transformation_list_{&system.dataMemoryManager()},
+    shape_model_list_{&system.dataMemoryManager()},
+    mesh_model_list_{&system.dataMemoryManager()}
 {
   initialize(system, settings);
 }
@@ -71,6 +85,104 @@ World::~World() noexcept
 {
 }
 
+/*!
+  \details
+  The transformations are collected in the same order as makeObjects.
+  The settings of an update are made apart from the world,
+  so the models are identified by the positions and the shape types
+  instead of serializing the object data.
+  */
+void World::collectTransformations(
+    const SettingNodeBase* settings,
+    Matrix4x4 transformation,
+    zisc::pmr::vector<ModelSettings>& settings_list) const noexcept
+{
+  const auto object_model_settings = castNode<ObjectModelSettingNode>(settings);
+  if (!object_model_settings->visibility())
+    return;
+  const auto& model_transformation_list = object_model_settings->transformationList();
+  if (0 < model_transformation_list.size()) {
+    transformation = transformation *
+                     Transformation::makeTransformation(model_transformation_list);
+  }
+  const auto object_settings = object_model_settings->objectSettingNode();
+  if (object_settings->type() == SettingNodeType::kGroupObject) {
+    const auto group_settings = castNode<GroupObjectSettingNode>(object_settings);
+    for (const auto child_settings : group_settings->objectList())
+      collectTransformations(child_settings, transformation, settings_list);
+  }
+  else {
+    settings_list.emplace_back(object_settings, transformation);
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void World::findInstanceCandidates(
+    const SettingNodeBase* settings,
+    zisc::pmr::vector<const SettingNodeBase*>& candidate_list) const noexcept
+{
+  const auto object_model_settings = castNode<ObjectModelSettingNode>(settings);
+  if (!object_model_settings->visibility())
+    return;
+  const auto object_settings = object_model_settings->objectSettingNode();
+  if (object_settings->type() == SettingNodeType::kGroupObject) {
+    const auto group_settings = castNode<GroupObjectSettingNode>(object_settings);
+    for (const auto child_settings : group_settings->objectList())
+      findInstanceCandidates(child_settings, candidate_list);
+  }
+  else {
+    const auto single_object_settings =
+        castNode<SingleObjectSettingNode>(object_settings);
+    if ((single_object_settings->shapeType() == ShapeType::kMesh) &&
+        !single_object_settings->isEmissiveObject()) {
+      candidate_list.emplace_back(object_settings);
+    }
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+uint World::findInstanceSource(const SettingNodeBase* settings) const noexcept
+{
+  const auto position = std::lower_bound(
+      instance_map_.begin(),
+      instance_map_.end(),
+      settings,
+      [](const std::tuple<const SettingNodeBase*, uint>& entry,
+         const SettingNodeBase* key)
+      {
+        return std::get<0>(entry) < key;
+      });
+  const bool is_found = (position != instance_map_.end()) &&
+                        (std::get<0>(*position) == settings);
+  return is_found ? std::get<1>(*position) : std::numeric_limits<uint>::max();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+uint World::findModelIndex(const Shape& shape) const noexcept
+{
+  const auto position = std::lower_bound(
+      shape_model_list_.begin(),
+      shape_model_list_.end(),
+      &shape,
+      [](const std::tuple<const Shape*, uint>& entry, const Shape* key)
+      {
+        return std::get<0>(entry) < key;
+      });
+  ZISC_ASSERT((position != shape_model_list_.end()) &&
+              (std::get<0>(*position) == &shape),
+              "The shape isn't found in the model list.");
+  return std::get<1>(*position);
+}
+
 /*!
   \details
   No detailed.
@@ -103,14 +215,19 @@ void World::initialize(System& system, const SettingNodeBase* settings) noexcept
   }
 
   {
+    auto bvh_settings = scene_settings->bvhSettingNode();
+    // Initialize the objects shared by instances
+    initializeInstance(system, scene_settings->objectSettingNode(), bvh_settings);
+    work_resource->reset();
+
     // Initialize objects
     auto object_list = initializeObject(system, scene_settings->objectSettingNode());
     work_resource->reset();
 
     // Initialize a BVH
-    auto bvh_settings = scene_settings->bvhSettingNode();
     bvh_ = Bvh::makeBvh(system, bvh_settings);
     bvh_->construct(system, bvh_settings, std::move(object_list));
+    relocateShapes(work_resource);
     work_resource->reset();
   }
 
@@ -158,6 +275,64 @@ void World::initializeEmitter(System& system,
   ZISC_ASSERT(0 < emitter_list_.size(), "The scene has no emitter.");
 }
 
+/*!
+  \details
+  The meshes which have the same settings and appear twice or more
+  in the scene are made only once in the object space and
+  are shared by the instances through a bottom level BVH.
+  Emissive meshes aren't instanced
+  since the light sources are sampled by the objects.
+  */
+void World::initializeInstance(System& system,
+                               const SettingNodeBase* settings,
+                               const SettingNodeBase* bvh_settings) noexcept
+{
+  auto work_resource = settings->workResource();
+  zisc::pmr::vector<const SettingNodeBase*> candidate_list{work_resource};
+  findInstanceCandidates(settings, candidate_list);
+
+  // Each candidate is serialized only once
+  zisc::pmr::vector<std::string> data_list{work_resource};
+  zisc::pmr::vector<MeshKey> key_list{work_resource};
+  data_list.reserve(candidate_list.size());
+  key_list.reserve(candidate_list.size());
+  for (uint i = 0; i < candidate_list.size(); ++i) {
+    data_list.emplace_back(makeObjectData(candidate_list[i]));
+    const auto& data = data_list.back();
+    key_list.emplace_back(zisc::Fnv1aHash64::hash(data.data(), data.size()), i);
+  }
+  std::sort(key_list.begin(), key_list.end());
+
+  instance_source_list_.clear();
+  instance_map_.clear();
+  for (auto begin = key_list.begin(); begin != key_list.end();) {
+    const uint64 key = std::get<0>(*begin);
+    const auto end = std::find_if(begin, key_list.end(),
+    [key](const MeshKey& candidate)
+    {
+      return std::get<0>(candidate) != key;
+    });
+    // The keys can collide, so the meshes of the same key are compared by data
+    while (begin != end) {
+      const auto& source_data = data_list[std::get<1>(*begin)];
+      const auto last = std::partition(begin + 1, end,
+      [&data_list, &source_data](const MeshKey& candidate)
+      {
+        return data_list[std::get<1>(candidate)] == source_data;
+      });
+      if (2 <= std::distance(begin, last)) {
+        const uint index = zisc::cast<uint>(instance_source_list_.size());
+        const auto source_settings = candidate_list[std::get<1>(*begin)];
+        makeInstanceSource(system, source_settings, bvh_settings);
+        for (auto candidate = begin; candidate != last; ++candidate)
+          instance_map_.emplace_back(candidate_list[std::get<1>(*candidate)], index);
+      }
+      begin = last;
+    }
+  }
+  std::sort(instance_map_.begin(), instance_map_.end());
+}
+
 /*!
   \details
   No detailed.
@@ -168,13 +343,51 @@ zisc::pmr::vector<Object> World::initializeObject(
 {
   auto results = makeObjects(system, settings);
 
+  // Record the transformations of the objects for updates
+  {
+    auto work_resource = settings->workResource();
+    zisc::pmr::vector<ModelSettings> settings_list{work_resource};
+    const auto transformation = Transformation::makeIdentity();
+    collectTransformations(settings, transformation, settings_list);
+    ZISC_ASSERT(settings_list.size() == results.size(),
+                "The transformation list doesn't match the objects.");
+    model_transformation_list_.clear();
+    model_transformation_list_.reserve(settings_list.size());
+    for (const auto& model_settings : settings_list) {
+      const auto object_settings =
+          castNode<SingleObjectSettingNode>(std::get<0>(model_settings));
+      model_transformation_list_.emplace_back(object_settings->shapeType(),
+                                              std::get<1>(model_settings));
+    }
+    shape_model_list_.clear();
+    for (uint model_index = 0; model_index < results.size(); ++model_index) {
+      const auto& objects = std::get<0>(results[model_index]);
+      for (const auto& object : objects)
+        shape_model_list_.emplace_back(&object.shape(), model_index);
+    }
+    std::sort(shape_model_list_.begin(), shape_model_list_.end());
+  }
+
+  // Keep the vertex data of the meshes
+  {
+    mesh_model_list_.clear();
+    for (uint model_index = 0; model_index < results.size(); ++model_index) {
+      auto& mesh = std::get<2>(results[model_index]);
+      if (mesh)
+        mesh_model_list_.emplace_back(std::move(mesh), model_index);
+    }
+  }
+
   // Initialize materials
   {
-    const std::size_t num_of_materials = results.size();
+    const std::size_t num_of_materials = material_list_.size() + results.size();
     material_list_.reserve(num_of_materials);
     material_body_list_.reserve(num_of_materials);
     for (auto& result : results) {
       auto& material = std::get<1>(result);
+      // The instances share the materials of the instance sources
+      if (!material)
+        continue;
       material_body_list_.emplace_back(std::move(material));
       material_list_.emplace_back(material_body_list_.back().get());
     }
@@ -274,22 +487,82 @@ void World::initializeTexture(System& system,
 
 /*!
   \details
-  No detailed.
+  The light sources are listed in the order of the objects and
+  each light source keeps the index in the list,
+  so the light samplers needn't search the list.
   */
 void World::initializeWorldLightSource() noexcept
 {
+  auto& object_list = bvh_->objectList();
   light_source_list_.clear();
   std::size_t num_of_lights = 0;
-  for (const auto& object : objectList()) {
+  for (const auto& object : object_list) {
     if (object.material().isLightSource())
       ++num_of_lights;
   }
   light_source_list_.reserve(num_of_lights);
-  for (const auto& object : objectList()) {
-    if (object.material().isLightSource())
+  for (auto& object : object_list) {
+    if (object.material().isLightSource()) {
+      object.setLightSourceIndex(zisc::cast<uint32>(light_source_list_.size()));
       light_source_list_.emplace_back(&object);
+    }
+    else {
+      object.setLightSourceIndex(Object::nonLightSourceIndex());
+    }
   }
-  std::sort(light_source_list_.begin(), light_source_list_.end());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+std::string World::makeObjectData(const SettingNodeBase* settings) noexcept
+{
+  std::ostringstream setting_stream{std::ios::binary};
+  settings->writeData(&setting_stream);
+  return setting_stream.str();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void World::makeInstanceSource(System& system,
+                               const SettingNodeBase* settings,
+                               const SettingNodeBase* bvh_settings) noexcept
+{
+  const auto object_settings = castNode<SingleObjectSettingNode>(settings);
+  // Make geometries in the object space
+  zisc::UniqueMemoryPointer<TriangleMesh> mesh;
+  const auto transformation = Transformation::makeIdentity();
+  auto shape_list = Shape::makeShape(system,
+                                     object_settings,
+                                     transformation,
+                                     true,
+                                     &mesh);
+  // Make material
+  const auto surface_index = object_settings->surfaceIndex();
+  const SurfaceModel* surface_model = surface_list_[surface_index];
+  auto material = zisc::UniqueMemoryPointer<Material>::make(
+      &system.dataMemoryManager(),
+      surface_model,
+      nullptr);
+  // Make objects
+  zisc::pmr::vector<Object> object_list{settings->workResource()};
+  object_list.reserve(shape_list.size());
+  for (auto& shape : shape_list)
+    object_list.emplace_back(std::move(shape), material.get());
+  // Make a bottom level BVH
+  auto bvh = Bvh::makeBvh(system, bvh_settings);
+  bvh->construct(system, bvh_settings, std::move(object_list));
+  if (CoreConfig::contiguousObjectLayoutIsEnabled())
+    bvh->relocateShapes();
+
+  instance_source_list_.emplace_back(InstanceSource{std::move(bvh),
+                                                   material.get(),
+                                                   std::move(mesh)});
+  material_body_list_.emplace_back(std::move(material));
+  material_list_.emplace_back(material_body_list_.back().get());
 }
 
 /*!
@@ -352,16 +625,33 @@ void World::makeSingleObject(
 {
   auto work_resource = settings->workResource();
   auto make_object =
-  [this, &system, settings, transformation, work_resource]()
+  [this, &system, settings, transformation, work_resource](const bool threading)
   {
     const auto model_settings = castNode<ObjectModelSettingNode>(settings);
     const auto object_settings =
         castNode<SingleObjectSettingNode>(model_settings->objectSettingNode());
-    // Make geometries
-    auto shape_list = Shape::makeShape(system, object_settings);
-    // Transform geometries
-    for (auto& shape : shape_list)
+    zisc::pmr::vector<Object> object_list{work_resource};
+    // Make an instance of the shared objects
+    const uint source_index = findInstanceSource(object_settings);
+    if (source_index != std::numeric_limits<uint>::max()) {
+      const auto& source = instance_source_list_[source_index];
+      zisc::UniqueMemoryPointer<Shape> shape =
+          zisc::UniqueMemoryPointer<Instance>::make(&system.dataMemoryManager(),
+                                                    source.bvh_.get());
       shape->transform(transformation);
+      object_list.emplace_back(std::move(shape), source.material_);
+      object_list.back().setName(model_settings->name());
+      return std::make_tuple(std::move(object_list),
+                             zisc::UniqueMemoryPointer<Material>{},
+                             zisc::UniqueMemoryPointer<TriangleMesh>{});
+    }
+    // Make geometries in the world space
+    zisc::UniqueMemoryPointer<TriangleMesh> mesh;
+    auto shape_list = Shape::makeShape(system,
+                                       object_settings,
+                                       transformation,
+                                       threading,
+                                       &mesh);
     // Set materials of geometries
     // Set Surface
     const auto surface_index = object_settings->surfaceIndex();
@@ -378,18 +668,36 @@ void World::makeSingleObject(
         surface_model,
         emitter_model);
     // Make objects
-    zisc::pmr::vector<Object> object_list{work_resource};
     object_list.reserve(shape_list.size());
     for (auto& shape : shape_list) {
       object_list.emplace_back(std::move(shape), material.get());
       object_list.back().setName(model_settings->name());
     }
-    return std::make_tuple(std::move(object_list), std::move(material));
+    return std::make_tuple(std::move(object_list),
+                           std::move(material),
+                           std::move(mesh));
   };
 
-  {
+  // A large mesh is made on the calling thread by all threads
+  const auto model_settings = castNode<ObjectModelSettingNode>(settings);
+  const auto object_settings =
+      castNode<SingleObjectSettingNode>(model_settings->objectSettingNode());
+  const bool is_large_mesh =
+      (object_settings->shapeType() == ShapeType::kMesh) &&
+      (TriangleMesh::parallelConstructionSize() <=
+       object_settings->meshParameters().face_list_.size());
+  if (is_large_mesh) {
+    std::promise<ObjectSet> object_set;
+    object_set.set_value(make_object(true));
+    results.emplace_back(object_set.get_future());
+  }
+  else {
+    auto make_object_task = [make_object]()
+    {
+      return make_object(false);
+    };
     auto& threads = system.threadManager();
-    auto result = threads.enqueue<ObjectSet>(make_object, work_resource);
+    auto result = threads.enqueue<ObjectSet>(make_object_task, work_resource);
     results.emplace_back(std::move(result));
   }
 }
@@ -413,4 +721,122 @@ void World::makeGroupObject(
     makeObjects(system, object_settings, transformation, results);
 }
 
+/*!
+  \details
+  The shapes are moved into the arena of the BVH,
+  so the model list of the shapes is made again.
+  */
+void World::relocateShapes(zisc::pmr::memory_resource* work_resource) noexcept
+{
+  if (!CoreConfig::contiguousObjectLayoutIsEnabled())
+    return;
+
+  const auto& object_list = objectList();
+  zisc::pmr::vector<uint> model_index_list{work_resource};
+  model_index_list.reserve(object_list.size());
+  for (const auto& object : object_list)
+    model_index_list.emplace_back(findModelIndex(object.shape()));
+
+  bvh_->relocateShapes();
+
+  ZISC_ASSERT(shape_model_list_.size() == object_list.size(),
+              "The model list doesn't match the objects.");
+  for (std::size_t i = 0; i < object_list.size(); ++i)
+    shape_model_list_[i] = std::make_tuple(&object_list[i].shape(), model_index_list[i]);
+  std::sort(shape_model_list_.begin(), shape_model_list_.end());
+}
+
+/*!
+  \details
+  The shapes of the changed models are transformed again from
+  the object space, so the errors of the transformations don't accumulate
+  over updates, and the BVH is refitted instead of being built again.
+  Returns false if the visible objects are changed,
+  then the world must be made again.
+  The light samplers which refer the world must be made again after updates.
+  */
+bool World::updateTransformation(System& system,
+                                 const SettingNodeBase* settings) noexcept
+{
+  const auto scene_settings = castNode<SceneSettingNode>(settings);
+
+  auto work_resource = static_cast<System::MemoryManager*>(settings->workResource());
+  std::mutex work_mutex;
+  work_resource->setMutex(&work_mutex);
+  work_resource->reset();
+
+  zisc::pmr::vector<ModelSettings> settings_list{work_resource};
+  {
+    const auto transformation = Transformation::makeIdentity();
+    collectTransformations(scene_settings->objectSettingNode(),
+                           transformation,
+                           settings_list);
+  }
+  // Only the transformations are compared, the object data isn't checked
+  const std::size_t num_of_models = model_transformation_list_.size();
+  bool is_updatable = settings_list.size() == num_of_models;
+  for (std::size_t i = 0; is_updatable && (i < num_of_models); ++i) {
+    const auto object_settings =
+        castNode<SingleObjectSettingNode>(std::get<0>(settings_list[i]));
+    is_updatable = object_settings->shapeType() ==
+                   std::get<0>(model_transformation_list_[i]);
+  }
+
+  if (is_updatable) {
+    zisc::pmr::vector<uint8> change_list{work_resource};
+    change_list.reserve(num_of_models);
+    bool is_transformed = false;
+    for (std::size_t i = 0; i < num_of_models; ++i) {
+      auto& old_transformation = std::get<1>(model_transformation_list_[i]);
+      const auto& new_transformation = std::get<1>(settings_list[i]);
+      const bool is_changed = new_transformation != old_transformation;
+      change_list.emplace_back(is_changed ? kTrue : kFalse);
+      old_transformation = new_transformation;
+      is_transformed = is_transformed || is_changed;
+    }
+    // Refit the BVH
+    if (is_transformed) {
+      // The vertices of a mesh are made once for the faces
+      for (auto& mesh_model : mesh_model_list_) {
+        const uint model_index = std::get<1>(mesh_model);
+        if (change_list[model_index] == kTrue) {
+          const auto object_settings = castNode<SingleObjectSettingNode>(
+              std::get<0>(settings_list[model_index]));
+          std::get<0>(mesh_model)->setTransformation(
+              object_settings->meshParameters(),
+              std::get<1>(settings_list[model_index]),
+              work_resource);
+        }
+      }
+      auto& object_list = bvh_->objectList();
+      zisc::pmr::vector<Matrix4x4> object_transformation_list{work_resource};
+      object_transformation_list.reserve(object_list.size());
+      for (auto& object : object_list) {
+        auto& shape = object.shape();
+        const uint model_index = findModelIndex(shape);
+        const bool is_face = (shape.type() == ShapeType::kMesh) ||
+                             (shape.type() == ShapeType::kBilinearPatch);
+        if ((change_list[model_index] == kTrue) && !is_face) {
+          shape.resetTransformation();
+          object_transformation_list.emplace_back(
+              std::get<1>(settings_list[model_index]));
+        }
+        else {
+          object_transformation_list.emplace_back(Transformation::makeIdentity());
+        }
+      }
+      const bool is_rebuilt = bvh_->refit(system,
+                                          scene_settings->bvhSettingNode(),
+                                          object_transformation_list);
+      // The objects are reordered by the rebuild
+      if (is_rebuilt)
+        relocateShapes(work_resource);
+      initializeWorldLightSource();
+    }
+  }
+
+  work_resource->setMutex(nullptr);
+  return is_updatable;
+}
+
 } // namespace nanairo
@@ -15,6 +15,7 @@
 #include <future>
 #include <list>
 #include <memory>
+#include <string>
 #include <tuple>
 #include <vector>
 // Zisc
@@ -30,6 +31,8 @@
 #include "Material/TextureModel/texture_model.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "Setting/setting_node_base.hpp"
+#include "Shape/shape.hpp"
+#include "Shape/triangle_mesh.hpp"
 
 namespace nanairo {
 
@@ -76,10 +79,47 @@ class World : public zisc::NonCopyable<World>
   //! Return the texture list
   const zisc::pmr::vector<const TextureModel*>& textureList() const noexcept;
 
+  //! Apply the transformations of the settings to the objects
+  bool updateTransformation(System& system,
+                            const SettingNodeBase* settings) noexcept;
+
  private:
   using ObjectSet = std::tuple<zisc::pmr::vector<Object>,
-                               zisc::UniqueMemoryPointer<Material>>;
+                               zisc::UniqueMemoryPointer<Material>,
+                               zisc::UniqueMemoryPointer<TriangleMesh>>;
+  using MeshKey = std::tuple<uint64, uint>; //!< The hash and the candidate index
+  using ModelSettings = std::tuple<const SettingNodeBase*, Matrix4x4>;
+  using ModelTransformation = std::tuple<ShapeType, Matrix4x4>;
+
+
+  //! The objects which are shared by the instances of a mesh
+  struct InstanceSource
+  {
+    zisc::UniqueMemoryPointer<Bvh> bvh_;
+    const Material* material_;
+    zisc::UniqueMemoryPointer<TriangleMesh> mesh_;
+  };
+
+
+  //! Write the settings of a single object into a string
+  static std::string makeObjectData(const SettingNodeBase* settings) noexcept;
+
+  //! Collect the transformations of the visible single objects
+  void collectTransformations(
+      const SettingNodeBase* settings,
+      Matrix4x4 transformation,
+      zisc::pmr::vector<ModelSettings>& settings_list) const noexcept;
+
+  //! Collect the meshes which can be instanced
+  void findInstanceCandidates(
+      const SettingNodeBase* settings,
+      zisc::pmr::vector<const SettingNodeBase*>& candidate_list) const noexcept;
+
+  //! Return the index of the instance source of the object or invalid index
+  uint findInstanceSource(const SettingNodeBase* settings) const noexcept;
 
+  //! Return the index of the model which the shape belongs to
+  uint findModelIndex(const Shape& shape) const noexcept;
 
   //! Initialize world
   void initialize(System& system, const SettingNodeBase* settings) noexcept;
@@ -87,6 +127,11 @@ class World : public zisc::NonCopyable<World>
   //! Initialize emitter list
   void initializeEmitter(System& system, const SettingNodeBase* settings) noexcept;
 
+  //! Initialize the objects shared by instances
+  void initializeInstance(System& system,
+                          const SettingNodeBase* settings,
+                          const SettingNodeBase* bvh_settings) noexcept;
+
   //! Initialize Objects
   zisc::pmr::vector<Object> initializeObject(
       System& system,
@@ -101,6 +146,11 @@ class World : public zisc::NonCopyable<World>
   //! Initialize texture list
   void initializeTexture(System& system, const SettingNodeBase* settings) noexcept;
 
+  //! Make the objects shared by the instances of a mesh
+  void makeInstanceSource(System& system,
+                          const SettingNodeBase* settings,
+                          const SettingNodeBase* bvh_settings) noexcept;
+
   //! Make objects
   zisc::pmr::vector<ObjectSet> makeObjects(
       System& system,
@@ -126,6 +176,9 @@ class World : public zisc::NonCopyable<World>
       const Matrix4x4& transformation,
       zisc::pmr::list<std::future<ObjectSet>>& results) const noexcept;
 
+  //! Place the shapes of the objects contiguously in the leaf order
+  void relocateShapes(zisc::pmr::memory_resource* work_resource) noexcept;
+
 
   zisc::pmr::vector<const EmitterModel*> emitter_list_;
   zisc::pmr::vector<const SurfaceModel*> surface_list_;
@@ -136,6 +189,12 @@ class World : public zisc::NonCopyable<World>
   zisc::pmr::vector<zisc::UniqueMemoryPointer<SurfaceModel>> surface_body_list_;
   zisc::pmr::vector<zisc::UniqueMemoryPointer<TextureModel>> texture_body_list_;
   zisc::pmr::vector<zisc::UniqueMemoryPointer<Material>> material_body_list_;
+  zisc::pmr::vector<InstanceSource> instance_source_list_;
+  zisc::pmr::vector<std::tuple<const SettingNodeBase*, uint>> instance_map_;
+  zisc::pmr::vector<ModelTransformation> model_transformation_list_;
+  zisc::pmr::vector<std::tuple<const Shape*, uint>> shape_model_list_;
+  zisc::pmr::vector<std::tuple<zisc::UniqueMemoryPointer<TriangleMesh>, uint>>
+      mesh_model_list_;
   zisc::UniqueMemoryPointer<Bvh> bvh_;
 };
 
@@ -18,6 +18,7 @@ ApplicationWindow {
   id: mainWindow
 
   property bool isRenderMode: false
+  property bool isPreviewing: false
 
   width: Definitions.mainWindowWidth
   height: Definitions.mainWindowHeight
@@ -60,11 +61,13 @@ ApplicationWindow {
       switch (menu) {
         case mainMenu.render: {
           mainWindow.isRenderMode = true;
+          mainWindow.isPreviewing = false;
           mainWindow.invokeRendering(false);
           break;
         }
         case mainMenu.preview: {
           mainWindow.isRenderMode = true;
+          mainWindow.isPreviewing = true;
           mainWindow.invokeRendering(true);
           break;
         }
@@ -79,15 +82,21 @@ ApplicationWindow {
   NSceneSettingView {
     id: settingView
 
-    enabled: !mainWindow.isRenderMode
+    enabled: !mainWindow.isRenderMode || mainWindow.isPreviewing
     anchors.fill: parent
     currentIndex: settingTabBar.currentIndex
+
+    // The transformations of the objects are applied to the preview
+    onTransformationIsChanged: {
+      if (mainWindow.isPreviewing)
+        nanairoManager.previewSceneEvent(settingView.getSceneData());
+    }
   }
 
   footer: NTabBar {
     id: settingTabBar
 
-    enabled: !mainWindow.isRenderMode
+    enabled: !mainWindow.isRenderMode || mainWindow.isPreviewing
     height: Definitions.defaultTabHeight
     Repeater {
       model: [qsTr("Tag"),
@@ -133,7 +142,10 @@ ApplicationWindow {
   Connections {
     target: nanairoManager
     onStarted: renderWindow.show()
-    onFinished: isRenderMode = false
+    onFinished: {
+      isRenderMode = false;
+      isPreviewing = false;
+    }
   }
 
   Component.onCompleted: loadPresetScene(Definitions.defaultScene)
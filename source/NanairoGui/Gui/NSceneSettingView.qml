@@ -70,6 +70,8 @@ NPane {
       isEditMode: settingView.isEditMode
       surfaceModelList: surfaceSettingView.surfaceModelList
       emitterModelList: emitterSettingView.emitterModelList
+
+      onTransformationIsChanged: settingView.transformationIsChanged()
     }
 
     NBvhSettingView {
@@ -134,4 +136,6 @@ NPane {
 
     isEditMode = true;
   }
+
+  signal transformationIsChanged()
 }
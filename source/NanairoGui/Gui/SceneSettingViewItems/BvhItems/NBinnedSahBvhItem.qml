@@ -0,0 +1,55 @@
+/*!
+  \file NBinnedSahBvhItem.qml
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+import QtQuick 2.12
+import QtQuick.Controls 2.12
+import QtQuick.Layouts 1.11
+import "../../Items"
+import "../../definitions.js" as Definitions
+
+NScrollView {
+  id: bvhItem
+
+  ColumnLayout {
+    spacing: Definitions.defaultItemSpace
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "bins"
+    }
+
+    NSpinBox {
+      id: numOfBinsSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: bvhItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      editable: true
+      from: 2
+      to: 256
+    }
+  }
+
+  function getSceneData() {
+    var sceneData = {};
+
+    sceneData[Definitions.numOfBins] = numOfBinsSpinBox.value;
+
+    return sceneData;
+  }
+
+  function initSceneData() {
+    numOfBinsSpinBox.value = 16;
+  }
+
+  function setSceneData(sceneData) {
+    numOfBinsSpinBox.value =
+        Definitions.getProperty(sceneData, Definitions.numOfBins);
+  }
+}
@@ -0,0 +1,74 @@
+/*!
+  \file NSpatialSplitBvhItem.qml
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+import QtQuick 2.12
+import QtQuick.Controls 2.12
+import QtQuick.Layouts 1.11
+import "../../Items"
+import "../../definitions.js" as Definitions
+
+NScrollView {
+  id: bvhItem
+
+  ColumnLayout {
+    spacing: Definitions.defaultItemSpace
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "bins"
+    }
+
+    NSpinBox {
+      id: numOfBinsSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: bvhItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 2
+      to: 256
+    }
+
+    NLabel {
+      Layout.topMargin: Definitions.defaultBlockSize
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "duplication limit [%]"
+    }
+
+    NSpinBox {
+      id: duplicationLimitSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: bvhItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 0
+      to: 100
+    }
+  }
+
+  function getSceneData() {
+    var sceneData = {};
+
+    sceneData[Definitions.numOfBins] = numOfBinsSpinBox.value;
+    sceneData[Definitions.duplicationLimit] = duplicationLimitSpinBox.value;
+
+    return sceneData;
+  }
+
+  function initSceneData() {
+    numOfBinsSpinBox.value = 16;
+    duplicationLimitSpinBox.value = 30;
+  }
+
+  function setSceneData(sceneData) {
+    numOfBinsSpinBox.value =
+        Definitions.getProperty(sceneData, Definitions.numOfBins);
+    duplicationLimitSpinBox.value =
+        Definitions.getProperty(sceneData, Definitions.duplicationLimit);
+  }
+}
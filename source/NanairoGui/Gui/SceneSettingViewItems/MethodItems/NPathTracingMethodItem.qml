@@ -32,18 +32,32 @@ NScrollView {
       Layout.preferredHeight: Definitions.defaultSettingItemHeight
       isEyePathSampler: true
     }
+
+    NCheckBox {
+      id: wavefrontCheckBox
+
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      checked: false
+      text: "wavefront"
+    }
   }
 
   function getSceneData() {
     var sceneData = lightSampler.getSceneData();
+    sceneData[Definitions.enableWavefront] = wavefrontCheckBox.checked;
     return sceneData;
   }
 
   function initSceneData() {
     lightSampler.initSceneData();
+    wavefrontCheckBox.checked = false;
   }
 
   function setSceneData(sceneData) {
     lightSampler.setSceneData(sceneData);
+    wavefrontCheckBox.checked =
+        Definitions.getProperty(sceneData, Definitions.enableWavefront);
   }
 }
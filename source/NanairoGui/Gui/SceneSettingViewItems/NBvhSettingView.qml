@@ -42,7 +42,10 @@ NScrollView {
           Layout.preferredHeight: Definitions.defaultSettingItemHeight
           currentIndex: 0
           model: [Definitions.binaryRadixTreeBvh,
-                  Definitions.agglomerativeTreeletRestructuringBvh]
+                  Definitions.agglomerativeTreeletRestructuringBvh,
+                  Definitions.binnedSahBvh,
+                  Definitions.plocBvh,
+                  Definitions.spatialSplitBvh]
 
           onCurrentIndexChanged: {
             if (settingView.isEditMode) {
@@ -52,6 +55,75 @@ NScrollView {
           }
         }
 
+        NLabel {
+          Layout.topMargin: Definitions.defaultBlockSize
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          text: "traversal"
+        }
+
+        NComboBox {
+          id: traversalComboBox
+
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          currentIndex: 0
+          model: [Definitions.orderedTraversal,
+                  Definitions.stacklessTraversal]
+        }
+
+        NLabel {
+          Layout.topMargin: Definitions.defaultBlockSize
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          text: "node format"
+        }
+
+        NComboBox {
+          id: nodeFormatComboBox
+
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          currentIndex: 0
+          model: [Definitions.fullNode,
+                  Definitions.quantized16Node,
+                  Definitions.quantized8Node]
+        }
+
+        NLabel {
+          Layout.topMargin: Definitions.defaultBlockSize
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          text: "max leaf size"
+        }
+
+        NSpinBox {
+          id: maxLeafSizeSpinBox
+
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          editable: true
+          from: 1
+          to: 15
+          value: 8
+        }
+
+        NLabel {
+          Layout.topMargin: Definitions.defaultBlockSize
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          text: "node width"
+        }
+
+        NComboBox {
+          id: nodeWidthComboBox
+
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          currentIndex: 0
+          model: ["2", "4", "8"]
+        }
+
         NPane {
           Layout.fillWidth: true
           Layout.fillHeight: true
@@ -79,6 +151,18 @@ NScrollView {
         NAgglomerativeTreeletRestructuringBvhItem {
           id: agglomerativeTreeletRestructuringBvh
         }
+
+        NBinnedSahBvhItem {
+          id: binnedSahBvh
+        }
+
+        NPlocBvhItem {
+          id: plocBvh
+        }
+
+        NSpatialSplitBvhItem {
+          id: spatialSplitBvh
+        }
       }
 
       Component.onCompleted: {
@@ -95,6 +179,10 @@ NScrollView {
     var sceneData = bvhView.getSceneData();
 
     sceneData[Definitions.type] = bvhTypeComboBox.currentText;
+    sceneData[Definitions.bvhTraversal] = traversalComboBox.currentText;
+    sceneData[Definitions.bvhNodeFormat] = nodeFormatComboBox.currentText;
+    sceneData[Definitions.bvhMaxLeafSize] = maxLeafSizeSpinBox.value;
+    sceneData[Definitions.bvhNodeWidth] = parseInt(nodeWidthComboBox.currentText);
 
     return sceneData;
   }
@@ -103,6 +191,18 @@ NScrollView {
     bvhTypeComboBox.currentIndex = bvhTypeComboBox.find(
         Definitions.getProperty(sceneData, Definitions.type));
 
+    traversalComboBox.currentIndex = traversalComboBox.find(
+        Definitions.getProperty(sceneData, Definitions.bvhTraversal));
+
+    nodeFormatComboBox.currentIndex = nodeFormatComboBox.find(
+        Definitions.getProperty(sceneData, Definitions.bvhNodeFormat));
+
+    maxLeafSizeSpinBox.value =
+        Definitions.getProperty(sceneData, Definitions.bvhMaxLeafSize);
+
+    nodeWidthComboBox.currentIndex = nodeWidthComboBox.find(
+        String(Definitions.getProperty(sceneData, Definitions.bvhNodeWidth)));
+
     var bvhView = bvhItemLayout.children[bvhTypeComboBox.currentIndex];
     bvhView.setSceneData(sceneData);
   }
@@ -57,6 +57,8 @@ NPane {
     onCurrentIndexIsChanged: {
       settingView.updateTransformationButtons(objectTree.getCurrentIndex());
     }
+
+    onTransformationIsChanged: settingView.transformationIsChanged()
   }
 
   NTransformationListOperationButton {
@@ -75,6 +77,7 @@ NPane {
         var source = transformationList.getCurrentIndex();
         var dest = source + 1;
         tModel.move(source, dest, 1);
+        settingView.transformationIsChanged();
       }
     }
     onMoveDownTransformationButtonClicked: {
@@ -83,12 +86,15 @@ NPane {
         var dest = transformationList.getCurrentIndex();
         var source = dest - 1;
         tModel.move(source, dest, 1);
+        settingView.transformationIsChanged();
       }
     }
     onDeleteTransformationButtonClicked: {
       var tModel = getTransformationModel();
-      if (tModel != null)
+      if (tModel != null) {
         tModel.remove(transformationList.getCurrentIndex(), 1);
+        settingView.transformationIsChanged();
+      }
     }
 
     function addTransformationItem(transformationType) {
@@ -100,6 +106,7 @@ NPane {
                 ? transformationModel.makeScalingItem()
                 : transformationModel.makeRotationItem();
         tModel.append(transformationItem);
+        settingView.transformationIsChanged();
       }
     }
 
@@ -374,4 +381,6 @@ NPane {
     settingView.updateOperationButtons(objectTree.getCurrentIndex());
     objectTree.setCurrentIndex(0);
   }
+
+  signal transformationIsChanged()
 }
@@ -24,6 +24,7 @@ NScrollView {
   property string shapeType: ""
   property string objectFilePath: ""
   property bool smoothing: false
+  property string meshCompression: ""
   property int surfaceIndex: 0
   property bool isEmissiveObject: false
   property int emitterIndex: 0
@@ -51,7 +52,9 @@ NScrollView {
           Layout.preferredHeight: Definitions.defaultSettingItemHeight
           currentIndex: find(objectSettingView.shapeType)
           model: [Definitions.planeObject,
-                  Definitions.meshObject]
+                  Definitions.meshObject,
+                  Definitions.sphereObject,
+                  Definitions.diskObject]
 
           onCurrentTextChanged: objectSettingView.shapeType = currentText
         }
@@ -94,14 +97,28 @@ NScrollView {
 
           Layout.alignment: Qt.AlignLeft | Qt.AlignTop
           Layout.preferredHeight: Definitions.defaultSettingItemHeight
-    //      enabled: objectSettingView.isMeshObject
-          enabled: false // \todo Implement smoothing
+          enabled: objectSettingView.isMeshObject
           checked: objectSettingView.smoothing
           text: "smoothing"
 
           onCheckedChanged: objectSettingView.smoothing = checked
         }
 
+        NComboBox {
+          id: meshCompressionComboBox
+
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          enabled: objectSettingView.isMeshObject
+          currentIndex: find(objectSettingView.meshCompression)
+          model: [Definitions.uncompressedMesh,
+                  Definitions.quantized16Mesh,
+                  Definitions.quantized32Mesh]
+
+          onCurrentTextChanged: objectSettingView.meshCompression = currentText
+        }
+
         NPane {
           Layout.fillWidth: true
           Layout.fillHeight: true
@@ -196,6 +213,7 @@ NScrollView {
     if (!isMeshObject) {
       objectFilePath = "";
       smoothing = false;
+      meshCompression = Definitions.uncompressedMesh;
     }
   }
 
@@ -205,6 +223,8 @@ NScrollView {
 
   onSmoothingChanged: setProperty(Definitions.smoothing, smoothing)
 
+  onMeshCompressionChanged: setProperty(Definitions.meshCompression, meshCompression)
+
   onSurfaceIndexChanged: setProperty(Definitions.surfaceIndex, surfaceIndex)
 
   onIsEmissiveObjectChanged: setProperty(Definitions.isEmissiveObject, isEmissiveObject)
@@ -217,6 +237,7 @@ NScrollView {
     item[Definitions.shapeType] = Definitions.planeObject;
     item[Definitions.objectFilePath] = "";
     item[Definitions.smoothing] = false;
+    item[Definitions.meshCompression] = Definitions.uncompressedMesh;
     item[Definitions.surfaceIndex] = 0;
     item[Definitions.isEmissiveObject] = false;
     item[Definitions.emitterIndex] = 0;
@@ -233,6 +254,7 @@ NScrollView {
       shapeType = Definitions.getProperty(item, Definitions.shapeType);
       objectFilePath = Definitions.getProperty(item, Definitions.objectFilePath);
       smoothing = Definitions.getProperty(item, Definitions.smoothing);
+      meshCompression = Definitions.getProperty(item, Definitions.meshCompression);
       surfaceIndex = Definitions.getProperty(item, Definitions.surfaceIndex);
       isEmissiveObject = Definitions.getProperty(item, Definitions.isEmissiveObject);
       emitterIndex = Definitions.getProperty(item, Definitions.emitterIndex);
@@ -250,6 +272,8 @@ NScrollView {
           Definitions.getProperty(item, Definitions.objectFilePath);
       sceneData[Definitions.smoothing] = 
           Definitions.getProperty(item, Definitions.smoothing);
+      sceneData[Definitions.meshCompression] = 
+          Definitions.getProperty(item, Definitions.meshCompression);
     }
     sceneData[Definitions.surfaceIndex] = 
         Definitions.getProperty(item, Definitions.surfaceIndex);
@@ -269,10 +293,13 @@ NScrollView {
           Definitions.getProperty(sceneData, Definitions.objectFilePath);
       item[Definitions.smoothing] = 
           Definitions.getProperty(sceneData, Definitions.smoothing);
+      item[Definitions.meshCompression] = 
+          Definitions.getProperty(sceneData, Definitions.meshCompression);
     }
     else {
       item[Definitions.objectFilePath] = "";
       item[Definitions.smoothing] = false;
+      item[Definitions.meshCompression] = Definitions.uncompressedMesh;
     }
     item[Definitions.surfaceIndex] = 
         Definitions.getProperty(sceneData, Definitions.surfaceIndex);
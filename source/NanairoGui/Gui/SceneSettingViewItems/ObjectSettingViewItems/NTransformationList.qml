@@ -82,7 +82,10 @@ NPane {
         if (tModel != null) {
           if (Definitions.isInBounds(itemIndex, 0, tModel.count)) {
             var item = tModel.get(itemIndex);
-            Definitions.setProperty(item, propertyName, value);
+            if (Definitions.getProperty(item, propertyName) != value) {
+              Definitions.setProperty(item, propertyName, value);
+              transformationList.transformationIsChanged();
+            }
           }
         }
       }
@@ -172,4 +175,6 @@ NPane {
   }
 
   signal currentIndexIsChanged(int index)
+
+  signal transformationIsChanged()
 }
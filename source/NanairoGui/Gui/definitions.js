@@ -98,6 +98,7 @@ var eyePathLightSampler = "@eyePathLightSampler@";
     var uniformLightSampler = "@uniformLightSampler@";
     var powerWeightedLightSampler = "@powerWeightedLightSampler@";
     var contributionWeightedLightSampler = "@contributionWeightedLightSampler@";
+var enableWavefront = "@enableWavefront@";
 
 // Texture
 var textureModel = "@textureModel@";
@@ -149,8 +150,14 @@ var angleOfView = "@angleOfView@";
 var shapeType = "@shapeType@";
     var planeObject = "@planeObject@";
     var meshObject = "@meshObject@";
+    var sphereObject = "@sphereObject@";
+    var diskObject = "@diskObject@";
 var objectFilePath = "@objectFilePath@";
 var smoothing = "@smoothing@";
+var meshCompression = "@meshCompression@";
+    var uncompressedMesh = "@uncompressedMesh@";
+    var quantized16Mesh = "@quantized16Mesh@";
+    var quantized32Mesh = "@quantized32Mesh@";
 var surfaceIndex = "@surfaceIndex@";
 var isEmissiveObject = "@isEmissiveObject@";
 var emitterIndex = "@emitterIndex@";
@@ -175,6 +182,21 @@ var bvh = "@bvh@";
     var agglomerativeTreeletRestructuringBvh = "@agglomerativeTreeletRestructuringBvh@";
         var treeletSize = "@treeletSize@";
         var optimizationLoopCount = "@optimizationLoopCount@";
+    var binnedSahBvh = "@binnedSahBvh@";
+        var numOfBins = "@numOfBins@";
+    var plocBvh = "@plocBvh@";
+        var searchRadius = "@searchRadius@";
+    var spatialSplitBvh = "@spatialSplitBvh@";
+        var duplicationLimit = "@duplicationLimit@";
+    var bvhTraversal = "@bvhTraversal@";
+        var orderedTraversal = "@orderedTraversal@";
+        var stacklessTraversal = "@stacklessTraversal@";
+    var bvhNodeFormat = "@bvhNodeFormat@";
+        var fullNode = "@fullNode@";
+        var quantized16Node = "@quantized16Node@";
+        var quantized8Node = "@quantized8Node@";
+    var bvhMaxLeafSize = "@bvhMaxLeafSize@";
+    var bvhNodeWidth = "@bvhNodeWidth@";
 
 // Global variables
 
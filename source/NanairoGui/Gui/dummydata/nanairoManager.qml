@@ -66,6 +66,8 @@ QtObject {
                       int axisEventType,
                       int value)
 
+  signal previewSceneEvent(var sceneData)
+
   signal started()
 
   signal stopRendering()
@@ -259,6 +259,7 @@ function getCornellBoxScene() {
             "@enabled@": true,
             "@groupLevel@": 1,
             "@isEmissiveObject@": false,
+            "@meshCompression@": "@uncompressedMesh@",
             "@name@": "TallBlock",
             "@objectFilePath@": "resources/models/Primitives/Cube.obj",
             "@shapeType@": "@meshObject@",
@@ -307,6 +308,7 @@ function getCornellBoxScene() {
             "@enabled@": true,
             "@groupLevel@": 1,
             "@isEmissiveObject@": false,
+            "@meshCompression@": "@uncompressedMesh@",
             "@name@": "ShortBlock",
             "@objectFilePath@": "resources/models/Primitives/Cube.obj",
             "@shapeType@": "@meshObject@",
@@ -380,6 +382,7 @@ function getCornellBoxScene() {
         }
     ],
     "@renderingMethod@": {
+        "@enableWavefront@": false,
         "@eyePathLightSampler@": "@powerWeightedLightSampler@",
         "@pathLength@": 3,
         "@rayCastEpsilon@": 1e-07,
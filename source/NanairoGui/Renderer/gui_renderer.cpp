@@ -11,9 +11,13 @@
 // Standard C++ library
 #include <cstddef>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <utility>
 // Qt
+#include <QJsonObject>
 #include <QObject>
 #include <QString>
 // Zisc
@@ -22,6 +26,7 @@
 // Nanairo
 #include "camera_event.hpp"
 #include "cui_renderer.hpp"
+#include "scene_value.hpp"
 #include "simple_renderer.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/scene.hpp"
@@ -62,14 +67,37 @@ void GuiRenderer::handleCameraEvent(uint32* cycle,
       camera.rotate(value);
     }
     // Reset rendering info
-    initForRendering();
-    ZISC_ASSERT(cycle != nullptr, "The cycle is null.");
-    ZISC_ASSERT(time != nullptr, "The time is null.");
-    auto& stopwatch = system().stopwatch();
-    stopwatch.stop();
-    stopwatch.start();
-    *cycle = 0;
-    *time = Clock::duration::zero();
+    restartRendering(cycle, time);
+  }
+}
+
+/*!
+  \details
+  The scene is received from the GUI thread,
+  so the event is taken under the lock.
+  */
+void GuiRenderer::setSceneEvent(const QJsonObject& scene_value) noexcept
+{
+  std::unique_lock<std::mutex> lock{scene_event_mutex_};
+  scene_event_ = scene_value;
+}
+
+/*!
+  */
+void GuiRenderer::handleSceneEvent(uint32* cycle,
+                                   Clock::duration* time) noexcept
+{
+  QJsonObject scene_value;
+  {
+    std::unique_lock<std::mutex> lock{scene_event_mutex_};
+    std::swap(scene_value, scene_event_);
+  }
+  if (!scene_value.isEmpty()) {
+    const auto scene_settings = SceneValue::toSetting(scene_value);
+    if (updateScene(*scene_settings)) {
+      // Reset rendering info
+      restartRendering(cycle, time);
+    }
   }
 }
 
@@ -81,6 +109,21 @@ void GuiRenderer::initialize() noexcept
     enableSavingAtEachCycle(true);
 }
 
+/*!
+  */
+void GuiRenderer::restartRendering(uint32* cycle,
+                                   Clock::duration* time) noexcept
+{
+  initForRendering();
+  ZISC_ASSERT(cycle != nullptr, "The cycle is null.");
+  ZISC_ASSERT(time != nullptr, "The time is null.");
+  auto& stopwatch = system().stopwatch();
+  stopwatch.stop();
+  stopwatch.start();
+  *cycle = 0;
+  *time = Clock::duration::zero();
+}
+
 /*!
   */
 void GuiRenderer::outputLdrImage(const std::string_view output_path,
@@ -11,9 +11,11 @@
 #define NANAIRO_GUI_RENDERER_HPP
 
 // Standard C++ library
+#include <mutex>
 #include <string>
 #include <string_view>
 // Qt
+#include <QJsonObject>
 #include <QObject>
 // Zisc
 #include "zisc/stopwatch.hpp"
@@ -56,14 +58,24 @@ class GuiRenderer : public QObject, public CuiRenderer
   //! Return the camera event of the renderer
   const CameraEvent& cameraEvent() const noexcept;
 
+  //! Set a scene of which the transformations are applied at the next cycle
+  void setSceneEvent(const QJsonObject& scene_value) noexcept;
+
  private:
   //! Handle camera event
   void handleCameraEvent(uint32* cycle,
                          Clock::duration* time) noexcept override;
 
+  //! Handle scene event
+  void handleSceneEvent(uint32* cycle,
+                        Clock::duration* time) noexcept override;
+
   //! Initialize the renderer
   void initialize() noexcept;
 
+  //! Restart the rendering from the first cycle
+  void restartRendering(uint32* cycle, Clock::duration* time) noexcept;
+
   //! Output LDR image
   void outputLdrImage(const std::string_view output_path,
                       const uint32 cycle,
@@ -71,6 +83,8 @@ class GuiRenderer : public QObject, public CuiRenderer
 
 
   CameraEvent camera_event_;
+  QJsonObject scene_event_;
+  std::mutex scene_event_mutex_;
   RenderingMode mode_;
 };
 
@@ -273,6 +273,15 @@ void GuiRendererManager::connectWithRenderer(GuiRenderer* renderer) noexcept
     };
     connect(this, &GuiRendererManager::previewEvent, handle_camera_event);
   }
+  {
+    auto handle_scene_event = [renderer](const QVariant& scene_data)
+    {
+      ZISC_ASSERT(renderer != nullptr, "The renderer is nulll.");
+      const auto scene_value = QJsonObject::fromVariantMap(scene_data.toMap());
+      renderer->setSceneEvent(scene_value);
+    };
+    connect(this, &GuiRendererManager::previewSceneEvent, handle_scene_event);
+  }
 }
 
 /*!
@@ -281,6 +290,7 @@ void GuiRendererManager::disconnectFromRenderer() noexcept
 {
   disconnect(this, &GuiRendererManager::stopRendering, nullptr, nullptr);
   disconnect(this, &GuiRendererManager::previewEvent, nullptr, nullptr);
+  disconnect(this, &GuiRendererManager::previewSceneEvent, nullptr, nullptr);
 }
 
 /*!
@@ -104,6 +104,9 @@ class GuiRendererManager : public QObject, public CuiRendererManager
                     const int axis_event_type,
                     const int value) const;
 
+  //! Called when the transformations of the scene are changed in previewing
+  void previewSceneEvent(const QVariant& scene_data) const;
+
   //! Notify of updating rendering progress
   void notifyOfRenderingProgress(const double progress,
                                  const QString& status) const;
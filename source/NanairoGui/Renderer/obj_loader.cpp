@@ -108,49 +108,82 @@ std::array<uint, 4> ObjLoader::countNumOfMeshes(QTextStream& obj_stream) noexcep
 }
 
 /*!
+  \details
+  A triangle and a quad are loaded as a face,
+  a polygon which has more corners is split into triangles like a fan.
   */
 void ObjLoader::loadFace(QTextStream& face_line,
                          const bool has_vnormal,
                          const bool has_vuv,
                          const bool smoothing,
-                         Face* face) noexcept
+                         zisc::pmr::vector<Face>* face_list) noexcept
 {
+  // The vertex, vuv and vnormal indices of a corner
+  using Corner = std::array<uint, 3>;
+  zisc::pmr::vector<Corner> corner_list{face_list->get_allocator().resource()};
   char delimiter;
-  uint vertex_indices[3];
-  uint vnormal_indices[3];
-  uint vuv_indices[3];
-  for (uint i = 0; i < 3; ++i) {
+  face_line.skipWhiteSpace();
+  while (!face_line.atEnd() && (face_line.status() == QTextStream::Ok)) {
+    Corner corner{{0, 0, 0}};
     if (has_vnormal && has_vuv) {
-      face_line >> vertex_indices[i] >> delimiter
-                >> vuv_indices[i] >> delimiter
-                >> vnormal_indices[i];
+      face_line >> corner[0] >> delimiter
+                >> corner[1] >> delimiter
+                >> corner[2];
     }
     else if (has_vnormal && !has_vuv) {
-      face_line >> vertex_indices[i] >> delimiter >> delimiter
-                >> vnormal_indices[i];
+      face_line >> corner[0] >> delimiter >> delimiter
+                >> corner[2];
     }
     else if (!has_vnormal && has_vuv) {
-      face_line >> vertex_indices[i] >> delimiter >> vuv_indices[i];
+      face_line >> corner[0] >> delimiter >> corner[1];
     }
     else {
-      face_line >> vertex_indices[i];
+      face_line >> corner[0];
     }
+    corner_list.emplace_back(corner);
+    face_line.skipWhiteSpace();
   }
+  if (corner_list.size() < 3)
+    return;
 
-  face->setVertexIndices(zisc::cast<uint32>(vertex_indices[0] - 1),
-                         zisc::cast<uint32>(vertex_indices[1] - 1),
-                         zisc::cast<uint32>(vertex_indices[2] - 1));
+  auto to_index = [&corner_list](const uint c, const uint attribute)
+  {
+    return zisc::cast<uint32>(corner_list[c][attribute] - 1);
+  };
+  auto add_face = [face_list, has_vnormal, has_vuv, smoothing, &to_index]
+  (const uint c0, const uint c1, const uint c2, const uint c3, const bool is_quad)
+  {
+    face_list->emplace_back();
+    auto& face = face_list->back();
+    face.setSmoothing(smoothing);
+    if (is_quad) {
+      face.setVertexIndices(to_index(c0, 0), to_index(c1, 0),
+                            to_index(c2, 0), to_index(c3, 0));
+      if (has_vnormal) {
+        face.setVnormalIndices(to_index(c0, 2), to_index(c1, 2),
+                               to_index(c2, 2), to_index(c3, 2));
+      }
+      if (has_vuv) {
+        face.setVuvIndices(to_index(c0, 1), to_index(c1, 1),
+                           to_index(c2, 1), to_index(c3, 1));
+      }
+    }
+    else {
+      face.setVertexIndices(to_index(c0, 0), to_index(c1, 0), to_index(c2, 0));
+      if (has_vnormal)
+        face.setVnormalIndices(to_index(c0, 2), to_index(c1, 2), to_index(c2, 2));
+      if (has_vuv)
+        face.setVuvIndices(to_index(c0, 1), to_index(c1, 1), to_index(c2, 1));
+    }
+  };
 
-  face->setSmoothing(smoothing);
-  if (has_vnormal) {
-    face->setVnormalIndices(zisc::cast<uint32>(vnormal_indices[0] - 1),
-                            zisc::cast<uint32>(vnormal_indices[1] - 1),
-                            zisc::cast<uint32>(vnormal_indices[2] - 1));
+  const uint num_of_corners = zisc::cast<uint>(corner_list.size());
+  if (num_of_corners == 4) {
+    add_face(0, 1, 2, 3, true);
   }
-  if (has_vuv) {
-    face->setVuvIndices(zisc::cast<uint32>(vuv_indices[0] - 1),
-                        zisc::cast<uint32>(vuv_indices[1] - 1),
-                        zisc::cast<uint32>(vuv_indices[2] - 1));
+  else {
+    for (uint c = 1; (c + 1) < num_of_corners; ++c)
+      add_face(0, c, c + 1, 0, false);
   }
 }
 
@@ -205,9 +238,7 @@ void ObjLoader::loadMesh(QTextStream& obj_stream,
      case zisc::Fnv1aHash32::hash("f"): {
       const bool has_vnormal = (0 < vnormal_list->size());
       const bool has_vuv = (0 < vuv_list->size());
-      face_list->emplace_back();
-      auto& face = face_list->back();
-      loadFace(buffer, has_vnormal, has_vuv, smoothing, &face);
+      loadFace(buffer, has_vnormal, has_vuv, smoothing, face_list);
       break;
      }
      default:
@@ -49,12 +49,12 @@ class ObjLoader
   //! Count the number of meshes
   static std::array<uint, 4> countNumOfMeshes(QTextStream& obj_stream) noexcept;
 
-  //! Load the face data
+  //! Load the faces of a polygon
   static void loadFace(QTextStream& face_line,
                        const bool has_vnormal,
                        const bool has_vuv,
                        const bool smoothing,
-                       Face* face) noexcept;
+                       zisc::pmr::vector<Face>* face_list) noexcept;
 
   //! Load the mesh data
   static void loadMesh(QTextStream& obj_stream,
@@ -61,6 +61,7 @@
 #include "NanairoCore/Setting/texture_setting_node.hpp"
 #include "NanairoCore/Setting/transformation_setting_node.hpp"
 #include "NanairoCore/Shape/shape.hpp"
+#include "NanairoCore/Shape/triangle_mesh.hpp"
 #include "NanairoCore/ToneMappingOperator/tone_mapping_operator.hpp"
 #include "NanairoGui/keyword.hpp"
 
@@ -86,11 +87,44 @@ void SceneValue::toBvhSetting(const QJsonObject& value,
   const auto bvh_value = toObject(value, keyword::bvh);
   {
     const auto bvh_type = toString(bvh_value, keyword::type);
-    const BvhType bvh = (bvh_type == keyword::binaryRadixTreeBvh)
-        ? BvhType::kBinaryRadixTree
-        : BvhType::kAgglomerativeTreeletRestructuring;
+    const BvhType bvh =
+        (bvh_type == keyword::binaryRadixTreeBvh)
+            ? BvhType::kBinaryRadixTree :
+        (bvh_type == keyword::agglomerativeTreeletRestructuringBvh)
+            ? BvhType::kAgglomerativeTreeletRestructuring :
+        (bvh_type == keyword::binnedSahBvh)
+            ? BvhType::kBinnedSah :
+        (bvh_type == keyword::plocBvh)
+            ? BvhType::kPloc
+            : BvhType::kSpatialSplit;
     bvh_setting->setBvhType(bvh);
   }
+  {
+    const auto traversal_type = toString(bvh_value, keyword::bvhTraversal);
+    const BvhTraversalType traversal =
+        (traversal_type == keyword::stacklessTraversal)
+            ? BvhTraversalType::kStackless
+            : BvhTraversalType::kOrdered;
+    bvh_setting->setTraversalType(traversal);
+  }
+  {
+    const auto node_format = toString(bvh_value, keyword::bvhNodeFormat);
+    const BvhNodeFormat format =
+        (node_format == keyword::quantized16Node)
+            ? BvhNodeFormat::kQuantized16 :
+        (node_format == keyword::quantized8Node)
+            ? BvhNodeFormat::kQuantized8
+            : BvhNodeFormat::kFull;
+    bvh_setting->setNodeFormat(format);
+  }
+  {
+    const auto max_leaf_size = toInt<uint32>(bvh_value, keyword::bvhMaxLeafSize);
+    bvh_setting->setMaxLeafSize(max_leaf_size);
+  }
+  {
+    const auto node_width = toInt<uint32>(bvh_value, keyword::bvhNodeWidth);
+    bvh_setting->setNodeWidth(node_width);
+  }
   switch (bvh_setting->bvhType()) {
    case BvhType::kAgglomerativeTreeletRestructuring: {
     auto& parameters = bvh_setting->agglomerativeTreeletRestructuringParameters();
@@ -103,6 +137,31 @@ void SceneValue::toBvhSetting(const QJsonObject& value,
     }
     break;
    }
+   case BvhType::kBinnedSah: {
+    auto& parameters = bvh_setting->binnedSahParameters();
+    {
+      parameters.num_of_bins_ = toInt<uint32>(bvh_value, keyword::numOfBins);
+    }
+    break;
+   }
+   case BvhType::kPloc: {
+    auto& parameters = bvh_setting->plocParameters();
+    {
+      parameters.search_radius_ = toInt<uint32>(bvh_value, keyword::searchRadius);
+    }
+    break;
+   }
+   case BvhType::kSpatialSplit: {
+    auto& parameters = bvh_setting->spatialSplitParameters();
+    {
+      parameters.num_of_bins_ = toInt<uint32>(bvh_value, keyword::numOfBins);
+    }
+    {
+      parameters.duplication_limit_ = toInt<uint32>(bvh_value,
+                                                    keyword::duplicationLimit);
+    }
+    break;
+   }
    case BvhType::kBinaryRadixTree:
    default:
     break;
@@ -370,6 +429,11 @@ void SceneValue::toRenderingMethodSetting(const QJsonObject& value,
       const auto sampler_type = getLightSourceSamplerType(light_sampler);
       parameters.eye_path_light_sampler_type_ = sampler_type;
     }
+    {
+      const auto wavefront_is_enabled = toBool(method_value,
+                                               keyword::enableWavefront);
+      parameters.wavefront_is_enabled_ = wavefront_is_enabled ? kTrue : kFalse;
+    }
     break;
    }
    case RenderingMethodType::kLightTracing: {
@@ -441,7 +505,11 @@ void SceneValue::toSingleObjectSetting(const QJsonObject& object_value,
     const auto shape_type = toString(object_value, keyword::shapeType);
     const ShapeType type =
         (shape_type == keyword::planeObject)
-            ? ShapeType::kPlane
+            ? ShapeType::kPlane :
+        (shape_type == keyword::sphereObject)
+            ? ShapeType::kSphere :
+        (shape_type == keyword::diskObject)
+            ? ShapeType::kDisk
             : ShapeType::kMesh;
     object_setting->setShapeType(type);
   }
@@ -464,6 +532,15 @@ void SceneValue::toSingleObjectSetting(const QJsonObject& object_value,
       const auto smoothing = toBool(object_value, keyword::smoothing);
       parameters.smoothing_ = (smoothing) ? kTrue : kFalse;
     }
+    {
+      const auto mesh_compression = toString(object_value, keyword::meshCompression);
+      parameters.compression_ =
+          (mesh_compression == keyword::quantized16Mesh)
+              ? MeshCompression::kQuantized16 :
+          (mesh_compression == keyword::quantized32Mesh)
+              ? MeshCompression::kQuantized32
+              : MeshCompression::kNone;
+    }
     {
       const auto object_file_path = toString(object_value, keyword::objectFilePath);
       // Open a object file
@@ -494,6 +571,8 @@ void SceneValue::toSingleObjectSetting(const QJsonObject& object_value,
     break;
    }
    case ShapeType::kPlane:
+   case ShapeType::kSphere:
+   case ShapeType::kDisk:
    default:
     break;
   }
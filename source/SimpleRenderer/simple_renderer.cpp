@@ -13,6 +13,7 @@
 #include <chrono>
 #include <cstdio>
 #include <fstream>
+#include <initializer_list>
 #include <limits>
 #include <memory>
 #include <mutex>
@@ -33,11 +34,14 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/scene.hpp"
 #include "NanairoCore/system.hpp"
+#include "NanairoCore/world.hpp"
 #include "NanairoCore/CameraModel/film.hpp"
 #include "NanairoCore/Color/hdr_image.hpp"
 #include "NanairoCore/Color/ldr_image.hpp"
 #include "NanairoCore/Color/rgba_32.hpp"
 #include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/DataStructure/traversal_statistics.hpp"
 #include "NanairoCore/Denoiser/denoiser.hpp"
 #include "NanairoCore/RenderingMethod/rendering_method.hpp"
 #include "NanairoCore/Sampling/sample_statistics.hpp"
@@ -185,6 +189,7 @@ void SimpleRenderer::render(const std::string& output_path) noexcept
 
     clearWorkMemory();
     handleCameraEvent(&cycle, &previous_time);
+    handleSceneEvent(&cycle, &previous_time);
 
     // Render
     renderScene(cycle);
@@ -233,6 +238,34 @@ void SimpleRenderer::setProgressCallback(
   progress_callback_ = callback;
 }
 
+/*!
+  \details
+  The objects are transformed and the BVH is refitted without making
+  the scene again. Returns false if the visible objects of the settings are
+  changed, then the scene isn't updated.
+  */
+bool SimpleRenderer::updateScene(const SettingNodeBase& settings) noexcept
+{
+  const auto scene_settings = castNode<SceneSettingNode>(&settings);
+
+  std::mutex data_mutex;
+  auto& data_resource = system().dataMemoryManager();
+  data_resource.setMutex(&data_mutex);
+
+  const bool result = scene().updateTransformation(system(), scene_settings);
+  if (result) {
+    // The light source samplers refer the light sources of the world
+    const auto method_settings = scene_settings->renderingMethodSettingNode();
+    renderingMethod().makeLightSourceSampler(system(), method_settings, scene());
+  }
+  else {
+    logMessage("The objects of the scene are changed, the update is skipped.");
+  }
+
+  data_resource.setMutex(nullptr);
+  return result;
+}
+
 /*!
   */
 void SimpleRenderer::enableSavingAtEachCycle(const bool flag) noexcept
@@ -247,6 +280,13 @@ void SimpleRenderer::handleCameraEvent(uint32*,
 {
 }
 
+/*!
+  */
+void SimpleRenderer::handleSceneEvent(uint32*,
+                                      Clock::duration*) noexcept
+{
+}
+
 /*!
   */
 void SimpleRenderer::initForRendering() noexcept
@@ -460,6 +500,9 @@ void SimpleRenderer::outputRenderedImage(
     const std::string& output_path,
     const uint32 cycle) noexcept
 {
+  if (TraversalStatistics::isEnabled())
+    outputTraversalStatistics(output_path, cycle);
+
   const auto& film = scene().film();
   const auto& sample_statistics = film.sampleStatistics();
 
@@ -471,6 +514,49 @@ void SimpleRenderer::outputRenderedImage(
   outputLdrImage(output_path, cycle, "cycle");
 }
 
+/*!
+  \details
+  The heatmaps are output before the rendered image,
+  so the LDR image holds the rendered image at the end.
+  */
+void SimpleRenderer::outputTraversalStatistics(
+    const std::string& output_path,
+    const uint32 cycle) noexcept
+{
+  using namespace std::string_literals;
+  using Type = TraversalStatistics::Type;
+
+  const auto& statistics = scene().film().traversalStatistics();
+  // Heatmaps
+  for (const auto type : {Type::kNode, Type::kAabbTest, Type::kObjectTest, Type::kHit}) {
+    statistics.makeHeatmap(type, &ldrImage());
+    const auto suffix = "cycle-"s + TraversalStatistics::name(type);
+    outputLdrImage(output_path, cycle, suffix);
+  }
+
+  // Summary
+  const auto total = statistics.totalCounter();
+  const uint64 num_of_rays = total.count(Type::kRay);
+  auto per_ray = [num_of_rays, &total](const Type type)
+  {
+    return (0 < num_of_rays)
+        ? zisc::cast<double>(total.count(type)) / zisc::cast<double>(num_of_rays)
+        : 0.0;
+  };
+  const double sah_cost = zisc::cast<double>(scene().world().bvh().calcSahCost());
+  std::array<char, 256> message;
+  std::snprintf(message.data(), message.size(),
+                "Traversal: %llu rays, %.2lf nodes/ray, %.2lf AABB tests/ray, "
+                "%.2lf object tests/ray, %.3lf hits/ray, SAH cost %.2lf",
+                zisc::cast<unsigned long long>(num_of_rays),
+                per_ray(Type::kNode),
+                per_ray(Type::kAabbTest),
+                per_ray(Type::kObjectTest),
+                per_ray(Type::kHit),
+                sah_cost);
+  logMessage(message.data());
+}
+
 /*!
   */
 inline
@@ -84,6 +84,9 @@ class SimpleRenderer
   //! Set the renderer state manually
   void setRunnable(const bool is_runnable) noexcept;
 
+  //! Apply the transformations of the settings to the rendering scene
+  bool updateScene(const SettingNodeBase& settings) noexcept;
+
  protected:
   //! Set the flag of saving image at each cycle
   void enableSavingAtEachCycle(const bool flag) noexcept;
@@ -97,6 +100,10 @@ class SimpleRenderer
   virtual void handleCameraEvent(uint32* cycle,
                                  Clock::duration* time) noexcept;
 
+  //! Handle scene event
+  virtual void handleSceneEvent(uint32* cycle,
+                                Clock::duration* time) noexcept;
+
   //! Return the HDR image
   HdrImage& hdrImage() noexcept;
 
@@ -206,6 +213,10 @@ class SimpleRenderer
   void outputRenderedImage(const std::string& output_path,
                            const uint32 cycle) noexcept;
 
+  //! Output the heatmaps and the summary of the BVH traversal
+  void outputTraversalStatistics(const std::string& output_path,
+                                 const uint32 cycle) noexcept;
+
   //! Process elapsed time per frame
   Clock::duration processElapsedTime(
       const Clock::duration& previous_time) const noexcept;
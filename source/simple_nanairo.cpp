@@ -20,6 +20,7 @@
 // Nanairo
 #include "simple_renderer.hpp"
 #include "simple_progress_bar.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
 #include "NanairoCore/Setting/scene_setting_node.hpp"
 
 namespace {
@@ -30,6 +31,7 @@ struct NanairoParameters
 {
   std::string nanabin_file_path_ = " ";
   std::string output_path_ = ".";
+  std::string bvh_cache_path_ = "";
 };
 
 //! Process command line arguments
@@ -53,6 +55,11 @@ int main(int argc, const char** argv)
     // Load scene settings
     nanairo::SceneSettingNode settings;
     settings.readData(&nanabin);
+    {
+      auto bvh_settings =
+          nanairo::castNode<nanairo::BvhSettingNode>(settings.bvhSettingNode());
+      bvh_settings->setCacheDirectory(parameters->bvh_cache_path_);
+    }
     // Initialize renderer
     renderer = std::make_unique<nanairo::SimpleRenderer>();
     log_stream = nanairo::makeTextLogStream(parameters->output_path_);
@@ -111,6 +118,11 @@ std::unique_ptr<NanairoParameters> processCommandLine(int& argc, const char** ar
       options.add_options()
           ("o,outputpath", "Specify the output dir in which images are saved.", value);
     }
+    {
+      auto value = cxxopts::value(parameters->bvh_cache_path_);
+      options.add_options()
+          ("bvhcache", "Specify the dir in which built BVHs are cached.", value);
+    }
 
     // Parse command line
     options.parse_positional({"binpath"});
@@ -0,0 +1,849 @@
+/*!
+  \file bvh_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// GoogleTest
+#include "gtest/gtest.h"
+// Standard C++ library
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <utility>
+// Zisc
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/DataStructure/binary_radix_tree_bvh.hpp"
+#include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/DataStructure/ploc_bvh.hpp"
+#include "NanairoCore/DataStructure/quantized_bvh_node.hpp"
+#include "NanairoCore/DataStructure/traversal_ray.hpp"
+#include "NanairoCore/DataStructure/wide_bvh.hpp"
+#include "NanairoCore/DataStructure/wide_bvh_node.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Material/material.hpp"
+#include "NanairoCore/Material/shader_model.hpp"
+#include "NanairoCore/Material/SurfaceModel/surface_model.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/Setting/single_object_setting_node.hpp"
+#include "NanairoCore/Shape/flat_triangle.hpp"
+#include "NanairoCore/Shape/instance.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+#include "NanairoCore/Shape/triangle_mesh.hpp"
+
+namespace {
+
+//! The surface of the test objects, BVH doesn't evaluate it
+class TestSurface : public nanairo::SurfaceModel
+{
+ public:
+  ShaderPointer makeBxdf(
+      const nanairo::IntersectionInfo& /* info */,
+      const nanairo::WavelengthSamples& /* wavelengths */,
+      nanairo::Sampler& /* sampler */,
+      const nanairo::PathState& /* path_state */,
+      zisc::pmr::memory_resource* /* mem_resource */) const noexcept override
+  {
+    return ShaderPointer{};
+  }
+
+  nanairo::SurfaceType type() const noexcept override
+  {
+    return nanairo::SurfaceType::kSmoothDiffuse;
+  }
+};
+
+/*!
+  \details
+  No detailed.
+  */
+nanairo::TriangleMesh makeRandomMesh(
+    const nanairo::uint32 num_of_faces,
+    const nanairo::uint32 seed,
+    const nanairo::MeshCompression compression = nanairo::MeshCompression::kNone)
+{
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  nanairo::MeshParameters parameters{resource};
+  parameters.compression_ = compression;
+  std::mt19937_64 engine{seed};
+  std::uniform_real_distribution<double> position{-10.0, 10.0};
+  std::uniform_real_distribution<double> offset{-0.5, 0.5};
+  for (nanairo::uint32 face = 0; face < num_of_faces; ++face) {
+    const std::array<double, 3> center{{position(engine),
+                                        position(engine),
+                                        position(engine)}};
+    for (nanairo::uint i = 0; i < 3; ++i) {
+      parameters.vertex_list_.push_back({{center[0] + offset(engine),
+                                          center[1] + offset(engine),
+                                          center[2] + offset(engine)}});
+    }
+    const nanairo::uint32 v = 3 * face;
+    parameters.face_list_.emplace_back(v, v + 1, v + 2);
+  }
+  return nanairo::TriangleMesh{parameters, resource, resource};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+zisc::pmr::vector<nanairo::Object> makeObjects(const nanairo::TriangleMesh& mesh,
+                                               const nanairo::Material& material)
+{
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  zisc::pmr::vector<nanairo::Object> object_list{
+      decltype(object_list)::allocator_type{resource}};
+  object_list.reserve(mesh.numOfFaces());
+  for (nanairo::uint32 face = 0; face < mesh.numOfFaces(); ++face) {
+    zisc::UniqueMemoryPointer<nanairo::Shape> shape =
+        zisc::UniqueMemoryPointer<nanairo::FlatTriangle>::make(resource, &mesh, face);
+    object_list.emplace_back(std::move(shape), &material);
+  }
+  return object_list;
+}
+
+/*!
+  \details
+  Make a mesh of long and thin triangles lying diagonally across the scene,
+  then the bounding boxes of the faces overlap a lot and are split spatially
+  */
+nanairo::TriangleMesh makeDiagonalMesh(const nanairo::uint32 num_of_faces,
+                                       const nanairo::uint32 seed)
+{
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  nanairo::MeshParameters parameters{resource};
+  std::mt19937_64 engine{seed};
+  std::uniform_real_distribution<double> position{-10.0, 10.0};
+  std::uniform_real_distribution<double> offset{-0.1, 0.1};
+  for (nanairo::uint32 face = 0; face < num_of_faces; ++face) {
+    const std::array<double, 3> start{{-10.0, position(engine), -10.0}};
+    const std::array<double, 3> end{{10.0, position(engine), 10.0}};
+    parameters.vertex_list_.push_back({{start[0], start[1], start[2]}});
+    parameters.vertex_list_.push_back({{end[0], end[1], end[2]}});
+    parameters.vertex_list_.push_back({{start[0] + offset(engine),
+                                        start[1] + offset(engine),
+                                        start[2] + 0.2}});
+    const nanairo::uint32 v = 3 * face;
+    parameters.face_list_.emplace_back(v, v + 1, v + 2);
+  }
+  return nanairo::TriangleMesh{parameters, resource, resource};
+}
+
+/*!
+  \details
+  Make a mesh of which the gaps between the faces grow geometrically along
+  the x axis, then the clustering of the faces makes a chain of the faces
+  */
+nanairo::TriangleMesh makeDeepMesh(const nanairo::uint32 num_of_faces)
+{
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  nanairo::MeshParameters parameters{resource};
+  double x = 0.0;
+  for (nanairo::uint32 face = 0; face < num_of_faces; ++face) {
+    const double gap = std::pow(3.0, zisc::cast<double>(face) - 75.0);
+    const double size = gap;
+    x += gap;
+    parameters.vertex_list_.push_back({{x, -size, -size}});
+    parameters.vertex_list_.push_back({{x, size, -size}});
+    parameters.vertex_list_.push_back({{x, 0.0, 2.0 * size}});
+    const nanairo::uint32 v = 3 * face;
+    parameters.face_list_.emplace_back(v, v + 1, v + 2);
+  }
+  return nanairo::TriangleMesh{parameters, resource, resource};
+}
+
+/*!
+  \details
+  Make a ray from the random origin outside of the objects toward the objects
+  */
+nanairo::Ray makeRandomRay(std::mt19937_64& engine)
+{
+  std::uniform_real_distribution<double> position{-15.0, 15.0};
+  const nanairo::Point3 origin{position(engine), position(engine), position(engine)};
+  const nanairo::Point3 target{0.5 * position(engine),
+                               0.5 * position(engine),
+                               0.5 * position(engine)};
+  return nanairo::Ray::makeRay(origin, (target - origin).normalized());
+}
+
+/*!
+  \details
+  Find the closest intersection by testing all objects
+  */
+nanairo::IntersectionInfo findClosestIntersection(
+    const zisc::pmr::vector<nanairo::Object>& object_list,
+    const nanairo::Ray& ray)
+{
+  nanairo::IntersectionInfo intersection;
+  intersection.setRayDistance(std::numeric_limits<nanairo::Float>::max());
+  for (const auto& object : object_list) {
+    if (object.shape().testIntersection(ray, &intersection))
+      intersection.setObject(&object);
+  }
+  return intersection;
+}
+
+/*!
+  \details
+  Test the closest intersections and the occlusions of the BVH against
+  the brute-force search
+  */
+void testBvhTraversal(const nanairo::Bvh& bvh, const nanairo::uint num_of_rays)
+{
+  constexpr nanairo::Float max_distance = std::numeric_limits<nanairo::Float>::max();
+  std::mt19937_64 engine{123456789};
+  for (nanairo::uint i = 0; i < num_of_rays; ++i) {
+    const auto ray = makeRandomRay(engine);
+    const auto reference = findClosestIntersection(bvh.objectList(), ray);
+    const auto intersection = bvh.castRay(ray, max_distance);
+    ASSERT_EQ(reference.object(), intersection.object())
+        << "The closest object of the ray " << i << " is wrong.";
+    if (!reference.isIntersected())
+      continue;
+    ASSERT_DOUBLE_EQ(reference.rayDistance(), intersection.rayDistance())
+        << "The distance of the ray " << i << " is wrong.";
+    ASSERT_TRUE(bvh.testOcclusion(ray, 1.001 * reference.rayDistance()))
+        << "The occluder of the ray " << i << " is missed.";
+    ASSERT_FALSE(bvh.testOcclusion(ray, 0.999 * reference.rayDistance()))
+        << "The ray " << i << " is occluded before the closest object.";
+  }
+}
+
+/*!
+  \details
+  Build the wide BVH of the builder and test it against the brute-force search
+  */
+template <nanairo::uint kWidth, typename BuilderBvh>
+void testWideBvhTraversal(nanairo::System& system,
+                          nanairo::BvhSettingNode* bvh_settings,
+                          const nanairo::TriangleMesh& mesh,
+                          const nanairo::Material& material)
+{
+  bvh_settings->setNodeWidth(kWidth);
+  auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+  bvh->construct(system, bvh_settings, makeObjects(mesh, material));
+  bvh_settings->setNodeWidth(2);
+
+  const auto wide_bvh =
+      dynamic_cast<const nanairo::WideBvh<kWidth, BuilderBvh>*>(bvh.get());
+  ASSERT_NE(nullptr, wide_bvh) << "The BVH isn't " << kWidth << "-wide.";
+  ASSERT_TRUE(wide_bvh->wideTreeIsUsed()) << "The wide tree isn't used.";
+  testBvhTraversal(*bvh, 1000);
+}
+
+/*!
+  \details
+  Test the intersections of the ray packets against the rays cast one by one.
+  The rays of a packet leave a point toward the pixels of a tile around
+  the center ray, which is random unless it is given,
+  and every few packets aren't coherent.
+  */
+void testRayPacket(const nanairo::Bvh& bvh,
+                   const nanairo::uint num_of_packets,
+                   const nanairo::Ray* center_ray = nullptr)
+{
+  using nanairo::uint;
+  constexpr uint packet_size = nanairo::Bvh::maxPacketSize();
+  constexpr nanairo::Float max_distance = std::numeric_limits<nanairo::Float>::max();
+  std::mt19937_64 engine{192837465};
+  std::uniform_real_distribution<double> spread{-0.05, 0.05};
+  std::array<nanairo::Ray, packet_size> ray_list;
+  std::array<nanairo::IntersectionInfo, packet_size> intersection_list;
+  for (uint packet = 0; packet < num_of_packets; ++packet) {
+    const bool is_coherent = (packet % 4) != 3;
+    const auto center = (center_ray != nullptr) ? *center_ray
+                                                : makeRandomRay(engine);
+    for (auto& ray : ray_list) {
+      if (is_coherent) {
+        const nanairo::Vector3 offset{spread(engine), spread(engine), spread(engine)};
+        const auto direction = (center.direction() + offset).normalized();
+        ray = nanairo::Ray::makeRay(center.origin(), direction);
+      }
+      else {
+        ray = makeRandomRay(engine);
+      }
+    }
+    bvh.castRayPacket(ray_list.data(), packet_size, intersection_list.data());
+    for (uint i = 0; i < packet_size; ++i) {
+      const auto reference = bvh.castRay(ray_list[i], max_distance);
+      const auto& intersection = intersection_list[i];
+      ASSERT_EQ(reference.object(), intersection.object())
+          << "The object of the ray " << i << " of the packet " << packet
+          << " is wrong.";
+      if (!reference.isIntersected())
+        continue;
+      ASSERT_DOUBLE_EQ(reference.rayDistance(), intersection.rayDistance())
+          << "The distance of the ray " << i << " of the packet " << packet
+          << " is wrong.";
+      for (uint axis = 0; axis < 3; ++axis) {
+        ASSERT_DOUBLE_EQ(reference.normal()[axis], intersection.normal()[axis])
+            << "The normal of the ray " << i << " of the packet " << packet
+            << " is wrong.";
+      }
+    }
+  }
+}
+
+/*!
+  \details
+  Return the path of the only cache file in the directory
+  */
+std::filesystem::path findCacheFile(const std::filesystem::path& cache_directory)
+{
+  const std::filesystem::directory_iterator first{cache_directory};
+  const auto num_of_files = std::distance(first, std::filesystem::directory_iterator{});
+  EXPECT_EQ(1, num_of_files) << "The number of the cache files is wrong.";
+  return (num_of_files == 1)
+      ? std::filesystem::directory_iterator{cache_directory}->path()
+      : std::filesystem::path{};
+}
+
+} // namespace
+
+TEST(BvhTest, WideBvhNodeIntersectionTest)
+{
+  using nanairo::uint;
+  using nanairo::Aabb;
+  using nanairo::Float;
+  using nanairo::Point3;
+  using nanairo::Vector3;
+  using NodeType = nanairo::WideBvhNode<4>;
+
+  // Three boxes on the x axis, the last lane is empty
+  NodeType node;
+  node.setChild(0, Aabb{Point3{4.0, -1.0, -1.0}, Point3{5.0, 1.0, 1.0}}, 0, 1);
+  node.setChild(1, Aabb{Point3{1.0, -1.0, -1.0}, Point3{2.0, 1.0, 1.0}}, 1, 1);
+  node.setChild(2, Aabb{Point3{1.0, 2.0, -1.0}, Point3{2.0, 3.0, 1.0}}, 2, 0);
+  ASSERT_EQ(3u, node.numOfChildren());
+  ASSERT_TRUE(node.isLeafChild(0));
+  ASSERT_FALSE(node.isLeafChild(2));
+  ASSERT_FALSE(node.hasChild(3));
+
+  const Point3 origin{0.0, 0.0, 0.0};
+  const nanairo::TraversalRay ray{
+      nanairo::Ray::makeRay(origin, Vector3{1.0, 0.0, 0.0})};
+  NodeType::FloatArray distance_list;
+  // Long ray
+  {
+    const uint mask = node.testIntersection(ray, 10.0, &distance_list);
+    ASSERT_EQ(0b0011u, mask) << "The wide node intersection test is wrong.";
+    ASSERT_DOUBLE_EQ(4.0, distance_list[0]);
+    ASSERT_DOUBLE_EQ(1.0, distance_list[1]);
+  }
+  // Short ray
+  {
+    const uint mask = node.testIntersection(ray, 3.0, &distance_list);
+    ASSERT_EQ(0b0010u, mask) << "The max distance of the ray isn't respected.";
+  }
+  // Opposite direction
+  {
+    const nanairo::TraversalRay ray2{
+        nanairo::Ray::makeRay(origin, Vector3{-1.0, 0.0, 0.0})};
+    const uint mask = node.testIntersection(ray2, 10.0, &distance_list);
+    ASSERT_EQ(0b0000u, mask) << "The boxes behind the ray are hit.";
+  }
+}
+
+TEST(BvhTest, WideBvhNodeGrazingRayTest)
+{
+  using nanairo::uint;
+  using nanairo::Aabb;
+  using nanairo::Point3;
+  using nanairo::Vector3;
+  using NodeType = nanairo::WideBvhNode<4>;
+
+  // The ray touches an edge of the box at (0.4, 0.7, 0.0).
+  // The values aren't representable, so the box is missed
+  // unless the bounds and the origin are rounded conservatively
+  NodeType node;
+  node.setChild(0, Aabb{Point3{0.4, -0.3, -1.0}, Point3{1.4, 0.7, 1.0}}, 0, 1);
+
+  const Point3 origin{0.1, 0.1, 0.0};
+  const Vector3 direction = Vector3{1.0, 2.0, 0.0}.normalized();
+  const nanairo::TraversalRay ray{nanairo::Ray::makeRay(origin, direction)};
+  NodeType::FloatArray distance_list;
+  const uint mask = node.testIntersection(ray, 10.0, &distance_list);
+  ASSERT_EQ(0b0001u, mask) << "The grazed box is missed.";
+  ASSERT_NEAR(0.3 * zisc::sqrt(5.0), distance_list[0], 1.0e-5)
+      << "The entry distance of the grazed box is wrong.";
+}
+
+TEST(BvhTest, QuantizedBvhNodeConservativeTest)
+{
+  using nanairo::uint;
+  using nanairo::Aabb;
+  using nanairo::Point3;
+  using NodeType = nanairo::QuantizedBvhNode<nanairo::uint8>;
+
+  const Aabb parent_box{Point3{-1.1, 0.3, 2.0}, Point3{3.7, 0.3, 1000.01}};
+  const Aabb child_box{Point3{0.123, 0.3, 500.5}, Point3{1.456, 0.3, 600.7}};
+  NodeType node;
+  node.setBoundingBox(parent_box);
+  node.setChild(0, parent_box, 0, 0);
+  node.setChild(1, child_box, 5, 2);
+  ASSERT_FALSE(node.isLeafChild(0));
+  ASSERT_TRUE(node.isLeafChild(1));
+  ASSERT_EQ(5u, node.childIndex(1));
+  ASSERT_EQ(2u, node.numOfObjects(1));
+
+  auto contains = [](const Aabb& outer, const Aabb& inner)
+  {
+    bool result = true;
+    for (uint axis = 0; axis < 3; ++axis) {
+      result = result && (outer.minPoint()[axis] <= inner.minPoint()[axis]) &&
+                         (inner.maxPoint()[axis] <= outer.maxPoint()[axis]);
+    }
+    return result;
+  };
+  ASSERT_TRUE(contains(node.childBoundingBox(0), parent_box))
+      << "The quantized box doesn't contain the parent box.";
+  ASSERT_TRUE(contains(node.childBoundingBox(1), child_box))
+      << "The quantized box doesn't contain the child box.";
+  // The box is expanded by two grid steps at most
+  const auto quantized_box = node.childBoundingBox(1);
+  const auto grid_step = (parent_box.maxPoint()[2] - parent_box.minPoint()[2]) /
+                         NodeType::maxValue();
+  ASSERT_GT(child_box.maxPoint()[2] - child_box.minPoint()[2] + 2.0 * grid_step,
+            quantized_box.maxPoint()[2] - quantized_box.minPoint()[2])
+      << "The quantized box is too loose.";
+}
+
+TEST(BvhTest, TraversalTest)
+{
+  using nanairo::BvhNodeFormat;
+  using nanairo::BvhTraversalType;
+  using nanairo::BvhType;
+  using nanairo::MeshCompression;
+  using nanairo::Transformation;
+
+  nanairo::SceneSettingNode scene_settings;
+  scene_settings.initialize();
+  nanairo::System system{scene_settings.systemSettingNode()};
+  auto bvh_settings = zisc::cast<nanairo::BvhSettingNode*>(
+      scene_settings.bvhSettingNode());
+
+  TestSurface surface;
+  const nanairo::Material material{&surface, nullptr};
+  const auto mesh = makeRandomMesh(2000, 12345);
+  for (const auto bvh_type : {BvhType::kBinaryRadixTree,
+                              BvhType::kBinnedSah,
+                              BvhType::kPloc}) {
+    for (const auto traversal_type : {BvhTraversalType::kStackless,
+                                      BvhTraversalType::kOrdered}) {
+      bvh_settings->setBvhType(bvh_type);
+      bvh_settings->setTraversalType(traversal_type);
+      auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+      bvh->construct(system, bvh_settings, makeObjects(mesh, material));
+      ASSERT_EQ(traversal_type, bvh->traversalType())
+          << "The traversal type is changed.";
+      testBvhTraversal(*bvh, 1000);
+    }
+  }
+
+  // The top levels of a large mesh are binned in parallel,
+  // 2^16 is the threshold of BinnedSahBvh::parallelBinningThreshold()
+  {
+    const auto large_mesh = makeRandomMesh(1u << 16, 54321);
+    bvh_settings->setBvhType(BvhType::kBinnedSah);
+    bvh_settings->setTraversalType(BvhTraversalType::kOrdered);
+    auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+    bvh->construct(system, bvh_settings, makeObjects(large_mesh, material));
+    testBvhTraversal(*bvh, 200);
+  }
+
+  // The long diagonal triangles are referred from several leaves
+  {
+    const auto diagonal_mesh = makeDiagonalMesh(500, 24680);
+    bvh_settings->setBvhType(BvhType::kSpatialSplit);
+    for (const auto traversal_type : {BvhTraversalType::kStackless,
+                                      BvhTraversalType::kOrdered}) {
+      bvh_settings->setTraversalType(traversal_type);
+      auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+      bvh->construct(system, bvh_settings, makeObjects(diagonal_mesh, material));
+      ASSERT_GT(bvh->referenceList().size(), bvh->objectList().size())
+          << "The objects aren't split spatially.";
+      testBvhTraversal(*bvh, 1000);
+    }
+  }
+
+  // The quantized trees are traversed and refitted in place
+  for (const auto node_format : {BvhNodeFormat::kQuantized16,
+                                 BvhNodeFormat::kQuantized8}) {
+    auto moved_mesh = makeRandomMesh(2000, 13579);
+    bvh_settings->setBvhType(BvhType::kBinaryRadixTree);
+    bvh_settings->setNodeFormat(node_format);
+    auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+    bvh->construct(system, bvh_settings, makeObjects(moved_mesh, material));
+    ASSERT_EQ(node_format, bvh->nodeFormat()) << "The node format is changed.";
+    testBvhTraversal(*bvh, 1000);
+
+    // A small motion keeps the tree
+    moved_mesh.transform(Transformation::makeTranslation(0.5, -0.3, 0.2));
+    zisc::pmr::vector<nanairo::Matrix4x4> transformation_list{
+        bvh->objectList().size(),
+        Transformation::makeIdentity(),
+        decltype(transformation_list)::allocator_type{
+            zisc::SimpleMemoryResource::sharedResource()}};
+    ASSERT_FALSE(bvh->refit(system, bvh_settings, transformation_list))
+        << "The quantized tree is built again.";
+    testBvhTraversal(*bvh, 1000);
+  }
+  bvh_settings->setNodeFormat(BvhNodeFormat::kFull);
+
+  // The tree of each builder is collapsed into the wide tree
+  bvh_settings->setTraversalType(BvhTraversalType::kOrdered);
+  bvh_settings->setBvhType(BvhType::kBinaryRadixTree);
+  testWideBvhTraversal<4, nanairo::BinaryRadixTreeBvh>(system, bvh_settings, mesh, material);
+  testWideBvhTraversal<8, nanairo::BinaryRadixTreeBvh>(system, bvh_settings, mesh, material);
+  bvh_settings->setBvhType(BvhType::kPloc);
+  testWideBvhTraversal<4, nanairo::PlocBvh>(system, bvh_settings, mesh, material);
+  testWideBvhTraversal<8, nanairo::PlocBvh>(system, bvh_settings, mesh, material);
+
+  // The triangles of a compressed mesh are tested with the shared vertices
+  {
+    const auto compressed_mesh = makeRandomMesh(2000,
+                                                12345,
+                                                MeshCompression::kQuantized16);
+    bvh_settings->setBvhType(BvhType::kBinaryRadixTree);
+    bvh_settings->setTraversalType(BvhTraversalType::kStackless);
+    auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+    bvh->construct(system, bvh_settings, makeObjects(compressed_mesh, material));
+    testBvhTraversal(*bvh, 1000);
+  }
+}
+
+TEST(BvhTest, CacheTest)
+{
+  namespace fs = std::filesystem;
+  using nanairo::uint32;
+
+  nanairo::SceneSettingNode scene_settings;
+  scene_settings.initialize();
+  nanairo::System system{scene_settings.systemSettingNode()};
+  auto bvh_settings = zisc::cast<nanairo::BvhSettingNode*>(
+      scene_settings.bvhSettingNode());
+
+  const fs::path cache_root = fs::path{testing::TempDir()} / "nanairo_bvh_cache";
+  const std::array<fs::path, 2> cache_directory_list{{cache_root / "mesh1",
+                                                      cache_root / "mesh2"}};
+  fs::remove_all(cache_root);
+  for (const auto& cache_directory : cache_directory_list)
+    fs::create_directories(cache_directory);
+
+  TestSurface surface;
+  const nanairo::Material material{&surface, nullptr};
+  const std::array<nanairo::TriangleMesh, 2> mesh_list{{makeRandomMesh(1000, 1),
+                                                        makeRandomMesh(1000, 2)}};
+  auto build = [&](const uint32 mesh_index)
+  {
+    const auto cache_directory = cache_directory_list[mesh_index].string();
+    bvh_settings->setCacheDirectory(cache_directory);
+    auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+    bvh->construct(system, bvh_settings, makeObjects(mesh_list[mesh_index], material));
+    return bvh;
+  };
+  // The time stamp tells whether the file is written again
+  const auto old_time = fs::file_time_type::clock::now() - std::chrono::hours{24};
+
+  // Round trip
+  const auto bvh = build(0);
+  const auto cache_file = findCacheFile(cache_directory_list[0]);
+  ASSERT_FALSE(cache_file.empty()) << "The cache file isn't saved.";
+  fs::last_write_time(cache_file, old_time);
+  {
+    const auto cached_bvh = build(0);
+    ASSERT_EQ(old_time, fs::last_write_time(cache_file))
+        << "The cache file isn't loaded.";
+    const auto& tree = bvh->bvhTree();
+    const auto& cached_tree = cached_bvh->bvhTree();
+    ASSERT_EQ(tree.size(), cached_tree.size()) << "The cached tree is wrong.";
+    for (std::size_t i = 0; i < tree.size(); ++i) {
+      ASSERT_EQ(tree[i].failureNextIndex(), cached_tree[i].failureNextIndex())
+          << "The cached tree is wrong.";
+      ASSERT_EQ(tree[i].numOfObjects(), cached_tree[i].numOfObjects())
+          << "The cached tree is wrong.";
+    }
+    ASSERT_TRUE(bvh->referenceList() == cached_bvh->referenceList())
+        << "The cached reference list is wrong.";
+    testBvhTraversal(*cached_bvh, 500);
+  }
+
+  // Stale file, the tree of the other mesh is stored with the key of the mesh
+  {
+    build(1);
+    const auto other_cache_file = findCacheFile(cache_directory_list[1]);
+    ASSERT_FALSE(other_cache_file.empty()) << "The cache file isn't saved.";
+    std::string data;
+    {
+      std::ifstream file{other_cache_file, std::ios::binary};
+      data.assign(std::istreambuf_iterator<char>{file},
+                  std::istreambuf_iterator<char>{});
+    }
+    {
+      // The key follows the identifier and the version in the header
+      constexpr std::size_t key_offset = 2 * sizeof(uint32);
+      std::ifstream file{cache_file, std::ios::binary};
+      file.seekg(key_offset);
+      file.read(&data[key_offset], sizeof(nanairo::uint64));
+    }
+    {
+      std::ofstream file{cache_file, std::ios::binary | std::ios::trunc};
+      file.write(data.data(), zisc::cast<std::streamsize>(data.size()));
+    }
+    fs::last_write_time(cache_file, old_time);
+    const auto rebuilt_bvh = build(0);
+    ASSERT_NE(old_time, fs::last_write_time(cache_file))
+        << "The stale cache file is loaded.";
+    testBvhTraversal(*rebuilt_bvh, 500);
+  }
+
+  // Broken links, the failure link of the root points back to the root
+  {
+    std::string data;
+    {
+      std::ifstream file{cache_file, std::ios::binary};
+      data.assign(std::istreambuf_iterator<char>{file},
+                  std::istreambuf_iterator<char>{});
+    }
+    {
+      // The tree follows the header and the object order
+      constexpr std::size_t header_size = 5 * sizeof(uint32) + sizeof(nanairo::uint64);
+      const std::size_t failure_offset = header_size +
+          mesh_list[0].numOfFaces() * sizeof(uint32) +
+          sizeof(nanairo::BvhTreeNode) - sizeof(uint32);
+      const uint32 failure_next_index = 0;
+      std::memcpy(&data[failure_offset], &failure_next_index, sizeof(uint32));
+    }
+    {
+      std::ofstream file{cache_file, std::ios::binary | std::ios::trunc};
+      file.write(data.data(), zisc::cast<std::streamsize>(data.size()));
+    }
+    fs::last_write_time(cache_file, old_time);
+    const auto rebuilt_bvh = build(0);
+    ASSERT_NE(old_time, fs::last_write_time(cache_file))
+        << "The cache file with broken links is loaded.";
+    testBvhTraversal(*rebuilt_bvh, 500);
+  }
+  fs::remove_all(cache_root);
+}
+
+TEST(BvhTest, InstanceTest)
+{
+  using nanairo::Transformation;
+  using nanairo::uint;
+
+  nanairo::SceneSettingNode scene_settings;
+  scene_settings.initialize();
+  nanairo::System system{scene_settings.systemSettingNode()};
+  auto bvh_settings = zisc::cast<nanairo::BvhSettingNode*>(
+      scene_settings.bvhSettingNode());
+
+  TestSurface surface;
+  const nanairo::Material material{&surface, nullptr};
+  const std::array<nanairo::Matrix4x4, 3> transformation_list{{
+      Transformation::makeTranslation(-12.0, 0.0, 3.0) *
+          Transformation::makeYAxisRotation(0.7),
+      Transformation::makeTranslation(4.0, 10.0, -5.0) *
+          Transformation::makeScaling(0.5, 1.5, 1.0),
+      Transformation::makeXAxisRotation(-1.2) *
+          Transformation::makeScaling(1.2, 1.2, 1.2)}};
+
+  // The instances of a mesh
+  const auto mesh = makeRandomMesh(500, 3);
+  auto bottom_bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+  bottom_bvh->construct(system, bvh_settings, makeObjects(mesh, material));
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  zisc::pmr::vector<nanairo::Object> instance_list{
+      decltype(instance_list)::allocator_type{resource}};
+  for (const auto& transformation : transformation_list) {
+    zisc::UniqueMemoryPointer<nanairo::Shape> shape =
+        zisc::UniqueMemoryPointer<nanairo::Instance>::make(resource,
+                                                           bottom_bvh.get());
+    shape->transform(transformation);
+    instance_list.emplace_back(std::move(shape), &material);
+  }
+  auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+  bvh->construct(system, bvh_settings, std::move(instance_list));
+
+  // The transformed copies of the mesh
+  std::array<nanairo::TriangleMesh, 3> mesh_list{{makeRandomMesh(500, 3),
+                                                  makeRandomMesh(500, 3),
+                                                  makeRandomMesh(500, 3)}};
+  zisc::pmr::vector<nanairo::Object> object_list{
+      decltype(object_list)::allocator_type{resource}};
+  for (uint i = 0; i < mesh_list.size(); ++i) {
+    mesh_list[i].transform(transformation_list[i]);
+    for (auto& object : makeObjects(mesh_list[i], material))
+      object_list.emplace_back(std::move(object));
+  }
+  auto reference_bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+  reference_bvh->construct(system, bvh_settings, std::move(object_list));
+
+  constexpr nanairo::Float max_distance = std::numeric_limits<nanairo::Float>::max();
+  std::mt19937_64 engine{987654321};
+  for (uint i = 0; i < 1000; ++i) {
+    const auto ray = makeRandomRay(engine);
+    const auto reference = reference_bvh->castRay(ray, max_distance);
+    const auto intersection = bvh->castRay(ray, max_distance);
+    ASSERT_EQ(reference.isIntersected(), intersection.isIntersected())
+        << "The intersection of the ray " << i << " is wrong.";
+    if (!reference.isIntersected())
+      continue;
+    ASSERT_NEAR(reference.rayDistance(), intersection.rayDistance(), 1.0e-8)
+        << "The distance of the ray " << i << " is wrong.";
+    ASSERT_EQ(reference.isBackFace(), intersection.isBackFace())
+        << "The face of the ray " << i << " is wrong.";
+    for (uint axis = 0; axis < 3; ++axis) {
+      ASSERT_NEAR(reference.point()[axis], intersection.point()[axis], 1.0e-8)
+          << "The point of the ray " << i << " is wrong.";
+      ASSERT_NEAR(reference.normal()[axis], intersection.normal()[axis], 1.0e-8)
+          << "The normal of the ray " << i << " is wrong.";
+    }
+  }
+}
+
+TEST(BvhTest, RefitTest)
+{
+  using nanairo::BvhTraversalType;
+  using nanairo::Transformation;
+  using nanairo::uint;
+
+  nanairo::SceneSettingNode scene_settings;
+  scene_settings.initialize();
+  nanairo::System system{scene_settings.systemSettingNode()};
+  auto bvh_settings = zisc::cast<nanairo::BvhSettingNode*>(
+      scene_settings.bvhSettingNode());
+
+  // The objects of the second mesh are distinguished by the material
+  TestSurface surface;
+  const std::array<nanairo::Material, 2> material_list{{
+      nanairo::Material{&surface, nullptr},
+      nanairo::Material{&surface, nullptr}}};
+  // A small motion keeps the tree and a large motion degrades it
+  const std::array<nanairo::Matrix4x4, 2> motion_list{{
+      Transformation::makeTranslation(0.5, -0.3, 0.2),
+      Transformation::makeTranslation(8.0, 0.0, -6.0) *
+          Transformation::makeYAxisRotation(1.0)}};
+
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  auto make_objects = [&material_list, resource](
+      const std::array<nanairo::TriangleMesh, 2>& mesh_list)
+  {
+    zisc::pmr::vector<nanairo::Object> object_list{
+        decltype(object_list)::allocator_type{resource}};
+    for (uint i = 0; i < mesh_list.size(); ++i) {
+      for (auto& object : makeObjects(mesh_list[i], material_list[i]))
+        object_list.emplace_back(std::move(object));
+    }
+    return object_list;
+  };
+
+  for (const auto traversal_type : {BvhTraversalType::kStackless,
+                                    BvhTraversalType::kOrdered}) {
+    bvh_settings->setTraversalType(traversal_type);
+    std::array<nanairo::TriangleMesh, 2> mesh_list{{makeRandomMesh(1000, 5),
+                                                    makeRandomMesh(1000, 6)}};
+    auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+    bvh->construct(system, bvh_settings, make_objects(mesh_list));
+    for (const auto& motion : motion_list) {
+      // Move the second mesh and refit the tree,
+      // the faces of the meshes are given the identity
+      mesh_list[1].transform(motion);
+      zisc::pmr::vector<nanairo::Matrix4x4> transformation_list{
+          bvh->objectList().size(),
+          Transformation::makeIdentity(),
+          decltype(transformation_list)::allocator_type{resource}};
+      bvh->refit(system, bvh_settings, transformation_list);
+      testBvhTraversal(*bvh, 500);
+
+      // The refitted tree finds the same hits as a fresh tree
+      auto fresh_bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+      fresh_bvh->construct(system, bvh_settings, make_objects(mesh_list));
+      constexpr nanairo::Float max_distance =
+          std::numeric_limits<nanairo::Float>::max();
+      std::mt19937_64 engine{1122334455};
+      for (uint i = 0; i < 500; ++i) {
+        const auto ray = makeRandomRay(engine);
+        const auto reference = fresh_bvh->castRay(ray, max_distance);
+        const auto intersection = bvh->castRay(ray, max_distance);
+        ASSERT_EQ(reference.isIntersected(), intersection.isIntersected())
+            << "The intersection of the ray " << i << " is wrong.";
+        if (!reference.isIntersected())
+          continue;
+        ASSERT_DOUBLE_EQ(reference.rayDistance(), intersection.rayDistance())
+            << "The distance of the ray " << i << " is wrong.";
+        ASSERT_EQ(&reference.object()->material(),
+                  &intersection.object()->material())
+            << "The mesh of the ray " << i << " is wrong.";
+      }
+    }
+  }
+}
+
+TEST(BvhTest, RayPacketTest)
+{
+  using nanairo::BvhNodeFormat;
+  using nanairo::BvhTraversalType;
+
+  nanairo::SceneSettingNode scene_settings;
+  scene_settings.initialize();
+  nanairo::System system{scene_settings.systemSettingNode()};
+  auto bvh_settings = zisc::cast<nanairo::BvhSettingNode*>(
+      scene_settings.bvhSettingNode());
+
+  TestSurface surface;
+  const nanairo::Material material{&surface, nullptr};
+  const auto mesh = makeRandomMesh(2000, 24680);
+  for (const auto node_format : {BvhNodeFormat::kFull,
+                                 BvhNodeFormat::kQuantized8}) {
+    for (const auto traversal_type : {BvhTraversalType::kStackless,
+                                      BvhTraversalType::kOrdered}) {
+      bvh_settings->setNodeFormat(node_format);
+      bvh_settings->setTraversalType(traversal_type);
+      auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+      bvh->construct(system, bvh_settings, makeObjects(mesh, material));
+      testRayPacket(*bvh, 200);
+    }
+  }
+
+  // The packet traversal falls back to the single rays in a deep tree
+  {
+    constexpr nanairo::uint32 num_of_faces = 150;
+    bvh_settings->setBvhType(nanairo::BvhType::kPloc);
+    bvh_settings->plocParameters().search_radius_ = num_of_faces;
+    bvh_settings->setNodeFormat(BvhNodeFormat::kFull);
+    bvh_settings->setTraversalType(BvhTraversalType::kOrdered);
+    const auto deep_mesh = makeDeepMesh(num_of_faces);
+    auto bvh = nanairo::Bvh::makeBvh(system, bvh_settings);
+    bvh->construct(system, bvh_settings, makeObjects(deep_mesh, material));
+    ASSERT_EQ(BvhTraversalType::kStackless, bvh->traversalType())
+        << "The tree isn't deeper than the traversal stack.";
+    // The rays along the chain visit both children of every level
+    const auto chain_ray = nanairo::Ray::makeRay(
+        nanairo::Point3{0.0, 0.0, 0.0},
+        nanairo::Vector3{1.0, 0.1, 0.1}.normalized());
+    testRayPacket(*bvh, 200, &chain_ray);
+  }
+}
@@ -0,0 +1,182 @@
+/*!
+  \file path_tracing_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// GoogleTest
+#include "gtest/gtest.h"
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/scene.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/CameraModel/film.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/RenderingMethod/path_tracing.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
+#include "NanairoCore/Sampling/sampled_wavelengths.hpp"
+#include "NanairoCore/Sampling/wavelength_sampler.hpp"
+#include "NanairoCore/Setting/group_object_setting_node.hpp"
+#include "NanairoCore/Setting/material_setting_node.hpp"
+#include "NanairoCore/Setting/object_model_setting_node.hpp"
+#include "NanairoCore/Setting/rendering_method_setting_node.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/Setting/single_object_setting_node.hpp"
+#include "NanairoCore/Setting/surface_setting_node.hpp"
+#include "NanairoCore/Setting/system_setting_node.hpp"
+#include "NanairoCore/Setting/transformation_setting_node.hpp"
+
+namespace {
+
+/*!
+  \details
+  A box of planes with a light on the ceiling is in front of the camera.
+  The walls have diffuse, glossy and specular surfaces.
+  */
+void makeTestScene(nanairo::SceneSettingNode& scene_settings)
+{
+  using nanairo::ObjectType;
+  using nanairo::SurfaceType;
+  using nanairo::TransformationType;
+  constexpr double pi = zisc::kPi<double>;
+
+  scene_settings.initialize();
+  auto system_settings = zisc::cast<nanairo::SystemSettingNode*>(
+      scene_settings.systemSettingNode());
+  system_settings->setNumOfThreads(2);
+  system_settings->setImageResolution(nanairo::CoreConfig::imageWidthMin(),
+                                      nanairo::CoreConfig::imageHeightMin());
+
+  // Materials
+  auto texture_list = zisc::cast<nanairo::TextureModelSettingNode*>(
+      scene_settings.textureModelSettingNode());
+  texture_list->addMaterial();
+  auto surface_list = zisc::cast<nanairo::SurfaceModelSettingNode*>(
+      scene_settings.surfaceModelSettingNode());
+  for (const auto surface_type : {SurfaceType::kSmoothDiffuse,
+                                  SurfaceType::kRoughConductor,
+                                  SurfaceType::kSmoothConductor}) {
+    auto surface = zisc::cast<nanairo::SurfaceSettingNode*>(
+        surface_list->addMaterial());
+    surface->setSurfaceType(surface_type);
+  }
+  auto emitter_list = zisc::cast<nanairo::EmitterModelSettingNode*>(
+      scene_settings.emitterModelSettingNode());
+  emitter_list->addMaterial();
+
+  // Camera
+  {
+    auto camera = zisc::cast<nanairo::ObjectModelSettingNode*>(
+        scene_settings.cameraSettingNode());
+    camera->setObject(ObjectType::kCamera);
+  }
+
+  // Objects
+  auto object_model = zisc::cast<nanairo::ObjectModelSettingNode*>(
+      scene_settings.objectSettingNode());
+  auto group = zisc::cast<nanairo::GroupObjectSettingNode*>(
+      object_model->setObject(ObjectType::kGroup));
+  auto add_plane = [group](const double scale,
+                           const double rotation_x,
+                           const double rotation_y,
+                           const double x,
+                           const double y,
+                           const double z,
+                           const nanairo::uint32 surface_index)
+  {
+    auto plane = zisc::cast<nanairo::ObjectModelSettingNode*>(group->addObject());
+    for (auto transformation : {
+        plane->addTransformation(TransformationType::kScaling, scale, scale, scale),
+        plane->addTransformation(TransformationType::kRotation, rotation_x, rotation_y, 0.0),
+        plane->addTransformation(TransformationType::kTranslation, x, y, z)}) {
+      zisc::cast<nanairo::TransformationSettingNode*>(transformation)->setEnabled(true);
+    }
+    auto object = zisc::cast<nanairo::SingleObjectSettingNode*>(
+        plane->objectSettingNode());
+    object->setSurfaceIndex(surface_index);
+    return object;
+  };
+  // Floor
+  add_plane(4.0, 0.0, 0.0, 0.0, 2.0, -1.5, 0);
+  // Back wall
+  add_plane(4.0, 0.5 * pi, 0.0, 0.0, 3.5, 0.0, 1);
+  // Left wall
+  add_plane(4.0, 0.0, 0.5 * pi, -1.5, 2.0, 0.0, 2);
+  // Light
+  auto light = add_plane(1.0, pi, 0.0, 0.0, 2.0, 1.4, 0);
+  light->setEmissive(true);
+  light->setEmitterIndex(0);
+}
+
+/*!
+  \details
+  The expected values of the pixels are returned.
+  */
+std::vector<nanairo::Float> renderImage(const nanairo::SceneSettingNode& scene_settings,
+                                        const nanairo::uint32 num_of_cycles)
+{
+  using nanairo::uint;
+
+  nanairo::System system{scene_settings.systemSettingNode()};
+  nanairo::Scene scene{system, &scene_settings};
+  const nanairo::WavelengthSampler wavelength_sampler{
+      scene.world(),
+      scene_settings.systemSettingNode()};
+  nanairo::PathTracing method{system,
+                              scene_settings.renderingMethodSettingNode(),
+                              scene};
+  for (nanairo::uint32 cycle = 1; cycle <= num_of_cycles; ++cycle) {
+    nanairo::PathState path_state{cycle};
+    path_state.setDimension(nanairo::SampleDimension::kWavelengthSample1);
+    const auto sampled_wavelengths = wavelength_sampler(system.globalSampler(),
+                                                        path_state);
+    method.render(system, scene, sampled_wavelengths, cycle);
+  }
+
+  std::vector<nanairo::Float> image;
+  const auto& sample_table = scene.film().sampleStatistics().sampleTable();
+  for (const auto& sample : sample_table) {
+    for (uint i = 0; i < sample->size(); ++i)
+      image.emplace_back(sample->get(i));
+  }
+  return image;
+}
+
+} // namespace
+
+TEST(PathTracingTest, WavefrontTest)
+{
+  using nanairo::uint;
+
+  nanairo::SceneSettingNode scene_settings;
+  makeTestScene(scene_settings);
+  auto method_settings = zisc::cast<nanairo::RenderingMethodSettingNode*>(
+      scene_settings.renderingMethodSettingNode());
+  auto& parameters = method_settings->pathTracingParameters();
+
+  constexpr nanairo::uint32 num_of_cycles = 2;
+  parameters.wavefront_is_enabled_ = nanairo::kFalse;
+  const auto reference = renderImage(scene_settings, num_of_cycles);
+  parameters.wavefront_is_enabled_ = nanairo::kTrue;
+  const auto image = renderImage(scene_settings, num_of_cycles);
+
+  // The paths of a pixel consume the same samples in both modes
+  ASSERT_EQ(reference.size(), image.size());
+  nanairo::Float total = 0.0;
+  for (uint i = 0; i < reference.size(); ++i) {
+    const nanairo::Float error = 1.0e-6 * zisc::max(zisc::abs(reference[i]), 1.0);
+    ASSERT_NEAR(reference[i], image[i], error)
+        << "The value " << i << " of the wavefront image is wrong.";
+    total += reference[i];
+  }
+  ASSERT_LT(0.0, total) << "The light isn't rendered.";
+}
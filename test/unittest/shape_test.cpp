@@ -14,12 +14,21 @@
 #include <cmath>
 #include <memory>
 // Zisc
+#include "zisc/math.hpp"
+#include "zisc/simple_memory_resource.hpp"
 #include "zisc/unit.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
 #include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Setting/single_object_setting_node.hpp"
+#include "NanairoCore/Shape/bilinear_patch.hpp"
+#include "NanairoCore/Shape/disk.hpp"
 #include "NanairoCore/Shape/plane.hpp"
+#include "NanairoCore/Shape/sphere.hpp"
 #include "NanairoCore/Shape/flat_triangle.hpp"
+#include "NanairoCore/Shape/triangle_mesh.hpp"
 
 TEST(ShapeTest, PlaneTransformationTest)
 {
@@ -148,20 +157,28 @@ TEST(ShapeTest, FlatTriangleTransformationTest)
   const Vector3 default_n{0.0, 0.0, 1.0};
   const Float default_area = 0.5;
 
-  auto make_triangle = [&default_p, &default_e]()
+  auto make_mesh = [&default_p, &default_e]()
   {
-    return std::make_unique<nanairo::FlatTriangle>(default_p,
-                                                   default_p + default_e[0],
-                                                   default_p + default_e[1]);
+    auto resource = zisc::SimpleMemoryResource::sharedResource();
+    nanairo::MeshParameters parameters{resource};
+    const std::array<Point3, 3> vertices{{default_p,
+                                          default_p + default_e[0],
+                                          default_p + default_e[1]}};
+    for (const auto& v : vertices)
+      parameters.vertex_list_.push_back({{v[0], v[1], v[2]}});
+    parameters.face_list_.emplace_back(0, 1, 2);
+    return std::make_unique<nanairo::TriangleMesh>(parameters, resource, resource);
   };
 
   // Translation
   {
-    auto shape = make_triangle();
+    auto mesh = make_mesh();
+    auto shape = std::make_unique<nanairo::FlatTriangle>(mesh.get(), 0);
 
     const Vector3 v{0.5, 1.0, -1.0};
     const auto transformation = Transformation::makeTranslation(v[0], v[1], v[2]);
 
+    mesh->transform(transformation);
     shape->transform(transformation);
     {
       const auto& p = shape->vertex0();
@@ -191,11 +208,13 @@ TEST(ShapeTest, FlatTriangleTransformationTest)
   }
   // Scaling
   {
-    auto shape = make_triangle();
+    auto mesh = make_mesh();
+    auto shape = std::make_unique<nanairo::FlatTriangle>(mesh.get(), 0);
 
     const Vector3 v{0.5, 0.1, 1.0};
     const auto transformation = Transformation::makeScaling(v[0], v[1], v[2]);
 
+    mesh->transform(transformation);
     shape->transform(transformation);
     {
       const auto& p = shape->vertex0();
@@ -225,11 +244,13 @@ TEST(ShapeTest, FlatTriangleTransformationTest)
   }
   // Rotation
   {
-    auto shape = make_triangle();
+    auto mesh = make_mesh();
+    auto shape = std::make_unique<nanairo::FlatTriangle>(mesh.get(), 0);
 
     const Float theta = zisc::toRadian(30.0);
     const auto transformation = Transformation::makeXAxisRotation(theta);
 
+    mesh->transform(transformation);
     shape->transform(transformation);
     {
       const auto& p = shape->vertex0();
@@ -253,3 +274,367 @@ TEST(ShapeTest, FlatTriangleTransformationTest)
         << "The translation of the triangle is failed.";
   }
 }
+
+TEST(ShapeTest, FlatTriangleSmoothingTest)
+{
+  using nanairo::uint;
+  using nanairo::Float;
+  using nanairo::Point2;
+  using nanairo::Point3;
+  using nanairo::Vector3;
+
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  nanairo::MeshParameters parameters{resource};
+  parameters.vertex_list_.push_back({{0.0, 0.0, 0.0}});
+  parameters.vertex_list_.push_back({{1.0, 0.0, 0.0}});
+  parameters.vertex_list_.push_back({{0.0, 1.0, 0.0}});
+  parameters.vnormal_list_.push_back({{0.0, 0.0, 1.0}});
+  parameters.vnormal_list_.push_back({{1.0, 0.0, 1.0}});
+  parameters.vnormal_list_.push_back({{0.0, 1.0, 1.0}});
+  parameters.face_list_.emplace_back(0, 1, 2);
+  parameters.face_list_[0].setVnormalIndices(0, 1, 2);
+
+  // Flat
+  {
+    nanairo::TriangleMesh mesh{parameters, resource, resource};
+    ASSERT_FALSE(mesh.hasNormal())
+        << "The vertex normals of a flat mesh are used.";
+    nanairo::FlatTriangle triangle{&mesh, 0};
+    const auto point = triangle.getPoint(Point2{0.5, 0.0});
+    for (uint i = 0; i < 3; ++i) {
+      ASSERT_DOUBLE_EQ(triangle.normal()[i], point.normal()[i])
+          << "The normal of the flat triangle is wrong.";
+    }
+  }
+  // Smoothed
+  {
+    parameters.smoothing_ = nanairo::kTrue;
+    nanairo::TriangleMesh mesh{parameters, resource, resource};
+    ASSERT_TRUE(mesh.hasNormal())
+        << "The vertex normals of a smoothed mesh aren't used.";
+    nanairo::FlatTriangle triangle{&mesh, 0};
+    const auto point = triangle.getPoint(Point2{0.5, 0.0});
+    const Vector3 n0{0.0, 0.0, 1.0};
+    const Vector3 n1 = Vector3{1.0, 0.0, 1.0}.normalized();
+    const Vector3 expected = (0.5 * n0 + 0.5 * n1).normalized();
+    for (uint i = 0; i < 3; ++i) {
+      ASSERT_DOUBLE_EQ(expected[i], point.normal()[i])
+          << "The normal of the smoothed triangle is wrong.";
+    }
+  }
+}
+
+TEST(ShapeTest, TriangleMeshCompressionTest)
+{
+  using nanairo::uint;
+  using nanairo::uint32;
+  using nanairo::Float;
+  using nanairo::MeshCompression;
+  using nanairo::Transformation;
+  using nanairo::Vector3;
+
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  nanairo::MeshParameters parameters{resource};
+  parameters.vertex_list_.push_back({{-1.5, 0.25, 3.0}});
+  parameters.vertex_list_.push_back({{2.5, -0.75, 1.0}});
+  parameters.vertex_list_.push_back({{0.125, 2.0, -1.0}});
+  parameters.vertex_list_.push_back({{1.0, 1.0, 2.0}});
+  parameters.vnormal_list_.push_back({{0.0, 0.0, 1.0}});
+  parameters.vnormal_list_.push_back({{-1.0, 2.0, -3.0}});
+  parameters.vnormal_list_.push_back({{0.5, -0.25, -0.5}});
+  parameters.vuv_list_.push_back({{0.0, 0.0}});
+  parameters.vuv_list_.push_back({{1.0, 0.3}});
+  parameters.vuv_list_.push_back({{0.7, 1.0}});
+  parameters.face_list_.emplace_back(0, 1, 2);
+  parameters.face_list_[0].setVnormalIndices(0, 1, 2);
+  parameters.face_list_[0].setVuvIndices(0, 1, 2);
+  parameters.face_list_.emplace_back(1, 3, 2);
+  parameters.face_list_[1].setVnormalIndices(1, 2, 0);
+  parameters.face_list_[1].setVuvIndices(1, 2, 0);
+  parameters.smoothing_ = nanairo::kTrue;
+
+  const auto transformation =
+      Transformation::makeTranslation(1.0, -2.0, 0.5) *
+      Transformation::makeYAxisRotation(0.3) *
+      Transformation::makeScaling(2.0, 1.0, 0.5);
+
+  nanairo::TriangleMesh reference{parameters, resource, resource};
+  ASSERT_EQ(MeshCompression::kNone, reference.compression())
+      << "The mesh is compressed by default.";
+  auto test_compression = [&](const MeshCompression compression,
+                              const Float position_error)
+  {
+    parameters.compression_ = compression;
+    nanairo::TriangleMesh mesh{parameters, resource, resource};
+    ASSERT_EQ(compression, mesh.compression()) << "The mesh isn't compressed.";
+    ASSERT_EQ(reference.numOfVertices(), mesh.numOfVertices())
+        << "The number of vertices of the compressed mesh is wrong.";
+    ASSERT_TRUE(mesh.hasNormal() && mesh.hasUv())
+        << "The attributes of the compressed mesh are lost.";
+    for (uint32 index = 0; index < mesh.numOfVertices(); ++index) {
+      for (uint i = 0; i < 3; ++i) {
+        ASSERT_NEAR(reference.vertex(index)[i], mesh.vertex(index)[i], position_error)
+            << "The quantized position is wrong.";
+        ASSERT_NEAR(reference.normal(index)[i], mesh.normal(index)[i], 1.0e-4)
+            << "The octahedral normal is wrong.";
+      }
+      for (uint i = 0; i < 2; ++i) {
+        ASSERT_NEAR(reference.uv(index)[i], mesh.uv(index)[i], 5.0e-4)
+            << "The half float UV is wrong.";
+      }
+    }
+  };
+  test_compression(MeshCompression::kQuantized16, 1.0e-4);
+  test_compression(MeshCompression::kQuantized32, 1.0e-8);
+
+  // Transformation
+  reference.transform(transformation);
+  parameters.compression_ = MeshCompression::kQuantized16;
+  nanairo::TriangleMesh mesh{parameters, resource, resource};
+  mesh.transform(transformation);
+  for (uint32 index = 0; index < mesh.numOfVertices(); ++index) {
+    for (uint i = 0; i < 3; ++i) {
+      ASSERT_NEAR(reference.vertex(index)[i], mesh.vertex(index)[i], 2.0e-4)
+          << "The transformation of the compressed mesh is wrong.";
+      ASSERT_NEAR(reference.normal(index)[i], mesh.normal(index)[i], 2.0e-4)
+          << "The normal transformation of the compressed mesh is wrong.";
+    }
+  }
+}
+
+TEST(ShapeTest, TriangleMeshUpdateTest)
+{
+  using nanairo::uint;
+  using nanairo::uint32;
+  using nanairo::MeshCompression;
+  using nanairo::Transformation;
+
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  nanairo::MeshParameters parameters{resource};
+  parameters.vertex_list_.push_back({{-1.5, 0.25, 3.0}});
+  parameters.vertex_list_.push_back({{2.5, -0.75, 1.0}});
+  parameters.vertex_list_.push_back({{0.125, 2.0, -1.0}});
+  parameters.vertex_list_.push_back({{1.0, 1.0, 2.0}});
+  parameters.vnormal_list_.push_back({{0.0, 0.0, 1.0}});
+  parameters.vnormal_list_.push_back({{-1.0, 2.0, -3.0}});
+  parameters.vnormal_list_.push_back({{0.5, -0.25, -0.5}});
+  parameters.face_list_.emplace_back(0, 1, 2);
+  parameters.face_list_[0].setVnormalIndices(0, 1, 2);
+  parameters.face_list_.emplace_back(1, 3, 2);
+  parameters.face_list_[1].setVnormalIndices(1, 2, 0);
+  parameters.smoothing_ = nanairo::kTrue;
+
+  const auto transformation1 =
+      Transformation::makeTranslation(1.0, -2.0, 0.5) *
+      Transformation::makeYAxisRotation(0.3) *
+      Transformation::makeScaling(2.0, 1.0, 0.5);
+  const auto transformation2 =
+      Transformation::makeTranslation(-0.7, 0.2, 3.0) *
+      Transformation::makeZAxisRotation(1.1) *
+      Transformation::makeScaling(0.3, 0.3, 0.3);
+
+  // The edits of the transformation don't accumulate errors
+  for (const auto compression : {MeshCompression::kNone,
+                                 MeshCompression::kQuantized16}) {
+    parameters.compression_ = compression;
+    nanairo::TriangleMesh reference{parameters, resource, resource};
+    reference.transform(transformation1);
+    nanairo::TriangleMesh mesh{parameters, resource, resource};
+    mesh.transform(transformation1);
+    for (uint i = 0; i < 100; ++i) {
+      mesh.setTransformation(parameters, transformation2, resource);
+      mesh.setTransformation(parameters, transformation1, resource);
+    }
+    for (uint32 index = 0; index < mesh.numOfVertices(); ++index) {
+      for (uint i = 0; i < 3; ++i) {
+        ASSERT_EQ(reference.vertex(index)[i], mesh.vertex(index)[i])
+            << "The vertex drifts by the updates.";
+        ASSERT_EQ(reference.normal(index)[i], mesh.normal(index)[i])
+            << "The normal drifts by the updates.";
+      }
+    }
+  }
+
+  // An analytic shape is transformed from the object space again
+  nanairo::Plane reference;
+  reference.transform(transformation1);
+  nanairo::Plane plane;
+  plane.transform(transformation1);
+  for (uint i = 0; i < 100; ++i) {
+    for (const auto& transformation : {transformation2, transformation1}) {
+      plane.resetTransformation();
+      plane.transform(transformation);
+    }
+  }
+  for (uint i = 0; i < 3; ++i) {
+    ASSERT_EQ(reference.vertex0()[i], plane.vertex0()[i])
+        << "The plane drifts by the updates.";
+  }
+  ASSERT_EQ(reference.surfaceArea(), plane.surfaceArea())
+      << "The surface area of the plane is wrong.";
+}
+
+TEST(ShapeTest, BilinearPatchTest)
+{
+  using nanairo::uint;
+  using nanairo::Float;
+  using nanairo::Point2;
+  using nanairo::Point3;
+  using nanairo::Ray;
+  using nanairo::Vector3;
+
+  auto resource = zisc::SimpleMemoryResource::sharedResource();
+  auto make_mesh = [resource](const std::array<Point3, 4>& vertices)
+  {
+    nanairo::MeshParameters parameters{resource};
+    for (const auto& v : vertices)
+      parameters.vertex_list_.push_back({{v[0], v[1], v[2]}});
+    parameters.face_list_.emplace_back(0, 1, 2, 3);
+    return std::make_unique<nanairo::TriangleMesh>(parameters, resource, resource);
+  };
+
+  // Planar quad
+  {
+    auto mesh = make_mesh({{Point3{0.0, 0.0, 0.0}, Point3{2.0, 0.0, 0.0},
+                            Point3{2.0, 1.0, 0.0}, Point3{0.0, 1.0, 0.0}}});
+    ASSERT_EQ(1, mesh->numOfQuads()) << "The planar quad is split.";
+    nanairo::BilinearPatch patch{mesh.get(), 0};
+    ASSERT_DOUBLE_EQ(2.0, patch.surfaceArea())
+        << "The surface area of the planar quad is wrong.";
+
+    const auto ray = Ray::makeRay(Point3{0.5, 0.25, 1.0}, Vector3{0.0, 0.0, -1.0});
+    Float t = 0.0;
+    Point2 st;
+    ASSERT_TRUE(patch.testIntersection(ray, 2.0, &t, &st))
+        << "The ray-quad intersection test is failed.";
+    ASSERT_DOUBLE_EQ(1.0, t) << "The ray distance is wrong.";
+    ASSERT_DOUBLE_EQ(0.25, st[0]) << "The st coordinate is wrong.";
+    ASSERT_DOUBLE_EQ(0.25, st[1]) << "The st coordinate is wrong.";
+    ASSERT_FALSE(patch.testIntersection(ray, 0.5, &t, &st))
+        << "The intersection beyond the max distance is found.";
+  }
+  // Curved patch, z = s * t
+  {
+    auto mesh = make_mesh({{Point3{0.0, 0.0, 0.0}, Point3{1.0, 0.0, 0.0},
+                            Point3{1.0, 1.0, 1.0}, Point3{0.0, 1.0, 0.0}}});
+    ASSERT_EQ(1, mesh->numOfQuads()) << "The curved patch is split.";
+    nanairo::BilinearPatch patch{mesh.get(), 0};
+    const Point2 expected{0.25, 0.75};
+    const auto ray = Ray::makeRay(Point3{expected[0], expected[1], 2.0},
+                                  Vector3{0.0, 0.0, -1.0});
+    Float t = 0.0;
+    Point2 st;
+    ASSERT_TRUE(patch.testIntersection(ray, 4.0, &t, &st))
+        << "The ray-patch intersection test is failed.";
+    ASSERT_NEAR(2.0 - expected[0] * expected[1], t, 1.0e-12)
+        << "The ray distance is wrong.";
+    for (uint i = 0; i < 2; ++i)
+      ASSERT_NEAR(expected[i], st[i], 1.0e-12) << "The st coordinate is wrong.";
+
+    mesh->splitQuads(true);
+    ASSERT_EQ(0, mesh->numOfQuads()) << "The curved patch isn't split.";
+    ASSERT_EQ(2, mesh->numOfFaces()) << "The curved patch isn't split.";
+  }
+  // Concave quad
+  {
+    auto mesh = make_mesh({{Point3{0.0, 0.0, 0.0}, Point3{1.0, 0.0, 0.0},
+                            Point3{0.25, 0.25, 0.0}, Point3{0.0, 1.0, 0.0}}});
+    ASSERT_EQ(0, mesh->numOfQuads()) << "The concave quad isn't split.";
+    ASSERT_EQ(2, mesh->numOfFaces()) << "The concave quad isn't split.";
+  }
+}
+
+TEST(ShapeTest, SphereTest)
+{
+  using nanairo::uint;
+  using nanairo::Float;
+  using nanairo::Point2;
+  using nanairo::Point3;
+  using nanairo::Ray;
+  using nanairo::Transformation;
+  using nanairo::Vector3;
+
+  nanairo::Sphere sphere;
+  {
+    const auto transformation = Transformation::makeTranslation(1.0, 0.0, 0.0) *
+                                Transformation::makeScaling(2.0, 2.0, 2.0);
+    sphere.transform(transformation);
+    ASSERT_DOUBLE_EQ(1.0, sphere.radius()) << "The scaling of the sphere is failed.";
+    ASSERT_DOUBLE_EQ(1.0, sphere.center()[0])
+        << "The translation of the sphere is failed.";
+    ASSERT_DOUBLE_EQ(4.0 * zisc::kPi<Float>, sphere.surfaceArea())
+        << "The surface area of the sphere is wrong.";
+    const auto aabb = sphere.boundingBox();
+    ASSERT_DOUBLE_EQ(0.0, aabb.minPoint()[0]) << "The bounding box is wrong.";
+    ASSERT_DOUBLE_EQ(2.0, aabb.maxPoint()[0]) << "The bounding box is wrong.";
+  }
+  {
+    const auto ray = Ray::makeRay(Point3{1.0, 0.0, 3.0}, Vector3{0.0, 0.0, -1.0});
+    Float t = 0.0;
+    ASSERT_TRUE(sphere.testIntersection(ray, 4.0, &t))
+        << "The ray-sphere intersection test is failed.";
+    ASSERT_DOUBLE_EQ(2.0, t) << "The ray distance is wrong.";
+    ASSERT_FALSE(sphere.testIntersection(ray, 1.5, &t))
+        << "The intersection beyond the max distance is found.";
+  }
+  {
+    const auto ray = Ray::makeRay(Point3{1.0, 0.0, 0.0}, Vector3{0.0, 0.0, 1.0});
+    Float t = 0.0;
+    ASSERT_TRUE(sphere.testIntersection(ray, 4.0, &t))
+        << "The ray from the inside doesn't hit the sphere.";
+    ASSERT_DOUBLE_EQ(1.0, t) << "The ray distance is wrong.";
+  }
+  // The pdf of the point seen from the reference point
+  {
+    const Point3 reference{1.0, 0.0, 3.0};
+    const Float inverse_pdf = sphere.getInversePdfFrom(reference, Point3{1.0, 0.0, 1.0});
+    // Solid angle of the cone * distance^2 / cos
+    const Float cos_max = std::sqrt(1.0 - 1.0 / 9.0);
+    ASSERT_NEAR(2.0 * zisc::kPi<Float> * (1.0 - cos_max) * 4.0, inverse_pdf, 1.0e-12)
+        << "The inverse pdf of the sphere is wrong.";
+    ASSERT_LT(sphere.surfaceArea(), sphere.getInversePdfFrom(reference, Point3{1.0, 0.0, -1.0}))
+        << "The back side of the sphere can be sampled.";
+  }
+}
+
+TEST(ShapeTest, DiskTest)
+{
+  using nanairo::uint;
+  using nanairo::Float;
+  using nanairo::Point2;
+  using nanairo::Point3;
+  using nanairo::Ray;
+  using nanairo::Transformation;
+  using nanairo::Vector3;
+
+  nanairo::Disk disk;
+  {
+    const auto transformation = Transformation::makeXAxisRotation(0.5 * zisc::kPi<Float>) *
+                                Transformation::makeScaling(4.0, 2.0, 1.0);
+    disk.transform(transformation);
+    ASSERT_DOUBLE_EQ(2.0 * zisc::kPi<Float>, disk.surfaceArea())
+        << "The surface area of the ellipse is wrong.";
+    ASSERT_NEAR(-1.0, disk.normal()[1], 1.0e-12) << "The normal of the disk is wrong.";
+    const auto aabb = disk.boundingBox();
+    ASSERT_DOUBLE_EQ(-2.0, aabb.minPoint()[0]) << "The bounding box is wrong.";
+    ASSERT_NEAR(0.0, aabb.minPoint()[1], 1.0e-12) << "The bounding box is wrong.";
+    ASSERT_NEAR(-1.0, aabb.minPoint()[2], 1.0e-12) << "The bounding box is wrong.";
+  }
+  {
+    const auto ray = Ray::makeRay(Point3{1.0, -2.0, 0.5}, Vector3{0.0, 1.0, 0.0});
+    Float t = 0.0;
+    Point2 st;
+    ASSERT_TRUE(disk.testIntersection(ray, 4.0, &t, &st))
+        << "The ray-disk intersection test is failed.";
+    ASSERT_NEAR(2.0, t, 1.0e-12) << "The ray distance is wrong.";
+    ASSERT_NEAR(0.75, st[0], 1.0e-12) << "The st coordinate is wrong.";
+    ASSERT_NEAR(0.75, st[1], 1.0e-12) << "The st coordinate is wrong.";
+  }
+  {
+    const auto ray = Ray::makeRay(Point3{1.8, -2.0, 0.5}, Vector3{0.0, 1.0, 0.0});
+    Float t = 0.0;
+    Point2 st;
+    ASSERT_FALSE(disk.testIntersection(ray, 4.0, &t, &st))
+        << "The ray outside the ellipse hits the disk.";
+  }
+}
@@ -180,6 +180,7 @@ def parseRenderingMethodSettings(settings, executor):
   # Path tracing
   scene_data["Type"] = "PathTracing"
   scene_data["EyePathLightSampler"] = "PowerWeightedLightSampler"
+  scene_data["EnableWavefront"] = False
   scene_data["RussianRoulette"] = "Reflectance (Max)"
   scene_data["PathLength"] = 3
   raycast_epsilon = toNanaFloat(1e-06, 7)
@@ -405,6 +406,44 @@ class Object:
 
     return has_body
 
+  def analyticShapeType(self):
+    # An object can be exported as an analytic shape by the custom property
+    # 'NanairoShape', which is 'Sphere' or 'Disk'
+    shape_types = {"Sphere": "SphereObject", "Disk": "DiskObject"}
+    shape = self.obj_.get("NanairoShape", "")
+    if shape not in shape_types:
+      return None
+    if not self.separate_transformation_:
+      printInfo(InfoType.kWarning,
+                "Object '{0}' is exported as a mesh.".format(self.obj_.name))
+      return None
+    return shape_types[shape]
+
+  def takeShapeTransformation(self):
+    # Fit the default shape, which has the radius 0.5 at the origin,
+    # to the bounding box of the object data
+    bound = self.obj_.bound_box
+    min_point = [min(p[i] for p in bound) for i in range(3)]
+    max_point = [max(p[i] for p in bound) for i in range(3)]
+    center = [toNanaFloat(0.5 * (min_point[i] + max_point[i])) for i in range(3)]
+    num_of_axes = 3 if self.obj_.get("NanairoShape") == "Sphere" else 2
+    diameter = toNanaFloat(max(max_point[i] - min_point[i] for i in range(num_of_axes)))
+
+    transformation_list = list()
+    if diameter != 1.0:
+      scaling_setting = dict()
+      scaling_setting["Type"] = "Scaling"
+      scaling_setting["Enabled"] = True
+      scaling_setting["Value"] = [diameter, diameter, diameter]
+      transformation_list.append(scaling_setting)
+    if (center[0] != 0.0) or (center[1] != 0.0) or (center[2] != 0.0):
+      translation_setting = dict()
+      translation_setting["Type"] = "Translation"
+      translation_setting["Enabled"] = True
+      translation_setting["Value"] = center
+      transformation_list.append(translation_setting)
+    return transformation_list
+
   def takeTransformation(self):
     transformation_list = list()
     if (not self.separate_transformation_) and (not self.isCamera()):
@@ -533,16 +572,28 @@ def parseSceneObjectSettings(settings, scene, material_info_list, object_list, o
       printInfo(InfoType.kWarning, 
                 "Object '{0}' doesn't have material.".format(obj.obj_.name))
 
-    obj_file_name = obj.obj_.name + ".obj"
-    obj_file_path = os.path.join(settings.resource_dir_, "objects", obj_file_name)
-    if obj.is_instance_:
-      printInfo(InfoType.kWarning,
-                "Object '{0}' is an instance.".format(obj.obj_.name))
-    settings.object_list_.append(obj.obj_)
-
-    obj_data["ShapeType"] = "MeshObject"
-    obj_data["ObjectFilePath"] = obj_file_path
-    obj_data["Smoothing"] = False
+    shape_type = obj.analyticShapeType()
+    if shape_type:
+      obj_data["ShapeType"] = shape_type
+      obj_data["Transformation"] = \
+          obj.takeShapeTransformation() + obj_data["Transformation"]
+    else:
+      obj_file_name = obj.obj_.name + ".obj"
+      obj_file_path = os.path.join(settings.resource_dir_, "objects", obj_file_name)
+      if obj.is_instance_:
+        printInfo(InfoType.kWarning,
+                  "Object '{0}' is an instance.".format(obj.obj_.name))
+      settings.object_list_.append(obj.obj_)
+
+      obj_data["ShapeType"] = "MeshObject"
+      obj_data["ObjectFilePath"] = obj_file_path
+      obj_data["Smoothing"] = any(polygon.use_smooth for polygon in obj.obj_.data.polygons)
+      # A large mesh can be compressed by the custom property
+      # 'NanairoMeshCompression', which is 'Quantized16' or 'Quantized32'
+      compression = obj.obj_.get("NanairoMeshCompression", "")
+      obj_data["MeshCompression"] = (compression + "Mesh"
+          if compression in ("Quantized16", "Quantized32")
+          else "UncompressedMesh")
     obj_data["SurfaceIndex"] = material_info.surface_index_
     obj_data["EmitterIndex"] = material_info.emitter_index_
     obj_data["IsEmissiveObject"] = material_info.has_emitter_
@@ -584,6 +635,9 @@ def parseBvhSettings(settings, executor):
   scene_data = dict()
 
   scene_data["Type"] = "BinaryRadixTreeBvh"
+  scene_data["Traversal"] = "OrderedTraversal"
+  scene_data["NodeFormat"] = "FullNode"
+  scene_data["MaxLeafSize"] = 8
 
   return scene_data
 
@@ -623,7 +677,7 @@ def exportObject(obj, object_dir):
       use_normals = True, \
       use_uvs = True, \
       use_materials = False, \
-      use_triangles = True, \
+      use_triangles = False, \
       use_nurbs = False, \
       use_vertex_groups = False, \
       use_blen_objects = True, \